@@ -65,19 +65,29 @@ typedef struct {
 
     unsigned int timeout_ms;  // SSL handshake timeout in millisecond
 
+    uint8_t   session_resume_enable;  // 1 to save session and resume it when connecting to the same host:port again
+    uintptr_t session;                // session saved by tls client, free by qcloud_iot_tls_client_session_free
+
 } SSLConnectParams;
 
 typedef SSLConnectParams TLSConnectParams;
 
 /**
- * @brief Tls setup and sharkhand
+ * @brief Tls setup and sharkhand, abbreviated handshake is tried if session is saved and resume is enabled.
  *
- * @param[in] connect_params connect params of tls
+ * @param[in,out] connect_params connect params of tls, session is updated after handshake if resume is enabled
  * @param[in] host server host
  * @param[in] port server port
  * @return tls handle, 0 for fail
  */
-uintptr_t qcloud_iot_tls_client_connect(const TLSConnectParams *connect_params, const char *host, const char *port);
+uintptr_t qcloud_iot_tls_client_connect(TLSConnectParams *connect_params, const char *host, const char *port);
+
+/**
+ * @brief Free tls session saved in connect params.
+ *
+ * @param[in,out] connect_params connect params of tls
+ */
+void qcloud_iot_tls_client_session_free(TLSConnectParams *connect_params);
 
 /**
  * @brief Disconect and free
@@ -99,6 +109,19 @@ void qcloud_iot_tls_client_disconnect(uintptr_t handle);
 int qcloud_iot_tls_client_write(uintptr_t handle, unsigned char *msg, size_t total_len, uint32_t timeout_ms,
                                 size_t *written_len);
 
+/**
+ * @brief Write data segments with tls, small segments are coalesced to avoid tiny records.
+ *
+ * @param[in,out] handle tls handle
+ * @param[in] iov data segments to write
+ * @param[in] iovcnt count of data segments
+ * @param[in] timeout_ms timeout millsecond
+ * @param[out] written_len number of bytes writtern
+ * @return @see IotReturnCode
+ */
+int qcloud_iot_tls_client_writev(uintptr_t handle, const IotIoVec *iov, int iovcnt, uint32_t timeout_ms,
+                                 size_t *written_len);
+
 /**
  * @brief Read msg with tls
  *
@@ -112,6 +135,35 @@ int qcloud_iot_tls_client_write(uintptr_t handle, unsigned char *msg, size_t tot
 int qcloud_iot_tls_client_read(uintptr_t handle, unsigned char *msg, size_t total_len, uint32_t timeout_ms,
                                size_t *read_len);
 
+/**
+ * @brief Receive msg with tls, return as soon as any data is read instead of waiting for total_len bytes.
+ *
+ * @param[in,out] handle tls handle
+ * @param[out] msg msg buffer
+ * @param[in] total_len buffer len
+ * @param[in] timeout_ms timeout millsecond
+ * @param[out] read_len number of bytes read
+ * @return @see IotReturnCode
+ */
+int qcloud_iot_tls_client_recv(uintptr_t handle, unsigned char *msg, size_t total_len, uint32_t timeout_ms,
+                               size_t *read_len);
+
+/**
+ * @brief Get socket fd of tls connection.
+ *
+ * @param[in] handle tls handle
+ * @return socket fd, -1 for no connection
+ */
+int qcloud_iot_tls_client_get_fd(uintptr_t handle);
+
+/**
+ * @brief Get length of data decrypted but not read, which is not reported by socket readable event.
+ *
+ * @param[in] handle tls handle
+ * @return length of data buffered in tls
+ */
+size_t qcloud_iot_tls_client_get_bytes_avail(uintptr_t handle);
+
 #if defined(__cplusplus)
 }
 #endif
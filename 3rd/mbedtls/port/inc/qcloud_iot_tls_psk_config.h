@@ -33,6 +33,8 @@
 extern "C" {
 #endif
 
+#include "qcloud_iot_config.h"
+
 /* System support */
 #define MBEDTLS_HAVE_ASM
 #define MBEDTLS_HAVE_TIME
@@ -60,14 +62,52 @@ extern "C" {
 #define MBEDTLS_CTR_DRBG_C
 #define MBEDTLS_ENTROPY_C
 
+/* AEAD suites for performance profile, aes-ni is only compiled on x86_64 */
+#ifdef TLS_PROFILE_PERFORMANCE
+#define MBEDTLS_GCM_C
+#define MBEDTLS_CHACHA20_C
+#define MBEDTLS_POLY1305_C
+#define MBEDTLS_CHACHAPOLY_C
+#if defined(__x86_64__) || defined(__amd64__)
+#define MBEDTLS_AESNI_C
+#endif
+#endif
+
 #define MBEDTLS_SSL_PROTO_TLS1_2
 #define MBEDTLS_SSL_ENCRYPT_THEN_MAC
 #define MBEDTLS_SSL_EXTENDED_MASTER_SECRET
 #define MBEDTLS_SSL_SESSION_TICKETS
 #define MBEDTLS_SSL_CLI_C
 #define MBEDTLS_SSL_TLS_C
+
+#ifdef TLS_MAX_FRAG_LEN
+#define MBEDTLS_SSL_MAX_FRAGMENT_LENGTH
+#endif
+
+#if defined(TLS_MAX_CONTENT_LEN)
+#define MBEDTLS_SSL_MAX_CONTENT_LEN TLS_MAX_CONTENT_LEN
+#elif defined(TLS_PROFILE_PERFORMANCE)
+#define MBEDTLS_SSL_MAX_CONTENT_LEN 16384
+#else
 #define MBEDTLS_SSL_MAX_CONTENT_LEN 3584
-#define MBEDTLS_SSL_CIPHERSUITES    MBEDTLS_TLS_PSK_WITH_AES_128_CBC_SHA, MBEDTLS_TLS_PSK_WITH_AES_256_CBC_SHA
+#endif
+
+/* AEAD suites are preferred, aes-gcm is faster than chacha20-poly1305 only with aes-ni */
+#if defined(TLS_PROFILE_PERFORMANCE) && defined(MBEDTLS_AESNI_C)
+#define MBEDTLS_SSL_CIPHERSUITES                   \
+    MBEDTLS_TLS_PSK_WITH_AES_128_GCM_SHA256,       \
+    MBEDTLS_TLS_PSK_WITH_CHACHA20_POLY1305_SHA256, \
+    MBEDTLS_TLS_PSK_WITH_AES_128_CBC_SHA,          \
+    MBEDTLS_TLS_PSK_WITH_AES_256_CBC_SHA
+#elif defined(TLS_PROFILE_PERFORMANCE)
+#define MBEDTLS_SSL_CIPHERSUITES                   \
+    MBEDTLS_TLS_PSK_WITH_CHACHA20_POLY1305_SHA256, \
+    MBEDTLS_TLS_PSK_WITH_AES_128_GCM_SHA256,       \
+    MBEDTLS_TLS_PSK_WITH_AES_128_CBC_SHA,          \
+    MBEDTLS_TLS_PSK_WITH_AES_256_CBC_SHA
+#else
+#define MBEDTLS_SSL_CIPHERSUITES MBEDTLS_TLS_PSK_WITH_AES_128_CBC_SHA, MBEDTLS_TLS_PSK_WITH_AES_256_CBC_SHA
+#endif
 
 #define MBEDTLS_TLS_DEFAULT_ALLOW_SHA1_IN_KEY_EXCHANGE
 
@@ -35,6 +35,7 @@ extern "C" {
 #include <stdint.h>
 #include <string.h>
 #include <errno.h>
+#include <limits.h>
 
 #include "mbedtls/ssl.h"
 #include "mbedtls/entropy.h"
@@ -42,31 +43,115 @@ extern "C" {
 #include "mbedtls/ctr_drbg.h"
 #include "mbedtls/error.h"
 
+#ifdef AUTH_MODE_CERT
+#include <stdio.h>
+
+#include "mbedtls/sha256.h"
+#include "mbedtls/platform_util.h"
+#endif
+
 #ifdef AUTH_MODE_KEY
 /**
- * @brief Only tls psk is supportted when using psk
+ * @brief Only tls psk is supportted when using psk, suites of tls profile are used if configured.
  *
  */
+#ifdef MBEDTLS_SSL_CIPHERSUITES
+static const int ciphersuites[] = {MBEDTLS_SSL_CIPHERSUITES, 0};
+#else
 static const int ciphersuites[] = {MBEDTLS_TLS_PSK_WITH_AES_128_CBC_SHA, MBEDTLS_TLS_PSK_WITH_AES_256_CBC_SHA, 0};
 #endif
+#endif
 
+#ifdef TLS_MAX_FRAG_LEN
 /**
- * @brief Data structure for mbedtls SSL connection
+ * @brief Max fragment length negotiated with server, server sends records no larger than it.
+ *
+ */
+#if TLS_MAX_FRAG_LEN == 512
+#define TLS_MAX_FRAG_LEN_CODE MBEDTLS_SSL_MAX_FRAG_LEN_512
+#elif TLS_MAX_FRAG_LEN == 1024
+#define TLS_MAX_FRAG_LEN_CODE MBEDTLS_SSL_MAX_FRAG_LEN_1024
+#elif TLS_MAX_FRAG_LEN == 2048
+#define TLS_MAX_FRAG_LEN_CODE MBEDTLS_SSL_MAX_FRAG_LEN_2048
+#elif TLS_MAX_FRAG_LEN == 4096
+#define TLS_MAX_FRAG_LEN_CODE MBEDTLS_SSL_MAX_FRAG_LEN_4096
+#else
+#error "TLS_MAX_FRAG_LEN should be 512, 1024, 2048 or 4096"
+#endif
+#endif
+
+/**
+ * @brief Max count of tls config kept in cache when no connection uses it.
+ *
+ */
+#define TLS_CONFIG_IDLE_MAX_NUM 4
+
+/**
+ * @brief Tls config shared by connections with the same credential, immutable after created.
+ *
+ */
+typedef struct TLSConfig {
+    struct TLSConfig * next;
+    int                ref_count;
+    unsigned char *    key;  // credential which config is created from
+    size_t             key_len;
+    mbedtls_ssl_config ssl_conf;
+#ifdef AUTH_MODE_CERT
+    mbedtls_x509_crt   ca_cert;
+    mbedtls_x509_crt   client_cert;
+    mbedtls_pk_context private_key;
+    mbedtls_pk_context sign_key;   // rsa private key wrapped to sign with lock
+    void *             sign_lock;  // blinding of rsa private key is updated when signing
+#endif
+} TLSConfig;
+
+/**
+ * @brief Random generator and tls config cache shared by all connections.
  *
  */
 typedef struct {
-    mbedtls_net_context      socket_fd;
+    void *                   lock;
+    int                      seeded;
     mbedtls_entropy_context  entropy;
     mbedtls_ctr_drbg_context ctr_drbg;
-    mbedtls_ssl_context      ssl;
-    mbedtls_ssl_config       ssl_conf;
-#ifdef AUTH_MODE_CERT
-    mbedtls_x509_crt ca_cert;
-    mbedtls_x509_crt client_cert;
-#endif
-    mbedtls_pk_context private_key;
+    TLSConfig *              config_list;  // recently used first
+    int                      idle_num;
+} TLSContext;
+
+static TLSContext sg_tls_context;
+
+/**
+ * @brief Data structure for mbedtls SSL connection
+ *
+ */
+typedef struct {
+    mbedtls_net_context socket_fd;
+    mbedtls_ssl_context ssl;
+    TLSConfig *         config;
+    uint32_t            read_timeout_ms;  // handshake timeout when connecting, remaining time of read after
 } TLSHandle;
 
+/**
+ * @brief Segments shorter than it are coalesced in one record when vectored write.
+ *
+ */
+#define TLS_WRITEV_COALESCE_LEN 256
+
+/**
+ * @brief Max length of host:port which session is saved for.
+ *
+ */
+#define TLS_SESSION_PEER_LEN 128
+
+/**
+ * @brief Session saved for resumption, with ticket or session id negotiated.
+ *
+ */
+typedef struct {
+    mbedtls_ssl_session session;
+    char                peer[TLS_SESSION_PEER_LEN];  // host:port
+} TLSSession;
+
 #ifdef MBEDTLS_DEBUG_C
 #define DEBUG_LEVEL 0
 static void _ssl_debug(void *ctx, int level, const char *file, int line, const char *str)
@@ -76,82 +161,499 @@ static void _ssl_debug(void *ctx, int level, const char *file, int line, const c
 #endif
 
 /**
- * @brief mbedtls SSL client init
+ * @brief Lock tls context, lock is created by the first caller.
+ *
+ * @return @see IotReturnCode
+ */
+static int _mbedtls_tls_context_lock(void)
+{
+    void *lock = sg_tls_context.lock;
+
+    if (!lock) {
+        lock = HAL_MutexCreate();
+        if (!lock) {
+            return QCLOUD_ERR_MALLOC;
+        }
+
+        // another thread creates lock at the same time
+        if (!__sync_bool_compare_and_swap(&sg_tls_context.lock, NULL, lock)) {
+            HAL_MutexDestroy(lock);
+        }
+    }
+
+    HAL_MutexLock(sg_tls_context.lock);
+    return QCLOUD_RET_SUCCESS;
+}
+
+/**
+ * @brief Unlock tls context.
  *
- * 1. call a series of mbedtls init functions
- * 2. init and set seed for random functions
- * 3. load CA file, cert files or PSK
+ */
+static void _mbedtls_tls_context_unlock(void)
+{
+    HAL_MutexUnlock(sg_tls_context.lock);
+}
+
+/**
+ * @brief Random function for ssl config, drbg shared by all connections is seeded only once.
+ *
+ * @param[in] ctx unused
+ * @param[out] output buffer to fill
+ * @param[in] output_len buffer len
+ * @return 0 for success, or mbedtls error code
+ */
+static int _mbedtls_tls_context_random(void *ctx, unsigned char *output, size_t output_len)
+{
+    int rc;
+
+    HAL_MutexLock(sg_tls_context.lock);
+    rc = mbedtls_ctr_drbg_random(&sg_tls_context.ctr_drbg, output, output_len);
+    HAL_MutexUnlock(sg_tls_context.lock);
+    return rc;
+}
+
+/**
+ * @brief Seed shared drbg if not seeded, tls context should be locked.
  *
- * @param[in,out] tls_handle mbedtls TLS handle
- * @param[in] connect_params device info for TLS connection
  * @return @see IotReturnCode
  */
-static int _mbedtls_tls_client_init(TLSHandle *tls_handle, const TLSConnectParams *connect_params)
+static int _mbedtls_tls_context_seed(void)
 {
     int rc;
 
-    mbedtls_net_init(&tls_handle->socket_fd);
-    mbedtls_ssl_init(&tls_handle->ssl);
-    mbedtls_ssl_config_init(&tls_handle->ssl_conf);
-    mbedtls_ctr_drbg_init(&tls_handle->ctr_drbg);
-    mbedtls_entropy_init(&tls_handle->entropy);
-#ifdef AUTH_MODE_CERT
-    mbedtls_x509_crt_init(&tls_handle->ca_cert);
-    mbedtls_x509_crt_init(&tls_handle->client_cert);
-    mbedtls_pk_init(&tls_handle->private_key);
-#endif
-#ifdef MBEDTLS_DEBUG_C
-    mbedtls_debug_set_threshold(DEBUG_LEVEL);
-    mbedtls_ssl_conf_dbg(&tls_handle->ssl_conf, _ssl_debug, NULL);
-#endif
+    if (sg_tls_context.seeded) {
+        return QCLOUD_RET_SUCCESS;
+    }
 
-    rc = mbedtls_ctr_drbg_seed(&tls_handle->ctr_drbg, mbedtls_entropy_func, &tls_handle->entropy, NULL, 0);
+    mbedtls_ctr_drbg_init(&sg_tls_context.ctr_drbg);
+    mbedtls_entropy_init(&sg_tls_context.entropy);
+
+    rc = mbedtls_ctr_drbg_seed(&sg_tls_context.ctr_drbg, mbedtls_entropy_func, &sg_tls_context.entropy, NULL, 0);
     if (rc) {
         Log_e("mbedtls_ctr_drbg_seed failed returned 0x%04x", -rc);
+        mbedtls_ctr_drbg_free(&sg_tls_context.ctr_drbg);
+        mbedtls_entropy_free(&sg_tls_context.entropy);
         return QCLOUD_ERR_SSL_INIT;
     }
 
+    sg_tls_context.seeded = 1;
+    return QCLOUD_RET_SUCCESS;
+}
+
+#ifdef AUTH_MODE_CERT
+/**
+ * @brief Update sha256 with content of file.
+ *
+ * @param[in,out] sha256 sha256 context started
+ * @param[in] path file path
+ * @return @see IotReturnCode
+ */
+static int _mbedtls_tls_file_hash(mbedtls_sha256_context *sha256, const char *path)
+{
+    unsigned char buf[256];
+    size_t        len;
+    int           rc = 0;
+
+    FILE *fp = fopen(path, "rb");
+    if (!fp) {
+        Log_e("open %s failed", STRING_PTR_PRINT_SANITY_CHECK(path));
+        return QCLOUD_ERR_FAILURE;
+    }
+
+    while (!rc && (len = fread(buf, 1, sizeof(buf), fp)) > 0) {
+        rc = mbedtls_sha256_update_ret(sha256, buf, len);
+    }
+    rc = rc || ferror(fp) ? QCLOUD_ERR_FAILURE : QCLOUD_RET_SUCCESS;
+    fclose(fp);
+    mbedtls_platform_zeroize(buf, sizeof(buf));
+    return rc;
+}
+#endif
+
+/**
+ * @brief Build cache key from credential, ca is compared by content for it may be changed in the same buffer. Cert
+ * and key files are compared by path and hash of content, so files rotated in the same path get a new config, while
+ * connections using the old one keep it until they disconnect.
+ *
+ * @param[in] connect_params device info for TLS connection
+ * @param[out] key_len length of key
+ * @return key malloc, NULL for fail
+ */
+static unsigned char *_mbedtls_tls_config_key(const TLSConnectParams *connect_params, size_t *key_len)
+{
+    unsigned char *key;
+
 #ifdef AUTH_MODE_CERT
+    size_t ca_len = connect_params->ca_crt_len, cert_len, key_file_len;
+
+    mbedtls_sha256_context sha256;
+    unsigned char          file_hash[32];
+    int                    rc;
+
     if (!connect_params->cert_file || !connect_params->key_file || !connect_params->ca_crt) {
         Log_d("cert_file/key_file/ca is empty!|cert_file=%s|key_file=%s|ca=%s",
               STRING_PTR_PRINT_SANITY_CHECK(connect_params->cert_file),
               STRING_PTR_PRINT_SANITY_CHECK(connect_params->key_file),
               STRING_PTR_PRINT_SANITY_CHECK(connect_params->ca_crt));
-        return QCLOUD_ERR_SSL_CERT;
+        return NULL;
+    }
+
+    mbedtls_sha256_init(&sha256);
+    rc = mbedtls_sha256_starts_ret(&sha256, 0);
+    rc = rc ? rc : _mbedtls_tls_file_hash(&sha256, connect_params->cert_file);
+    rc = rc ? rc : _mbedtls_tls_file_hash(&sha256, connect_params->key_file);
+    rc = rc ? rc : mbedtls_sha256_finish_ret(&sha256, file_hash);
+    mbedtls_sha256_free(&sha256);
+    if (rc) {
+        return NULL;
+    }
+
+    cert_len     = strlen(connect_params->cert_file) + 1;
+    key_file_len = strlen(connect_params->key_file) + 1;
+    *key_len     = ca_len + cert_len + key_file_len + sizeof(file_hash);
+
+    key = HAL_Malloc(*key_len);
+    if (!key) {
+        return NULL;
+    }
+    memcpy(key, connect_params->ca_crt, ca_len);
+    memcpy(key + ca_len, connect_params->cert_file, cert_len);
+    memcpy(key + ca_len + cert_len, connect_params->key_file, key_file_len);
+    memcpy(key + ca_len + cert_len + key_file_len, file_hash, sizeof(file_hash));
+#else
+    size_t psk_id_len;
+
+    if (!connect_params->psk || !connect_params->psk_id) {
+        Log_d("psk/psk_id is empty!");
+        return NULL;
+    }
+
+    psk_id_len = strlen(connect_params->psk_id) + 1;
+    *key_len   = psk_id_len + connect_params->psk_length;
+
+    key = HAL_Malloc(*key_len);
+    if (!key) {
+        return NULL;
+    }
+    memcpy(key, connect_params->psk_id, psk_id_len);
+    memcpy(key + psk_id_len, connect_params->psk, connect_params->psk_length);
+#endif
+    return key;
+}
+
+#ifdef AUTH_MODE_CERT
+/**
+ * @brief verify server certificate
+ *
+ * mbedtls has provided similar function mbedtls_x509_crt_verify_with_profile
+ */
+int _mbedtls_tls_client_certificate_verify(void *hostname, mbedtls_x509_crt *crt, int depth, uint32_t *flags)
+{
+    return *flags;
+}
+
+/**
+ * @brief Decrypt with rsa private key shared, for rsa alt key.
+ *
+ * @param[in] ctx @see TLSConfig
+ * @return 0 for success, or mbedtls error code
+ */
+static int _mbedtls_tls_rsa_decrypt(void *ctx, int mode, size_t *olen, const unsigned char *input,
+                                    unsigned char *output, size_t output_max_len)
+{
+    int rc;
+
+    TLSConfig *config = (TLSConfig *)ctx;
+
+    HAL_MutexLock(config->sign_lock);
+    rc = mbedtls_rsa_pkcs1_decrypt(mbedtls_pk_rsa(config->private_key), _mbedtls_tls_context_random, NULL, mode, olen,
+                                   input, output, output_max_len);
+    HAL_MutexUnlock(config->sign_lock);
+    return rc;
+}
+
+/**
+ * @brief Sign with rsa private key shared, for rsa alt key. Only the private key operation is serialized, so
+ * handshakes of connections sharing the config run in parallel.
+ *
+ * @param[in] ctx @see TLSConfig
+ * @return 0 for success, or mbedtls error code
+ */
+static int _mbedtls_tls_rsa_sign(void *ctx, int (*f_rng)(void *, unsigned char *, size_t), void *p_rng, int mode,
+                                 mbedtls_md_type_t md_alg, unsigned int hashlen, const unsigned char *hash,
+                                 unsigned char *sig)
+{
+    int rc;
+
+    TLSConfig *config = (TLSConfig *)ctx;
+
+    HAL_MutexLock(config->sign_lock);
+    rc = mbedtls_rsa_pkcs1_sign(mbedtls_pk_rsa(config->private_key), f_rng, p_rng, mode, md_alg, hashlen, hash, sig);
+    HAL_MutexUnlock(config->sign_lock);
+    return rc;
+}
+
+/**
+ * @brief Key length of rsa private key shared, for rsa alt key.
+ *
+ * @param[in] ctx @see TLSConfig
+ * @return key length in bytes
+ */
+static size_t _mbedtls_tls_rsa_key_len(void *ctx)
+{
+    TLSConfig *config = (TLSConfig *)ctx;
+    return mbedtls_rsa_get_len(mbedtls_pk_rsa(config->private_key));
+}
+
+/**
+ * @brief Setup key to sign in handshakes running in parallel, private key is not thread safe without
+ * MBEDTLS_THREADING_C. Rsa key is wrapped to sign with lock. Ecdsa signing only reads the key once comb table of
+ * generator is cached in group, so it is precomputed here. Tls context should be locked.
+ *
+ * @param[in,out] config @see TLSConfig
+ * @param[out] sign_key key for ssl config
+ * @return 0 for success, or mbedtls error code
+ */
+static int _mbedtls_tls_sign_key_setup(TLSConfig *config, mbedtls_pk_context **sign_key)
+{
+    int                  rc;
+    mbedtls_ecp_keypair *ec;
+    mbedtls_ecp_point    point;
+
+    switch (mbedtls_pk_get_type(&config->private_key)) {
+        case MBEDTLS_PK_RSA:
+            *sign_key = &config->sign_key;
+            return mbedtls_pk_setup_rsa_alt(&config->sign_key, config, _mbedtls_tls_rsa_decrypt, _mbedtls_tls_rsa_sign,
+                                            _mbedtls_tls_rsa_key_len);
+        case MBEDTLS_PK_ECKEY:
+        case MBEDTLS_PK_ECKEY_DH:
+        case MBEDTLS_PK_ECDSA:
+            *sign_key = &config->private_key;
+            ec        = mbedtls_pk_ec(config->private_key);
+            mbedtls_ecp_point_init(&point);
+            rc = mbedtls_ecp_mul(&ec->grp, &point, &ec->d, &ec->grp.G, mbedtls_ctr_drbg_random,
+                                 &sg_tls_context.ctr_drbg);
+            mbedtls_ecp_point_free(&point);
+            return rc;
+        default:
+            return MBEDTLS_ERR_PK_TYPE_MISMATCH;
+    }
+}
+#endif
+
+/**
+ * @brief Free tls config.
+ *
+ * @param[in,out] config @see TLSConfig
+ */
+static void _mbedtls_tls_config_free(TLSConfig *config)
+{
+#ifdef AUTH_MODE_CERT
+    mbedtls_x509_crt_free(&config->client_cert);
+    mbedtls_x509_crt_free(&config->ca_cert);
+    mbedtls_pk_free(&config->sign_key);
+    mbedtls_pk_free(&config->private_key);
+    if (config->sign_lock) {
+        HAL_MutexDestroy(config->sign_lock);
+    }
+#endif
+    mbedtls_ssl_config_free(&config->ssl_conf);
+    // psk in key should not be left in heap
+    memset(config->key, 0, config->key_len);
+    HAL_Free(config->key);
+    HAL_Free(config);
+}
+
+/**
+ * @brief Create tls config, load CA file, cert files or PSK.
+ *
+ * @param[in] connect_params device info for TLS connection
+ * @return @see TLSConfig, NULL for fail
+ */
+static TLSConfig *_mbedtls_tls_config_new(const TLSConnectParams *connect_params)
+{
+    int rc;
+#ifdef AUTH_MODE_CERT
+    mbedtls_pk_context *sign_key;
+#endif
+
+    TLSConfig *config = HAL_Malloc(sizeof(TLSConfig));
+    if (!config) {
+        return NULL;
+    }
+    memset(config, 0, sizeof(TLSConfig));
+
+    mbedtls_ssl_config_init(&config->ssl_conf);
+#ifdef AUTH_MODE_CERT
+    mbedtls_x509_crt_init(&config->ca_cert);
+    mbedtls_x509_crt_init(&config->client_cert);
+    mbedtls_pk_init(&config->private_key);
+    mbedtls_pk_init(&config->sign_key);
+#endif
+
+    config->key = _mbedtls_tls_config_key(connect_params, &config->key_len);
+    if (!config->key) {
+        goto error;
     }
 
-    rc = mbedtls_x509_crt_parse(&tls_handle->ca_cert, (const unsigned char *)connect_params->ca_crt,
+    rc = mbedtls_ssl_config_defaults(&config->ssl_conf, MBEDTLS_SSL_IS_CLIENT, MBEDTLS_SSL_TRANSPORT_STREAM,
+                                     MBEDTLS_SSL_PRESET_DEFAULT);
+    if (rc) {
+        Log_e("mbedtls_ssl_config_defaults failed returned 0x%04x", -rc);
+        goto error;
+    }
+
+    mbedtls_ssl_conf_rng(&config->ssl_conf, _mbedtls_tls_context_random, NULL);
+#ifdef MBEDTLS_DEBUG_C
+    mbedtls_debug_set_threshold(DEBUG_LEVEL);
+    mbedtls_ssl_conf_dbg(&config->ssl_conf, _ssl_debug, NULL);
+#endif
+
+#if defined(TLS_MAX_FRAG_LEN) && defined(MBEDTLS_SSL_MAX_FRAGMENT_LENGTH)
+    rc = mbedtls_ssl_conf_max_frag_len(&config->ssl_conf, TLS_MAX_FRAG_LEN_CODE);
+    if (rc) {
+        Log_e("mbedtls_ssl_conf_max_frag_len failed returned 0x%04x", -rc);
+        goto error;
+    }
+#endif
+
+#ifdef AUTH_MODE_CERT
+    rc = mbedtls_x509_crt_parse(&config->ca_cert, (const unsigned char *)connect_params->ca_crt,
                                 (connect_params->ca_crt_len + 1));
     if (rc) {
         Log_e("parse ca crt failed returned 0x%04x", -rc);
-        return QCLOUD_ERR_SSL_CERT;
+        goto error;
     }
 
-    rc = mbedtls_x509_crt_parse_file(&tls_handle->client_cert, connect_params->cert_file);
+    rc = mbedtls_x509_crt_parse_file(&config->client_cert, connect_params->cert_file);
     if (rc) {
         Log_e("load client cert file failed returned 0x%04x", -rc);
-        return QCLOUD_ERR_SSL_CERT;
+        goto error;
     }
 
-    rc = mbedtls_pk_parse_keyfile(&tls_handle->private_key, connect_params->key_file, "");
+    rc = mbedtls_pk_parse_keyfile(&config->private_key, connect_params->key_file, "");
     if (rc) {
         Log_e("load client key file failed returned 0x%04x", -rc);
-        return QCLOUD_ERR_SSL_CERT;
+        goto error;
     }
-#else
-    if (!connect_params->psk || !connect_params->psk_id) {
-        Log_d("psk/psk_id is empty!");
-        return QCLOUD_ERR_SSL_INIT;
+
+    config->sign_lock = HAL_MutexCreate();
+    if (!config->sign_lock) {
+        goto error;
+    }
+
+    rc = _mbedtls_tls_sign_key_setup(config, &sign_key);
+    if (rc) {
+        Log_e("setup sign key failed returned 0x%04x", -rc);
+        goto error;
     }
 
-    rc = mbedtls_ssl_conf_psk(&tls_handle->ssl_conf, (unsigned char *)connect_params->psk, connect_params->psk_length,
+    mbedtls_ssl_conf_verify(&config->ssl_conf, _mbedtls_tls_client_certificate_verify, NULL);
+    mbedtls_ssl_conf_authmode(&config->ssl_conf, MBEDTLS_SSL_VERIFY_REQUIRED);
+    mbedtls_ssl_conf_ca_chain(&config->ssl_conf, &config->ca_cert, NULL);
+    rc = mbedtls_ssl_conf_own_cert(&config->ssl_conf, &config->client_cert, sign_key);
+    if (rc) {
+        Log_e("mbedtls_ssl_conf_own_cert failed returned 0x%04x", -rc);
+        goto error;
+    }
+#else
+    rc = mbedtls_ssl_conf_psk(&config->ssl_conf, (unsigned char *)connect_params->psk, connect_params->psk_length,
                               (const unsigned char *)connect_params->psk_id, strlen(connect_params->psk_id));
     if (rc) {
         Log_e("mbedtls_ssl_conf_psk fail 0x%04x", -rc);
-        return rc;
+        goto error;
     }
+
+    // ciphersuites selection for PSK device
+    mbedtls_ssl_conf_ciphersuites(&config->ssl_conf, ciphersuites);
 #endif
-    return QCLOUD_RET_SUCCESS;
+    return config;
+
+error:
+    _mbedtls_tls_config_free(config);
+    return NULL;
+}
+
+/**
+ * @brief Get tls config of credential from cache, created if not found.
+ *
+ * @param[in] connect_params device info for TLS connection
+ * @return @see TLSConfig, NULL for fail
+ */
+static TLSConfig *_mbedtls_tls_config_get(const TLSConnectParams *connect_params)
+{
+    TLSConfig **prev, *config = NULL;
+
+    unsigned char *key;
+    size_t         key_len;
+
+    if (_mbedtls_tls_context_lock()) {
+        return NULL;
+    }
+
+    if (_mbedtls_tls_context_seed()) {
+        goto exit;
+    }
+
+    key = _mbedtls_tls_config_key(connect_params, &key_len);
+    if (!key) {
+        goto exit;
+    }
+
+    for (prev = &sg_tls_context.config_list; *prev; prev = &(*prev)->next) {
+        if ((*prev)->key_len == key_len && !memcmp((*prev)->key, key, key_len)) {
+            config = *prev;
+            *prev  = config->next;
+            break;
+        }
+    }
+    memset(key, 0, key_len);
+    HAL_Free(key);
+
+    if (!config) {
+        config = _mbedtls_tls_config_new(connect_params);
+        if (!config) {
+            goto exit;
+        }
+    } else if (!config->ref_count) {
+        sg_tls_context.idle_num--;
+    }
+
+    config->ref_count++;
+    config->next               = sg_tls_context.config_list;
+    sg_tls_context.config_list = config;
+exit:
+    _mbedtls_tls_context_unlock();
+    return config;
+}
+
+/**
+ * @brief Release tls config, least recently used configs are freed if too many are idle.
+ *
+ * @param[in,out] config @see TLSConfig
+ */
+static void _mbedtls_tls_config_put(TLSConfig *config)
+{
+    TLSConfig **prev, **last_idle = NULL;
+
+    _mbedtls_tls_context_lock();
+    if (--config->ref_count) {
+        _mbedtls_tls_context_unlock();
+        return;
+    }
+
+    sg_tls_context.idle_num++;
+    while (sg_tls_context.idle_num > TLS_CONFIG_IDLE_MAX_NUM) {
+        for (prev = &sg_tls_context.config_list; *prev; prev = &(*prev)->next) {
+            last_idle = (*prev)->ref_count ? last_idle : prev;
+        }
+
+        config     = *last_idle;
+        *last_idle = config->next;
+        _mbedtls_tls_config_free(config);
+        sg_tls_context.idle_num--;
+    }
+    _mbedtls_tls_context_unlock();
 }
 
 /**
@@ -161,74 +663,170 @@ static int _mbedtls_tls_client_init(TLSHandle *tls_handle, const TLSConnectParam
  */
 static void _mbedtls_tls_client_free(TLSHandle *tls_handle)
 {
-    mbedtls_net_free(&(tls_handle->socket_fd));
-#ifdef AUTH_MODE_CERT
-    mbedtls_x509_crt_free(&tls_handle->client_cert);
-    mbedtls_x509_crt_free(&tls_handle->ca_cert);
-    mbedtls_pk_free(&tls_handle->private_key);
-#endif
+    if (tls_handle->socket_fd.fd >= 0) {
+        HAL_TCP_Disconnect(tls_handle->socket_fd.fd);
+    }
     mbedtls_ssl_free(&tls_handle->ssl);
-    mbedtls_ssl_config_free(&tls_handle->ssl_conf);
-    mbedtls_ctr_drbg_free(&tls_handle->ctr_drbg);
-    mbedtls_entropy_free(&tls_handle->entropy);
+    if (tls_handle->config) {
+        _mbedtls_tls_config_put(tls_handle->config);
+    }
     HAL_Free(tls_handle);
 }
 
-#ifdef AUTH_MODE_CERT
 /**
- * @brief verify server certificate
+ * @brief Send for mbedtls bio, HAL_TCP_Write is used for socket of HAL_TCP_Connect is nonblocking.
  *
- * mbedtls has provided similar function mbedtls_x509_crt_verify_with_profile
+ * @param[in] ctx @see TLSHandle
+ * @param[in] buf data to send
+ * @param[in] len data len
+ * @return length of data sent, or mbedtls error code
  */
-int _mbedtls_tls_client_certificate_verify(void *hostname, mbedtls_x509_crt *crt, int depth, uint32_t *flags)
+static int _mbedtls_net_send(void *ctx, const unsigned char *buf, size_t len)
 {
-    return *flags;
+    int    rc;
+    size_t write_len = 0;
+
+    TLSHandle *tls_handle = (TLSHandle *)ctx;
+
+    rc = HAL_TCP_Write(tls_handle->socket_fd.fd, buf, len, INT_MAX, &write_len);
+    switch (rc) {
+        case QCLOUD_RET_SUCCESS:
+            return (int)write_len;
+        case QCLOUD_ERR_TCP_WRITE_TIMEOUT:
+            return MBEDTLS_ERR_SSL_WANT_WRITE;
+        default:
+            return MBEDTLS_ERR_NET_SEND_FAILED;
+    }
 }
-#endif
 
 /**
- * @brief Tls setup and sharkhand
+ * @brief Receive with timeout for mbedtls bio, HAL_TCP_Recv is used instead of mbedtls_net_recv_timeout for select
+ * of which fails on fd larger than FD_SETSIZE. Timeout is kept in handle for ssl config is shared by connections.
+ *
+ * @param[in] ctx @see TLSHandle
+ * @param[out] buf buffer to save data
+ * @param[in] len buffer len
+ * @param[in] timeout_ms unused, read_timeout_ms of handle is used, 0 for no waiting
+ * @return length of data read, or mbedtls error code
+ */
+static int _mbedtls_net_recv_timeout(void *ctx, unsigned char *buf, size_t len, uint32_t timeout_ms)
+{
+    int    rc;
+    size_t read_len = 0;
+
+    TLSHandle *tls_handle = (TLSHandle *)ctx;
+
+    rc = HAL_TCP_Recv(tls_handle->socket_fd.fd, buf, len, tls_handle->read_timeout_ms, &read_len);
+    switch (rc) {
+        case QCLOUD_RET_SUCCESS:
+            return (int)read_len;
+        case QCLOUD_ERR_TCP_NOTHING_TO_READ:
+            return MBEDTLS_ERR_SSL_TIMEOUT;
+        case QCLOUD_ERR_TCP_PEER_SHUTDOWN:
+            return 0;
+        default:
+            return MBEDTLS_ERR_NET_RECV_FAILED;
+    }
+}
+
+/**
+ * @brief Get session saved for host:port.
  *
  * @param[in] connect_params connect params of tls
  * @param[in] host server host
  * @param[in] port server port
+ * @return session saved, NULL for none
+ */
+static const mbedtls_ssl_session *_mbedtls_tls_client_session_get(const TLSConnectParams *connect_params,
+                                                                  const char *host, const char *port)
+{
+    char        peer[TLS_SESSION_PEER_LEN];
+    TLSSession *saved = (TLSSession *)connect_params->session;
+
+    if (!connect_params->session_resume_enable || !saved) {
+        return NULL;
+    }
+
+    HAL_Snprintf(peer, sizeof(peer), "%s:%s", STRING_PTR_PRINT_SANITY_CHECK(host), STRING_PTR_PRINT_SANITY_CHECK(port));
+    return strcmp(peer, saved->peer) ? NULL : &saved->session;
+}
+
+/**
+ * @brief Save session negotiated for resumption of next connect.
+ *
+ * @param[in,out] connect_params connect params of tls
+ * @param[in] ssl ssl context after handshake
+ * @param[in] host server host
+ * @param[in] port server port
+ */
+static void _mbedtls_tls_client_session_save(TLSConnectParams *connect_params, const mbedtls_ssl_context *ssl,
+                                             const char *host, const char *port)
+{
+    int         rc;
+    TLSSession *saved = (TLSSession *)connect_params->session;
+
+    if (!connect_params->session_resume_enable) {
+        return;
+    }
+
+    if (!saved) {
+        saved = HAL_Malloc(sizeof(TLSSession));
+        if (!saved) {
+            return;
+        }
+        mbedtls_ssl_session_init(&saved->session);
+        connect_params->session = (uintptr_t)saved;
+    }
+
+    // ticket of old session is freed before overwritten
+    mbedtls_ssl_session_free(&saved->session);
+    mbedtls_ssl_session_init(&saved->session);
+
+    rc = HAL_Snprintf(saved->peer, sizeof(saved->peer), "%s:%s", STRING_PTR_PRINT_SANITY_CHECK(host),
+                      STRING_PTR_PRINT_SANITY_CHECK(port));
+    if (rc < 0 || (size_t)rc >= sizeof(saved->peer)) {
+        qcloud_iot_tls_client_session_free(connect_params);
+        return;
+    }
+
+    rc = mbedtls_ssl_get_session(ssl, &saved->session);
+    if (rc) {
+        Log_w("mbedtls_ssl_get_session failed returned 0x%04x", -rc);
+        qcloud_iot_tls_client_session_free(connect_params);
+    }
+}
+
+/**
+ * @brief Tls setup and sharkhand, abbreviated handshake is tried if session is saved and resume is enabled. Drbg
+ * and ssl config with parsed credential are shared by connections, only ssl context is allocated for each one.
+ *
+ * @param[in,out] connect_params connect params of tls, session is updated after handshake if resume is enabled
+ * @param[in] host server host
+ * @param[in] port server port
  * @return tls handle, 0 for fail
  */
-uintptr_t qcloud_iot_tls_client_connect(const TLSConnectParams *connect_params, const char *host, const char *port)
+uintptr_t qcloud_iot_tls_client_connect(TLSConnectParams *connect_params, const char *host, const char *port)
 {
     int rc = 0;
 
+    const mbedtls_ssl_session *saved_session;
+
     TLSHandle *tls_handle = (TLSHandle *)HAL_Malloc(sizeof(TLSHandle));
     if (!tls_handle) {
         return 0;
     }
 
-    rc = _mbedtls_tls_client_init(tls_handle, connect_params);
-    if (rc) {
-        goto error;
-    }
+    mbedtls_net_init(&tls_handle->socket_fd);
+    mbedtls_ssl_init(&tls_handle->ssl);
+    tls_handle->read_timeout_ms = connect_params->timeout_ms;
 
-    Log_d("Setting up the SSL/TLS structure...");
-    rc = mbedtls_ssl_config_defaults(&tls_handle->ssl_conf, MBEDTLS_SSL_IS_CLIENT, MBEDTLS_SSL_TRANSPORT_STREAM,
-                                     MBEDTLS_SSL_PRESET_DEFAULT);
-    if (rc) {
-        Log_e("mbedtls_ssl_config_defaults failed returned 0x%04x", -rc);
+    tls_handle->config = _mbedtls_tls_config_get(connect_params);
+    if (!tls_handle->config) {
         goto error;
     }
 
-    mbedtls_ssl_conf_rng(&tls_handle->ssl_conf, mbedtls_ctr_drbg_random, &tls_handle->ctr_drbg);
-#ifdef AUTH_MODE_CERT
-    mbedtls_ssl_conf_verify(&(tls_handle->ssl_conf), _mbedtls_tls_client_certificate_verify, (void *)host);
-    mbedtls_ssl_conf_authmode(&(tls_handle->ssl_conf), MBEDTLS_SSL_VERIFY_REQUIRED);
-    mbedtls_ssl_conf_ca_chain(&tls_handle->ssl_conf, &tls_handle->ca_cert, NULL);
-    rc = mbedtls_ssl_conf_own_cert(&tls_handle->ssl_conf, &tls_handle->client_cert, &tls_handle->private_key);
-    if (rc) {
-        Log_e("mbedtls_ssl_conf_own_cert failed returned 0x%04x", -rc);
-        goto error;
-    }
-#endif
-    mbedtls_ssl_conf_read_timeout(&tls_handle->ssl_conf, connect_params->timeout_ms);
-    rc = mbedtls_ssl_setup(&tls_handle->ssl, &tls_handle->ssl_conf);
+    Log_d("Setting up the SSL/TLS structure...");
+    rc = mbedtls_ssl_setup(&tls_handle->ssl, &tls_handle->config->ssl_conf);
     if (rc) {
         Log_e("mbedtls_ssl_setup failed returned 0x%04x", -rc);
         goto error;
@@ -240,34 +838,44 @@ uintptr_t qcloud_iot_tls_client_connect(const TLSConnectParams *connect_params,
         Log_e("mbedtls_ssl_set_hostname failed returned 0x%04x", -rc);
         goto error;
     }
-#else
-    // ciphersuites selection for PSK device
-    if (connect_params->psk) {
-        mbedtls_ssl_conf_ciphersuites(&(tls_handle->ssl_conf), ciphersuites);
-    }
 #endif
-    mbedtls_ssl_set_bio(&tls_handle->ssl, &tls_handle->socket_fd, mbedtls_net_send, mbedtls_net_recv,
-                        mbedtls_net_recv_timeout);
+    mbedtls_ssl_set_bio(&tls_handle->ssl, tls_handle, _mbedtls_net_send, NULL, _mbedtls_net_recv_timeout);
+
+    // offer session saved, server does a full handshake if it does not accept
+    saved_session = _mbedtls_tls_client_session_get(connect_params, host, port);
+    if (saved_session) {
+        rc = mbedtls_ssl_set_session(&tls_handle->ssl, saved_session);
+        if (rc) {
+            Log_w("mbedtls_ssl_set_session failed returned 0x%04x", -rc);
+        }
+    }
+
     Log_d("Performing the SSL/TLS handshake...");
     Log_d("Connecting to /%s/%s...", STRING_PTR_PRINT_SANITY_CHECK(host), STRING_PTR_PRINT_SANITY_CHECK(port));
-    rc = mbedtls_net_connect(&tls_handle->socket_fd, host, port, MBEDTLS_NET_PROTO_TCP);
-    if (rc < 0) {
+    // HAL_TCP_Connect instead of mbedtls_net_connect, to use dns cache, parallel connect and standby connection
+    tls_handle->socket_fd.fd = HAL_TCP_Connect(host, port);
+    if (tls_handle->socket_fd.fd < 0) {
+        Log_e("HAL_TCP_Connect failed returned %d", tls_handle->socket_fd.fd);
         goto error;
     }
 
+    // private key shared is locked only when signing, @see _mbedtls_tls_sign_key_setup
     do {
         rc = mbedtls_ssl_handshake(&tls_handle->ssl);
-        if (rc && rc != MBEDTLS_ERR_SSL_WANT_READ && rc != MBEDTLS_ERR_SSL_WANT_WRITE) {
-            Log_e("mbedtls_ssl_handshake failed returned 0x%04x", -rc);
+    } while (rc == MBEDTLS_ERR_SSL_WANT_READ || rc == MBEDTLS_ERR_SSL_WANT_WRITE);
+
+    if (rc) {
+        Log_e("mbedtls_ssl_handshake failed returned 0x%04x", -rc);
+        // full handshake next time
+        qcloud_iot_tls_client_session_free(connect_params);
 
 #ifdef AUTH_MODE_CERT
-            if (rc == MBEDTLS_ERR_X509_CERT_VERIFY_FAILED) {
-                Log_e("Unable to verify the server's certificate");
-            }
-#endif
-            goto error;
+        if (rc == MBEDTLS_ERR_X509_CERT_VERIFY_FAILED) {
+            Log_e("Unable to verify the server's certificate");
         }
-    } while (rc);
+#endif
+        goto error;
+    }
 
     rc = mbedtls_ssl_get_verify_result(&(tls_handle->ssl));
     if (rc) {
@@ -275,7 +883,7 @@ uintptr_t qcloud_iot_tls_client_connect(const TLSConnectParams *connect_params,
         goto error;
     }
 
-    mbedtls_ssl_conf_read_timeout(&tls_handle->ssl_conf, 200);
+    _mbedtls_tls_client_session_save(connect_params, &tls_handle->ssl, host, port);
 
     Log_d("connected with /%s/%s...", STRING_PTR_PRINT_SANITY_CHECK(host), port);
     return (uintptr_t)tls_handle;
@@ -285,6 +893,23 @@ error:
     return 0;
 }
 
+/**
+ * @brief Free tls session saved in connect params.
+ *
+ * @param[in,out] connect_params connect params of tls
+ */
+void qcloud_iot_tls_client_session_free(TLSConnectParams *connect_params)
+{
+    TLSSession *saved = (TLSSession *)connect_params->session;
+    if (!saved) {
+        return;
+    }
+
+    mbedtls_ssl_session_free(&saved->session);
+    HAL_Free(saved);
+    connect_params->session = 0;
+}
+
 /**
  * @brief Disconect and free
  *
@@ -347,6 +972,64 @@ int qcloud_iot_tls_client_write(uintptr_t handle, unsigned char *msg, size_t tot
     return QCLOUD_RET_SUCCESS;
 }
 
+/**
+ * @brief Write data segments with tls, small segments are coalesced to avoid tiny records.
+ *
+ * @param[in,out] handle tls handle
+ * @param[in] iov data segments to write
+ * @param[in] iovcnt count of data segments
+ * @param[in] timeout_ms timeout millsecond
+ * @param[out] written_len number of bytes writtern
+ * @return @see IotReturnCode
+ */
+int qcloud_iot_tls_client_writev(uintptr_t handle, const IotIoVec *iov, int iovcnt, uint32_t timeout_ms,
+                                 size_t *written_len)
+{
+    Timer          timer;
+    int            rc = QCLOUD_RET_SUCCESS, i;
+    size_t         len, fill_len, coalesce_len = 0, sent_len = 0;
+    const uint8_t *data;
+    unsigned char  coalesce_buf[TLS_WRITEV_COALESCE_LEN];
+
+    *written_len = 0;
+    HAL_Timer_CountdownMs(&timer, (unsigned int)timeout_ms);
+
+    // each ssl write produces at least one record, so small segments share the record with head of next segment
+    for (i = 0; i < iovcnt && !rc; i++) {
+        data = (const uint8_t *)iov[i].base;
+        len  = iov[i].len;
+        if (coalesce_len + len <= sizeof(coalesce_buf)) {
+            memcpy(coalesce_buf + coalesce_len, data, len);
+            coalesce_len += len;
+            continue;
+        }
+
+        if (coalesce_len) {
+            fill_len = sizeof(coalesce_buf) - coalesce_len;
+            memcpy(coalesce_buf + coalesce_len, data, fill_len);
+            data += fill_len;
+            len -= fill_len;
+            coalesce_len = 0;
+
+            rc = qcloud_iot_tls_client_write(handle, coalesce_buf, sizeof(coalesce_buf), HAL_Timer_Remain(&timer),
+                                             &sent_len);
+            *written_len += sent_len;
+            if (rc) {
+                break;
+            }
+        }
+
+        rc = qcloud_iot_tls_client_write(handle, (unsigned char *)data, len, HAL_Timer_Remain(&timer), &sent_len);
+        *written_len += sent_len;
+    }
+
+    if (!rc && coalesce_len) {
+        rc = qcloud_iot_tls_client_write(handle, coalesce_buf, coalesce_len, HAL_Timer_Remain(&timer), &sent_len);
+        *written_len += sent_len;
+    }
+    return rc;
+}
+
 /**
  * @brief Read msg with tls
  *
@@ -369,7 +1052,9 @@ int qcloud_iot_tls_client_read(uintptr_t handle, unsigned char *msg, size_t tota
     *read_len = 0;
 
     do {
-        read_rc = mbedtls_ssl_read(&tls_handle->ssl, msg + *read_len, total_len - *read_len);
+        // data decrypted is returned without waiting, otherwise wait on socket for exactly the remaining time
+        tls_handle->read_timeout_ms = HAL_Timer_Remain(&timer);
+        read_rc                     = mbedtls_ssl_read(&tls_handle->ssl, msg + *read_len, total_len - *read_len);
         if (read_rc <= 0 && read_rc != MBEDTLS_ERR_SSL_WANT_WRITE && read_rc != MBEDTLS_ERR_SSL_WANT_READ &&
             read_rc != MBEDTLS_ERR_SSL_TIMEOUT) {
             Log_e("cloud_iot_network_tls_read failed: 0x%04x", -read_rc);
@@ -389,6 +1074,70 @@ int qcloud_iot_tls_client_read(uintptr_t handle, unsigned char *msg, size_t tota
     return *read_len == 0 ? QCLOUD_ERR_SSL_NOTHING_TO_READ : QCLOUD_ERR_SSL_READ_TIMEOUT;
 }
 
+/**
+ * @brief Receive msg with tls, return as soon as any data is read instead of waiting for total_len bytes.
+ *
+ * @param[in,out] handle tls handle
+ * @param[out] msg msg buffer
+ * @param[in] total_len buffer len
+ * @param[in] timeout_ms timeout millsecond
+ * @param[out] read_len number of bytes read
+ * @return @see IotReturnCode
+ */
+int qcloud_iot_tls_client_recv(uintptr_t handle, unsigned char *msg, size_t total_len, uint32_t timeout_ms,
+                               size_t *read_len)
+{
+    Timer timer;
+    int   read_rc;
+
+    TLSHandle *tls_handle = (TLSHandle *)handle;
+    HAL_Timer_CountdownMs(&timer, timeout_ms);
+
+    *read_len = 0;
+
+    do {
+        // data decrypted is returned without waiting, otherwise wait on socket for exactly the remaining time
+        tls_handle->read_timeout_ms = HAL_Timer_Remain(&timer);
+        read_rc                     = mbedtls_ssl_read(&tls_handle->ssl, msg, total_len);
+        if (read_rc > 0) {
+            *read_len = read_rc;
+            return QCLOUD_RET_SUCCESS;
+        }
+
+        if (read_rc != MBEDTLS_ERR_SSL_WANT_WRITE && read_rc != MBEDTLS_ERR_SSL_WANT_READ &&
+            read_rc != MBEDTLS_ERR_SSL_TIMEOUT) {
+            Log_e("cloud_iot_network_tls_recv failed: 0x%04x", -read_rc);
+            return QCLOUD_ERR_SSL_READ;
+        }
+    } while (!HAL_Timer_Expired(&timer));
+
+    return QCLOUD_ERR_SSL_NOTHING_TO_READ;
+}
+
+/**
+ * @brief Get socket fd of tls connection.
+ *
+ * @param[in] handle tls handle
+ * @return socket fd, -1 for no connection
+ */
+int qcloud_iot_tls_client_get_fd(uintptr_t handle)
+{
+    TLSHandle *tls_handle = (TLSHandle *)handle;
+    return tls_handle ? tls_handle->socket_fd.fd : -1;
+}
+
+/**
+ * @brief Get length of data decrypted but not read, which is not reported by socket readable event.
+ *
+ * @param[in] handle tls handle
+ * @return length of data buffered in tls
+ */
+size_t qcloud_iot_tls_client_get_bytes_avail(uintptr_t handle)
+{
+    TLSHandle *tls_handle = (TLSHandle *)handle;
+    return tls_handle ? mbedtls_ssl_get_bytes_avail(&tls_handle->ssl) : 0;
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -211,23 +211,13 @@ static void _usr_init(void)
 {
     usr_data_template_init();
 
-    DataTemplatePropertyValue value;
-    value.value_int = 0;
-    usr_data_template_property_value_set(USR_PROPERTY_INDEX_POWER_SWITCH, value);
-    value.value_enum = 0;
-    usr_data_template_property_value_set(USR_PROPERTY_INDEX_COLOR, value);
-    value.value_int = 10;
-    usr_data_template_property_value_set(USR_PROPERTY_INDEX_BRIGHTNESS, value);
-    value.value_string = "light";
-    usr_data_template_property_value_set(USR_PROPERTY_INDEX_NAME, value);
-    value.value_int = 30;
-    usr_data_template_property_struct_value_set(USR_PROPERTY_INDEX_POSITION, USR_PROPERTY_POSITION_INDEX_LONGITUDE,
-                                                value);
-    value.value_int = 30;
-    usr_data_template_property_struct_value_set(USR_PROPERTY_INDEX_POSITION, USR_PROPERTY_POSITION_INDEX_LATITUDE,
-                                                value);
-    value.value_string = "high";
-    usr_data_template_property_value_set(USR_PROPERTY_INDEX_POWER, value);
+    usr_data_template_property_power_switch_set(0);
+    usr_data_template_property_color_set(0);
+    usr_data_template_property_brightness_set(10);
+    usr_data_template_property_name_set("light");
+    usr_data_template_property_position_longitude_set(30);
+    usr_data_template_property_position_latitude_set(30);
+    usr_data_template_property_power_set("high");
 }
 
 // ----------------------------------------------------------------------------
@@ -28,6 +28,32 @@
 
 #include "data_template_config.h"
 
+/**
+ * @brief Tokens to index property json, properties beyond are found by scanning.
+ *
+ */
+#define PROPERTY_JSON_TOKEN_NUM 32
+
+static uint32_t _parse_property_array(const char* json_buf, int buf_len, DataTemplateProperty* properties,
+                                      int property_count, const DataTemplatePropertyHash* hash);
+
+/**
+ * @brief Copy string into buffer of property, truncated if buffer is not enough.
+ *
+ * @param[in,out] property pointer to property, string type
+ * @param[in] str string to copy
+ * @param[in] len string length
+ */
+static void _copy_property_string(DataTemplateProperty* property, const char* str, int len)
+{
+    if (len >= property->string_size) {
+        Log_w("%s is truncated to %d bytes!", property->key, property->string_size - 1);
+        len = property->string_size - 1;
+    }
+    memcpy(property->value.value_string, str, len);
+    property->value.value_string[len] = '\0';
+}
+
 /**
  * @brief Set property value.
  *
@@ -37,8 +63,6 @@
  */
 static int _set_property_value(DataTemplateProperty* property, UtilsJsonValue value)
 {
-    int i, rc = 0;
-
     switch (property->type) {
         case DATA_TEMPLATE_TYPE_INT:
         case DATA_TEMPLATE_TYPE_ENUM:
@@ -48,19 +72,18 @@ static int _set_property_value(DataTemplateProperty* property, UtilsJsonValue va
             return utils_json_value_data_get(value, UTILS_JSON_VALUE_TYPE_UINT32, &property->value.value_time);
         case DATA_TEMPLATE_TYPE_STRING:
         case DATA_TEMPLATE_TYPE_STRING_ENUM:
-            if (!property->value.value_string) {  // no need copy
+            if (!property->value.value_string || !property->string_size) {  // no need copy
                 return 0;
             }
-            strncpy(property->value.value_string, value.value, value.value_len);
-            property->value.value_string[value.value_len] = '\0';
+            _copy_property_string(property, value.value, value.value_len);
             return 0;
         case DATA_TEMPLATE_TYPE_FLOAT:
             return utils_json_value_data_get(value, UTILS_JSON_VALUE_TYPE_FLOAT, &property->value.value_float);
         case DATA_TEMPLATE_TYPE_STRUCT:
-            for (i = 0; i < property->value.value_struct.count; i++) {
-                rc |= _set_property_value(property->value.value_struct.property + i, value);
-            }
-            return rc;
+            return _parse_property_array(value.value, value.value_len, property->value.value_struct.property,
+                                         property->value.value_struct.count, property->value.value_struct.hash)
+                       ? 0
+                       : -1;
         case DATA_TEMPLATE_TYPE_ARRAY:
             Log_e("array type is not supportted yet!");
             return -1;
@@ -71,207 +94,232 @@ static int _set_property_value(DataTemplateProperty* property, UtilsJsonValue va
 }
 
 /**
- * @brief Get property node in json.
+ * @brief Write property node into json.
  *
- * @param[out] json_buf buffer to put node
- * @param[in] buf_len buffer length
- * @param[in] property property to get node
+ * @param[in,out] writer @see UtilsJsonWriter
+ * @param[in] property property to write
  * @return 0 for success.
  */
-static int _get_property_node(char* json_buf, int buf_len, const DataTemplateProperty* property)
+static int _write_property_node(UtilsJsonWriter* writer, const DataTemplateProperty* property)
 {
-    int len, i;
+    int i, rc = 0;
+
+    if ((property->type == DATA_TEMPLATE_TYPE_STRING || property->type == DATA_TEMPLATE_TYPE_STRING_ENUM) &&
+        !property->value.value_string) {
+        return 0;
+    }
+
+    utils_json_writer_key(writer, property->key, strlen(property->key));
     switch (property->type) {
         case DATA_TEMPLATE_TYPE_INT:
         case DATA_TEMPLATE_TYPE_ENUM:
         case DATA_TEMPLATE_TYPE_BOOL:
-            return HAL_Snprintf(json_buf, buf_len, "\"%s\":%d", property->key, property->value.value_int);
+            utils_json_writer_int(writer, property->value.value_int);
+            return 0;
         case DATA_TEMPLATE_TYPE_TIME:
-            return HAL_Snprintf(json_buf, buf_len, "\"%s\":%u", property->key, property->value.value_time);
+            utils_json_writer_uint(writer, property->value.value_time);
+            return 0;
         case DATA_TEMPLATE_TYPE_STRING:
         case DATA_TEMPLATE_TYPE_STRING_ENUM:
-            if (!property->value.value_string) {
-                return 0;
-            }
-            return HAL_Snprintf(json_buf, buf_len, "\"%s\":\"%s\"", property->key, property->value.value_string);
+            utils_json_writer_string(writer, property->value.value_string, strlen(property->value.value_string));
+            return 0;
         case DATA_TEMPLATE_TYPE_FLOAT:
-            return HAL_Snprintf(json_buf, buf_len, "\"%s\":%f", property->key, property->value.value_float);
+            utils_json_writer_float(writer, property->value.value_float);
+            return 0;
         case DATA_TEMPLATE_TYPE_STRUCT:
-            len = HAL_Snprintf(json_buf, buf_len, "\"%s\":{", property->key);
+            utils_json_writer_object_begin(writer);
             for (i = 0; i < property->value.value_struct.count; i++) {
-                len += _get_property_node(json_buf + len, buf_len - len, property->value.value_struct.property + i);
-                json_buf[len++] = ',';
+                rc |= _write_property_node(writer, property->value.value_struct.property + i);
             }
-            json_buf[--len] = '}';
-            return len + 1;
+            utils_json_writer_object_end(writer);
+            return rc;
         case DATA_TEMPLATE_TYPE_ARRAY:
             Log_e("array type is not supportted yet!");
+            utils_json_writer_null(writer);
             return -1;
         default:
             Log_e("unkown type!");
+            utils_json_writer_null(writer);
             return -1;
     }
 }
 
 /**
- * @brief Parse property array.
+ * @brief Hash key with seed, same as hash_key in tools/data_template_codegen.py.
  *
- * @param[in] json_buf json string to parse
- * @param[in] buf_len json len
- * @param[in,out] properties pointer to property array
- * @param[in] property_count count of property
+ * @param[in] key key
+ * @param[in] key_len key length
+ * @param[in] seed seed
+ * @return hash value
  */
-static void _parse_property_array(const char* json_buf, int buf_len, DataTemplateProperty* properties,
-                                  int property_count)
+static uint32_t _hash_property_key(const char* key, int key_len, uint32_t seed)
 {
-    DataTemplateProperty* property;
-    UtilsJsonValue        value;
-    for (int i = 0; i < property_count; i++) {
-        property = &properties[i];
-        if (!utils_json_value_get(property->key, strlen(property->key), json_buf, buf_len, &value)) {
-            property->need_report = !_set_property_value(property, value);
-        }
+    uint32_t hash = 2166136261U ^ seed;
+
+    for (int i = 0; i < key_len; i++) {
+        hash ^= (uint8_t)key[i];
+        hash *= 16777619U;
     }
+    hash ^= hash >> 16;
+    hash *= 0x7feb352dU;
+    hash ^= hash >> 15;
+    return hash;
 }
 
-/**************************************************************************************
- * user property
- **************************************************************************************/
+/**
+ * @brief Get property index of key by perfect hash, O(1) for any number of properties.
+ *
+ * @param[in] hash @see DataTemplatePropertyHash
+ * @param[in] properties property array hashed
+ * @param[in] key key
+ * @param[in] key_len key length
+ * @return index of property, -1 for not found
+ */
+static int _get_property_index(const DataTemplatePropertyHash* hash, const DataTemplateProperty* properties,
+                               const char* key, int key_len)
+{
+    uint16_t seed  = hash->seed[_hash_property_key(key, key_len, 0) & hash->bucket_mask];
+    uint8_t  index = hash->index[_hash_property_key(key, key_len, seed) & hash->slot_mask];
 
-#define TOTAL_USR_PROPERTY_COUNT 6
+    // key not in table may also be hashed into a slot
+    if (index == 0xff || strncmp(properties[index].key, key, key_len) || properties[index].key[key_len]) {
+        return -1;
+    }
+    return index;
+}
 
-static DataTemplateProperty sg_usr_data_template_property[TOTAL_USR_PROPERTY_COUNT];
+/**
+ * @brief Parse property array.
+ *
+ * @param[in] json_buf json string to parse
+ * @param[in] buf_len json len
+ * @param[in,out] properties pointer to property array
+ * @param[in] property_count count of property, 32 at most
+ * @param[in] hash perfect hash of property keys, NULL to look up properties one by one
+ * @return bitmap of properties set, bit i for properties[i]
+ */
+static uint32_t _parse_property_array(const char* json_buf, int buf_len, DataTemplateProperty* properties,
+                                      int property_count, const DataTemplatePropertyHash* hash)
+{
+    UtilsJsonValue value;
+    UtilsJsonToken tokens[PROPERTY_JSON_TOKEN_NUM];
 
-#define TOTAL_USR_PROPERTY_STRUCT_POSITION_COUNT 2
+    uint32_t set_bitmap = 0;
 
-static DataTemplateProperty sg_usr_property_position[TOTAL_USR_PROPERTY_STRUCT_POSITION_COUNT];
+    int i, index;
+    int num = utils_json_index_parse(json_buf, buf_len, 1, tokens, PROPERTY_JSON_TOKEN_NUM);
+    if (num <= 0 || tokens[0].type != UTILS_JSON_TOKEN_TYPE_OBJECT) {
+        return 0;
+    }
 
-static void _init_data_template_property_position(void)
-{
-    sg_usr_property_position[USR_PROPERTY_POSITION_INDEX_LONGITUDE].value.value_int = 0;
-    sg_usr_property_position[USR_PROPERTY_POSITION_INDEX_LONGITUDE].key             = "longitude";
-    sg_usr_property_position[USR_PROPERTY_POSITION_INDEX_LONGITUDE].type            = DATA_TEMPLATE_TYPE_INT;
+    // walk members of json once, each key is matched by perfect hash
+    if (hash) {
+        for (i = 1; i < tokens[0].next; i = tokens[i].next) {
+            index = _get_property_index(hash, properties, tokens[i].key, tokens[i].key_len);
+            if (index >= 0 && !_set_property_value(&properties[index], tokens[i].value)) {
+                set_bitmap |= 1U << index;
+            }
+        }
+        if (!tokens[0].partial) {
+            return set_bitmap;
+        }
+    }
 
-    sg_usr_property_position[USR_PROPERTY_POSITION_INDEX_LATITUDE].value.value_int = 0;
-    sg_usr_property_position[USR_PROPERTY_POSITION_INDEX_LATITUDE].key             = "latitude";
-    sg_usr_property_position[USR_PROPERTY_POSITION_INDEX_LATITUDE].type            = DATA_TEMPLATE_TYPE_INT;
+    // members beyond tokens are not indexed, look up the properties left
+    for (i = 0; i < property_count; i++) {
+        if ((set_bitmap >> i) & 1) {
+            continue;
+        }
+        if (!utils_json_index_member_get(tokens, 0, NULL, properties[i].key, strlen(properties[i].key), &value) &&
+            !_set_property_value(&properties[i], value)) {
+            set_bitmap |= 1U << i;
+        }
+    }
+    return set_bitmap;
 }
 
-static void _init_data_template_property(void)
+/**
+ * @brief Check if new value is changed beyond deadband from value last reported.
+ *
+ * @param[in] property property to check
+ * @param[in] value new value
+ * @return 1 if changed
+ */
+static int _is_property_value_changed(const DataTemplateProperty* property, DataTemplatePropertyValue value)
 {
-    sg_usr_data_template_property[USR_PROPERTY_INDEX_POWER_SWITCH].value.value_bool = 0;
-    sg_usr_data_template_property[USR_PROPERTY_INDEX_POWER_SWITCH].key              = "power_switch";
-    sg_usr_data_template_property[USR_PROPERTY_INDEX_POWER_SWITCH].type             = DATA_TEMPLATE_TYPE_BOOL;
-    sg_usr_data_template_property[USR_PROPERTY_INDEX_POWER_SWITCH].need_report      = 1;
-
-    sg_usr_data_template_property[USR_PROPERTY_INDEX_COLOR].value.value_enum = 0;
-    sg_usr_data_template_property[USR_PROPERTY_INDEX_COLOR].key              = "color";
-    sg_usr_data_template_property[USR_PROPERTY_INDEX_COLOR].type             = DATA_TEMPLATE_TYPE_ENUM;
-    sg_usr_data_template_property[USR_PROPERTY_INDEX_COLOR].need_report      = 1;
-
-    sg_usr_data_template_property[USR_PROPERTY_INDEX_BRIGHTNESS].value.value_int = 0;
-    sg_usr_data_template_property[USR_PROPERTY_INDEX_BRIGHTNESS].key             = "brightness";
-    sg_usr_data_template_property[USR_PROPERTY_INDEX_BRIGHTNESS].type            = DATA_TEMPLATE_TYPE_INT;
-    sg_usr_data_template_property[USR_PROPERTY_INDEX_BRIGHTNESS].need_report     = 1;
-
-    static char sg_usr_property_name[64 + 1];
-    sg_usr_data_template_property[USR_PROPERTY_INDEX_NAME].value.value_string = sg_usr_property_name;
-    sg_usr_data_template_property[USR_PROPERTY_INDEX_NAME].key                = "name";
-    sg_usr_data_template_property[USR_PROPERTY_INDEX_NAME].type               = DATA_TEMPLATE_TYPE_STRING;
-    sg_usr_data_template_property[USR_PROPERTY_INDEX_NAME].need_report        = 1;
-
-    _init_data_template_property_position();
-    sg_usr_data_template_property[USR_PROPERTY_INDEX_POSITION].value.value_struct.property = sg_usr_property_position;
-    sg_usr_data_template_property[USR_PROPERTY_INDEX_POSITION].value.value_struct.count =
-        TOTAL_USR_PROPERTY_STRUCT_POSITION_COUNT;
-    sg_usr_data_template_property[USR_PROPERTY_INDEX_POSITION].key         = "position";
-    sg_usr_data_template_property[USR_PROPERTY_INDEX_POSITION].type        = DATA_TEMPLATE_TYPE_STRUCT;
-    sg_usr_data_template_property[USR_PROPERTY_INDEX_POSITION].need_report = 1;
-
-    static char sg_usr_property_power[64 + 1];
-    sg_usr_data_template_property[USR_PROPERTY_INDEX_POWER].value.value_string_enum = sg_usr_property_power;
-    sg_usr_data_template_property[USR_PROPERTY_INDEX_POWER].key                     = "power";
-    sg_usr_data_template_property[USR_PROPERTY_INDEX_POWER].type                    = DATA_TEMPLATE_TYPE_STRING_ENUM;
-    sg_usr_data_template_property[USR_PROPERTY_INDEX_POWER].need_report             = 1;
-}
+    double diff;
 
-/**************************************************************************************
- * user event
- **************************************************************************************/
-
-#define TOTAL_USR_EVENT_COUNT 3
-
-DataTemplateEvent sg_usr_data_template_event[TOTAL_USR_EVENT_COUNT];
+    switch (property->type) {
+        case DATA_TEMPLATE_TYPE_INT:
+        case DATA_TEMPLATE_TYPE_ENUM:
+        case DATA_TEMPLATE_TYPE_BOOL:
+            diff = (double)value.value_int - property->report_value.value_int;
+            break;
+        case DATA_TEMPLATE_TYPE_TIME:
+            diff = (double)value.value_time - property->report_value.value_time;
+            break;
+        case DATA_TEMPLATE_TYPE_FLOAT:
+            diff = (double)value.value_float - property->report_value.value_float;
+            break;
+        case DATA_TEMPLATE_TYPE_STRING:
+        case DATA_TEMPLATE_TYPE_STRING_ENUM:
+            return !property->value.value_string || strcmp(property->value.value_string, value.value_string);
+        default:
+            return 1;
+    }
+    return diff > property->deadband || diff < -property->deadband;
+}
 
 /**
- * @brief Sample of event post params.
+ * @brief Save value as reported, including members of struct.
  *
+ * @param[in,out] property property reported
  */
-static const char* sg_usr_event_status_report_params  = "{\"status\":0,\"message\":\"ok\"}";
-static const char* sg_usr_event_low_voltage_params    = "{\"voltage\":1.0}";
-static const char* sg_usr_event_hardware_fault_params = "{\"name\":\"broken\",\"error_code\":-1}";
-
-static void _init_data_template_event(void)
+static void _set_property_value_reported(DataTemplateProperty* property)
 {
-    sg_usr_data_template_event[USR_EVENT_INDEX_STATUS_REPORT].event_id = "status_report";
-    sg_usr_data_template_event[USR_EVENT_INDEX_STATUS_REPORT].type     = IOT_DATA_TEMPLATE_EVENT_TYPE_INFO;
-    sg_usr_data_template_event[USR_EVENT_INDEX_STATUS_REPORT].params   = sg_usr_event_status_report_params;
-
-    sg_usr_data_template_event[USR_EVENT_INDEX_LOW_VOLTAGE].event_id = "low_voltage";
-    sg_usr_data_template_event[USR_EVENT_INDEX_LOW_VOLTAGE].type     = IOT_DATA_TEMPLATE_EVENT_TYPE_ALERT;
-    sg_usr_data_template_event[USR_EVENT_INDEX_LOW_VOLTAGE].params   = sg_usr_event_low_voltage_params;
+    int i;
 
-    sg_usr_data_template_event[USR_EVENT_INDEX_HARDWARE_FAULT].event_id = "hardware_fault";
-    sg_usr_data_template_event[USR_EVENT_INDEX_HARDWARE_FAULT].type     = IOT_DATA_TEMPLATE_EVENT_TYPE_FAULT;
-    sg_usr_data_template_event[USR_EVENT_INDEX_HARDWARE_FAULT].params   = sg_usr_event_hardware_fault_params;
+    if (property->type == DATA_TEMPLATE_TYPE_STRUCT) {
+        for (i = 0; i < property->value.value_struct.count; i++) {
+            _set_property_value_reported(property->value.value_struct.property + i);
+        }
+        return;
+    }
+    property->report_value = property->value;
 }
 
 /**************************************************************************************
- * user action
+ * user property
  **************************************************************************************/
 
-#define TOTAL_USR_ACTION_COUNT 1
-
-DataTemplateAction sg_usr_data_template_action[TOTAL_USR_ACTION_COUNT];
-
-#define TOTAL_USR_ACTION_LIGHT_BLINK_INPUT_PARAMS_COUNT 3
+#if TOTAL_USR_PROPERTY_COUNT > 32
+#error "dirty bitmap supports 32 properties at most"
+#endif
 
-static DataTemplateProperty sg_usr_action_light_blink_input[TOTAL_USR_ACTION_LIGHT_BLINK_INPUT_PARAMS_COUNT];
-
-static void _init_data_template_action_light_blink_input(void)
-{
-    sg_usr_action_light_blink_input[USR_ACTION_LIGHT_BLINK_INPUT_INDEX_TIME].value.value_int = 0;
-    sg_usr_action_light_blink_input[USR_ACTION_LIGHT_BLINK_INPUT_INDEX_TIME].key             = "time";
-    sg_usr_action_light_blink_input[USR_ACTION_LIGHT_BLINK_INPUT_INDEX_TIME].type            = DATA_TEMPLATE_TYPE_INT;
-
-    sg_usr_action_light_blink_input[USR_ACTION_LIGHT_BLINK_INPUT_INDEX_COLOR].value.value_int = 0;
-    sg_usr_action_light_blink_input[USR_ACTION_LIGHT_BLINK_INPUT_INDEX_COLOR].key             = "color";
-    sg_usr_action_light_blink_input[USR_ACTION_LIGHT_BLINK_INPUT_INDEX_COLOR].type            = DATA_TEMPLATE_TYPE_ENUM;
-
-    sg_usr_action_light_blink_input[USR_ACTION_LIGHT_BLINK_INPUT_INDEX_TOTAL_TIME].value.value_int = 0;
-    sg_usr_action_light_blink_input[USR_ACTION_LIGHT_BLINK_INPUT_INDEX_TOTAL_TIME].key             = "total_time";
-    sg_usr_action_light_blink_input[USR_ACTION_LIGHT_BLINK_INPUT_INDEX_TOTAL_TIME].type = DATA_TEMPLATE_TYPE_INT;
-}
+/**
+ * @brief Properties changed and not reported, bit index is @see UsrPropertyIndex.
+ *
+ */
+static uint32_t sg_usr_property_dirty;
 
 /**
- * @brief Sample of action reply.
+ * @brief Time of the first change not reported, and coalescing window from it.
  *
  */
-static IotDataTemplateActionReply sg_usr_action_light_blink_reply = {
-    .code         = 0,
-    .client_token = {.value = "test", .value_len = 4},
-    .response     = "{\"err_code\":0}",
-};
+static uint64_t sg_usr_property_dirty_time_ms;
+static uint32_t sg_usr_property_report_window_ms;
 
-static void _init_data_template_action(void)
+/**
+ * @brief Mark property dirty, coalescing window starts from the first dirty one.
+ *
+ * @param[in] dirty_bitmap bitmap of properties changed
+ */
+static void _set_usr_property_dirty(uint32_t dirty_bitmap)
 {
-    _init_data_template_action_light_blink_input();
-    sg_usr_data_template_action[USR_ACTION_INDEX_LIGHT_BLINK].action_id = "light_blink";
-    sg_usr_data_template_action[USR_ACTION_INDEX_LIGHT_BLINK].input_struct.value_struct.property =
-        sg_usr_action_light_blink_input;
-    sg_usr_data_template_action[USR_ACTION_INDEX_LIGHT_BLINK].input_struct.value_struct.count =
-        TOTAL_USR_ACTION_LIGHT_BLINK_INPUT_PARAMS_COUNT;
-    sg_usr_data_template_action[USR_ACTION_INDEX_LIGHT_BLINK].reply = sg_usr_action_light_blink_reply;
+    if (!sg_usr_property_dirty && dirty_bitmap) {
+        sg_usr_property_dirty_time_ms = HAL_Timer_CurrentMs();
+    }
+    sg_usr_property_dirty |= dirty_bitmap;
 }
 
 /**************************************************************************************
@@ -284,9 +332,9 @@ static void _init_data_template_action(void)
  */
 void usr_data_template_init(void)
 {
-    _init_data_template_property();
-    _init_data_template_event();
-    _init_data_template_action();
+    // tables are generated with initializer, report all the properties at first
+    sg_usr_property_dirty         = (uint32_t)((1ULL << TOTAL_USR_PROPERTY_COUNT) - 1);
+    sg_usr_property_dirty_time_ms = 0;
 }
 
 /**
@@ -308,13 +356,17 @@ DataTemplatePropertyValue usr_data_template_property_value_get(UsrPropertyIndex
  */
 void usr_data_template_property_value_set(UsrPropertyIndex index, DataTemplatePropertyValue value)
 {
-    if (sg_usr_data_template_property[index].type == DATA_TEMPLATE_TYPE_STRING ||
-        sg_usr_data_template_property[index].type == DATA_TEMPLATE_TYPE_STRING_ENUM) {
-        strncpy(sg_usr_data_template_property[index].value.value_string, value.value_string,
-                strlen(value.value_string));
+    DataTemplateProperty* property = &sg_usr_data_template_property[index];
+
+    int changed = _is_property_value_changed(property, value);
+    if (property->type == DATA_TEMPLATE_TYPE_STRING || property->type == DATA_TEMPLATE_TYPE_STRING_ENUM) {
+        _copy_property_string(property, value.value_string, strlen(value.value_string));
+    } else {
+        property->value = value;
+    }
+    if (changed) {
+        _set_usr_property_dirty(1U << index);
     }
-    sg_usr_data_template_property[index].value       = value;
-    sg_usr_data_template_property[index].need_report = 1;
 }
 
 /**
@@ -339,15 +391,18 @@ DataTemplatePropertyValue usr_data_template_property_struct_value_get(UsrPropert
 void usr_data_template_property_struct_value_set(UsrPropertyIndex struct_index, int property_index,
                                                  DataTemplatePropertyValue value)
 {
-    if (sg_usr_data_template_property[struct_index].value.value_struct.property[property_index].type ==
-            DATA_TEMPLATE_TYPE_STRING ||
-        sg_usr_data_template_property[struct_index].value.value_struct.property[property_index].type ==
-            DATA_TEMPLATE_TYPE_STRING_ENUM) {
-        strncpy(
-            sg_usr_data_template_property[struct_index].value.value_struct.property[property_index].value.value_string,
-            value.value_string, strlen(value.value_string));
+    DataTemplateProperty* property =
+        &sg_usr_data_template_property[struct_index].value.value_struct.property[property_index];
+
+    int changed = _is_property_value_changed(property, value);
+    if (property->type == DATA_TEMPLATE_TYPE_STRING || property->type == DATA_TEMPLATE_TYPE_STRING_ENUM) {
+        _copy_property_string(property, value.value_string, strlen(value.value_string));
+    } else {
+        property->value = value;
+    }
+    if (changed) {
+        _set_usr_property_dirty(1U << struct_index);
     }
-    sg_usr_data_template_property[struct_index].need_report = 1;
 }
 
 /**
@@ -357,22 +412,79 @@ void usr_data_template_property_struct_value_set(UsrPropertyIndex struct_index,
  */
 void usr_data_template_property_parse(UtilsJsonValue params)
 {
-    _parse_property_array(params.value, params.value_len, sg_usr_data_template_property, TOTAL_USR_PROPERTY_COUNT);
+    _set_usr_property_dirty(_parse_property_array(params.value, params.value_len, sg_usr_data_template_property,
+                                                  TOTAL_USR_PROPERTY_COUNT, &sg_usr_data_template_property_hash));
 }
 
 /**
  * @brief Get property status.
  *
  * @param[in] index @see UsrPropertyIndex
- * @return need_report
+ * @return 1 if property is changed and not reported yet
  */
 int usr_data_template_property_status_get(UsrPropertyIndex index)
 {
-    return sg_usr_data_template_property[index].need_report;
+    return (sg_usr_property_dirty >> index) & 1;
 }
 
 /**
- * @brief Report all the properties needed report.
+ * @brief Set deadband of numeric property, value set within deadband of last reported value is not reported.
+ *
+ * @param[in] index @see UsrPropertyIndex
+ * @param[in] deadband deadband, 0 for reporting any change
+ */
+void usr_data_template_property_deadband_set(UsrPropertyIndex index, float deadband)
+{
+    sg_usr_data_template_property[index].deadband = deadband;
+}
+
+/**
+ * @brief Set deadband of numeric property in struct.
+ *
+ * @param[in] struct_index @see UsrPropertyIndex, @note DATA_TEMPLATE_TYPE_STRUCT is required here.
+ * @param[in] property_index depends on which struct
+ * @param[in] deadband deadband, 0 for reporting any change
+ */
+void usr_data_template_property_struct_deadband_set(UsrPropertyIndex struct_index, int property_index, float deadband)
+{
+    sg_usr_data_template_property[struct_index].value.value_struct.property[property_index].deadband = deadband;
+}
+
+/**
+ * @brief Set coalescing window, properties changed within window are reported in one message.
+ *
+ * @param[in] window_ms window from the first change, 0 for reporting at once
+ */
+void usr_data_template_property_report_window_set(uint32_t window_ms)
+{
+    sg_usr_property_report_window_ms = window_ms;
+}
+
+/**
+ * @brief Write the changed properties into params, @see PropertyParamsWrite.
+ *
+ * @param[in,out] writer @see UtilsJsonWriter
+ * @param[in] usr_data pointer to dirty bitmap
+ * @return 0 for success.
+ */
+static int _write_property_report_params(UtilsJsonWriter* writer, void* usr_data)
+{
+    uint32_t dirty = *(uint32_t*)usr_data;
+
+    int rc = 0;
+
+    utils_json_writer_object_begin(writer);
+    for (int i = 0; i < TOTAL_USR_PROPERTY_COUNT; i++) {
+        if ((dirty >> i) & 1) {
+            rc |= _write_property_node(writer, &sg_usr_data_template_property[i]);
+        }
+    }
+    utils_json_writer_object_end(writer);
+    return rc;
+}
+
+/**
+ * @brief Report the changed properties when coalescing window passed.
  *
  * @param[in,out] client pointer to mqtt client
  * @param[in] buf buffer to report
@@ -381,26 +493,28 @@ int usr_data_template_property_status_get(UsrPropertyIndex index)
  */
 int usr_data_template_property_report(void* client, char* buf, int buf_len)
 {
-    char params[512];
-    memset(params, 0, sizeof(params));
-    params[0]  = '{';
-    int offset = 1;
-    for (int i = 0; i < TOTAL_USR_PROPERTY_COUNT; i++) {
-        DataTemplateProperty* property = &sg_usr_data_template_property[i];
-        if (property->need_report) {
-            offset += _get_property_node(params + offset, sizeof(params) - offset, property);
-            if (offset) {
-                params[offset++] = ',';
-            }
-            property->need_report = 0;
-        }
+    uint32_t dirty = sg_usr_property_dirty;
+
+    int i, rc;
+
+    if (!dirty || HAL_Timer_CurrentMs() - sg_usr_property_dirty_time_ms < sg_usr_property_report_window_ms) {
+        return QCLOUD_RET_SUCCESS;
     }
-    params[--offset] = '}';
 
-    if (offset) {
-        return IOT_DataTemplate_PropertyReport(client, buf, buf_len, params);
+    rc = IOT_DataTemplate_PropertyReportWrite(client, buf, buf_len, _write_property_report_params, &dirty);
+    if (rc < 0) {
+        // keep dirty and retry after another window
+        sg_usr_property_dirty_time_ms = HAL_Timer_CurrentMs();
+        return rc;
+    }
+
+    for (i = 0; i < TOTAL_USR_PROPERTY_COUNT; i++) {
+        if ((dirty >> i) & 1) {
+            _set_property_value_reported(&sg_usr_data_template_property[i]);
+        }
     }
-    return QCLOUD_RET_SUCCESS;
+    sg_usr_property_dirty &= ~dirty;
+    return rc;
 }
 
 /**
@@ -430,28 +544,17 @@ void usr_data_template_event_post(void* client, char* buf, int buf_len, UsrEvent
  */
 int usr_data_template_action_parse(UtilsJsonValue action_id, UtilsJsonValue params, UsrActionIndex* index)
 {
-    DataTemplateProperty* property;
-
-    int input_property_count;
+    DataTemplatePropertyValue* input;
 
     for (int i = 0; i < TOTAL_USR_ACTION_COUNT; i++) {
         if (!strncmp(action_id.value, sg_usr_data_template_action[i].action_id, action_id.value_len)) {
-            property             = sg_usr_data_template_action[i].input_struct.value_struct.property;
-            input_property_count = sg_usr_data_template_action[i].input_struct.value_struct.count;
-
-            // 1. reset need report
-            for (int j = 0; j < input_property_count; j++) {
-                property[j].need_report = 0;
-            }
-
-            // 2. parse
-            _parse_property_array(params.value, params.value_len, property, input_property_count);
+            input = &sg_usr_data_template_action[i].input_struct;
 
-            // 3. check all the input params is set
-            for (int j = 0; j < input_property_count; j++) {
-                if (!property[j].need_report) {
-                    return QCLOUD_ERR_JSON_PARSE;
-                }
+            // all the input params should be set
+            if (_parse_property_array(params.value, params.value_len, input->value_struct.property,
+                                      input->value_struct.count, input->value_struct.hash) !=
+                (uint32_t)((1ULL << input->value_struct.count) - 1)) {
+                return QCLOUD_ERR_JSON_PARSE;
             }
             *index = i;
             return QCLOUD_RET_SUCCESS;
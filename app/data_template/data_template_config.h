@@ -61,6 +61,18 @@ typedef enum {
 typedef struct DataTemplateProperty     DataTemplateProperty;
 typedef union DataTemplatePropertyValue DataTemplatePropertyValue;
 
+/**
+ * @brief Perfect hash of property keys, generated by tools/data_template_codegen.py. Key is hashed with seed 0 to
+ * get bucket, then hashed with seed of bucket to get slot of property index.
+ *
+ */
+typedef struct {
+    const uint16_t* seed;        /**< seed of each bucket */
+    const uint8_t*  index;       /**< property index of each slot, 0xff for empty */
+    uint16_t        bucket_mask; /**< number of buckets - 1 */
+    uint16_t        slot_mask;   /**< number of slots - 1 */
+} DataTemplatePropertyHash;
+
 /**
  * @brief Property value definition.
  *
@@ -74,8 +86,9 @@ union DataTemplatePropertyValue {
     char*    value_string;
     uint32_t value_time;
     struct {
-        DataTemplateProperty* property;
-        int                   count;
+        DataTemplateProperty*           property;
+        int                             count;
+        const DataTemplatePropertyHash* hash;
     } value_struct;
     DataTemplatePropertyValue* value_arrary; /**< not supportted yet */
 };
@@ -88,7 +101,9 @@ struct DataTemplateProperty {
     DataTemplatePropertyType  type;
     const char*               key;
     DataTemplatePropertyValue value;
-    int                       need_report;
+    int                       string_size;  /**< buffer size of string value, string type only */
+    float                     deadband;     /**< change within deadband is not reported, numeric type only */
+    DataTemplatePropertyValue report_value; /**< value last reported, compared with new value and deadband */
 };
 
 /**
@@ -107,39 +122,11 @@ typedef struct {
     IotDataTemplateActionReply reply;
 } DataTemplateAction;
 
-/**************************************************************************************
- * usr data template definition
- **************************************************************************************/
-
-typedef enum {
-    USR_PROPERTY_INDEX_POWER_SWITCH = 0,
-    USR_PROPERTY_INDEX_COLOR,
-    USR_PROPERTY_INDEX_BRIGHTNESS,
-    USR_PROPERTY_INDEX_NAME,
-    USR_PROPERTY_INDEX_POSITION,
-    USR_PROPERTY_INDEX_POWER,
-} UsrPropertyIndex;
-
-typedef enum {
-    USR_PROPERTY_POSITION_INDEX_LONGITUDE = 0,
-    USR_PROPERTY_POSITION_INDEX_LATITUDE,
-} UsrPropertyPositionIndex;
-
-typedef enum {
-    USR_EVENT_INDEX_STATUS_REPORT = 0,
-    USR_EVENT_INDEX_LOW_VOLTAGE,
-    USR_EVENT_INDEX_HARDWARE_FAULT,
-} UsrEventIndex;
-
-typedef enum {
-    USR_ACTION_INDEX_LIGHT_BLINK = 0,
-} UsrActionIndex;
-
-typedef enum {
-    USR_ACTION_LIGHT_BLINK_INPUT_INDEX_TIME = 0,
-    USR_ACTION_LIGHT_BLINK_INPUT_INDEX_COLOR,
-    USR_ACTION_LIGHT_BLINK_INPUT_INDEX_TOTAL_TIME,
-} UsrActionLightBlinkInputIndex;
+/**
+ * @brief Index enums, tables and typed accessors generated from thing model json, @see data_template.json.
+ *
+ */
+#include "data_template_config_gen.h"
 
 /**************************************************************************************
  * api for user data template
@@ -198,12 +185,36 @@ void usr_data_template_property_parse(UtilsJsonValue params);
  * @brief Get property status.
  *
  * @param[in] index @see UsrPropertyIndex
- * @return need_report
+ * @return 1 if property is changed and not reported yet
  */
 int usr_data_template_property_status_get(UsrPropertyIndex index);
 
 /**
- * @brief Report all the properties needed report.
+ * @brief Set deadband of numeric property, value set within deadband of last reported value is not reported.
+ *
+ * @param[in] index @see UsrPropertyIndex
+ * @param[in] deadband deadband, 0 for reporting any change
+ */
+void usr_data_template_property_deadband_set(UsrPropertyIndex index, float deadband);
+
+/**
+ * @brief Set deadband of numeric property in struct.
+ *
+ * @param[in] struct_index @see UsrPropertyIndex, @note DATA_TEMPLATE_TYPE_STRUCT is required here.
+ * @param[in] property_index depends on which struct
+ * @param[in] deadband deadband, 0 for reporting any change
+ */
+void usr_data_template_property_struct_deadband_set(UsrPropertyIndex struct_index, int property_index, float deadband);
+
+/**
+ * @brief Set coalescing window, properties changed within window are reported in one message.
+ *
+ * @param[in] window_ms window from the first change, 0 for reporting at once
+ */
+void usr_data_template_property_report_window_set(uint32_t window_ms);
+
+/**
+ * @brief Report the changed properties when coalescing window passed.
  *
  * @param[in,out] client pointer to mqtt client
  * @param[in] buf buffer to report
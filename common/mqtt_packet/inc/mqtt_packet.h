@@ -43,6 +43,7 @@ extern "C" {
 #define MAX_NO_OF_REMAINING_LENGTH_BYTES 4
 #define MAX_MQTT_FIXED_HEADER_LEN        (1 + MAX_NO_OF_REMAINING_LENGTH_BYTES)
 #define MIN_MQTT_FIXED_HEADER_LEN        (1 + 1)
+#define MAX_MQTT_REMAINING_LENGTH        (268435455)
 
 /**
  * @brief Check if short buffer.
@@ -207,6 +208,21 @@ int mqtt_disconnect_packet_serialize(uint8_t* buf, int buf_len);
  */
 int mqtt_pingreq_packet_serialize(uint8_t* buf, int buf_len);
 
+/**
+ * @brief Serialize fixed header, topic name and packet id of publish packet, payload is not copied and should be sent
+ * right after the header. See 3.3.
+ *
+ * @param[out] buf the buffer into which the header will be serialized
+ * @param[in] buf_len the length in bytes of the supplied buffer
+ * @param[in] flags the MQTT dup, qos, retained flag
+ * @param[in] packet_id integer - the MQTT packet identifier
+ * @param[in] topic_name char * - the MQTT topic in the publish
+ * @param[in] payload_len integer - the length of the MQTT payload
+ * @return serialized length of header, or error if <= 0
+ */
+int mqtt_publish_packet_header_serialize(uint8_t* buf, int buf_len, const MQTTPublishFlags* flags, uint16_t packet_id,
+                                         const char* topic_name, int payload_len);
+
 /**
  * @brief Serialize the supplied publish data into the supplied buffer, ready for sending. See 3.3.
  *
@@ -294,6 +310,24 @@ int mqtt_pingresp_packet_deserialize(uint8_t* buf, int buf_len);
 int mqtt_publish_packet_deserialize(uint8_t* buf, int buf_len, MQTTPublishFlags* flags, uint16_t* packet_id,
                                     char** topic_name, int* topic_len, uint8_t** payload, int* payload_len);
 
+/**
+ * @brief Deserialize fixed header and variable header of publish packet, whose payload is not read into buffer. See
+ * 3.3.
+ *
+ * @param[in] buf the raw buffer data, holding fixed header and variable header
+ * @param[in] buf_len the length in bytes of the supplied buffer, variable header should end before it
+ * @param[out] flags the MQTT dup, qos, retained flag
+ * @param[out] packet_id returned integer - the MQTT packet identifier
+ * @param[out] topic_name returned string - the MQTT topic in the publish
+ * @param[out] topic_len returned integer - the length of the MQTT topic
+ * @param[out] payload returned byte buffer - where payload starts in buffer, not filled
+ * @param[out] payload_len returned integer - the length of the MQTT payload, also set when topic is rejected for
+ * buffer too short, so that payload can be skipped
+ * @return @see MQTTPacketErrCode
+ */
+int mqtt_publish_packet_header_deserialize(uint8_t* buf, int buf_len, MQTTPublishFlags* flags, uint16_t* packet_id,
+                                           char** topic_name, int* topic_len, uint8_t** payload, int* payload_len);
+
 /**
  * @brief Deserialize the supplied (wire) buffer into an ack. See 3.4.
  *
@@ -238,8 +238,9 @@ int mqtt_publish_packet_deserialize(uint8_t* buf, int buf_len, MQTTPublishFlags*
 
     ptr_remain = ptr;
 
-    rc = _read_string(topic_name, &ptr);
-    if (rc <= 0) {
+    // topic and packet id should be in remaining length, or they are read beyond the packet
+    rc = len < 2 ? 0 : _read_string(topic_name, &ptr);
+    if (rc <= 0 || rc + 2 + (flags->qos > 0 ? 2 : 0) > len) {
         rc = MQTT_ERR_INVALID_PACKET_TYPE;
         goto exit;
     }
@@ -257,6 +258,66 @@ exit:
     return rc;
 }
 
+/**
+ * @brief Deserialize fixed header and variable header of publish packet, whose payload is not read into buffer. See
+ * 3.3.
+ *
+ * @param[in] buf the raw buffer data, holding fixed header and variable header
+ * @param[in] buf_len the length in bytes of the supplied buffer, variable header should end before it
+ * @param[out] flags the MQTT dup, qos, retained flag
+ * @param[out] packet_id returned integer - the MQTT packet identifier
+ * @param[out] topic_name returned string - the MQTT topic in the publish
+ * @param[out] topic_len returned integer - the length of the MQTT topic
+ * @param[out] payload returned byte buffer - where payload starts in buffer, not filled
+ * @param[out] payload_len returned integer - the length of the MQTT payload, also set when topic is rejected for
+ * buffer too short, so that payload can be skipped
+ * @return @see MQTTPacketErrCode
+ */
+int mqtt_publish_packet_header_deserialize(uint8_t* buf, int buf_len, MQTTPublishFlags* flags, uint16_t* packet_id,
+                                           char** topic_name, int* topic_len, uint8_t** payload, int* payload_len)
+{
+    SHORT_BUFFER_CHECK(buf_len, MIN_MQTT_FIXED_HEADER_LEN);
+
+    uint8_t* ptr           = buf;
+    int      rc            = 0;
+    int      len           = 0;
+    int      packet_id_len = 0;
+
+    rc = _mqtt_packet_type_check(PUBLISH, flags, &ptr);
+    if (rc) {
+        return rc;
+    }
+
+    // payload is not in buffer, so remaining length is not limited by buffer length
+    rc = _mqtt_remaining_length_deserialize(MAX_MQTT_FIXED_HEADER_LEN + MAX_MQTT_REMAINING_LENGTH, &len, &ptr);
+    if (rc) {
+        return rc;
+    }
+
+    SHORT_BUFFER_CHECK(buf_len, ptr - buf + 2);
+    if (len < 2) {
+        return MQTT_ERR_INVALID_PACKET_TYPE;
+    }
+
+    packet_id_len = flags->qos > 0 ? 2 : 0;
+    *topic_len    = _read_int(&ptr);
+    if (!*topic_len || 2 + *topic_len + packet_id_len > len) {
+        return MQTT_ERR_INVALID_PACKET_TYPE;
+    }
+    *payload_len = len - 2 - *topic_len - packet_id_len;
+
+    // at least one byte left in buffer for payload
+    SHORT_BUFFER_CHECK(buf_len, ptr - buf + *topic_len + packet_id_len + 1);
+
+    *topic_name = (char*)ptr;
+    ptr += *topic_len;
+    if (packet_id_len) {
+        *packet_id = _read_int(&ptr);
+    }
+    *payload = ptr;
+    return MQTT_RET_PACKET_OK;
+}
+
 /**
  * @brief Deserialize the supplied (wire) buffer into an ack. See 3.4.
  *
@@ -198,6 +198,22 @@ static int _mqtt_connect_variable_header_serialize(const MQTTPacketConnectOption
     return MQTT_RET_PACKET_OK;
 }
 
+/**
+ * @brief Get the number of bytes used to encode remaining length. See 2.2.3.
+ *
+ * @param[in] length the length to be encoded to remaining length
+ * @return bytes of remaining length
+ */
+static int _mqtt_remaining_length_len(int length)
+{
+    int len = 1;
+    while (length >= 128) {
+        length /= 128;
+        len++;
+    }
+    return len;
+}
+
 /**
  * @brief Serialize the remaining length of the MQTT publish packet that would be produced using the supplied
  * parameters. See 3.3.2 & 3.3.3.
@@ -205,7 +221,7 @@ static int _mqtt_connect_variable_header_serialize(const MQTTPacketConnectOption
  * @param[in] qos the MQTT QoS of the publish (packet id is omitted for QoS 0)
  * @param[in] topic_name the topic name to be used in the publish
  * @param[in] payload_len the length of the payload to be sent
- * @param[in] buf_len the length in bytes of the supplied buffer
+ * @param[in] buf_len the length in bytes of the supplied buffer, which holds the header only
  * @param[out] pptr pointer to the output buffer - incremented by the number of bytes used & returned
  */
 static int _mqtt_publish_remaining_length_serialize(uint8_t qos, const char* topic_name, int payload_len, int buf_len,
@@ -218,7 +234,8 @@ static int _mqtt_publish_remaining_length_serialize(uint8_t qos, const char* top
         len += 2; /* packet id */
     }
 
-    SHORT_BUFFER_CHECK(buf_len, len + MAX_MQTT_FIXED_HEADER_LEN);
+    // fixed header and variable header, payload is not in buffer
+    SHORT_BUFFER_CHECK(buf_len, 1 + _mqtt_remaining_length_len(len) + len - payload_len);
 
     _mqtt_remaining_length_serialize(len, pptr);
     return MQTT_RET_PACKET_OK;
@@ -332,19 +349,19 @@ int mqtt_pingreq_packet_serialize(uint8_t* buf, int buf_len)
 }
 
 /**
- * @brief Serialize the supplied publish data into the supplied buffer, ready for sending. See 3.3.
+ * @brief Serialize fixed header, topic name and packet id of publish packet, payload is not copied and should be sent
+ * right after the header. See 3.3.
  *
- * @param[out] buf the buffer into which the packet will be serialized
+ * @param[out] buf the buffer into which the header will be serialized
  * @param[in] buf_len the length in bytes of the supplied buffer
  * @param[in] flags the MQTT dup, qos, retained flag
  * @param[in] packet_id integer - the MQTT packet identifier
  * @param[in] topic_name char * - the MQTT topic in the publish
- * @param[in] payload byte buffer - the MQTT publish payload
  * @param[in] payload_len integer - the length of the MQTT payload
- * @return serialized length, or error if <= 0
+ * @return serialized length of header, or error if <= 0
  */
-int mqtt_publish_packet_serialize(uint8_t* buf, int buf_len, const MQTTPublishFlags* flags, uint16_t packet_id,
-                                  const char* topic_name, const uint8_t* payload, int payload_len)
+int mqtt_publish_packet_header_serialize(uint8_t* buf, int buf_len, const MQTTPublishFlags* flags, uint16_t packet_id,
+                                         const char* topic_name, int payload_len)
 {
     SHORT_BUFFER_CHECK(buf_len, MIN_MQTT_FIXED_HEADER_LEN);
 
@@ -353,6 +370,7 @@ int mqtt_publish_packet_serialize(uint8_t* buf, int buf_len, const MQTTPublishFl
 
     _mqtt_header_serialize(PUBLISH, flags, &ptr);
 
+    // payload is not in buffer
     rc = _mqtt_publish_remaining_length_serialize(flags->qos, topic_name, payload_len, buf_len, &ptr);
     if (rc) {
         return rc;
@@ -363,11 +381,32 @@ int mqtt_publish_packet_serialize(uint8_t* buf, int buf_len, const MQTTPublishFl
     if (flags->qos > 0) {
         _write_int(packet_id, &ptr);
     }
+    return ptr - buf;
+}
 
-    memcpy(ptr, payload, payload_len);
+/**
+ * @brief Serialize the supplied publish data into the supplied buffer, ready for sending. See 3.3.
+ *
+ * @param[out] buf the buffer into which the packet will be serialized
+ * @param[in] buf_len the length in bytes of the supplied buffer
+ * @param[in] flags the MQTT dup, qos, retained flag
+ * @param[in] packet_id integer - the MQTT packet identifier
+ * @param[in] topic_name char * - the MQTT topic in the publish
+ * @param[in] payload byte buffer - the MQTT publish payload
+ * @param[in] payload_len integer - the length of the MQTT payload
+ * @return serialized length, or error if <= 0
+ */
+int mqtt_publish_packet_serialize(uint8_t* buf, int buf_len, const MQTTPublishFlags* flags, uint16_t packet_id,
+                                  const char* topic_name, const uint8_t* payload, int payload_len)
+{
+    int header_len =
+        mqtt_publish_packet_header_serialize(buf, buf_len - payload_len, flags, packet_id, topic_name, payload_len);
+    if (header_len <= 0) {
+        return header_len;
+    }
 
-    ptr += payload_len;
-    return ptr - buf;
+    memcpy(buf + header_len, payload, payload_len);
+    return header_len + payload_len;
 }
 
 /**
@@ -166,6 +166,62 @@ TEST(MQTTPacketTest, PUBLISH) {
             MQTT_RET_PACKET_OK);
   ASSERT_NE(deserialize_packet_id, serialize_packet_id);
 
+  /**
+   * @brief header only, payload sent separately
+   *
+   */
+  serialize_flags.qos = 1;
+  int header_len = sizeof(test_packet) - serialize_payload_len;
+  ASSERT_EQ(mqtt_publish_packet_header_serialize(packet_buf, header_len, &serialize_flags, serialize_packet_id,
+                                                 serialize_topic_name, serialize_payload_len),
+            header_len);
+  ASSERT_EQ(memcmp(packet_buf, test_packet, header_len), 0);
+  ASSERT_EQ(mqtt_publish_packet_header_serialize(packet_buf, header_len - 1, &serialize_flags, serialize_packet_id,
+                                                 serialize_topic_name, serialize_payload_len),
+            MQTT_ERR_SHORT_BUFFER);
+
+  /**
+   * @brief header only, payload left in network
+   *
+   */
+  deserialize_packet_id = 0;
+  ASSERT_EQ(mqtt_publish_packet_deserialize(test_packet, header_len, &deserialize_flags, &deserialize_packet_id,
+                                            &deserialize_topic_name, &deserialize_topic_len, &deserialize_payload,
+                                            &deserialize_payload_len),
+            MQTT_ERR_SHORT_BUFFER);
+  ASSERT_EQ(mqtt_publish_packet_header_deserialize(test_packet, header_len + 1, &deserialize_flags,
+                                                   &deserialize_packet_id, &deserialize_topic_name,
+                                                   &deserialize_topic_len, &deserialize_payload,
+                                                   &deserialize_payload_len),
+            MQTT_RET_PACKET_OK);
+  ASSERT_EQ(deserialize_packet_id, serialize_packet_id);
+  ASSERT_EQ(deserialize_topic_len, serialize_topic_len);
+  ASSERT_EQ(memcmp(deserialize_topic_name, serialize_topic_name, deserialize_topic_len), 0);
+  ASSERT_EQ(deserialize_payload, test_packet + header_len);
+  ASSERT_EQ(deserialize_payload_len, serialize_payload_len);
+
+  // topic not in buffer, payload length is still returned to skip the packet
+  deserialize_payload_len = 0;
+  ASSERT_EQ(mqtt_publish_packet_header_deserialize(test_packet, header_len, &deserialize_flags,
+                                                   &deserialize_packet_id, &deserialize_topic_name,
+                                                   &deserialize_topic_len, &deserialize_payload,
+                                                   &deserialize_payload_len),
+            MQTT_ERR_SHORT_BUFFER);
+  ASSERT_EQ(deserialize_payload_len, serialize_payload_len);
+
+  // topic longer than remaining length
+  memcpy(packet_buf, test_packet, sizeof(test_packet));
+  packet_buf[2] = 0x01;
+  ASSERT_EQ(mqtt_publish_packet_header_deserialize(packet_buf, sizeof(packet_buf), &deserialize_flags,
+                                                   &deserialize_packet_id, &deserialize_topic_name,
+                                                   &deserialize_topic_len, &deserialize_payload,
+                                                   &deserialize_payload_len),
+            MQTT_ERR_INVALID_PACKET_TYPE);
+  ASSERT_EQ(mqtt_publish_packet_deserialize(packet_buf, sizeof(packet_buf), &deserialize_flags, &deserialize_packet_id,
+                                            &deserialize_topic_name, &deserialize_topic_len, &deserialize_payload,
+                                            &deserialize_payload_len),
+            MQTT_ERR_INVALID_PACKET_TYPE);
+
   /**
    * @brief bad packet
    *
@@ -63,6 +63,33 @@ typedef struct {
     int         value_len;
 } UtilsJsonValue;
 
+/**
+ * @brief Json token type
+ *
+ */
+typedef enum {
+    UTILS_JSON_TOKEN_TYPE_OBJECT = 0,
+    UTILS_JSON_TOKEN_TYPE_ARRAY,
+    UTILS_JSON_TOKEN_TYPE_STRING,
+    UTILS_JSON_TOKEN_TYPE_NUMBER,
+    UTILS_JSON_TOKEN_TYPE_BOOLEAN,
+    UTILS_JSON_TOKEN_TYPE_NULL,
+} UtilsJsonTokenType;
+
+/**
+ * @brief Json token, tokens are stored in document order and children of a container follow it.
+ *
+ */
+typedef struct {
+    const char    *key;     /**< key of object member, NULL for root and array element */
+    UtilsJsonValue value;   /**< value span, same as utils_json_value_get */
+    uint16_t       key_len; /**< key length */
+    uint16_t       next;    /**< index of next sibling, which is also the end of subtree */
+    uint8_t        type;    /**< @see UtilsJsonTokenType */
+    uint8_t        depth;   /**< depth of token, 0 for root */
+    uint8_t        partial; /**< children of container are not all indexed, lookups fall back to scan */
+} UtilsJsonToken;
+
 /**
  * @brief Get value from json string. Not strict, just for iot scene, we suppose all the string is valid json.
  *
@@ -92,6 +119,207 @@ int utils_json_value_data_get(UtilsJsonValue value, UtilsJsonValueType type, voi
  */
 int utils_json_get_uint32(const char *key, int key_len, const char *src, int src_len, uint32_t *data);
 
+/**
+ * @brief Index json string in one pass. Containers deeper than max depth or beyond max tokens are not indexed but
+ * marked partial, lookups in them fall back to utils_json_value_get, so the index never fails for lack of tokens.
+ *
+ * @param[in] src json string
+ * @param[in] src_len src length
+ * @param[in] max_depth depth of tokens to index, 1 for members of root only
+ * @param[out] tokens token array provided by caller
+ * @param[in] max_tokens size of token array, no more than 65535
+ * @return number of tokens, -1 for invalid json
+ */
+int utils_json_index_parse(const char *src, int src_len, int max_depth, UtilsJsonToken *tokens, int max_tokens);
+
+/**
+ * @brief Get value from json index, same as utils_json_value_get.
+ *
+ * @param[in] tokens tokens returned by utils_json_index_parse
+ * @param[in] num number of tokens
+ * @param[in] key key in json, support nesting with '.'
+ * @param[in] key_len key len
+ * @param[out] value value
+ * @return 0 for success
+ */
+int utils_json_index_value_get(const UtilsJsonToken *tokens, int num, const char *key, int key_len,
+                               UtilsJsonValue *value);
+
+/**
+ * @brief Get member value of object token. Search starts from hint and wraps around, so looking up members in the
+ * order of json costs O(1) each.
+ *
+ * @param[in] tokens tokens returned by utils_json_index_parse
+ * @param[in] parent index of object token, 0 for root
+ * @param[in,out] hint index of token to start search, updated to the next sibling of found, NULL to search from first
+ * @param[in] key member key, no nesting
+ * @param[in] key_len key len
+ * @param[out] value value
+ * @return 0 for success
+ */
+int utils_json_index_member_get(const UtilsJsonToken *tokens, int parent, int *hint, const char *key, int key_len,
+                                UtilsJsonValue *value);
+
+/**
+ * @brief Json writer, write json into buffer directly. Once buffer is not enough, nothing more is written and
+ * utils_json_writer_finish returns -1, so payload is never truncated silently.
+ *
+ */
+typedef struct {
+    char    *buf;        /**< buffer to write */
+    int      buf_len;    /**< buffer length */
+    int      len;        /**< length written */
+    uint32_t has_member; /**< one bit for each depth, set if container has member written */
+    uint8_t  depth;      /**< depth of container, no more than 32 */
+    uint8_t  after_key;  /**< key written, value should follow without ',' */
+    uint8_t  overflow;   /**< buffer or depth overflow */
+} UtilsJsonWriter;
+
+/**
+ * @brief Write key literal, which is quoted at compile time.
+ *
+ */
+#define UTILS_JSON_WRITER_KEY(writer, key) \
+    utils_json_writer_key_literal(writer, "\"" key "\":", sizeof("\"" key "\":") - 1)
+
+/**
+ * @brief Init json writer.
+ *
+ * @param[out] writer @see UtilsJsonWriter
+ * @param[in] buf buffer to write
+ * @param[in] buf_len buffer length
+ */
+void utils_json_writer_init(UtilsJsonWriter *writer, char *buf, int buf_len);
+
+/**
+ * @brief Begin object, ',' is added between members automatically.
+ *
+ * @param[in,out] writer @see UtilsJsonWriter
+ */
+void utils_json_writer_object_begin(UtilsJsonWriter *writer);
+
+/**
+ * @brief End object.
+ *
+ * @param[in,out] writer @see UtilsJsonWriter
+ */
+void utils_json_writer_object_end(UtilsJsonWriter *writer);
+
+/**
+ * @brief Begin array, ',' is added between elements automatically.
+ *
+ * @param[in,out] writer @see UtilsJsonWriter
+ */
+void utils_json_writer_array_begin(UtilsJsonWriter *writer);
+
+/**
+ * @brief End array.
+ *
+ * @param[in,out] writer @see UtilsJsonWriter
+ */
+void utils_json_writer_array_end(UtilsJsonWriter *writer);
+
+/**
+ * @brief Write key of object member, key is escaped.
+ *
+ * @param[in,out] writer @see UtilsJsonWriter
+ * @param[in] key key
+ * @param[in] key_len key length
+ */
+void utils_json_writer_key(UtilsJsonWriter *writer, const char *key, int key_len);
+
+/**
+ * @brief Write quoted key with ':', use UTILS_JSON_WRITER_KEY instead.
+ *
+ * @param[in,out] writer @see UtilsJsonWriter
+ * @param[in] key_literal key literal, such as "\"key\":"
+ * @param[in] len literal length
+ */
+void utils_json_writer_key_literal(UtilsJsonWriter *writer, const char *key_literal, int len);
+
+/**
+ * @brief Write integer.
+ *
+ * @param[in,out] writer @see UtilsJsonWriter
+ * @param[in] value value
+ */
+void utils_json_writer_int(UtilsJsonWriter *writer, int64_t value);
+
+/**
+ * @brief Write unsigned integer.
+ *
+ * @param[in,out] writer @see UtilsJsonWriter
+ * @param[in] value value
+ */
+void utils_json_writer_uint(UtilsJsonWriter *writer, uint64_t value);
+
+/**
+ * @brief Write integer as string, some protocols (such as ota progress) take numbers as string.
+ *
+ * @param[in,out] writer @see UtilsJsonWriter
+ * @param[in] value value
+ */
+void utils_json_writer_int_string(UtilsJsonWriter *writer, int64_t value);
+
+/**
+ * @brief Write float with 6 decimals at most, trailing zeros are removed. Magnitude not less than 1e12 is written in
+ * %.17g form, NaN and infinity are written as null.
+ *
+ * @param[in,out] writer @see UtilsJsonWriter
+ * @param[in] value value
+ */
+void utils_json_writer_float(UtilsJsonWriter *writer, double value);
+
+/**
+ * @brief Write true or false.
+ *
+ * @param[in,out] writer @see UtilsJsonWriter
+ * @param[in] value 0 for false
+ */
+void utils_json_writer_bool(UtilsJsonWriter *writer, int value);
+
+/**
+ * @brief Write null.
+ *
+ * @param[in,out] writer @see UtilsJsonWriter
+ */
+void utils_json_writer_null(UtilsJsonWriter *writer);
+
+/**
+ * @brief Write string, '"', '\\' and control characters are escaped.
+ *
+ * @param[in,out] writer @see UtilsJsonWriter
+ * @param[in] str string
+ * @param[in] len string length
+ */
+void utils_json_writer_string(UtilsJsonWriter *writer, const char *str, int len);
+
+/**
+ * @brief Write string which is already escaped, such as string value got from json. Only quotes are added.
+ *
+ * @param[in,out] writer @see UtilsJsonWriter
+ * @param[in] str escaped string without quotes
+ * @param[in] len string length
+ */
+void utils_json_writer_string_raw(UtilsJsonWriter *writer, const char *str, int len);
+
+/**
+ * @brief Write json value which is already serialized, such as params from user.
+ *
+ * @param[in,out] writer @see UtilsJsonWriter
+ * @param[in] json json value
+ * @param[in] len json length
+ */
+void utils_json_writer_raw(UtilsJsonWriter *writer, const char *json, int len);
+
+/**
+ * @brief Finish writing, '\0' is appended if buffer is enough.
+ *
+ * @param[in,out] writer @see UtilsJsonWriter
+ * @return length of json, -1 for buffer overflow or containers not closed
+ */
+int utils_json_writer_finish(UtilsJsonWriter *writer);
+
 /**
  * @brief Remove '\\' in json string.
  *
@@ -50,6 +50,20 @@ typedef enum {
     LOG_LEVEL_DEBUG   = 4, /**< debug log level */
 } LogLevel;
 
+/**
+ * @brief Logs of level higher than LOG_MIN_LEVEL are removed when compiling, set by CONFIG_LOG_MIN_LEVEL.
+ *
+ */
+#ifndef LOG_MIN_LEVEL
+#define LOG_MIN_LEVEL LOG_LEVEL_DEBUG
+#endif
+
+/**
+ * @brief Log level set by utils_log_set_level, read by log macros before arguments evaluated.
+ *
+ */
+extern LogLevel g_utils_log_level;
+
 /**
  * @brief User's self defined log handler callback.
  *
@@ -62,6 +76,17 @@ typedef struct {
     char *(*log_get_current_time_str)(void);
 } LogHandleFunc;
 
+/**
+ * @brief Function needed by drain thread of async log.
+ *
+ */
+typedef struct {
+    void *(*log_sem_create)(void);
+    void (*log_sem_destroy)(void *sem);
+    void (*log_sem_post)(void *sem);
+    int (*log_sem_wait)(void *sem, uint32_t timeout_ms);
+} LogAsyncFunc;
+
 /**
  * @brief Init log with func, log level, max log size.
  *
@@ -78,6 +103,29 @@ int utils_log_init(LogHandleFunc func, LogLevel log_level, int max_log_size);
  */
 void utils_log_deinit(void);
 
+/**
+ * @brief Switch log to async, records are formatted and printed by drain thread running utils_log_async_run. Should be
+ * called before other threads logging.
+ *
+ * @param[in] func function needed by drain thread
+ * @param[in] record_num number of records in log ring, logs are dropped when ring is full
+ * @return 0 for success
+ */
+int utils_log_async_init(LogAsyncFunc func, int record_num);
+
+/**
+ * @brief Drain thread entry, returns when utils_log_async_deinit.
+ *
+ * @param[in] arg not used
+ */
+void utils_log_async_run(void *arg);
+
+/**
+ * @brief Stop drain thread and wait for it to exit, log is printed by the thread logging after.
+ *
+ */
+void utils_log_async_deinit(void);
+
 /**
  * @brief Set log level.
  *
@@ -93,7 +141,8 @@ void utils_log_set_level(LogLevel log_level);
 LogLevel utils_log_get_level(void);
 
 /**
- * @brief Generate log if level higher than set.
+ * @brief Generate log if level higher than set, arguments are saved to log ring and formatted when drained, or printed
+ * directly if no ring.
  *
  * @param[in] file file path
  * @param[in] func function where generate log
@@ -103,11 +152,23 @@ LogLevel utils_log_get_level(void);
  */
 void utils_log_gen(const char *file, const char *func, const int line, const int level, const char *fmt, ...);
 
+/**
+ * @brief Generate log only if level enabled, checked before arguments evaluated. Level above LOG_MIN_LEVEL is a false
+ * constant condition, so the call and its strings are removed by compiler even without optimization.
+ *
+ */
+#define UTILS_LOG_GEN(level, fmt, ...)                                                  \
+    do {                                                                                \
+        if ((level) <= LOG_MIN_LEVEL && (level) <= g_utils_log_level) {                 \
+            utils_log_gen(__FILE__, __FUNCTION__, __LINE__, level, fmt, ##__VA_ARGS__); \
+        }                                                                               \
+    } while (0)
+
 // Simple APIs for log generation in different level
-#define Log_d(fmt, ...) utils_log_gen(__FILE__, __FUNCTION__, __LINE__, LOG_LEVEL_DEBUG, fmt, ##__VA_ARGS__)
-#define Log_i(fmt, ...) utils_log_gen(__FILE__, __FUNCTION__, __LINE__, LOG_LEVEL_INFO, fmt, ##__VA_ARGS__)
-#define Log_w(fmt, ...) utils_log_gen(__FILE__, __FUNCTION__, __LINE__, LOG_LEVEL_WARN, fmt, ##__VA_ARGS__)
-#define Log_e(fmt, ...) utils_log_gen(__FILE__, __FUNCTION__, __LINE__, LOG_LEVEL_ERROR, fmt, ##__VA_ARGS__)
+#define Log_d(fmt, ...) UTILS_LOG_GEN(LOG_LEVEL_DEBUG, fmt, ##__VA_ARGS__)
+#define Log_i(fmt, ...) UTILS_LOG_GEN(LOG_LEVEL_INFO, fmt, ##__VA_ARGS__)
+#define Log_w(fmt, ...) UTILS_LOG_GEN(LOG_LEVEL_WARN, fmt, ##__VA_ARGS__)
+#define Log_e(fmt, ...) UTILS_LOG_GEN(LOG_LEVEL_ERROR, fmt, ##__VA_ARGS__)
 
 #ifdef __cplusplus
 }
@@ -29,6 +29,12 @@
 
 #include "utils_json.h"
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 /**
  * @brief Delimiter of json
  *
@@ -48,399 +54,388 @@ typedef enum {
     JSON_DELIMITER_TYPE_BOOLEAN_FALSE_LOWER = 'f',
     JSON_DELIMITER_TYPE_NULL_UPPER          = 'N',
     JSON_DELIMITER_TYPE_NULL_LOWER          = 'n',
+    JSON_DELIMITER_ESCAPE                   = '\\',
     JSON_DELIMITER_SPACE                    = ' ',
     JSON_DELIMITER_NONE                     = 0,
 } JsonDelimiter;
 
+/**************************************************************************************
+ * structural scan
+ **************************************************************************************/
+
+#if defined(__AVX2__) || defined(__SSE2__)
+
 /**
- * @brief Element type support
+ * @brief Vector to compare 32 bytes (AVX2) or 16 bytes (SSE2) at a time.
  *
  */
-typedef enum {
-    JSON_ELEMENT_ARRAY = 0,
-    JSON_ELEMENT_OBJECT,
-    JSON_ELEMENT_VALUE_STRING,
-    JSON_ELEMENT_VALUE_NUMBER,
-    JSON_ELEMENT_VALUE_BOOLEAN,
-    JSON_ELEMENT_VALUE_NULL,
-    JSON_ELEMENT_KEY,
-} JsonElementType;
+#if defined(__AVX2__)
+#define JSON_VECTOR_SIZE 32
+typedef __m256i JsonVector;
+#define _json_vector_load(p)      _mm256_loadu_si256((const __m256i *)(p))
+#define _json_vector_eq(v, c)     ((uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(c))))
+#define _json_vector_or(v, c)     _mm256_or_si256(v, _mm256_set1_epi8(c))
+#else
+#define JSON_VECTOR_SIZE 16
+typedef __m128i JsonVector;
+#define _json_vector_load(p)      _mm_loadu_si128((const __m128i *)(p))
+#define _json_vector_eq(v, c)     ((uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8(c))))
+#define _json_vector_or(v, c)     _mm_or_si128(v, _mm_set1_epi8(c))
+#endif
 
 /**
- * @brief Json Element
+ * @brief Size of block classified at a time, one bit for one byte.
  *
  */
-typedef struct {
-    JsonElementType type;
-    char *          pos_begin;
-    char *          pos_end;
-    int             element_len;
-} JsonElement;
-
-#define json_key   JsonElement
-#define json_value JsonElement
+#define JSON_BLOCK_SIZE 64
 
 /**
- * @brief Is delimiter begin or end matched
+ * @brief Bitmap of structural characters in block.
  *
  */
 typedef struct {
-    int (*is_begin_matched)(char *str);
-    int (*is_end_matched)(char *str, int *offset);
-} IsDelimiterMatched;
+    uint64_t quote;     /**< '"' */
+    uint64_t backslash; /**< '\\' */
+    uint64_t open;      /**< '{' or '[' */
+    uint64_t close;     /**< '}' or ']' */
+} JsonBlock;
 
 /**
- * @brief For array type, when meets '[', means depth++
+ * @brief Classify structural characters of block, bytes beyond end are taken as space.
  *
- * @param[in] str pointer to char
- * @return true for matched
+ * @param[in] pos block begin
+ * @param[in] end end of json
+ * @param[out] block @see JsonBlock
  */
-static int _is_array_begin_matched(char *str)
+static void _json_block_classify(const char *pos, const char *end, JsonBlock *block)
 {
-    return *str == JSON_DELIMITER_ARRAY_BEGIN;
-}
+    char       buf[JSON_BLOCK_SIZE];
+    JsonVector v, v_lower;
+    uint64_t   shift;
+    int        i;
 
-/**
- * @brief For array type, when meets ']', means depth--
- *
- * @param[in] str pointer to char
- * @param[out] offset offset for pointer to move
- * @return true for matched
- */
-static int _is_array_end_matched(char *str, int *offset)
-{
-    return *str == JSON_DELIMITER_ARRAY_END;
-}
+    if (end - pos < JSON_BLOCK_SIZE) {
+        memset(buf, ' ', sizeof(buf));
+        memcpy(buf, pos, end - pos);
+        pos = buf;
+    }
 
-/**
- * @brief For object type, when meets '{', means depth++
- *
- * @param[in] str pointer to char
- * @return true for matched
- */
-static int _is_object_begin_matched(char *str)
-{
-    return *str == JSON_DELIMITER_OBJECT_BEGIN;
+    memset(block, 0, sizeof(JsonBlock));
+    for (i = 0; i < JSON_BLOCK_SIZE; i += JSON_VECTOR_SIZE) {
+        shift   = i;
+        v       = _json_vector_load(pos + i);
+        v_lower = _json_vector_or(v, 0x20);  // '[' | 0x20 = '{', ']' | 0x20 = '}'
+        block->quote |= (uint64_t)_json_vector_eq(v, JSON_DELIMITER_TYPE_STRING) << shift;
+        block->backslash |= (uint64_t)_json_vector_eq(v, JSON_DELIMITER_ESCAPE) << shift;
+        block->open |= (uint64_t)_json_vector_eq(v_lower, JSON_DELIMITER_OBJECT_BEGIN) << shift;
+        block->close |= (uint64_t)_json_vector_eq(v_lower, JSON_DELIMITER_OBJECT_END) << shift;
+    }
 }
 
 /**
- * @brief For object type, when meets '}', means depth--
+ * @brief Find characters escaped by odd sequence of backslash, same as simdjson.
  *
- * @param[in] str pointer to char
- * @param[out] offset offset for pointer to move
- * @return true for matched
+ * @param[in] backslash bitmap of backslash
+ * @param[in,out] prev_escaped whether first character of next block is escaped
+ * @return bitmap of escaped characters
  */
-static int _is_object_end_matched(char *str, int *offset)
+static uint64_t _json_block_escaped(uint64_t backslash, uint64_t *prev_escaped)
 {
-    return *str == JSON_DELIMITER_OBJECT_END;
+    const uint64_t even_bits = 0x5555555555555555ULL;
+
+    uint64_t follows_escape, odd_starts, even_sequences, escaped;
+
+    backslash &= ~*prev_escaped;
+    follows_escape = backslash << 1 | *prev_escaped;
+    odd_starts     = backslash & ~even_bits & ~follows_escape;
+    even_sequences = odd_starts + backslash;
+    *prev_escaped  = even_sequences < backslash;  // carry out
+    escaped        = (even_bits ^ (even_sequences << 1)) & follows_escape;
+    return escaped;
 }
 
 /**
- * @brief For string type, when meets '"', but not "\"", means the end
+ * @brief Mark characters between quotes, including the beginning quote.
  *
- * @param[in] str pointer to char
- * @param[out] offset offset for pointer to move
- * @return true for matched
+ * @param[in] quote bitmap of unescaped quotes
+ * @param[in,out] prev_in_string all 1 if block ends in string
+ * @return bitmap of string
  */
-static int _is_string_end_matched(char *str, int *offset)
+static uint64_t _json_block_in_string(uint64_t quote, uint64_t *prev_in_string)
 {
-    return *str == '"' && *(str - 1) != '\\';
+    uint64_t in_string = quote;
+
+    in_string ^= in_string << 1;
+    in_string ^= in_string << 2;
+    in_string ^= in_string << 4;
+    in_string ^= in_string << 8;
+    in_string ^= in_string << 16;
+    in_string ^= in_string << 32;
+    in_string ^= *prev_in_string;
+
+    *prev_in_string = (uint64_t)((int64_t)in_string >> 63);
+    return in_string;
 }
 
 /**
- * @brief For number type, when meets not '0~9', '.' or 'f' for float, means the end
+ * @brief Find first '"' or '\\' from pos.
  *
- * @param[in] str pointer to char
- * @param[out] offset offset for pointer to move
- * @return true for matched
+ * @param[in] pos pos to search
+ * @param[in] end end of json
+ * @return pos found, end if not found
  */
-static int _is_number_end_matched(char *str, int *offset)
+static const char *_json_find_string_special(const char *pos, const char *end)
 {
-    return (*str < '0' || *str > '9') && *str != '.' && *str != 'f' && *str != '-';
+    JsonVector v;
+    uint32_t   mask;
+
+    while (end - pos >= JSON_VECTOR_SIZE) {
+        v    = _json_vector_load(pos);
+        mask = _json_vector_eq(v, JSON_DELIMITER_TYPE_STRING) | _json_vector_eq(v, JSON_DELIMITER_ESCAPE);
+        if (mask) {
+            return pos + __builtin_ctz(mask);
+        }
+        pos += JSON_VECTOR_SIZE;
+    }
+
+    while (pos < end && *pos != JSON_DELIMITER_TYPE_STRING && *pos != JSON_DELIMITER_ESCAPE) {
+        pos++;
+    }
+    return pos;
 }
 
 /**
- * @brief For boolen type, when meets "true", "True", "false" or "False", means the end
+ * @brief Find end of object or array, block by block. Brackets in string are filtered by bitmap.
  *
- * @param[in] str pointer to char
- * @param[out] offset offset for pointer to move, -1 means error
- * @return true for matched
+ * @param[in] pos pos of the beginning '{' or '['
+ * @param[in] end end of json
+ * @return pos after the ending '}' or ']', NULL for failed
  */
-static int _is_boolean_end_matched(char *str, int *offset)
+static const char *_json_skip_container(const char *pos, const char *end)
 {
-    *offset = !strncmp(str, "true", 4) || !strncmp(str, "TRUE", 4) ? 4 : *offset;
-    *offset = !strncmp(str, "false", 5) || !strncmp(str, "FALSE", 5) ? 5 : *offset;
-    if (*offset == 0) {
-        *offset = -1;  // -1 means error
+    JsonBlock block;
+    uint64_t  prev_escaped = 0, prev_in_string = 0;
+    uint64_t  in_string, open, close, structural;
+    int       depth = 0;
+
+    for (; pos < end; pos += JSON_BLOCK_SIZE) {
+        _json_block_classify(pos, end, &block);
+        in_string = _json_block_in_string(block.quote & ~_json_block_escaped(block.backslash, &prev_escaped),
+                                          &prev_in_string);
+
+        open  = block.open & ~in_string;
+        close = block.close & ~in_string;
+
+        // container could not end in this block
+        if (__builtin_popcountll(close) < depth) {
+            depth += __builtin_popcountll(open) - __builtin_popcountll(close);
+            continue;
+        }
+
+        structural = open | close;
+        while (structural) {
+            depth += (open & structural & -structural) ? 1 : -1;
+            if (!depth) {
+                return pos + __builtin_ctzll(structural) + 1;
+            }
+            structural &= structural - 1;
+        }
     }
-    return 1;
+    return NULL;
 }
 
+#else
+
 /**
- * @brief For boolen type, when meets "null", "NULL", means the end
+ * @brief Find first '"' or '\\' from pos.
  *
- * @param[in] str pointer to char
- * @param[out] offset offset for pointer to move, -1 means error
- * @return true for matched
+ * @param[in] pos pos to search
+ * @param[in] end end of json
+ * @return pos found, end if not found
  */
-static int _is_null_end_matched(char *str, int *offset)
+static const char *_json_find_string_special(const char *pos, const char *end)
 {
-    *offset = !strncmp(str, "null", 4) || !strncmp(str, "NULL", 4) ? 4 : 0;
-    if (*offset == 0) {
-        *offset = -1;  // -1 means error
+    while (pos < end && *pos != JSON_DELIMITER_TYPE_STRING && *pos != JSON_DELIMITER_ESCAPE) {
+        pos++;
     }
-    return 1;
+    return pos;
 }
 
-/**
- * @brief Table of matched function of elements
- *
- */
-static IsDelimiterMatched sg_element_matched_func[] = {
-    {_is_array_begin_matched, _is_array_end_matched},    // JSON_ELEMENT_ARRAY
-    {_is_object_begin_matched, _is_object_end_matched},  // JSON_ELEMENT_OBJECT
-    {NULL, _is_string_end_matched},                      // JSON_ELEMENT_VALUE_STRING
-    {NULL, _is_number_end_matched},                      // JSON_ELEMENT_VALUE_NUMBER
-    {NULL, _is_boolean_end_matched},                     // JSON_ELEMENT_VALUE_BOOLEAN
-    {NULL, _is_null_end_matched},                        // JSON_ELEMENT_VALUE_NULL
-    {NULL, NULL},                                        // JSON_ELEMENT_KEY
-};
+static const char *_json_skip_string(const char *pos, const char *end);
 
 /**
- * @brief Increase pos and decrease remain len
+ * @brief Find end of object or array, strings are skipped as a whole.
  *
- * @param[in,out] pos current pos
- * @param[in,out] len current len
+ * @param[in] pos pos of the beginning '{' or '['
+ * @param[in] end end of json
+ * @return pos after the ending '}' or ']', NULL for failed
  */
-static void _increase_pos(char **pos, int *len)
+static const char *_json_skip_container(const char *pos, const char *end)
 {
-    (*pos)++;
-    (*len)--;
-};
+    int depth = 0;
+
+    while (pos < end) {
+        switch (*pos) {
+            case JSON_DELIMITER_TYPE_STRING:
+                pos = _json_skip_string(pos + 1, end);
+                if (!pos) {
+                    return NULL;
+                }
+                break;
+            case JSON_DELIMITER_OBJECT_BEGIN:
+            case JSON_DELIMITER_ARRAY_BEGIN:
+                depth++;
+                break;
+            case JSON_DELIMITER_OBJECT_END:
+            case JSON_DELIMITER_ARRAY_END:
+                if (!--depth) {
+                    return pos + 1;
+                }
+                break;
+            default:
+                break;
+        }
+        pos++;
+    }
+    return NULL;
+}
+
+#endif
 
 /**
- * @brief Find delimiter and return pos
+ * @brief Skip space characters.
  *
- * @param[in] ch delimiter character
- * @param[in] spilt_char if 0 then spilt nothing but delimiter
- * @param[in] str input string
- * @param[in,out] remain_len remaining length
- * @return NULL for failed
+ * @param[in] pos current pos
+ * @param[in] end end of json
+ * @return first non-space pos, end if not found
  */
-static char *_find_json_delimiter(JsonDelimiter ch, char spilt_char, char *str, int *remain_len)
+static const char *_json_skip_space(const char *pos, const char *end)
 {
-    char *pos = NULL;
-
-    while ((*remain_len) > 0 && str && *str) {
-        if ((!spilt_char && *str != ch) || (spilt_char && *str == spilt_char)) {
-            _increase_pos(&str, remain_len);
-            continue;
-        }
-
-        pos = (*str == ch) ? str : 0;
-        break;
+    while (pos < end && (*pos == ' ' || *pos == '\t' || *pos == '\r' || *pos == '\n')) {
+        pos++;
     }
-
     return pos;
 }
 
 /**
- * @brief Find element end
+ * @brief Find end of string.
  *
- * @param[in] is_begin_matched using in nesting
- * @param[in] is_end_matched match end
- * @param[in] str input string
- * @param[in,out] remain_len remaining length
- * @return NULL for failed
+ * @param[in] pos pos after the beginning '"'
+ * @param[in] end end of json
+ * @return pos of the ending '"', NULL for failed
  */
-static char *_find_json_value_element_end(int (*is_begin_matched)(char *), int (*is_end_matched)(char *, int *),
-                                          char *str, int *remain_len)
+static const char *_json_skip_string(const char *pos, const char *end)
 {
-    int   offset = 0;
-    int   depth  = 0;
-    char *pos    = NULL;
-
-    while (str && *str) {
-        offset = 0;
-
-        if (*remain_len <= 0) {
-            return NULL;
-        }
-
-        if (is_begin_matched) {
-            if (is_begin_matched(str)) {
-                depth++;
-            }
+    while (pos < end) {
+        pos = _json_find_string_special(pos, end);
+        if (pos >= end) {
+            break;
         }
-
-        if (is_end_matched(str, &offset)) {
-            if (!depth) {
-                if (offset < 0) {
-                    break;  // failed
-                }
-                pos = str + offset;
-                (*remain_len) -= offset;
-                break;
-            }
-
-            if (depth > 0) {
-                depth--;
-            }
+        if (*pos == JSON_DELIMITER_TYPE_STRING) {
+            return pos;
         }
-
-        str++;
-        (*remain_len)--;
+        pos += 2;  // escape
     }
-
-    return pos;
+    return NULL;
 }
 
 /**
- * @brief Get json key from string
+ * @brief Find end of number, boolean or null.
  *
- * @param[in] node_begin string begin
- * @param[in,out] remain_len remaining length
- * @param[out] key key node
- * @return 0 for success
+ * @param[in] pos pos of the first character
+ * @param[in] end end of json
+ * @return pos after the last character, NULL for empty
  */
-static int _get_json_key(char *node_begin, int *remain_len, json_key *key)
+static const char *_json_skip_scalar(const char *pos, const char *end)
 {
-    char *key_begin = _find_json_delimiter(JSON_DELIMITER_KEY, JSON_DELIMITER_SPACE, node_begin, remain_len);
-    if (!key_begin) {
-        return -1;
-    }
-    _increase_pos(&key_begin, remain_len);
+    const char *begin = pos;
 
-    char *key_end = _find_json_delimiter(JSON_DELIMITER_KEY, JSON_DELIMITER_NONE, key_begin, remain_len);
-    if (!key_end) {
-        return -1;
+    while (pos < end && *pos != JSON_DELIMITER_ELEMENT_END && *pos != JSON_DELIMITER_OBJECT_END &&
+           *pos != JSON_DELIMITER_ARRAY_END && *pos != ' ' && *pos != '\t' && *pos != '\r' && *pos != '\n') {
+        pos++;
     }
-
-    key->type        = JSON_ELEMENT_KEY;
-    key->pos_begin   = key_begin;
-    key->pos_end     = key_end;
-    key->element_len = key_end - key_begin;
-    return 0;
+    return pos > begin ? pos : NULL;
 }
 
 /**
- * @brief Get json value from key end
+ * @brief Find end of value.
  *
- * @param[in] key_end end of key
- * @param[in,out] remain_len remaining length
- * @param[out] value value node
- * @return 0 for success
+ * @param[in] pos pos of the first character of value
+ * @param[in] end end of json
+ * @return pos after value, NULL for failed
  */
-static int _get_json_value(char *key_end, int *remain_len, json_value *value)
+static const char *_json_skip_value(const char *pos, const char *end)
 {
-    char *value_begin = _find_json_delimiter(JSON_DELIMITER_VALUE, JSON_DELIMITER_SPACE, key_end, remain_len);
-    if (!value_begin) {
-        return -1;
-    }
-    _increase_pos(&value_begin, remain_len);
-
-    // filter all the space
-    while (*value_begin == ' ') {
-        value_begin++;
-        (*remain_len)--;
-        if (*remain_len <= 0) {
-            return -1;
-        }
-    };
-
-    JsonElementType type;
-
-    char *value_end = NULL;
-
-    switch (*value_begin) {
-        case JSON_DELIMITER_ARRAY_BEGIN:
-            // should + 1 for escape first [
-            _increase_pos(&value_begin, remain_len);
-            type = JSON_ELEMENT_ARRAY;
-            break;
-        case JSON_DELIMITER_OBJECT_BEGIN:
-            // should + 1 for escape first {
-            _increase_pos(&value_begin, remain_len);
-            type = JSON_ELEMENT_OBJECT;
-            break;
+    switch (*pos) {
         case JSON_DELIMITER_TYPE_STRING:
-            // should + 1 for escape first "
-            _increase_pos(&value_begin, remain_len);
-            type = JSON_ELEMENT_VALUE_STRING;
-            break;
-        case JSON_DELIMITER_TYPE_BOOLEAN_TRUE_UPPER:
-        case JSON_DELIMITER_TYPE_BOOLEAN_TRUE_LOWER:
-        case JSON_DELIMITER_TYPE_BOOLEAN_FALSE_UPPER:
-        case JSON_DELIMITER_TYPE_BOOLEAN_FALSE_LOWER:
-            type = JSON_ELEMENT_VALUE_BOOLEAN;
-            break;
-        case JSON_DELIMITER_TYPE_NULL_UPPER:
-        case JSON_DELIMITER_TYPE_NULL_LOWER:
-            type = JSON_ELEMENT_VALUE_NULL;
-            break;
+            pos = _json_skip_string(pos + 1, end);
+            return pos ? pos + 1 : NULL;
+        case JSON_DELIMITER_OBJECT_BEGIN:
+        case JSON_DELIMITER_ARRAY_BEGIN:
+            return _json_skip_container(pos, end);
         default:
-            type = JSON_ELEMENT_VALUE_NUMBER;
-            break;
-    }
-
-    value_end = _find_json_value_element_end(sg_element_matched_func[type].is_begin_matched,
-                                             sg_element_matched_func[type].is_end_matched, value_begin, remain_len);
-    if (!value_end) {
-        return -1;
+            return _json_skip_scalar(pos, end);
     }
-
-    int is_object_or_array           = (type == JSON_ELEMENT_ARRAY || type == JSON_ELEMENT_OBJECT);
-    int is_object_or_array_or_string = (is_object_or_array || type == JSON_ELEMENT_VALUE_STRING);
-
-    value->type        = type;
-    value->pos_begin   = value_begin - is_object_or_array;                   // include '[' or '{'
-    value->element_len = value_end - value->pos_begin + is_object_or_array;  // include ']' or '}'
-    value->pos_end     = value_end + is_object_or_array_or_string;           // filter '"' , ']' or '}'
-    return 0;
 }
 
 /**
- * @brief Get value by key from json string
+ * @brief Get value by key from json object, values of other keys are skipped as a whole.
  *
  * @param[in] str json string
  * @param[in] str_len strign length
  * @param[in] key key
  * @param[in] key_len key length
- * @param[out] value value
+ * @param[out] value value, '"' of string is excluded
  * @return 0 for success
  */
-int json_get_value_by_key(const char *str, int str_len, const char *key, int key_len, json_value *value)
+static int _json_get_value_by_key(const char *str, int str_len, const char *key, int key_len, UtilsJsonValue *value)
 {
-    int      rc           = 0;
-    char *   object_begin = NULL;
-    json_key key_found    = {JSON_ELEMENT_KEY, 0, 0, 0};
+    const char *end = str + str_len;
+    const char *pos = _json_skip_space(str, end);
+    const char *member_key, *value_end;
 
-    object_begin = _find_json_delimiter(JSON_DELIMITER_OBJECT_BEGIN, JSON_DELIMITER_SPACE, (char *)str, &str_len);
-    if (!object_begin) {
+    if (pos >= end || *pos != JSON_DELIMITER_OBJECT_BEGIN) {
         return -1;
     }
-    _increase_pos(&object_begin, &str_len);
+    pos = _json_skip_space(pos + 1, end);
 
-    do {
-        rc = _get_json_key(object_begin, &str_len, &key_found);
-        if (rc) {
-            break;
+    while (pos < end && *pos == JSON_DELIMITER_KEY) {
+        member_key = pos + 1;
+        pos        = _json_skip_string(member_key, end);
+        if (!pos) {
+            return -1;
         }
-        _increase_pos(&key_found.pos_end, &str_len);
 
-        rc = _get_json_value(key_found.pos_end, &str_len, value);
-        if (rc) {
-            break;
+        int is_matched = pos - member_key == key_len && !memcmp(member_key, key, key_len);
+
+        pos = _json_skip_space(pos + 1, end);
+        if (pos >= end || *pos != JSON_DELIMITER_VALUE) {
+            return -1;
+        }
+        pos = _json_skip_space(pos + 1, end);
+        if (pos >= end) {
+            return -1;
         }
 
-        // NULL of object begin can be ok for reach the end of str
-        object_begin = _find_json_delimiter(JSON_DELIMITER_ELEMENT_END, JSON_DELIMITER_SPACE, value->pos_end, &str_len);
-        if (object_begin) {
-            _increase_pos(&object_begin, &str_len);
+        value_end = _json_skip_value(pos, end);
+        if (!value_end) {
+            return -1;
+        }
+
+        if (is_matched) {
+            int is_string    = *pos == JSON_DELIMITER_TYPE_STRING;
+            value->value     = pos + is_string;
+            value->value_len = value_end - pos - 2 * is_string;
+            return 0;
         }
-    } while (key_len != key_found.element_len || strncmp(key, key_found.pos_begin, key_found.element_len));
 
-    return rc;
+        pos = _json_skip_space(value_end, end);
+        if (pos >= end || *pos != JSON_DELIMITER_ELEMENT_END) {
+            return -1;
+        }
+        pos = _json_skip_space(pos + 1, end);
+    }
+    return -1;
 }
 
 /**
@@ -457,39 +452,22 @@ int utils_json_value_get(const char *key, int key_len, const char *src, int src_
 {
     int rc = 0;
 
-    char *delim        = NULL;
-    char *src_iter     = (char *)src;
-    int   src_iter_len = src_len;
-    char *key_iter     = (char *)key;
-    char *key_next     = NULL;
-    int   key_next_len = 0;
+    const char *delim;
+    const char *key_end = key + key_len;
 
-    json_value value_tmp;
+    UtilsJsonValue value_tmp = {src, src_len};
 
     // key can be separated by '.', such as: outer_key.(.......).inner_key
-    while ((delim = strchr(key_iter, '.'))) {
-        key_next     = key_iter;
-        key_next_len = delim - key_iter;
-
-        rc = json_get_value_by_key(src_iter, src_iter_len, key_next, key_next_len, &value_tmp);
+    while ((delim = memchr(key, '.', key_end - key))) {
+        rc = _json_get_value_by_key(value_tmp.value, value_tmp.value_len, key, delim - key, &value_tmp);
         if (rc) {
             return rc;
         }
-
-        src_iter     = value_tmp.pos_begin;
-        src_iter_len = value_tmp.element_len;
-        key_iter     = delim + 1;
+        key = delim + 1;
     }
 
     // found inner key and get value
-    rc = json_get_value_by_key(src_iter, src_iter_len, key_iter, key_len + key - key_iter, &value_tmp);
-    if (rc) {
-        return rc;
-    }
-
-    value->value     = value_tmp.pos_begin;
-    value->value_len = value_tmp.element_len;
-    return 0;
+    return _json_get_value_by_key(value_tmp.value, value_tmp.value_len, key, key_end - key, value);
 }
 
 /**
@@ -554,6 +532,737 @@ int utils_json_get_uint32(const char *key, int key_len, const char *src, int src
     return 0;
 }
 
+/**
+ * @brief Context of json index.
+ *
+ */
+typedef struct {
+    const char     *end;
+    UtilsJsonToken *tokens;
+    int             max_tokens;
+    int             max_depth;
+    int             num;
+    int             overflow;
+} JsonIndexContext;
+
+/**
+ * @brief Index value and its children, tokens of children are not stored beyond max depth or max tokens.
+ *
+ * @param[in,out] ctx @see JsonIndexContext
+ * @param[in] pos pos of the first character of value
+ * @param[in] key key of value, NULL for root and array element
+ * @param[in] key_len key length
+ * @param[in] depth depth of value
+ * @return pos after value, NULL for invalid json
+ */
+static const char *_json_index_value(JsonIndexContext *ctx, const char *pos, const char *key, int key_len, int depth)
+{
+    const char     *begin = pos;
+    const char     *end   = ctx->end;
+    const char     *member_key;
+    UtilsJsonToken *token;
+    char            container_end;
+    int             index = ctx->num++;
+
+    token          = &ctx->tokens[index];
+    token->key     = key;
+    token->key_len = key_len;
+    token->depth   = depth;
+    token->partial = 0;
+
+    switch (*pos) {
+        case JSON_DELIMITER_OBJECT_BEGIN:
+        case JSON_DELIMITER_ARRAY_BEGIN:
+            token->type = *pos == JSON_DELIMITER_OBJECT_BEGIN ? UTILS_JSON_TOKEN_TYPE_OBJECT
+                                                              : UTILS_JSON_TOKEN_TYPE_ARRAY;
+            container_end = *pos == JSON_DELIMITER_OBJECT_BEGIN ? JSON_DELIMITER_OBJECT_END
+                                                                : JSON_DELIMITER_ARRAY_END;
+            if (depth >= ctx->max_depth) {
+                token->partial = 1;
+                pos            = _json_skip_container(pos, end);
+                break;
+            }
+
+            pos = _json_skip_space(pos + 1, end);
+            if (pos < end && *pos == container_end) {
+                pos++;
+                break;
+            }
+
+            while (pos < end) {
+                member_key = NULL;
+                key_len    = 0;
+                if (token->type == UTILS_JSON_TOKEN_TYPE_OBJECT) {
+                    if (*pos != JSON_DELIMITER_KEY) {
+                        return NULL;
+                    }
+                    member_key = pos + 1;
+                    pos        = _json_skip_string(member_key, end);
+                    if (!pos) {
+                        return NULL;
+                    }
+                    key_len = pos - member_key;
+                    pos     = _json_skip_space(pos + 1, end);
+                    if (pos >= end || *pos != JSON_DELIMITER_VALUE) {
+                        return NULL;
+                    }
+                    pos = _json_skip_space(pos + 1, end);
+                }
+                if (pos >= end) {
+                    return NULL;
+                }
+
+                if (ctx->num < ctx->max_tokens) {
+                    pos = _json_index_value(ctx, pos, member_key, key_len, depth + 1);
+                } else {
+                    ctx->overflow = 1;
+                    pos           = _json_skip_value(pos, end);
+                }
+                if (!pos) {
+                    return NULL;
+                }
+
+                pos = _json_skip_space(pos, end);
+                if (pos < end && *pos == JSON_DELIMITER_ELEMENT_END) {
+                    pos = _json_skip_space(pos + 1, end);
+                    continue;
+                }
+                if (pos < end && *pos == container_end) {
+                    pos++;
+                    break;
+                }
+                return NULL;
+            }
+            // children after overflow are not indexed
+            token->partial = ctx->overflow;
+            break;
+        case JSON_DELIMITER_TYPE_STRING:
+            token->type        = UTILS_JSON_TOKEN_TYPE_STRING;
+            token->value.value = pos + 1;
+            pos                = _json_skip_string(pos + 1, end);
+            if (!pos) {
+                return NULL;
+            }
+            token->value.value_len = pos - token->value.value;
+            token->next            = ctx->num;
+            return pos + 1;
+        case JSON_DELIMITER_TYPE_BOOLEAN_TRUE_UPPER:
+        case JSON_DELIMITER_TYPE_BOOLEAN_TRUE_LOWER:
+        case JSON_DELIMITER_TYPE_BOOLEAN_FALSE_UPPER:
+        case JSON_DELIMITER_TYPE_BOOLEAN_FALSE_LOWER:
+            token->type = UTILS_JSON_TOKEN_TYPE_BOOLEAN;
+            pos         = _json_skip_scalar(pos, end);
+            break;
+        case JSON_DELIMITER_TYPE_NULL_UPPER:
+        case JSON_DELIMITER_TYPE_NULL_LOWER:
+            token->type = UTILS_JSON_TOKEN_TYPE_NULL;
+            pos         = _json_skip_scalar(pos, end);
+            break;
+        default:
+            token->type = UTILS_JSON_TOKEN_TYPE_NUMBER;
+            pos         = _json_skip_scalar(pos, end);
+            break;
+    }
+
+    if (!pos) {
+        return NULL;
+    }
+    token->value.value     = begin;
+    token->value.value_len = pos - begin;
+    token->next            = ctx->num;
+    return pos;
+}
+
+/**
+ * @brief Index json string in one pass. Containers deeper than max depth or beyond max tokens are not indexed but
+ * marked partial, lookups in them fall back to utils_json_value_get, so the index never fails for lack of tokens.
+ *
+ * @param[in] src json string
+ * @param[in] src_len src length
+ * @param[in] max_depth depth of tokens to index, 1 for members of root only
+ * @param[out] tokens token array provided by caller
+ * @param[in] max_tokens size of token array, no more than 65535
+ * @return number of tokens, -1 for invalid json
+ */
+int utils_json_index_parse(const char *src, int src_len, int max_depth, UtilsJsonToken *tokens, int max_tokens)
+{
+    const char      *pos;
+    JsonIndexContext ctx = {src + src_len, tokens, max_tokens > UINT16_MAX ? UINT16_MAX : max_tokens, max_depth, 0, 0};
+
+    if (!src || !tokens || max_tokens <= 0) {
+        return -1;
+    }
+
+    pos = _json_skip_space(src, ctx.end);
+    if (pos >= ctx.end || (*pos != JSON_DELIMITER_OBJECT_BEGIN && *pos != JSON_DELIMITER_ARRAY_BEGIN)) {
+        return -1;
+    }
+
+    pos = _json_index_value(&ctx, pos, NULL, 0, 0);
+    return pos ? ctx.num : -1;
+}
+
+/**
+ * @brief Find member of object token.
+ *
+ * @param[in] tokens tokens returned by utils_json_index_parse
+ * @param[in] parent index of object token
+ * @param[in] hint index of token to start search, 0 to search from first
+ * @param[in] key member key
+ * @param[in] key_len key len
+ * @return index of member, -1 for not found
+ */
+static int _json_index_member_find(const UtilsJsonToken *tokens, int parent, int hint, const char *key, int key_len)
+{
+    int i, first = parent + 1, last = tokens[parent].next;
+
+    if (tokens[parent].type != UTILS_JSON_TOKEN_TYPE_OBJECT) {
+        return -1;
+    }
+
+    hint = hint > parent && hint < last ? hint : first;
+    for (i = hint; i < last; i = tokens[i].next) {
+        if (tokens[i].key_len == key_len && !memcmp(tokens[i].key, key, key_len)) {
+            return i;
+        }
+    }
+    for (i = first; i < hint; i = tokens[i].next) {
+        if (tokens[i].key_len == key_len && !memcmp(tokens[i].key, key, key_len)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Get value from json index, same as utils_json_value_get.
+ *
+ * @param[in] tokens tokens returned by utils_json_index_parse
+ * @param[in] num number of tokens
+ * @param[in] key key in json, support nesting with '.'
+ * @param[in] key_len key len
+ * @param[out] value value
+ * @return 0 for success
+ */
+int utils_json_index_value_get(const UtilsJsonToken *tokens, int num, const char *key, int key_len,
+                               UtilsJsonValue *value)
+{
+    int         parent = 0, index;
+    const char *key_end = key + key_len;
+    const char *delim;
+
+    if (num <= 0) {
+        return -1;
+    }
+
+    // key can be separated by '.', such as: outer_key.(.......).inner_key
+    while (1) {
+        delim = memchr(key, '.', key_end - key);
+        index = _json_index_member_find(tokens, parent, 0, key, delim ? delim - key : key_end - key);
+        if (index < 0) {
+            return tokens[parent].partial && tokens[parent].type == UTILS_JSON_TOKEN_TYPE_OBJECT
+                       ? utils_json_value_get(key, key_end - key, tokens[parent].value.value,
+                                              tokens[parent].value.value_len, value)
+                       : -1;
+        }
+
+        if (!delim) {
+            *value = tokens[index].value;
+            return 0;
+        }
+        parent = index;
+        key    = delim + 1;
+    }
+}
+
+/**
+ * @brief Get member value of object token. Search starts from hint and wraps around, so looking up members in the
+ * order of json costs O(1) each.
+ *
+ * @param[in] tokens tokens returned by utils_json_index_parse
+ * @param[in] parent index of object token, 0 for root
+ * @param[in,out] hint index of token to start search, updated to the next sibling of found, NULL to search from first
+ * @param[in] key member key, no nesting
+ * @param[in] key_len key len
+ * @param[out] value value
+ * @return 0 for success
+ */
+int utils_json_index_member_get(const UtilsJsonToken *tokens, int parent, int *hint, const char *key, int key_len,
+                                UtilsJsonValue *value)
+{
+    int index = _json_index_member_find(tokens, parent, hint ? *hint : 0, key, key_len);
+    if (index >= 0) {
+        *value = tokens[index].value;
+        if (hint) {
+            *hint = tokens[index].next;
+        }
+        return 0;
+    }
+
+    if (!tokens[parent].partial || tokens[parent].type != UTILS_JSON_TOKEN_TYPE_OBJECT) {
+        return -1;
+    }
+    return _json_get_value_by_key(tokens[parent].value.value, tokens[parent].value.value_len, key, key_len, value);
+}
+
+/**
+ * @brief Two digits of 00 ~ 99, to format integer two digits at a time.
+ *
+ */
+static const char sg_json_digits[] =
+    "0001020304050607080910111213141516171819"
+    "2021222324252627282930313233343536373839"
+    "4041424344454647484950515253545556575859"
+    "6061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+/**
+ * @brief Format unsigned integer backward from end of buffer.
+ *
+ * @param[in] value value
+ * @param[out] end end of buffer, at least 20 bytes before
+ * @return begin of digits
+ */
+static char *_json_uint_format(uint64_t value, char *end)
+{
+    int index;
+
+    while (value >= 100) {
+        index  = (value % 100) * 2;
+        value /= 100;
+        *--end = sg_json_digits[index + 1];
+        *--end = sg_json_digits[index];
+    }
+
+    if (value >= 10) {
+        index  = value * 2;
+        *--end = sg_json_digits[index + 1];
+        *--end = sg_json_digits[index];
+    } else {
+        *--end = '0' + value;
+    }
+    return end;
+}
+
+/**
+ * @brief Format integer backward from end of buffer.
+ *
+ * @param[in] value value
+ * @param[out] end end of buffer, at least 21 bytes before
+ * @return begin of digits
+ */
+static char *_json_int_format(int64_t value, char *end)
+{
+    char *begin;
+
+    if (value >= 0) {
+        return _json_uint_format(value, end);
+    }
+    begin    = _json_uint_format(-(uint64_t)value, end);
+    *--begin = '-';
+    return begin;
+}
+
+/**
+ * @brief Append data to buffer, mark overflow if buffer is not enough.
+ *
+ * @param[in,out] writer @see UtilsJsonWriter
+ * @param[in] data data to append
+ * @param[in] len data length
+ */
+static void _json_writer_append(UtilsJsonWriter *writer, const char *data, int len)
+{
+    if (writer->overflow) {
+        return;
+    }
+
+    if (len > writer->buf_len - writer->len) {
+        writer->overflow = 1;
+        return;
+    }
+    memcpy(writer->buf + writer->len, data, len);
+    writer->len += len;
+}
+
+/**
+ * @brief Add ',' if it is not the first element of container.
+ *
+ * @param[in,out] writer @see UtilsJsonWriter
+ */
+static void _json_writer_element_begin(UtilsJsonWriter *writer)
+{
+    uint32_t bit;
+
+    if (writer->after_key) {
+        writer->after_key = 0;
+        return;
+    }
+
+    if (!writer->depth) {
+        return;
+    }
+
+    bit = 1u << (writer->depth - 1);
+    if (writer->has_member & bit) {
+        _json_writer_append(writer, ",", 1);
+    }
+    writer->has_member |= bit;
+}
+
+/**
+ * @brief Begin container.
+ *
+ * @param[in,out] writer @see UtilsJsonWriter
+ * @param[in] ch '{' or '['
+ */
+static void _json_writer_container_begin(UtilsJsonWriter *writer, char ch)
+{
+    _json_writer_element_begin(writer);
+    _json_writer_append(writer, &ch, 1);
+
+    if (writer->depth >= 32) {
+        writer->overflow = 1;
+        return;
+    }
+    writer->depth++;
+    writer->has_member &= ~(1u << (writer->depth - 1));
+}
+
+/**
+ * @brief End container.
+ *
+ * @param[in,out] writer @see UtilsJsonWriter
+ * @param[in] ch '}' or ']'
+ */
+static void _json_writer_container_end(UtilsJsonWriter *writer, char ch)
+{
+    if (!writer->depth || writer->after_key) {
+        writer->overflow = 1;
+        return;
+    }
+    _json_writer_append(writer, &ch, 1);
+    writer->depth--;
+}
+
+/**
+ * @brief Append string with escaping, without quotes.
+ *
+ * @param[in,out] writer @see UtilsJsonWriter
+ * @param[in] str string
+ * @param[in] len string length
+ */
+static void _json_writer_append_escaped(UtilsJsonWriter *writer, const char *str, int len)
+{
+    const char *end = str + len;
+    const char *run = str;
+
+    char escape[6] = {'\\', 'u', '0', '0'};
+
+    for (; str < end; str++) {
+        unsigned char ch = *str;
+        if (ch >= 0x20 && ch != '"' && ch != '\\') {
+            continue;
+        }
+
+        _json_writer_append(writer, run, str - run);
+        run = str + 1;
+
+        switch (ch) {
+            case '"':
+            case '\\':
+                escape[1] = ch;
+                _json_writer_append(writer, escape, 2);
+                break;
+            case '\n':
+                _json_writer_append(writer, "\\n", 2);
+                break;
+            case '\r':
+                _json_writer_append(writer, "\\r", 2);
+                break;
+            case '\t':
+                _json_writer_append(writer, "\\t", 2);
+                break;
+            default:
+                escape[1] = 'u';
+                escape[4] = "0123456789abcdef"[ch >> 4];
+                escape[5] = "0123456789abcdef"[ch & 0xf];
+                _json_writer_append(writer, escape, 6);
+                break;
+        }
+    }
+    _json_writer_append(writer, run, end - run);
+}
+
+/**
+ * @brief Init json writer.
+ *
+ * @param[out] writer @see UtilsJsonWriter
+ * @param[in] buf buffer to write
+ * @param[in] buf_len buffer length
+ */
+void utils_json_writer_init(UtilsJsonWriter *writer, char *buf, int buf_len)
+{
+    memset(writer, 0, sizeof(UtilsJsonWriter));
+    writer->buf      = buf;
+    writer->buf_len  = buf_len;
+    writer->overflow = !buf || buf_len <= 0;
+}
+
+/**
+ * @brief Begin object, ',' is added between members automatically.
+ *
+ * @param[in,out] writer @see UtilsJsonWriter
+ */
+void utils_json_writer_object_begin(UtilsJsonWriter *writer)
+{
+    _json_writer_container_begin(writer, JSON_DELIMITER_OBJECT_BEGIN);
+}
+
+/**
+ * @brief End object.
+ *
+ * @param[in,out] writer @see UtilsJsonWriter
+ */
+void utils_json_writer_object_end(UtilsJsonWriter *writer)
+{
+    _json_writer_container_end(writer, JSON_DELIMITER_OBJECT_END);
+}
+
+/**
+ * @brief Begin array, ',' is added between elements automatically.
+ *
+ * @param[in,out] writer @see UtilsJsonWriter
+ */
+void utils_json_writer_array_begin(UtilsJsonWriter *writer)
+{
+    _json_writer_container_begin(writer, JSON_DELIMITER_ARRAY_BEGIN);
+}
+
+/**
+ * @brief End array.
+ *
+ * @param[in,out] writer @see UtilsJsonWriter
+ */
+void utils_json_writer_array_end(UtilsJsonWriter *writer)
+{
+    _json_writer_container_end(writer, JSON_DELIMITER_ARRAY_END);
+}
+
+/**
+ * @brief Write key of object member, key is escaped.
+ *
+ * @param[in,out] writer @see UtilsJsonWriter
+ * @param[in] key key
+ * @param[in] key_len key length
+ */
+void utils_json_writer_key(UtilsJsonWriter *writer, const char *key, int key_len)
+{
+    _json_writer_element_begin(writer);
+    _json_writer_append(writer, "\"", 1);
+    _json_writer_append_escaped(writer, key, key_len);
+    _json_writer_append(writer, "\":", 2);
+    writer->after_key = 1;
+}
+
+/**
+ * @brief Write quoted key with ':', use UTILS_JSON_WRITER_KEY instead.
+ *
+ * @param[in,out] writer @see UtilsJsonWriter
+ * @param[in] key_literal key literal, such as "\"key\":"
+ * @param[in] len literal length
+ */
+void utils_json_writer_key_literal(UtilsJsonWriter *writer, const char *key_literal, int len)
+{
+    _json_writer_element_begin(writer);
+    _json_writer_append(writer, key_literal, len);
+    writer->after_key = 1;
+}
+
+/**
+ * @brief Write integer.
+ *
+ * @param[in,out] writer @see UtilsJsonWriter
+ * @param[in] value value
+ */
+void utils_json_writer_int(UtilsJsonWriter *writer, int64_t value)
+{
+    char  buf[24];
+    char *begin = _json_int_format(value, buf + sizeof(buf));
+
+    _json_writer_element_begin(writer);
+    _json_writer_append(writer, begin, buf + sizeof(buf) - begin);
+}
+
+/**
+ * @brief Write unsigned integer.
+ *
+ * @param[in,out] writer @see UtilsJsonWriter
+ * @param[in] value value
+ */
+void utils_json_writer_uint(UtilsJsonWriter *writer, uint64_t value)
+{
+    char  buf[24];
+    char *begin = _json_uint_format(value, buf + sizeof(buf));
+
+    _json_writer_element_begin(writer);
+    _json_writer_append(writer, begin, buf + sizeof(buf) - begin);
+}
+
+/**
+ * @brief Write integer as string, some protocols (such as ota progress) take numbers as string.
+ *
+ * @param[in,out] writer @see UtilsJsonWriter
+ * @param[in] value value
+ */
+void utils_json_writer_int_string(UtilsJsonWriter *writer, int64_t value)
+{
+    char  buf[24];
+    char *begin;
+
+    buf[sizeof(buf) - 1] = '"';
+    begin                = _json_int_format(value, buf + sizeof(buf) - 1);
+    *--begin             = '"';
+
+    _json_writer_element_begin(writer);
+    _json_writer_append(writer, begin, buf + sizeof(buf) - begin);
+}
+
+/**
+ * @brief Write float with 6 decimals at most, trailing zeros are removed. Magnitude not less than 1e12 is written in
+ * %.17g form, NaN and infinity are written as null.
+ *
+ * @param[in,out] writer @see UtilsJsonWriter
+ * @param[in] value value
+ */
+void utils_json_writer_float(UtilsJsonWriter *writer, double value)
+{
+    char     buf[48];
+    char    *begin, *end = buf + sizeof(buf);
+    uint64_t scaled, fraction;
+    int      len, negative = value < 0;
+
+    // NaN or infinity
+    if (!(value - value == 0)) {
+        utils_json_writer_null(writer);
+        return;
+    }
+
+    // too large to scale into uint64, rare in iot, %.17g is exact and at most 24 chars even for DBL_MAX
+    if (value >= 1e12 || value <= -1e12) {
+        len = snprintf(buf, sizeof(buf), "%.17g", value);
+        _json_writer_element_begin(writer);
+        _json_writer_append(writer, buf, len);
+        return;
+    }
+
+    scaled   = (uint64_t)((negative ? -value : value) * 1000000.0 + 0.5);
+    fraction = scaled % 1000000;
+
+    // fraction without trailing zeros
+    begin = end;
+    if (fraction) {
+        len = 6;
+        while (!(fraction % 10)) {
+            fraction /= 10;
+            len--;
+        }
+        begin = _json_uint_format(fraction, end);
+        while (end - begin < len) {
+            *--begin = '0';
+        }
+        *--begin = '.';
+    }
+
+    begin = _json_uint_format(scaled / 1000000, begin);
+    if (negative && scaled) {
+        *--begin = '-';
+    }
+
+    _json_writer_element_begin(writer);
+    _json_writer_append(writer, begin, end - begin);
+}
+
+/**
+ * @brief Write true or false.
+ *
+ * @param[in,out] writer @see UtilsJsonWriter
+ * @param[in] value 0 for false
+ */
+void utils_json_writer_bool(UtilsJsonWriter *writer, int value)
+{
+    _json_writer_element_begin(writer);
+    _json_writer_append(writer, value ? "true" : "false", value ? 4 : 5);
+}
+
+/**
+ * @brief Write null.
+ *
+ * @param[in,out] writer @see UtilsJsonWriter
+ */
+void utils_json_writer_null(UtilsJsonWriter *writer)
+{
+    _json_writer_element_begin(writer);
+    _json_writer_append(writer, "null", 4);
+}
+
+/**
+ * @brief Write string, '"', '\\' and control characters are escaped.
+ *
+ * @param[in,out] writer @see UtilsJsonWriter
+ * @param[in] str string
+ * @param[in] len string length
+ */
+void utils_json_writer_string(UtilsJsonWriter *writer, const char *str, int len)
+{
+    _json_writer_element_begin(writer);
+    _json_writer_append(writer, "\"", 1);
+    _json_writer_append_escaped(writer, str, len);
+    _json_writer_append(writer, "\"", 1);
+}
+
+/**
+ * @brief Write string which is already escaped, such as string value got from json. Only quotes are added.
+ *
+ * @param[in,out] writer @see UtilsJsonWriter
+ * @param[in] str escaped string without quotes
+ * @param[in] len string length
+ */
+void utils_json_writer_string_raw(UtilsJsonWriter *writer, const char *str, int len)
+{
+    _json_writer_element_begin(writer);
+    _json_writer_append(writer, "\"", 1);
+    _json_writer_append(writer, str, len);
+    _json_writer_append(writer, "\"", 1);
+}
+
+/**
+ * @brief Write json value which is already serialized, such as params from user.
+ *
+ * @param[in,out] writer @see UtilsJsonWriter
+ * @param[in] json json value
+ * @param[in] len json length
+ */
+void utils_json_writer_raw(UtilsJsonWriter *writer, const char *json, int len)
+{
+    _json_writer_element_begin(writer);
+    _json_writer_append(writer, json, len);
+}
+
+/**
+ * @brief Finish writing, '\0' is appended if buffer is enough.
+ *
+ * @param[in,out] writer @see UtilsJsonWriter
+ * @return length of json, -1 for buffer overflow or containers not closed
+ */
+int utils_json_writer_finish(UtilsJsonWriter *writer)
+{
+    if (writer->overflow || writer->depth || writer->after_key || writer->len >= writer->buf_len) {
+        return -1;
+    }
+    writer->buf[writer->len] = '\0';
+    return writer->len;
+}
+
 /**
  * @brief Remove '\\' in json string.
  *
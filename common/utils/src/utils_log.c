@@ -28,11 +28,105 @@
 
 #include "utils_log.h"
 
-static const char *  LEVEL_STR[] = {"DIS", "ERR", "WRN", "INF", "DBG"};
+#include "qcloud_iot_config.h"
+
+#include <stddef.h>
+
+/**
+ * @brief Number of records in log ring without drain thread, set by CONFIG_LOG_RING_RECORD_NUM. Logs are printed
+ * directly when it is full. 0 for no ring, which takes the same memory as one log buffer.
+ *
+ */
+#ifndef LOG_RING_RECORD_NUM
+#define LOG_RING_RECORD_NUM (0)
+#endif
+
+/**
+ * @brief Interval for drain thread to check log ring when not woken up (unit: ms)
+ *
+ */
+#define LOG_DRAIN_INTERVAL_MS (100)
+
+/**
+ * @brief Max length of one conversion specification, such as "%-08.3lld".
+ *
+ */
+#define LOG_SPEC_MAX_LEN (32)
+
+/**
+ * @brief Type of argument saved in log record, integers are widened to long long.
+ *
+ */
+typedef enum {
+    LOG_ARG_NONE = 0, /**< "%%" */
+    LOG_ARG_INT,      /**< char */
+    LOG_ARG_LLONG,
+    LOG_ARG_ULLONG,
+    LOG_ARG_DOUBLE,
+    LOG_ARG_LDOUBLE,
+    LOG_ARG_PTR,
+    LOG_ARG_STR,     /**< string copied to record */
+    LOG_ARG_INVALID, /**< not supported, such as "%n", log is formatted when generated */
+} LogArgType;
+
+/**
+ * @brief Conversion specification parsed from format.
+ *
+ */
+typedef struct {
+    const char *begin;         /**< '%' */
+    int         len;           /**< length of specification */
+    int         prefix_len;    /**< length of flags, width and precision, without length modifier */
+    char        conversion;    /**< conversion specifier */
+    uint8_t     width_arg;     /**< width is given by argument */
+    uint8_t     precision_arg; /**< precision is given by argument */
+    int         precision;     /**< precision in format, -1 for none */
+    LogArgType  type;
+} LogSpec;
+
+/**
+ * @brief Log record in ring, time string and arguments are saved right after it in binary and formatted when drained.
+ *
+ */
+typedef struct {
+    uint32_t    seq;       /**< sequence to sync producers and consumer */
+    uint8_t     level;     /**< @see LogLevel */
+    uint8_t     formatted; /**< content after time string is formatted text instead of arguments */
+    int         line;
+    const char *file;
+    const char *func;
+    const char *fmt;
+} LogRecord;
+
+/**
+ * @brief Lock-free ring of log records, any thread claims a record by sequence, while only one thread drains at a
+ * time, either the drain thread or the thread logging when no drain thread.
+ *
+ */
+typedef struct {
+    uint8_t     *records;
+    uint32_t     record_num; /**< power of 2 */
+    size_t       record_size;
+    uint32_t     head;       /**< next record to drain */
+    uint32_t     tail;       /**< next record to claim */
+    int          draining;   /**< one thread is draining or printing directly with scratch */
+    uint32_t     drop_num;   /**< logs dropped for ring full */
+    char        *scratch;    /**< formatting buffer of thread draining */
+    LogAsyncFunc async_func;
+    void        *wake_sem;   /**< posted to wake up drain thread */
+    void        *exit_sem;   /**< posted when drain thread exits */
+    int          running;    /**< 1 after async init, 2 when drain thread runs, cleared to stop drain thread */
+    int          async;      /**< drain thread is running */
+    int          sleeping;   /**< drain thread is waiting for wake_sem */
+    int          writer_num; /**< threads may post wake_sem, deinit waits for them */
+} LogRing;
+
+static const char   *LEVEL_STR[] = {"DIS", "ERR", "WRN", "INF", "DBG"};
 static LogHandleFunc sg_log_handle_func;
-static char *        sg_log_buffer;
+static LogRing       sg_log_ring;
 static int           sg_log_max_size;
-static LogLevel      sg_log_print_level = LOG_LEVEL_DEBUG;
+
+LogLevel g_utils_log_level = LOG_LEVEL_DEBUG;
 
 /**
  * @brief Get file name form path.
@@ -56,6 +150,539 @@ static const char *_get_filename(const char *path)
     return q;
 }
 
+/**
+ * @brief Parse conversion specification.
+ *
+ * @param[in] p pointer to '%' in format
+ * @param[out] spec specification parsed
+ * @return pointer after specification
+ */
+static const char *_log_spec_parse(const char *p, LogSpec *spec)
+{
+    const char *q      = p + 1;
+    char        length = 0;
+
+    memset(spec, 0, sizeof(LogSpec));
+    spec->begin     = p;
+    spec->precision = -1;
+
+    // flags and width
+    q += strspn(q, "-+ #0");
+    if (*q == '*') {
+        spec->width_arg = 1;
+        q++;
+    }
+    while (*q >= '0' && *q <= '9') {
+        q++;
+    }
+
+    // precision
+    if (*q == '.') {
+        q++;
+        spec->precision = 0;
+        if (*q == '*') {
+            spec->precision_arg = 1;
+            q++;
+        }
+        while (*q >= '0' && *q <= '9') {
+            spec->precision = spec->precision * 10 + *q++ - '0';
+        }
+    }
+    spec->prefix_len = q - p;
+
+    // length modifier, "ll" as 'q' and "hh" as 'h'
+    if (*q == 'h' || *q == 'l' || *q == 'j' || *q == 'z' || *q == 't' || *q == 'L') {
+        length = *q++;
+        if ((length == 'h' || length == 'l') && *q == length) {
+            length = length == 'l' ? 'q' : 'h';
+            q++;
+        }
+    }
+
+    spec->conversion = *q;
+    switch (*q) {
+        case 'd':
+        case 'i':
+            spec->type = LOG_ARG_LLONG;
+            break;
+        case 'u':
+        case 'o':
+        case 'x':
+        case 'X':
+            spec->type = LOG_ARG_ULLONG;
+            break;
+        case 'c':
+            spec->type = length ? LOG_ARG_INVALID : LOG_ARG_INT;
+            break;
+        case 'f':
+        case 'F':
+        case 'e':
+        case 'E':
+        case 'g':
+        case 'G':
+        case 'a':
+        case 'A':
+            spec->type = length == 'L' ? LOG_ARG_LDOUBLE : LOG_ARG_DOUBLE;
+            break;
+        case 's':
+            spec->type = length ? LOG_ARG_INVALID : LOG_ARG_STR;
+            break;
+        case 'p':
+            spec->type = LOG_ARG_PTR;
+            break;
+        case '%':
+            spec->type = LOG_ARG_NONE;
+            break;
+        default:
+            spec->type = LOG_ARG_INVALID;
+            return q;
+    }
+
+    // 'L' only for float
+    if ((length == 'L') != (spec->type == LOG_ARG_LDOUBLE)) {
+        spec->type = LOG_ARG_INVALID;
+    }
+
+    q++;
+    spec->len = q - p;
+    if (spec->len >= LOG_SPEC_MAX_LEN) {
+        spec->type = LOG_ARG_INVALID;
+    }
+    return q;
+}
+
+/**
+ * @brief Save value to record.
+ *
+ * @param[in,out] o pointer to write, moved forward
+ * @param[in] end end of record
+ * @param[in] value value to save
+ * @param[in] len length of value
+ * @return 0 for success, -1 for no space
+ */
+static int _log_arg_save(uint8_t **o, const uint8_t *end, const void *value, size_t len)
+{
+    if ((size_t)(end - *o) < len) {
+        return -1;
+    }
+    memcpy(*o, value, len);
+    *o += len;
+    return 0;
+}
+
+/**
+ * @brief Save arguments in binary, string is copied for it may be freed before drained.
+ *
+ * @param[in,out] o pointer to write
+ * @param[in] end end of record
+ * @param[in] fmt format of log content
+ * @param[in] ap arguments
+ * @return 0 for success, -1 for not supported or no space, then log should be formatted when generated
+ */
+static int _log_args_encode(uint8_t *o, const uint8_t *end, const char *fmt, va_list ap)
+{
+    LogSpec            spec;
+    int                rc = 0, width, precision;
+    long long          llong_value;
+    unsigned long long ullong_value;
+    double             double_value;
+    long double        ldouble_value;
+    void              *ptr_value;
+    const char        *str_value;
+    size_t             str_len;
+
+    while ((fmt = strchr(fmt, '%'))) {
+        fmt = _log_spec_parse(fmt, &spec);
+        if (spec.type == LOG_ARG_INVALID) {
+            return -1;
+        }
+
+        if (spec.width_arg) {
+            width = va_arg(ap, int);
+            rc |= _log_arg_save(&o, end, &width, sizeof(width));
+        }
+
+        precision = spec.precision;
+        if (spec.precision_arg) {
+            precision = va_arg(ap, int);
+            rc |= _log_arg_save(&o, end, &precision, sizeof(precision));
+        }
+
+        switch (spec.type) {
+            case LOG_ARG_INT:
+                width = va_arg(ap, int);
+                rc |= _log_arg_save(&o, end, &width, sizeof(width));
+                break;
+            case LOG_ARG_LLONG:
+            case LOG_ARG_ULLONG:
+                // read with the type in format, for arguments of different size are passed in different way
+                switch (spec.begin[spec.prefix_len]) {
+                    case 'l':
+                        llong_value = spec.begin[spec.prefix_len + 1] == 'l' ? va_arg(ap, long long)
+                                      : spec.type == LOG_ARG_LLONG           ? va_arg(ap, long)
+                                                                             : (long long)va_arg(ap, unsigned long);
+                        break;
+                    case 'j':
+                        llong_value = va_arg(ap, intmax_t);
+                        break;
+                    case 'z':
+                        llong_value = va_arg(ap, size_t);
+                        break;
+                    case 't':
+                        llong_value = va_arg(ap, ptrdiff_t);
+                        break;
+                    default:
+                        llong_value = spec.type == LOG_ARG_LLONG ? (long long)va_arg(ap, int)
+                                                                 : (long long)va_arg(ap, unsigned int);
+                        // "%hd" and "%hhd" print value converted to short and char
+                        if (spec.begin[spec.prefix_len] == 'h') {
+                            llong_value = spec.begin[spec.prefix_len + 1] == 'h'
+                                              ? (spec.type == LOG_ARG_LLONG ? (signed char)llong_value
+                                                                            : (unsigned char)llong_value)
+                                              : (spec.type == LOG_ARG_LLONG ? (short)llong_value
+                                                                            : (unsigned short)llong_value);
+                        }
+                        break;
+                }
+                ullong_value = llong_value;
+                rc |= _log_arg_save(&o, end, &ullong_value, sizeof(ullong_value));
+                break;
+            case LOG_ARG_DOUBLE:
+                double_value = va_arg(ap, double);
+                rc |= _log_arg_save(&o, end, &double_value, sizeof(double_value));
+                break;
+            case LOG_ARG_LDOUBLE:
+                ldouble_value = va_arg(ap, long double);
+                rc |= _log_arg_save(&o, end, &ldouble_value, sizeof(ldouble_value));
+                break;
+            case LOG_ARG_PTR:
+                ptr_value = va_arg(ap, void *);
+                rc |= _log_arg_save(&o, end, &ptr_value, sizeof(ptr_value));
+                break;
+            case LOG_ARG_STR:
+                str_value = va_arg(ap, const char *);
+                str_value = str_value ? str_value : "(null)";
+                // string is truncated by precision or space left, not read beyond precision for "%.*s"
+                str_len = end - o > 0 ? end - o - 1 : 0;
+                str_len = precision >= 0 && (size_t)precision < str_len ? precision : str_len;
+                str_len = strnlen(str_value, str_len);
+                rc |= _log_arg_save(&o, end, str_value, str_len);
+                rc |= _log_arg_save(&o, end, "", 1);
+                break;
+            default:
+                break;
+        }
+
+        if (rc) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Format arguments saved in record by format.
+ *
+ * @param[out] o buffer to write
+ * @param[in] size size of buffer
+ * @param[in] fmt format of log content
+ * @param[in] args arguments saved by _log_args_encode
+ * @return length written
+ */
+static int _log_args_format(char *o, int size, const char *fmt, const uint8_t *args)
+{
+    LogSpec            spec;
+    char               spec_buf[LOG_SPEC_MAX_LEN];
+    const char        *p;
+    int                n = 0, rc, width = 0, precision = 0, int_value;
+    unsigned long long ullong_value;
+    double             double_value;
+    long double        ldouble_value;
+    void              *ptr_value;
+
+#define LOG_SPEC_PRINT(value)                                                                                   \
+    (spec.width_arg ? (spec.precision_arg ? snprintf(o + n, size - n, spec_buf, width, precision, value)        \
+                                          : snprintf(o + n, size - n, spec_buf, width, value))                  \
+                    : (spec.precision_arg ? snprintf(o + n, size - n, spec_buf, precision, value)               \
+                                          : snprintf(o + n, size - n, spec_buf, value)))
+
+    while (*fmt && n < size - 1) {
+        // literal text
+        p  = strchr(fmt, '%');
+        rc = p ? p - fmt : (int)strlen(fmt);
+        rc = rc < size - 1 - n ? rc : size - 1 - n;
+        memcpy(o + n, fmt, rc);
+        n += rc;
+        if (!p || n >= size - 1) {
+            break;
+        }
+
+        fmt = _log_spec_parse(p, &spec);
+        if (spec.width_arg) {
+            memcpy(&width, args, sizeof(width));
+            args += sizeof(width);
+        }
+        if (spec.precision_arg) {
+            memcpy(&precision, args, sizeof(precision));
+            args += sizeof(precision);
+        }
+
+        // length modifier is replaced by "ll" for integers widened
+        memcpy(spec_buf, spec.begin, spec.prefix_len);
+        rc = spec.prefix_len;
+        if (spec.type == LOG_ARG_LLONG || spec.type == LOG_ARG_ULLONG) {
+            spec_buf[rc++] = 'l';
+            spec_buf[rc++] = 'l';
+        }
+        if (spec.type == LOG_ARG_LDOUBLE) {
+            spec_buf[rc++] = 'L';
+        }
+        spec_buf[rc++] = spec.conversion;
+        spec_buf[rc]   = '\0';
+
+        switch (spec.type) {
+            case LOG_ARG_NONE:
+                rc = snprintf(o + n, size - n, "%%");
+                break;
+            case LOG_ARG_INT:
+                memcpy(&int_value, args, sizeof(int_value));
+                args += sizeof(int_value);
+                rc = LOG_SPEC_PRINT(int_value);
+                break;
+            case LOG_ARG_LLONG:
+                memcpy(&ullong_value, args, sizeof(ullong_value));
+                args += sizeof(ullong_value);
+                rc = LOG_SPEC_PRINT((long long)ullong_value);
+                break;
+            case LOG_ARG_ULLONG:
+                memcpy(&ullong_value, args, sizeof(ullong_value));
+                args += sizeof(ullong_value);
+                rc = LOG_SPEC_PRINT(ullong_value);
+                break;
+            case LOG_ARG_DOUBLE:
+                memcpy(&double_value, args, sizeof(double_value));
+                args += sizeof(double_value);
+                rc = LOG_SPEC_PRINT(double_value);
+                break;
+            case LOG_ARG_LDOUBLE:
+                memcpy(&ldouble_value, args, sizeof(ldouble_value));
+                args += sizeof(ldouble_value);
+                rc = LOG_SPEC_PRINT(ldouble_value);
+                break;
+            case LOG_ARG_PTR:
+                memcpy(&ptr_value, args, sizeof(ptr_value));
+                args += sizeof(ptr_value);
+                rc = LOG_SPEC_PRINT(ptr_value);
+                break;
+            case LOG_ARG_STR:
+                rc = LOG_SPEC_PRINT((const char *)args);
+                args += strlen((const char *)args) + 1;
+                break;
+            default:
+                rc = 0;
+                break;
+        }
+        n += rc > 0 ? rc : 0;
+    }
+#undef LOG_SPEC_PRINT
+
+    n = n < size - 1 ? n : size - 1;
+    return n;
+}
+
+/**
+ * @brief Format record to log line.
+ *
+ * @param[in] record record to format
+ * @param[out] buf buffer to write
+ * @param[in] size size of buffer
+ */
+static void _log_record_format(const LogRecord *record, char *buf, int size)
+{
+    const char *time_str = (const char *)(record + 1);
+    const char *content  = time_str + strlen(time_str) + 1;
+
+    // reserve 2 bytes for "\r\n"
+    int n = snprintf(buf, size - 2, "%s|%s|%s|%s(%d): ", LEVEL_STR[record->level], time_str,
+                     _get_filename(record->file), record->func, record->line);
+    n     = n < size - 3 ? n : size - 3;
+
+    if (record->formatted) {
+        int len = strlen(content);
+        len     = len < size - 3 - n ? len : size - 3 - n;
+        memcpy(buf + n, content, len);
+        n += len;
+    } else {
+        n += _log_args_format(buf + n, size - 2 - n, record->fmt, (const uint8_t *)content);
+    }
+    memcpy(buf + n, "\r\n", 3);
+}
+
+/**
+ * @brief Print log line and pass it to user handler.
+ *
+ * @param[in] log log line
+ */
+static void _log_output(const char *log)
+{
+    if (sg_log_handle_func.log_handle) {
+        sg_log_handle_func.log_handle(log);
+    }
+    sg_log_handle_func.log_printf("%s", log);
+}
+
+/**
+ * @brief Get record by sequence.
+ *
+ * @param[in] ring pointer to log ring
+ * @param[in] pos sequence of record
+ * @return pointer to record
+ */
+static LogRecord *_log_ring_record(LogRing *ring, uint32_t pos)
+{
+    return (LogRecord *)(ring->records + (pos & (ring->record_num - 1)) * ring->record_size);
+}
+
+/**
+ * @brief Claim record to write, never blocks.
+ *
+ * @param[in,out] ring pointer to log ring
+ * @param[out] pos sequence of record claimed
+ * @return pointer to record, NULL for ring full
+ */
+static LogRecord *_log_ring_claim(LogRing *ring, uint32_t *pos)
+{
+    LogRecord *record;
+    int32_t    diff;
+
+    *pos = __atomic_load_n(&ring->tail, __ATOMIC_RELAXED);
+    for (;;) {
+        record = _log_ring_record(ring, *pos);
+        diff   = (int32_t)(__atomic_load_n(&record->seq, __ATOMIC_ACQUIRE) - *pos);
+        if (!diff) {
+            // record is free, claim it if no others do
+            if (__atomic_compare_exchange_n(&ring->tail, pos, *pos + 1, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                return record;
+            }
+        } else if (diff < 0) {
+            // record is not drained yet
+            return NULL;
+        } else {
+            *pos = __atomic_load_n(&ring->tail, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+/**
+ * @brief Get next record to drain, only by thread draining.
+ *
+ * @param[in] ring pointer to log ring
+ * @return pointer to record, NULL for ring empty or next record is still being written
+ */
+static LogRecord *_log_ring_peek(LogRing *ring)
+{
+    uint32_t   head   = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    LogRecord *record = _log_ring_record(ring, head);
+    return __atomic_load_n(&record->seq, __ATOMIC_SEQ_CST) == head + 1 ? record : NULL;
+}
+
+/**
+ * @brief Drain records written, the caller should own draining.
+ *
+ * @param[in,out] ring pointer to log ring
+ * @return number of logs drained
+ */
+static int _log_ring_drain(LogRing *ring)
+{
+    LogRecord *record;
+    uint32_t   drop_num;
+    int        count = 0;
+
+    while ((record = _log_ring_peek(ring))) {
+        _log_record_format(record, ring->scratch, sg_log_max_size);
+
+        // release record before output, so producers reuse it as soon as possible
+        __atomic_store_n(&record->seq, ring->head + ring->record_num, __ATOMIC_RELEASE);
+        __atomic_store_n(&ring->head, ring->head + 1, __ATOMIC_RELEASE);
+
+        _log_output(ring->scratch);
+        count++;
+    }
+
+    drop_num = __atomic_exchange_n(&ring->drop_num, 0, __ATOMIC_RELAXED);
+    if (drop_num) {
+        snprintf(ring->scratch, sg_log_max_size, "%s|%s|%u logs dropped for log ring full\r\n",
+                 LEVEL_STR[LOG_LEVEL_WARN], sg_log_handle_func.log_get_current_time_str(), drop_num);
+        _log_output(ring->scratch);
+    }
+    return count;
+}
+
+/**
+ * @brief Drain records if no other thread is draining, record written while releasing draining is drained either by
+ * this thread or the thread writting it.
+ *
+ * @param[in,out] ring pointer to log ring
+ * @return number of logs drained
+ */
+static int _log_ring_flush(LogRing *ring)
+{
+    int count = 0;
+
+    if (!ring->records) {
+        return 0;
+    }
+
+    do {
+        if (__atomic_exchange_n(&ring->draining, 1, __ATOMIC_SEQ_CST)) {
+            break;
+        }
+        count += _log_ring_drain(ring);
+        __atomic_store_n(&ring->draining, 0, __ATOMIC_SEQ_CST);
+    } while (_log_ring_peek(ring));
+    return count;
+}
+
+/**
+ * @brief Format and print log directly without ring, when no ring or ring is full and no drain thread is running.
+ * Scratch is used if no other thread is draining, otherwise buffer is allocated.
+ *
+ * @param[in] file file path
+ * @param[in] func function where generate log
+ * @param[in] line line of source file where genertate log
+ * @param[in] level @see LogLevel
+ * @param[in] fmt format of log content
+ * @param[in] ap arguments
+ */
+static void _log_print_direct(const char *file, const char *func, int line, int level, const char *fmt, va_list ap)
+{
+    int   n, rc;
+    int   own_scratch = !__atomic_exchange_n(&sg_log_ring.draining, 1, __ATOMIC_SEQ_CST);
+    char *buf         = own_scratch ? sg_log_ring.scratch : sg_log_handle_func.log_malloc(sg_log_max_size);
+    if (!buf) {
+        __atomic_add_fetch(&sg_log_ring.drop_num, 1, __ATOMIC_RELAXED);
+        return;
+    }
+
+    // reserve 2 bytes for "\r\n"
+    n  = snprintf(buf, sg_log_max_size - 2, "%s|%s|%s|%s(%d): ", LEVEL_STR[level],
+                  sg_log_handle_func.log_get_current_time_str(), _get_filename(file), func, line);
+    n  = n < sg_log_max_size - 3 ? n : sg_log_max_size - 3;
+    rc = vsnprintf(buf + n, sg_log_max_size - 2 - n, fmt, ap);
+    n += rc < 0 ? 0 : rc < sg_log_max_size - 3 - n ? rc : sg_log_max_size - 3 - n;
+    memcpy(buf + n, "\r\n", 3);
+
+    _log_output(buf);
+    if (!own_scratch) {
+        sg_log_handle_func.log_free(buf);
+        return;
+    }
+
+    // records written while owning scratch are left to this thread
+    __atomic_store_n(&sg_log_ring.draining, 0, __ATOMIC_SEQ_CST);
+    _log_ring_flush(&sg_log_ring);
+}
+
 /**
  * @brief Init log with func, log level, max log size.
  *
@@ -66,13 +693,30 @@ static const char *_get_filename(const char *path)
  */
 int utils_log_init(LogHandleFunc func, LogLevel log_level, int max_log_size)
 {
+    LogRing *ring = &sg_log_ring;
+    uint32_t i;
+
     sg_log_handle_func = func;
-    sg_log_print_level = log_level;
+    g_utils_log_level = log_level;
     sg_log_max_size    = max_log_size;
-    if (func.log_malloc) {
-        sg_log_buffer = func.log_malloc(max_log_size);
+    if (!func.log_malloc) {
+        return 1;
+    }
+
+    memset(ring, 0, sizeof(LogRing));
+    ring->record_num  = LOG_RING_RECORD_NUM;
+    ring->record_size = (sizeof(LogRecord) + max_log_size + 7) & ~7;
+    ring->records     = ring->record_num ? func.log_malloc(ring->record_num * ring->record_size) : NULL;
+    ring->scratch     = func.log_malloc(max_log_size);
+    if ((ring->record_num && !ring->records) || !ring->scratch) {
+        utils_log_deinit();
+        return 1;
     }
-    return !sg_log_buffer;
+
+    for (i = 0; i < ring->record_num; i++) {
+        _log_ring_record(ring, i)->seq = i;
+    }
+    return 0;
 }
 
 /**
@@ -81,8 +725,133 @@ int utils_log_init(LogHandleFunc func, LogLevel log_level, int max_log_size)
  */
 void utils_log_deinit(void)
 {
-    sg_log_handle_func.log_free(sg_log_buffer);
-    sg_log_buffer = NULL;
+    LogRing *ring = &sg_log_ring;
+
+    utils_log_async_deinit();
+    _log_ring_flush(ring);
+
+    if (ring->records) {
+        sg_log_handle_func.log_free(ring->records);
+    }
+    if (ring->scratch) {
+        sg_log_handle_func.log_free(ring->scratch);
+    }
+    ring->records = NULL;
+    ring->scratch = NULL;
+}
+
+/**
+ * @brief Switch log to async, records are formatted and printed by drain thread running utils_log_async_run.
+ *
+ * @param[in] func function needed by drain thread
+ * @param[in] record_num number of records in log ring, logs are dropped when ring is full
+ * @return 0 for success
+ */
+int utils_log_async_init(LogAsyncFunc func, int record_num)
+{
+    LogRing *ring = &sg_log_ring;
+    uint8_t *records;
+    uint32_t i, num = LOG_RING_RECORD_NUM ? LOG_RING_RECORD_NUM : 1;
+
+    if (!ring->scratch || ring->wake_sem) {
+        return 1;
+    }
+
+    // grow ring, no others should be logging now
+    while (num < (uint32_t)record_num) {
+        num <<= 1;
+    }
+    if (num > ring->record_num) {
+        records = sg_log_handle_func.log_malloc(num * ring->record_size);
+        if (!records) {
+            return 1;
+        }
+        if (ring->records) {
+            sg_log_handle_func.log_free(ring->records);
+        }
+        ring->records    = records;
+        ring->record_num = num;
+        ring->head       = 0;
+        ring->tail       = 0;
+        for (i = 0; i < num; i++) {
+            _log_ring_record(ring, i)->seq = i;
+        }
+    }
+
+    ring->async_func = func;
+    ring->wake_sem   = func.log_sem_create();
+    ring->exit_sem   = func.log_sem_create();
+    if (!ring->wake_sem || !ring->exit_sem) {
+        utils_log_async_deinit();
+        return 1;
+    }
+    __atomic_store_n(&ring->running, 1, __ATOMIC_RELEASE);
+    return 0;
+}
+
+/**
+ * @brief Drain thread entry, returns when utils_log_async_deinit.
+ *
+ * @param[in] arg not used
+ */
+void utils_log_async_run(void *arg)
+{
+    LogRing *ring    = &sg_log_ring;
+    int      running = 1;
+
+    // not async init, already deinit, or another drain thread is running
+    if (!__atomic_compare_exchange_n(&ring->running, &running, 2, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST)) {
+        return;
+    }
+
+    __atomic_store_n(&ring->async, 1, __ATOMIC_SEQ_CST);
+    while (__atomic_load_n(&ring->running, __ATOMIC_ACQUIRE)) {
+        if (_log_ring_flush(ring)) {
+            continue;
+        }
+
+        // sleep until woken up by the first record written after
+        __atomic_store_n(&ring->sleeping, 1, __ATOMIC_SEQ_CST);
+        if (!_log_ring_peek(ring)) {
+            ring->async_func.log_sem_wait(ring->wake_sem, LOG_DRAIN_INTERVAL_MS);
+        }
+        __atomic_store_n(&ring->sleeping, 0, __ATOMIC_SEQ_CST);
+    }
+
+    // records written from now on are drained by the thread logging
+    __atomic_store_n(&ring->async, 0, __ATOMIC_SEQ_CST);
+    _log_ring_flush(ring);
+    ring->async_func.log_sem_post(ring->exit_sem);
+}
+
+/**
+ * @brief Stop drain thread and wait for it to exit, log is printed by the thread logging after. Drain thread not
+ * started yet returns at once when it starts.
+ *
+ */
+void utils_log_async_deinit(void)
+{
+    LogRing *ring = &sg_log_ring;
+
+    // only wait for drain thread running, or exit_sem is never posted
+    if (__atomic_exchange_n(&ring->running, 0, __ATOMIC_SEQ_CST) == 2) {
+        ring->async_func.log_sem_post(ring->wake_sem);
+        ring->async_func.log_sem_wait(ring->exit_sem, UINT32_MAX);
+
+        // async is cleared now, wait for threads which read it set and may still post wake_sem
+        while (__atomic_load_n(&ring->writer_num, __ATOMIC_SEQ_CST)) {
+            ring->async_func.log_sem_wait(ring->exit_sem, 1);
+        }
+    }
+
+    if (ring->wake_sem) {
+        ring->async_func.log_sem_destroy(ring->wake_sem);
+    }
+    if (ring->exit_sem) {
+        ring->async_func.log_sem_destroy(ring->exit_sem);
+    }
+    ring->wake_sem = NULL;
+    ring->exit_sem = NULL;
 }
 
 /**
@@ -92,7 +861,7 @@ void utils_log_deinit(void)
  */
 void utils_log_set_level(LogLevel log_level)
 {
-    sg_log_print_level = log_level;
+    g_utils_log_level = log_level;
 }
 
 /**
@@ -102,11 +871,11 @@ void utils_log_set_level(LogLevel log_level)
  */
 LogLevel utils_log_get_level(void)
 {
-    return sg_log_print_level;
+    return g_utils_log_level;
 }
 
 /**
- * @brief Generate log if level higher than set.
+ * @brief Generate log if level higher than set, arguments are saved to log ring and formatted when drained.
  *
  * @param[in] file file path
  * @param[in] func function where generate log
@@ -116,30 +885,72 @@ LogLevel utils_log_get_level(void)
  */
 void utils_log_gen(const char *file, const char *func, const int line, const int level, const char *fmt, ...)
 {
-    if (level > sg_log_print_level) {
+    LogRing    *ring = &sg_log_ring;
+    LogRecord  *record;
+    uint32_t    pos;
+    uint8_t    *o, *end;
+    const char *time_str;
+    size_t      time_len;
+    va_list     ap, ap_copy;
+
+    if (level > g_utils_log_level || !ring->scratch) {
         return;
     }
 
-    /* format log content */
-    const char *file_name = _get_filename(file);
-    char *      o         = sg_log_buffer;
+    record = ring->records ? _log_ring_claim(ring, &pos) : NULL;
+    if (!record && !__atomic_load_n(&ring->async, __ATOMIC_SEQ_CST)) {
+        // no drain thread, drain ring by this thread and claim again, or print directly as others are draining
+        _log_ring_flush(ring);
+        record = ring->records ? _log_ring_claim(ring, &pos) : NULL;
+        if (!record) {
+            va_start(ap, fmt);
+            _log_print_direct(file, func, line, level, fmt, ap);
+            va_end(ap);
+            return;
+        }
+    }
+    if (!record) {
+        __atomic_add_fetch(&ring->drop_num, 1, __ATOMIC_RELAXED);
+        return;
+    }
 
-    o += snprintf(sg_log_buffer, sg_log_max_size, "%s|%s|%s|%s(%d): ", LEVEL_STR[level],
-                  sg_log_handle_func.log_get_current_time_str(), file_name, func, line);
+    record->level     = level;
+    record->formatted = 0;
+    record->line      = line;
+    record->file      = file;
+    record->func      = func;
+    record->fmt       = fmt;
+
+    // time string, then arguments, or formatted content if not supported
+    o        = (uint8_t *)(record + 1);
+    end      = o + sg_log_max_size;
+    time_str = sg_log_handle_func.log_get_current_time_str();
+    time_len = strnlen(time_str, sg_log_max_size / 2);
+    memcpy(o, time_str, time_len);
+    o[time_len] = '\0';
+    o += time_len + 1;
 
-    va_list ap;
     va_start(ap, fmt);
-    vsnprintf(o, sg_log_max_size - 2 - strlen(sg_log_buffer), fmt, ap);
+    va_copy(ap_copy, ap);
+    if (_log_args_encode(o, end, fmt, ap)) {
+        record->formatted = 1;
+        vsnprintf((char *)o, end - o, fmt, ap_copy);
+    }
+    va_end(ap_copy);
     va_end(ap);
 
-    strncat(sg_log_buffer, "\r\n", sg_log_max_size - strlen(sg_log_buffer) - 1);
+    __atomic_store_n(&record->seq, pos + 1, __ATOMIC_SEQ_CST);
 
-    if (level <= sg_log_print_level) {
-        if (sg_log_handle_func.log_handle) {
-            sg_log_handle_func.log_handle(sg_log_buffer);
-        }
-        sg_log_handle_func.log_printf("%s", sg_log_buffer);
+    // wake up drain thread if sleeping, counted so that async deinit does not destroy wake_sem before posted
+    __atomic_add_fetch(&ring->writer_num, 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&ring->async, __ATOMIC_SEQ_CST) && __atomic_exchange_n(&ring->sleeping, 0, __ATOMIC_SEQ_CST)) {
+        ring->async_func.log_sem_post(ring->wake_sem);
     }
+    __atomic_sub_fetch(&ring->writer_num, 1, __ATOMIC_SEQ_CST);
 
-    return;
+    // check again after record published, drain thread may have exited without draining it
+    if (__atomic_load_n(&ring->async, __ATOMIC_SEQ_CST)) {
+        return;
+    }
+    _log_ring_flush(ring);
 }
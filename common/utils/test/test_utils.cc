@@ -28,8 +28,15 @@
  * </table>
  */
 
+#include <atomic>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
 #include <iostream>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include "gtest/gtest.h"
 #include "qcloud_iot_platform.h"
@@ -131,6 +138,222 @@ TEST(UtilsLogTest, log) {
   utils_log_deinit();
 }
 
+/**
+ * @brief Test arguments of log not evaluated when level disabled, and cost of disabled log.
+ *
+ */
+TEST(UtilsLogTest, log_level) {
+  const int log_times = 10000000;
+
+  int evaluated = 0;
+  auto arg = [&]() { return ++evaluated; };
+
+  utils_log_set_level(LOG_LEVEL_INFO);
+  Log_d("debug log: %d", arg());
+  ASSERT_EQ(evaluated, 0);
+  Log_i("info log: %d", arg());
+  ASSERT_EQ(evaluated, LOG_LEVEL_INFO <= LOG_MIN_LEVEL ? 1 : 0);
+
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < log_times; i++) {
+    Log_d("debug log: %d", arg());
+  }
+  auto cost = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+  utils_log_set_level(LOG_LEVEL_DEBUG);
+
+  std::cout << "disabled debug log cost: " << static_cast<double>(cost.count()) / log_times << " ns" << std::endl;
+}
+
+static std::string sg_log_line;
+
+static void _log_handle(const char *message) { sg_log_line = message; }
+
+/**
+ * @brief Test log arguments saved in binary and formatted when drained, same as snprintf.
+ *
+ */
+TEST(UtilsLogTest, log_format) {
+  LogHandleFunc func = {0};
+  func.log_malloc = HAL_Malloc;
+  func.log_free = HAL_Free;
+  func.log_get_current_time_str = HAL_Timer_Current;
+  func.log_printf = HAL_Printf;
+  func.log_handle = _log_handle;
+  ASSERT_EQ(utils_log_init(func, LOG_LEVEL_DEBUG, 2048), 0);
+
+  char expect[2048];
+  auto content = [&]() { return sg_log_line.substr(sg_log_line.find("): ") + 3); };
+
+#define LOG_FORMAT_CHECK(fmt, ...)                           \
+  do {                                                       \
+    HAL_Snprintf(expect, sizeof(expect), fmt, ##__VA_ARGS__); \
+    Log_d(fmt, ##__VA_ARGS__);                               \
+    ASSERT_EQ(content(), std::string(expect) + "\r\n");      \
+  } while (0)
+
+  LOG_FORMAT_CHECK("%d %u %x %04x %lu %lld %llu %zu %hhd %hd", -5, 4000000000u, 255, 7, 123456789012UL,
+                   -9000000000LL, 18000000000000000000ULL, sizeof(expect), 300, 70000);
+  LOG_FORMAT_CHECK("%s|%.*s|%10s|%-5s|%.2s", "hello", 3, "abcdef", "r", "l", "xyz");
+  LOG_FORMAT_CHECK("%f %.3e %g %5.1f", 3.14159, 12345.678, 0.0001, 7.25);
+  LOG_FORMAT_CHECK("%c%c %% %p %*d %-*.*d", 'a', 'b', &expect, 6, 42, 8, 4, 7);
+  LOG_FORMAT_CHECK("not supported %lc, formatted when generated", L'A');
+#undef LOG_FORMAT_CHECK
+
+  // string longer than log is truncated
+  std::string large(4096, 'a');
+  Log_d("%s", large.c_str());
+  ASSERT_EQ(sg_log_line.size(), 2047);
+  utils_log_deinit();
+}
+
+static std::atomic<int> sg_log_count;
+static std::atomic<int> sg_log_drop_count;
+
+static void _log_printf_none(const char *fmt, ...) {}
+
+static void _log_count_handle(const char *message) {
+  if (strstr(message, "logs dropped")) {
+    sg_log_drop_count++;
+  } else if (strstr(message, "concurrent log")) {
+    sg_log_count++;
+  }
+}
+
+/**
+ * @brief Test no log dropped without drain thread when threads log at the same time more than ring records.
+ *
+ */
+TEST(UtilsLogTest, log_concurrent) {
+  const int thread_num = 16;
+  const int log_times = 200;
+
+  LogHandleFunc func = {0};
+  func.log_malloc = HAL_Malloc;
+  func.log_free = HAL_Free;
+  func.log_get_current_time_str = HAL_Timer_Current;
+  func.log_printf = _log_printf_none;
+  func.log_handle = _log_count_handle;
+  ASSERT_EQ(utils_log_init(func, LOG_LEVEL_DEBUG, 256), 0);
+
+  sg_log_count = 0;
+  sg_log_drop_count = 0;
+  std::vector<std::thread> threads;
+  for (int i = 0; i < thread_num; i++) {
+    threads.emplace_back([=]() {
+      for (int j = 0; j < log_times; j++) {
+        Log_i("concurrent log %d %d", i, j);
+      }
+    });
+  }
+  for (auto &t : threads) {
+    t.join();
+  }
+  utils_log_deinit();
+  ASSERT_EQ(sg_log_count, thread_num * log_times);
+  ASSERT_EQ(sg_log_drop_count, 0);
+}
+
+#ifdef MULTITHREAD_ENABLED
+/**
+ * @brief Test log printed by drain thread.
+ *
+ */
+TEST(UtilsLogTest, log_async) {
+  LogHandleFunc func = {0};
+  func.log_malloc = HAL_Malloc;
+  func.log_free = HAL_Free;
+  func.log_get_current_time_str = HAL_Timer_Current;
+  func.log_printf = HAL_Printf;
+  func.log_handle = _log_handle;
+  ASSERT_EQ(utils_log_init(func, LOG_LEVEL_DEBUG, 2048), 0);
+
+  LogAsyncFunc async_func = {
+      .log_sem_create = HAL_SemaphoreCreate,
+      .log_sem_destroy = HAL_SemaphoreDestroy,
+      .log_sem_post = HAL_SemaphorePost,
+      .log_sem_wait = HAL_SemaphoreWait,
+  };
+  ASSERT_EQ(utils_log_async_init(async_func, 64), 0);
+
+  static ThreadParams thread_params;
+  thread_params.thread_name = const_cast<char *>("log_drain");
+  thread_params.thread_func = utils_log_async_run;
+  thread_params.stack_size = 4096;
+  ASSERT_EQ(HAL_ThreadCreate(&thread_params), 0);
+
+  sg_log_line.clear();
+  Log_i("Here is a async log %d!", 1);
+  for (int i = 0; i < 100 && sg_log_line.empty(); i++) {
+    HAL_SleepMs(10);
+  }
+  ASSERT_NE(sg_log_line.find("Here is a async log 1!"), std::string::npos);
+
+  // logs left are drained when drain thread exits
+  Log_i("Here is a async log %d!", 2);
+  utils_log_async_deinit();
+  ASSERT_NE(sg_log_line.find("Here is a async log 2!"), std::string::npos);
+  utils_log_deinit();
+
+  // deinit never waits for drain thread not started
+  ASSERT_EQ(utils_log_init(func, LOG_LEVEL_DEBUG, 2048), 0);
+  ASSERT_EQ(utils_log_async_init(async_func, 64), 0);
+  Log_i("Here is a async log %d!", 3);
+  utils_log_deinit();
+  ASSERT_NE(sg_log_line.find("Here is a async log 3!"), std::string::npos);
+}
+
+/**
+ * @brief Test no log lost when drain thread stops while threads are logging.
+ *
+ */
+TEST(UtilsLogTest, log_async_deinit_concurrent) {
+  const int thread_num = 4;
+  const int log_times = 100;
+
+  LogHandleFunc func = {0};
+  func.log_malloc = HAL_Malloc;
+  func.log_free = HAL_Free;
+  func.log_get_current_time_str = HAL_Timer_Current;
+  func.log_printf = _log_printf_none;
+  func.log_handle = _log_count_handle;
+  ASSERT_EQ(utils_log_init(func, LOG_LEVEL_DEBUG, 256), 0);
+
+  LogAsyncFunc async_func = {
+      .log_sem_create = HAL_SemaphoreCreate,
+      .log_sem_destroy = HAL_SemaphoreDestroy,
+      .log_sem_post = HAL_SemaphorePost,
+      .log_sem_wait = HAL_SemaphoreWait,
+  };
+  // large enough to hold all logs, so none is dropped
+  ASSERT_EQ(utils_log_async_init(async_func, thread_num * log_times), 0);
+
+  static ThreadParams thread_params;
+  thread_params.thread_name = const_cast<char *>("log_drain");
+  thread_params.thread_func = utils_log_async_run;
+  thread_params.stack_size = 4096;
+  ASSERT_EQ(HAL_ThreadCreate(&thread_params), 0);
+  HAL_SleepMs(10);
+
+  sg_log_count = 0;
+  sg_log_drop_count = 0;
+  std::vector<std::thread> threads;
+  for (int i = 0; i < thread_num; i++) {
+    threads.emplace_back([=]() {
+      for (int j = 0; j < log_times; j++) {
+        Log_i("concurrent log %d %d", i, j);
+      }
+    });
+  }
+  utils_log_async_deinit();
+  for (auto &t : threads) {
+    t.join();
+  }
+  utils_log_deinit();
+  ASSERT_EQ(sg_log_count, thread_num * log_times);
+  ASSERT_EQ(sg_log_drop_count, 0);
+}
+#endif
+
 /**
  * @brief Test json.
  *
@@ -178,4 +401,574 @@ TEST(UtilsJsonTest, json) {
   ASSERT_EQ(strncmp(test_json_before_strip, test_json, strlen(test_json_before_strip)), 0);
 }
 
+/**
+ * @brief Test json index, lookups should be same as utils_json_value_get.
+ *
+ */
+TEST(UtilsJsonTest, json_index) {
+  char test_json[] =
+      "{\"str_test\":\"te\\\"st\", \"int_test\" : 100,\"float_test\":1.210f,\"bool_test\":true,"
+      "\"depth_test\": {\"test\":\"test1\", \"array\":[1, {\"a\":\"b\"}, [2]]},\"null_test\":null}";
+  const char *keys[] = {"str_test",  "int_test",        "float_test",   "bool_test",
+                        "null_test", "depth_test.test", "depth_test.array"};
+
+  UtilsJsonToken tokens[16];
+  UtilsJsonValue value, expect;
+
+  int num = utils_json_index_parse(test_json, strlen(test_json), 8, tokens, 16);
+  ASSERT_EQ(num, 14);
+  ASSERT_EQ(tokens[0].next, num);
+  ASSERT_EQ(tokens[0].partial, 0);
+  ASSERT_EQ(tokens[1].type, UTILS_JSON_TOKEN_TYPE_STRING);
+  ASSERT_EQ(tokens[5].type, UTILS_JSON_TOKEN_TYPE_OBJECT);
+  ASSERT_EQ(tokens[5].next, 13);
+  ASSERT_EQ(tokens[13].type, UTILS_JSON_TOKEN_TYPE_NULL);
+
+  // depth limited and token limited index fall back to scan
+  for (int max_tokens : {16, 6, 1}) {
+    num = utils_json_index_parse(test_json, strlen(test_json), max_tokens == 6 ? 1 : 8, tokens, max_tokens);
+    ASSERT_GT(num, 0);
+    for (const char *key : keys) {
+      ASSERT_EQ(utils_json_value_get(key, strlen(key), test_json, strlen(test_json), &expect), 0);
+      ASSERT_EQ(utils_json_index_value_get(tokens, num, key, strlen(key), &value), 0);
+      ASSERT_EQ(value.value, expect.value);
+      ASSERT_EQ(value.value_len, expect.value_len);
+    }
+    ASSERT_NE(utils_json_index_value_get(tokens, num, "not_exist", strlen("not_exist"), &value), 0);
+  }
+  ASSERT_EQ(strncmp(value.value, "[1, {\"a\":\"b\"}, [2]]", value.value_len), 0);
+
+  // brackets in string
+  char test_json_bracket[] = "{\"array\":[\"]\", \"}\"], \"str\":\"[\"}";
+  num = utils_json_index_parse(test_json_bracket, strlen(test_json_bracket), 8, tokens, 16);
+  ASSERT_EQ(num, 5);
+  ASSERT_EQ(utils_json_index_value_get(tokens, num, "array", strlen("array"), &value), 0);
+  ASSERT_EQ(strncmp(value.value, "[\"]\", \"}\"]", value.value_len), 0);
+  ASSERT_EQ(utils_json_index_value_get(tokens, num, "str", strlen("str"), &value), 0);
+  ASSERT_EQ(strncmp(value.value, "[", value.value_len), 0);
+
+  // hint
+  num = utils_json_index_parse(test_json, strlen(test_json), 1, tokens, 16);
+  int hint = 0;
+  ASSERT_EQ(utils_json_index_member_get(tokens, 0, &hint, "bool_test", strlen("bool_test"), &value), 0);
+  ASSERT_EQ(hint, 5);
+  ASSERT_EQ(utils_json_index_member_get(tokens, 0, &hint, "int_test", strlen("int_test"), &value), 0);
+  ASSERT_EQ(strncmp(value.value, "100", value.value_len), 0);
+  ASSERT_EQ(hint, 3);
+
+  // invalid json
+  for (const char *invalid : {"", "  ", "\"str\"", "{\"a\":1", "{\"a\" 1}", "{\"a\":\"1}", "{\"a\":1,}", "[1 2]"}) {
+    ASSERT_EQ(utils_json_index_parse(invalid, strlen(invalid), 8, tokens, 16), -1);
+  }
+  ASSERT_EQ(utils_json_index_parse(" [ ] ", 5, 8, tokens, 16), 1);
+}
+
+/**
+ * @brief Control payload of property_count properties, keys of properties are returned.
+ *
+ */
+static std::string _json_control_payload(int property_count, std::vector<std::string> &keys) {
+  std::string payload = "{\"method\":\"control\",\"clientToken\":\"clientToken-8f6b2d\",\"params\":{";
+  for (int i = 0; i < property_count; i++) {
+    keys.push_back("property_" + std::to_string(i));
+    payload += (i ? ",\"" : "\"") + keys[i] + "\":";
+    payload += i % 3 ? std::to_string(i * 7) : "\"value_" + std::to_string(i) + "\"";
+  }
+  return payload + "}}";
+}
+
+/**
+ * @brief Test json index on control payload of 5, 50 and 500 properties, lookups should be same as scan.
+ *
+ */
+TEST(UtilsJsonTest, json_index_control) {
+  for (int property_count : {5, 50, 500}) {
+    std::vector<std::string> keys;
+    std::string              payload = _json_control_payload(property_count, keys);
+
+    std::vector<UtilsJsonToken> tokens(property_count + 1);
+    UtilsJsonValue              params, expect_params, value, expect;
+
+    int num = utils_json_index_parse(payload.c_str(), payload.length(), 1, tokens.data(), 4);
+    ASSERT_GT(num, 0);
+    ASSERT_EQ(utils_json_index_value_get(tokens.data(), num, "params", strlen("params"), &params), 0);
+    ASSERT_EQ(utils_json_value_get("params", strlen("params"), payload.c_str(), payload.length(), &expect_params), 0);
+    ASSERT_EQ(params.value, expect_params.value);
+    ASSERT_EQ(params.value_len, expect_params.value_len);
+
+    num = utils_json_index_parse(params.value, params.value_len, 1, tokens.data(), tokens.size());
+    ASSERT_EQ(num, property_count + 1);
+    int hint = 0;
+    for (auto &key : keys) {
+      ASSERT_EQ(utils_json_index_member_get(tokens.data(), 0, &hint, key.c_str(), key.length(), &value), 0);
+      ASSERT_EQ(utils_json_value_get(key.c_str(), key.length(), params.value, params.value_len, &expect), 0);
+      ASSERT_EQ(value.value, expect.value);
+      ASSERT_EQ(value.value_len, expect.value_len);
+    }
+  }
+}
+
+/**
+ * @brief Compare json index with utils_json_value_get on control payload of 5, 50 and 500 properties.
+ *
+ */
+TEST(UtilsJsonTest, DISABLED_json_index_benchmark) {
+  const int loop_bytes = 50 * 1024 * 1024;
+
+  for (int property_count : {5, 50, 500}) {
+    std::vector<std::string> keys;
+    std::string              payload = _json_control_payload(property_count, keys);
+
+    int loops = loop_bytes / payload.length() / property_count + 1;
+    int found = 0;
+
+    UtilsJsonValue method, client_token, params, value;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int n = 0; n < loops; n++) {
+      utils_json_value_get("method", strlen("method"), payload.c_str(), payload.length(), &method);
+      utils_json_value_get("clientToken", strlen("clientToken"), payload.c_str(), payload.length(), &client_token);
+      utils_json_value_get("params", strlen("params"), payload.c_str(), payload.length(), &params);
+      for (auto &key : keys) {
+        found += !utils_json_value_get(key.c_str(), key.length(), params.value, params.value_len, &value);
+      }
+    }
+    auto scan_cost = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+    ASSERT_EQ(found, property_count * loops);
+
+    std::vector<UtilsJsonToken> tokens(property_count + 1);
+    found = 0;
+    start = std::chrono::steady_clock::now();
+    for (int n = 0; n < loops; n++) {
+      int num = utils_json_index_parse(payload.c_str(), payload.length(), 1, tokens.data(), 4);
+      utils_json_index_value_get(tokens.data(), num, "method", strlen("method"), &method);
+      utils_json_index_value_get(tokens.data(), num, "clientToken", strlen("clientToken"), &client_token);
+      utils_json_index_value_get(tokens.data(), num, "params", strlen("params"), &params);
+      num      = utils_json_index_parse(params.value, params.value_len, 1, tokens.data(), tokens.size());
+      int hint = 0;
+      for (auto &key : keys) {
+        found += !utils_json_index_member_get(tokens.data(), 0, &hint, key.c_str(), key.length(), &value);
+      }
+    }
+    auto index_cost = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+    ASSERT_EQ(found, property_count * loops);
+
+    std::cout << property_count << " properties(" << payload.length()
+              << " bytes) scan: " << static_cast<double>(scan_cost.count()) / loops / 1000
+              << " us, index: " << static_cast<double>(index_cost.count()) / loops / 1000 << " us" << std::endl;
+  }
+}
+
+/**
+ * @brief Random json value with escapes and brackets in strings.
+ *
+ */
+static std::string _random_json_value(int depth) {
+  const char *chars[] = {"a", "]", "}", "[", "{", ":", ",", " ", "\\\"", "\\\\", "\\\\\\\"", "\\/"};
+
+  std::string value;
+  switch (depth > 3 ? rand() % 4 : rand() % 6) {
+    case 0:
+      value = "\"";
+      for (int n = rand() % 100; n > 0; n--) {
+        value += chars[rand() % (sizeof(chars) / sizeof(chars[0]))];
+      }
+      return value + "\"";
+    case 1:
+      return std::to_string(rand() - RAND_MAX / 2);
+    case 2:
+      return rand() % 2 ? "true" : "false";
+    case 3:
+      return "null";
+    case 4:
+      value = "[";
+      for (int n = rand() % 5; n > 0; n--) {
+        value += _random_json_value(depth + 1) + (n > 1 ? ", " : "");
+      }
+      return value + "]";
+    default:
+      value = "{";
+      for (int n = rand() % 5; n > 0; n--) {
+        value += "\"k" + std::to_string(n) + "\" : " + _random_json_value(depth + 1) + (n > 1 ? "," : "");
+      }
+      return value + "}";
+  }
+}
+
+/**
+ * @brief Test json scan on random json, values should be found exactly where they are generated.
+ *
+ */
+TEST(UtilsJsonTest, json_random) {
+  srand(2021);
+  for (int loop = 0; loop < 2000; loop++) {
+    std::vector<std::pair<size_t, size_t>> spans;
+
+    std::string json = "{";
+    int         count = rand() % 20 + 1;
+    for (int i = 0; i < count; i++) {
+      std::string value = _random_json_value(0);
+      json += "\"key_" + std::to_string(i) + "\":" + std::string(rand() % 3, ' ');
+      // string value is without '"'
+      spans.push_back(value[0] == '"' ? std::make_pair(json.length() + 1, value.length() - 2)
+                                      : std::make_pair(json.length(), value.length()));
+      json += value + (i < count - 1 ? "," : "}");
+    }
+
+    std::vector<UtilsJsonToken> tokens(count + 1);
+    int num = utils_json_index_parse(json.c_str(), json.length(), 1, tokens.data(), tokens.size());
+    ASSERT_EQ(num, count + 1) << json;
+
+    UtilsJsonValue value;
+    for (int i = 0; i < count; i++) {
+      std::string key = "key_" + std::to_string(i);
+      ASSERT_EQ(utils_json_value_get(key.c_str(), key.length(), json.c_str(), json.length(), &value), 0) << json;
+      ASSERT_EQ(value.value, json.c_str() + spans[i].first) << json;
+      ASSERT_EQ(value.value_len, spans[i].second) << json;
+      ASSERT_EQ(utils_json_index_value_get(tokens.data(), num, key.c_str(), key.length(), &value), 0) << json;
+      ASSERT_EQ(value.value, json.c_str() + spans[i].first) << json;
+      ASSERT_EQ(value.value_len, spans[i].second) << json;
+    }
+  }
+}
+
+/**
+ * @brief Large get_status_reply payload of 1000 properties, with escapes and nests in values.
+ *
+ */
+static std::string _json_status_payload(void) {
+  std::string status =
+      "{\"method\":\"get_status_reply\",\"clientToken\":\"clientToken-8f6b2d\",\"data\":{\"reported\":{";
+  for (int i = 0; i < 1000; i++) {
+    status += (i ? ",\"" : "\"") + std::string("property_") + std::to_string(i) + "\":";
+    switch (i % 4) {
+      case 0:
+        status += std::to_string(i * 7);
+        break;
+      case 1:
+        status += "\"name with \\\"quote\\\" and \\\\ slash " + std::to_string(i) + "\"";
+        break;
+      case 2:
+        status += "{\"longitude\":" + std::to_string(i) + ",\"latitude\":-" + std::to_string(i) + "}";
+        break;
+      default:
+        status += "[1.5, 2.5, {\"value\":true}]";
+        break;
+    }
+  }
+  return status + "},\"control\":{\"power_switch\":1}},\"code\":0}";
+}
+
+/**
+ * @brief Large file list payload of 1000 resources.
+ *
+ */
+static std::string _json_file_list_payload(void) {
+  std::string file_list = "{\"method\":\"report_version_rsp\",\"resource_list\":[";
+  for (int i = 0; i < 1000; i++) {
+    file_list += (i ? ",{" : "{") + std::string("\"resource_name\":\"audio_") + std::to_string(i) +
+                 ".mp3\",\"version\":\"1.0." + std::to_string(i) + "\",\"resource_type\":\"AUDIO\"}";
+  }
+  return file_list + "],\"result_code\":0}";
+}
+
+/**
+ * @brief Test json scan on large get_status_reply and file list payloads, keys after large values should be found.
+ *
+ */
+TEST(UtilsJsonTest, json_scan_large) {
+  std::string    status    = _json_status_payload();
+  std::string    file_list = _json_file_list_payload();
+  UtilsJsonValue value;
+
+  ASSERT_EQ(utils_json_value_get("data.control", strlen("data.control"), status.c_str(), status.length(), &value), 0);
+  ASSERT_EQ(std::string(value.value, value.value_len), "{\"power_switch\":1}");
+  ASSERT_EQ(utils_json_value_get("code", strlen("code"), status.c_str(), status.length(), &value), 0);
+  ASSERT_EQ(std::string(value.value, value.value_len), "0");
+  ASSERT_EQ(utils_json_value_get("data.reported.property_998", strlen("data.reported.property_998"), status.c_str(),
+                                 status.length(), &value),
+            0);
+  ASSERT_EQ(std::string(value.value, value.value_len), "{\"longitude\":998,\"latitude\":-998}");
+  ASSERT_NE(utils_json_value_get("data.power_switch", strlen("data.power_switch"), status.c_str(), status.length(),
+                                 &value),
+            0);
+
+  ASSERT_EQ(utils_json_value_get("result_code", strlen("result_code"), file_list.c_str(), file_list.length(), &value),
+            0);
+  ASSERT_EQ(std::string(value.value, value.value_len), "0");
+}
+
+/**
+ * @brief Throughput of utils_json_value_get on large get_status_reply and file list payloads.
+ *
+ */
+TEST(UtilsJsonTest, DISABLED_json_scan_benchmark) {
+  const int loop_bytes = 256 * 1024 * 1024;
+
+  std::string status    = _json_status_payload();
+  std::string file_list = _json_file_list_payload();
+
+  struct {
+    const char        *name;
+    const std::string &payload;
+    const char        *key;
+  } cases[] = {{"get_status_reply", status, "data.control"}, {"file list", file_list, "result_code"}};
+
+  for (auto &c : cases) {
+    UtilsJsonValue value;
+
+    int loops = loop_bytes / c.payload.length() + 1;
+    int found = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int n = 0; n < loops; n++) {
+      found += !utils_json_value_get(c.key, strlen(c.key), c.payload.c_str(), c.payload.length(), &value);
+    }
+    auto cost = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+    ASSERT_EQ(found, loops);
+
+    std::cout << c.name << "(" << c.payload.length() << " bytes) scan: "
+              << static_cast<double>(c.payload.length()) * loops * 1000 / cost.count() << " MB/s" << std::endl;
+  }
+}
+
+/**
+ * @brief Test json writer, output should be valid json and same as expected.
+ *
+ */
+TEST(UtilsJsonTest, json_writer) {
+  char            buf[256];
+  UtilsJsonWriter writer;
+
+  utils_json_writer_init(&writer, buf, sizeof(buf));
+  utils_json_writer_object_begin(&writer);
+  UTILS_JSON_WRITER_KEY(&writer, "method");
+  utils_json_writer_string(&writer, "report", strlen("report"));
+  utils_json_writer_key(&writer, "na\"me", strlen("na\"me"));
+  utils_json_writer_string(&writer, "a\"b\\c\n\x01", strlen("a\"b\\c\n\x01"));
+  UTILS_JSON_WRITER_KEY(&writer, "list");
+  utils_json_writer_array_begin(&writer);
+  utils_json_writer_int(&writer, INT64_MIN);
+  utils_json_writer_int(&writer, INT64_MAX);
+  utils_json_writer_uint(&writer, UINT64_MAX);
+  utils_json_writer_int_string(&writer, -1);
+  utils_json_writer_bool(&writer, 1);
+  utils_json_writer_null(&writer);
+  utils_json_writer_array_begin(&writer);
+  utils_json_writer_array_end(&writer);
+  utils_json_writer_object_begin(&writer);
+  utils_json_writer_object_end(&writer);
+  utils_json_writer_raw(&writer, "{\"a\":1}", strlen("{\"a\":1}"));
+  // escaped string from json is not escaped again
+  utils_json_writer_string_raw(&writer, "t\\\"k", strlen("t\\\"k"));
+  utils_json_writer_array_end(&writer);
+  UTILS_JSON_WRITER_KEY(&writer, "float");
+  utils_json_writer_array_begin(&writer);
+  utils_json_writer_float(&writer, 0);
+  utils_json_writer_float(&writer, -1.5);
+  utils_json_writer_float(&writer, 3.1415926);
+  utils_json_writer_float(&writer, 0.0000001);
+  utils_json_writer_float(&writer, 1e13);
+  utils_json_writer_float(&writer, NAN);
+  utils_json_writer_array_end(&writer);
+  utils_json_writer_object_end(&writer);
+
+  const char *expected =
+      "{\"method\":\"report\",\"na\\\"me\":\"a\\\"b\\\\c\\n\\u0001\",\"list\":[-9223372036854775808,"
+      "9223372036854775807,18446744073709551615,\"-1\",true,null,[],{},{\"a\":1},\"t\\\"k\"],"
+      "\"float\":[0,-1.5,3.141593,0,10000000000000,null]}";
+  ASSERT_EQ(utils_json_writer_finish(&writer), strlen(expected));
+  ASSERT_STREQ(buf, expected);
+
+  UtilsJsonValue value;
+  ASSERT_EQ(utils_json_value_get("list", strlen("list"), buf, strlen(buf), &value), 0);
+  ASSERT_EQ(strncmp(value.value, "[-9223372036854775808", strlen("[-9223372036854775808")), 0);
+  ASSERT_EQ(utils_json_value_get("float", strlen("float"), buf, strlen(buf), &value), 0);
+  ASSERT_EQ(value.value_len, strlen("[0,-1.5,3.141593,0,10000000000000,null]"));
+
+  // overflow at every length should be reported, never write beyond buffer
+  for (size_t len = 0; len <= strlen(expected); len++) {
+    std::vector<char> small(len + 1, '#');
+    utils_json_writer_init(&writer, small.data(), len);
+    utils_json_writer_object_begin(&writer);
+    UTILS_JSON_WRITER_KEY(&writer, "method");
+    utils_json_writer_string(&writer, "report", strlen("report"));
+    utils_json_writer_key(&writer, "na\"me", strlen("na\"me"));
+    utils_json_writer_string(&writer, "a\"b\\c\n\x01", strlen("a\"b\\c\n\x01"));
+    utils_json_writer_object_end(&writer);
+    int rc = utils_json_writer_finish(&writer);
+    if (len > strlen("{\"method\":\"report\",\"na\\\"me\":\"a\\\"b\\\\c\\n\\u0001\"}")) {
+      ASSERT_GT(rc, 0);
+    } else {
+      ASSERT_EQ(rc, -1);
+    }
+    ASSERT_EQ(small[len], '#');
+  }
+
+  // large floats are written in exponent form and parsed back exactly
+  const double large[] = {1e60, -1e60, DBL_MAX, -DBL_MAX, 123456789012345.6};
+  for (double v : large) {
+    utils_json_writer_init(&writer, buf, sizeof(buf));
+    utils_json_writer_float(&writer, v);
+    int len = utils_json_writer_finish(&writer);
+    ASSERT_GT(len, 0);
+    ASSERT_LE(len, 24);
+    ASSERT_EQ(strtod(buf, NULL), v);
+  }
+
+  // containers not closed or key without value
+  utils_json_writer_init(&writer, buf, sizeof(buf));
+  utils_json_writer_object_begin(&writer);
+  ASSERT_EQ(utils_json_writer_finish(&writer), -1);
+  utils_json_writer_init(&writer, buf, sizeof(buf));
+  utils_json_writer_object_begin(&writer);
+  UTILS_JSON_WRITER_KEY(&writer, "key");
+  utils_json_writer_object_end(&writer);
+  ASSERT_EQ(utils_json_writer_finish(&writer), -1);
+}
+
+/**
+ * @brief Write report of properties by json writer.
+ *
+ */
+static int _json_writer_report(char *buf, int buf_len, int count, const std::vector<std::string> &names) {
+  UtilsJsonWriter writer;
+  utils_json_writer_init(&writer, buf, buf_len);
+  utils_json_writer_object_begin(&writer);
+  UTILS_JSON_WRITER_KEY(&writer, "method");
+  utils_json_writer_string(&writer, "report", strlen("report"));
+  UTILS_JSON_WRITER_KEY(&writer, "clientToken");
+  utils_json_writer_string(&writer, "property-1", strlen("property-1"));
+  UTILS_JSON_WRITER_KEY(&writer, "params");
+  utils_json_writer_object_begin(&writer);
+  for (int i = 0; i < count; i++) {
+    utils_json_writer_key(&writer, names[i].c_str(), names[i].length());
+    switch (i % 3) {
+      case 0:
+        utils_json_writer_int(&writer, i * 7);
+        break;
+      case 1:
+        utils_json_writer_float(&writer, i + 0.25);
+        break;
+      default:
+        utils_json_writer_string(&writer, names[i].c_str(), names[i].length());
+        break;
+    }
+  }
+  utils_json_writer_object_end(&writer);
+  utils_json_writer_object_end(&writer);
+  return utils_json_writer_finish(&writer);
+}
+
+/**
+ * @brief Write report of properties by snprintf, the way before json writer.
+ *
+ */
+static int _json_snprintf_report(char *buf, int buf_len, int count, const std::vector<std::string> &names) {
+  static std::vector<char> params;
+  params.resize(buf_len);
+
+  int offset = HAL_Snprintf(params.data(), buf_len, "{");
+  for (int i = 0; i < count; i++) {
+    switch (i % 3) {
+      case 0:
+        offset += HAL_Snprintf(params.data() + offset, buf_len - offset, "\"%s\":%d,", names[i].c_str(), i * 7);
+        break;
+      case 1:
+        offset += HAL_Snprintf(params.data() + offset, buf_len - offset, "\"%s\":%f,", names[i].c_str(), i + 0.25);
+        break;
+      default:
+        offset += HAL_Snprintf(params.data() + offset, buf_len - offset, "\"%s\":\"%s\",", names[i].c_str(),
+                               names[i].c_str());
+        break;
+    }
+  }
+  params[offset - 1] = '}';
+  return HAL_Snprintf(buf, buf_len, "{\"method\":\"report\",\"clientToken\":\"%s\",\"params\":%s}", "property-1",
+                      params.data());
+}
+
+/**
+ * @brief Test large report of json writer, every property should be parsed back and truncation should be reported.
+ *
+ */
+TEST(UtilsJsonTest, json_writer_report) {
+  std::vector<std::string> names;
+  for (int i = 0; i < 1000; i++) {
+    names.push_back("property_" + std::to_string(i));
+  }
+  std::vector<char> buf(64 * 1024);
+
+  int len = _json_writer_report(buf.data(), buf.size(), names.size(), names);
+  ASSERT_GT(len, 0);
+  ASSERT_EQ(static_cast<size_t>(len), strlen(buf.data()));
+
+  UtilsJsonValue params, value;
+  ASSERT_EQ(utils_json_value_get("params", strlen("params"), buf.data(), len, &params), 0);
+
+  std::vector<UtilsJsonToken> tokens(names.size() + 1);
+  int num = utils_json_index_parse(params.value, params.value_len, 1, tokens.data(), tokens.size());
+  ASSERT_EQ(num, static_cast<int>(names.size()) + 1);
+
+  int hint = 0;
+  for (size_t i = 0; i < names.size(); i++) {
+    ASSERT_EQ(utils_json_index_member_get(tokens.data(), 0, &hint, names[i].c_str(), names[i].length(), &value), 0);
+    std::string data(value.value, value.value_len);
+    switch (i % 3) {
+      case 0:
+        ASSERT_EQ(data, std::to_string(i * 7));
+        break;
+      case 1:
+        ASSERT_EQ(strtod(data.c_str(), NULL), i + 0.25);
+        break;
+      default:
+        ASSERT_EQ(data, names[i]);
+        break;
+    }
+  }
+
+  // buffer one byte short of the report is never truncated silently
+  ASSERT_EQ(_json_writer_report(buf.data(), len, names.size(), names), -1);
+}
+
+/**
+ * @brief Benchmark of report serialization, json writer and snprintf with intermediate params buffer.
+ *
+ */
+TEST(UtilsJsonTest, DISABLED_json_writer_benchmark) {
+  const int loop_properties = 4 * 1024 * 1024;
+
+  std::vector<std::string> names;
+  for (int i = 0; i < 1000; i++) {
+    names.push_back("property_" + std::to_string(i));
+  }
+  std::vector<char> buf(64 * 1024);
+
+  for (int count : {10, 100, 1000}) {
+    int loops = loop_properties / count;
+
+    struct {
+      const char *name;
+      int (*report)(char *, int, int, const std::vector<std::string> &);
+    } cases[] = {{"snprintf", _json_snprintf_report}, {"writer", _json_writer_report}};
+
+    for (auto &c : cases) {
+      int len = 0;
+
+      auto start = std::chrono::steady_clock::now();
+      for (int n = 0; n < loops; n++) {
+        len = c.report(buf.data(), buf.size(), count, names);
+      }
+      auto cost = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+      ASSERT_GT(len, 0);
+
+      UtilsJsonValue value;
+      ASSERT_EQ(utils_json_value_get("params", strlen("params"), buf.data(), len, &value), 0);
+
+      std::cout << count << " properties(" << len << " bytes) " << c.name << ": " << cost.count() / loops << " ns"
+                << std::endl;
+    }
+  }
+}
+
 }  // namespace utils_unittest
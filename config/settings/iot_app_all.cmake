@@ -21,9 +21,28 @@ set(CONFIG_DEBUG_DEV_INFO_USED ON)
 # 是否使能多线程
 set(CONFIG_MULTITHREAD_ENABLED OFF)
 
+# TLS性能配置，DEFAULT：CBC套件；PERFORMANCE：优先使用AES-GCM/CHACHA20-POLY1305套件，x86_64上开启AES-NI（仅密钥认证）
+set(CONFIG_TLS_PROFILE "DEFAULT")
+
+# TLS记录最大长度（字节，不超过16384），为空时DEFAULT使用3584，PERFORMANCE使用16384（仅密钥认证）
+set(CONFIG_TLS_MAX_CONTENT_LEN "")
+
+# TLS最大分片长度协商（512/1024/2048/4096），为空时不协商
+set(CONFIG_TLS_MAX_FRAG_LEN "")
+
+# 日志编译等级（DISABLE/ERROR/WARN/INFO/DEBUG），比该等级更详细的日志在编译时去除
+set(CONFIG_LOG_MIN_LEVEL "DEBUG")
+
+# 日志缓存条数（2的幂），未启动日志线程时日志先缓存再输出，为空时不缓存直接输出，内存占用与旧版本一致
+set(CONFIG_LOG_RING_RECORD_NUM "")
+
+# 是否使能日志上报云端功能
+set(CONFIG_LOG_UPLOAD ON)
+
 option(IOT_DEBUG "Enable IOT_DEBUG" ${CONFIG_IOT_DEBUG})
 option(DEBUG_DEV_INFO_USED "Enable DEBUG_DEV_INFO_USED" ${CONFIG_DEBUG_DEV_INFO_USED})
 option(AUTH_WITH_NO_TLS "Enable AUTH_WITH_NO_TLS" ${CONFIG_AUTH_WITH_NOTLS})
+option(LOG_UPLOAD "Enable LOG_UPLOAD" ${CONFIG_LOG_UPLOAD})
 
 if(${CONFIG_AUTH_MODE} STREQUAL  "KEY")
 	option(AUTH_MODE_KEY "Enable AUTH_MODE_KEY" ON)
@@ -35,6 +54,26 @@ else()
 	message(FATAL_ERROR "INVAILD AUTH_MODE:${FEATURE_AUTH_MODE} WITH AUTH_WITH_NO_TLS:${FEATURE_AUTH_WITH_NOTLS}!")
 endif()
 
+if(${CONFIG_TLS_PROFILE} STREQUAL "PERFORMANCE")
+	option(TLS_PROFILE_PERFORMANCE "Enable TLS_PROFILE_PERFORMANCE" ON)
+elseif(${CONFIG_TLS_PROFILE} STREQUAL "DEFAULT")
+	option(TLS_PROFILE_PERFORMANCE "Enable TLS_PROFILE_PERFORMANCE" OFF)
+else()
+	message(FATAL_ERROR "INVAILD TLS_PROFILE:${CONFIG_TLS_PROFILE}!")
+endif()
+set(TLS_MAX_CONTENT_LEN ${CONFIG_TLS_MAX_CONTENT_LEN})
+set(TLS_MAX_FRAG_LEN ${CONFIG_TLS_MAX_FRAG_LEN})
+
+if(NOT ${CONFIG_LOG_MIN_LEVEL} MATCHES "^(DISABLE|ERROR|WARN|INFO|DEBUG)$")
+	message(FATAL_ERROR "INVAILD LOG_MIN_LEVEL:${CONFIG_LOG_MIN_LEVEL}!")
+endif()
+add_definitions("-DLOG_MIN_LEVEL=LOG_LEVEL_${CONFIG_LOG_MIN_LEVEL}")
+
+if(NOT "${CONFIG_LOG_RING_RECORD_NUM}" MATCHES "^(|1|2|4|8|16|32|64|128)$")
+	message(FATAL_ERROR "INVAILD LOG_RING_RECORD_NUM:${CONFIG_LOG_RING_RECORD_NUM}!")
+endif()
+set(LOG_RING_RECORD_NUM ${CONFIG_LOG_RING_RECORD_NUM})
+
 configure_file (
   "${IOT_SDK_SOURCE_DIR}/config/settings/qcloud_iot_config.h.in"
   "${IOT_SDK_SOURCE_DIR}/include/config/qcloud_iot_config.h" 
@@ -87,6 +126,9 @@ add_subdirectory(${IOT_SDK_SOURCE_DIR}/services/common/http_client)
 add_subdirectory(${IOT_SDK_SOURCE_DIR}/services/common/cos)
 add_subdirectory(${IOT_SDK_SOURCE_DIR}/services/common/system)
 add_subdirectory(${IOT_SDK_SOURCE_DIR}/services/common/ota)
+if(${CONFIG_LOG_UPLOAD} STREQUAL "ON")
+	add_subdirectory(${IOT_SDK_SOURCE_DIR}/services/common/log_upload)
+endif()
 add_subdirectory(${IOT_SDK_SOURCE_DIR}/services/explorer/data_template)
 include_directories(${inc_services})
 add_library(iot_services STATIC ${src_services})
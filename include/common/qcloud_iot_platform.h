@@ -346,7 +346,8 @@ int HAL_Timer_SetSystimeMs(uint64_t timestamp_ms);
  **************************************************************************************/
 
 /**
- * @brief TCP connect in linux
+ * @brief TCP connect in linux. Addresses are cached, and connected in parallel with staggered starts, standby
+ * connection started by HAL_TCP_Prewarm is used first.
  *
  * @param[in] host host to connect
  * @param[out] port port to connect
@@ -354,6 +355,24 @@ int HAL_Timer_SetSystimeMs(uint64_t timestamp_ms);
  */
 int HAL_TCP_Connect(const char *host, const char *port);
 
+/**
+ * @brief Resolve host into cache and start a standby connection in background, which is taken by the next
+ * HAL_TCP_Connect to the same host. Standby connection closed by peer or too old is replaced.
+ *
+ * @param[in] host host to connect
+ * @param[in] port port to connect
+ * @return @see IotReturnCode
+ */
+int HAL_TCP_Prewarm(const char *host, const char *port);
+
+/**
+ * @brief Close standby connection to host started by HAL_TCP_Prewarm.
+ *
+ * @param[in] host host to connect
+ * @param[in] port port to connect
+ */
+void HAL_TCP_PrewarmCancel(const char *host, const char *port);
+
 /**
  * @brief TCP disconnect
  *
@@ -374,6 +393,27 @@ int HAL_TCP_Disconnect(int fd);
  */
 int HAL_TCP_Write(int fd, const uint8_t *data, uint32_t len, uint32_t timeout_ms, size_t *written_len);
 
+/**
+ * @brief Data segment of vectored write.
+ *
+ */
+typedef struct {
+    const void *base; /**< start of data segment */
+    size_t      len;  /**< length of data segment */
+} IotIoVec;
+
+/**
+ * @brief TCP vectored write, segments are sent in order without being copied together.
+ *
+ * @param[in] fd socket fd
+ * @param[in] iov data segments to write
+ * @param[in] iovcnt count of data segments
+ * @param[in] timeout_ms timeout
+ * @param[out] written_len data written length
+ * @return @see IotReturnCode
+ */
+int HAL_TCP_Writev(int fd, const IotIoVec *iov, int iovcnt, uint32_t timeout_ms, size_t *written_len);
+
 /**
  * @brief TCP read.
  *
@@ -386,6 +426,73 @@ int HAL_TCP_Write(int fd, const uint8_t *data, uint32_t len, uint32_t timeout_ms
  */
 int HAL_TCP_Read(int fd, uint8_t *data, uint32_t len, uint32_t timeout_ms, size_t *read_len);
 
+/**
+ * @brief TCP receive, return as soon as any data is read instead of waiting for len bytes.
+ *
+ * @param[in] fd socket fd
+ * @param[out] buf buffer to save read data
+ * @param[in] len buffer len
+ * @param[in] timeout_ms timeout
+ * @param[out] read_len length of data read
+ * @return @see IotReturnCode
+ */
+int HAL_TCP_Recv(int fd, uint8_t *buf, uint32_t len, uint32_t timeout_ms, size_t *read_len);
+
+/**************************************************************************************
+ * network poller
+ **************************************************************************************/
+
+/**
+ * @brief Create poller to wait for readable event of many sockets, such as epoll in linux.
+ *
+ * @return pointer to poller, NULL for fail
+ */
+void *HAL_Poller_Create(void);
+
+/**
+ * @brief Destroy poller, sockets added are not closed.
+ *
+ * @param[in,out] poller pointer to poller
+ */
+void HAL_Poller_Destroy(void *poller);
+
+/**
+ * @brief Add socket to poller, level triggered readable event is reported with usr_data.
+ *
+ * @param[in,out] poller pointer to poller
+ * @param[in] fd socket fd
+ * @param[in] usr_data user data reported when socket is readable
+ * @return @see IotReturnCode
+ */
+int HAL_Poller_Add(void *poller, int fd, void *usr_data);
+
+/**
+ * @brief Remove socket from poller, socket closed is removed automatically.
+ *
+ * @param[in,out] poller pointer to poller
+ * @param[in] fd socket fd
+ * @return @see IotReturnCode
+ */
+int HAL_Poller_Del(void *poller, int fd);
+
+/**
+ * @brief Wait for sockets readable.
+ *
+ * @param[in,out] poller pointer to poller
+ * @param[out] ready user data of readable sockets
+ * @param[in] max_ready max count of ready
+ * @param[in] timeout_ms timeout
+ * @return count of readable sockets, 0 for timeout, others @see IotReturnCode
+ */
+int HAL_Poller_Wait(void *poller, void **ready, int max_ready, uint32_t timeout_ms);
+
+/**
+ * @brief Wake up poller waiting in other thread, wait returns with no socket readable.
+ *
+ * @param[in,out] poller pointer to poller
+ */
+void HAL_Poller_Wakeup(void *poller);
+
 #if defined(__cplusplus)
 }
 #endif
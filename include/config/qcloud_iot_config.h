@@ -54,6 +54,10 @@ extern "C" {
 /* #undef BROADCAST_ENABLED */
 /* #undef RRPC_ENABLED */
 /* #undef REMOTE_CONFIG_MQTT */
+/* #undef TLS_PROFILE_PERFORMANCE */
+/* #undef TLS_MAX_CONTENT_LEN */
+/* #undef TLS_MAX_FRAG_LEN */
+/* #undef LOG_RING_RECORD_NUM */
 
 #ifdef __cplusplus
 }
@@ -55,7 +55,7 @@ extern "C" {
 #define QCLOUD_IOT_MQTT_KEEP_ALIVE_INTERNAL (240 * 1000)
 
 /**
- * @brief default MQTT Tx buffer size, MAX: 16*1024
+ * @brief default MQTT Tx buffer size, publish payload is sent without copying and not limited by it, MAX: 16*1024
  *
  */
 #define QCLOUD_IOT_MQTT_TX_BUF_LEN (2048)
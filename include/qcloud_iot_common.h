@@ -57,6 +57,7 @@ extern "C" {
 #include "qcloud_iot_ota.h"
 #include "qcloud_iot_cos.h"
 #include "qcloud_iot_http_client.h"
+#include "qcloud_iot_log_upload.h"
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,133 @@
+/**
+ * @copyright
+ *
+ * Tencent is pleased to support the open source community by making IoT Hub available.
+ * Copyright(C) 2018 - 2021 THL A29 Limited, a Tencent company.All rights reserved.
+ *
+ * Licensed under the MIT License(the "License"); you may not use this file except in
+ * compliance with the License. You may obtain a copy of the License at
+ * http://opensource.org/licenses/MIT
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed under the License is
+ * distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @file qcloud_iot_log_upload.h
+ * @brief upload log to cloud by http
+ * @author fancyxu (fancyxu@tencent.com)
+ * @version 1.0
+ * @date 2026-10-16
+ *
+ * @par Change Log:
+ * <table>
+ * <tr><th>Date       <th>Version <th>Author    <th>Description
+ * <tr><td>2026-10-16 <td>1.0     <td>fancyxu   <td>first commit
+ * </table>
+ */
+
+#ifndef IOT_HUB_DEVICE_C_SDK_INCLUDE_SERVICES_COMMON_QCLOUD_IOT_LOG_UPLOAD_H_
+#define IOT_HUB_DEVICE_C_SDK_INCLUDE_SERVICES_COMMON_QCLOUD_IOT_LOG_UPLOAD_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#include "qcloud_iot_common.h"
+
+/**
+ * @brief Functions to save logs into file (or flash) when upload fails, all NULL to keep logs in memory only.
+ *
+ */
+typedef struct {
+    size_t (*log_file_save)(const char *data, size_t len);         /**< append to file, return length saved */
+    size_t (*log_file_read)(char *buf, size_t len, size_t offset); /**< read from offset, return length read */
+    int (*log_file_del)(void);                                     /**< delete file, 0 for success */
+    size_t (*log_file_get_size)(void);                             /**< size of file, 0 for no file */
+} LogUploadFileFunc;
+
+/**
+ * @brief Log upload init params.
+ *
+ */
+typedef struct {
+    const char       *url;             /**< log server url */
+    int               port;            /**< log server port */
+    const char       *product_id;      /**< product id */
+    const char       *device_name;     /**< device name */
+    const char       *sign_key;        /**< key to sign logs, device secret for key auth, NULL for not signing */
+    uint32_t          buffer_size;     /**< size of memory ring, rounded up to power of 2 */
+    uint32_t          interval_ms;     /**< upload interval, logs are uploaded earlier if ring is half full */
+    uint8_t           compress_enable; /**< deflate post body, server should accept Content-Encoding:deflate */
+    LogUploadFileFunc file_func;       /**< @see LogUploadFileFunc */
+} LogUploadInitParams;
+
+/**
+ * Default log upload init parameters
+ */
+#define DEFAULT_LOG_UPLOAD_INIT_PARAMS                                                                        \
+    {                                                                                                         \
+        LOG_UPLOAD_SERVER_URL, 80, NULL, NULL, NULL, LOG_UPLOAD_BUFFER_SIZE, LOG_UPLOAD_INTERVAL_MS, 0, { 0 } \
+    }
+
+/**
+ * @brief Statistics of log upload.
+ *
+ */
+typedef struct {
+    uint64_t upload_bytes; /**< log bytes accepted by server */
+    uint64_t post_bytes;   /**< http body bytes posted, less than upload bytes if compressed */
+    uint32_t post_num;     /**< number of http posts */
+    uint32_t connect_num;  /**< number of http connections */
+    uint32_t drop_num;     /**< logs dropped for memory ring full */
+    uint32_t drop_bytes;   /**< log bytes dropped for file full or rejected by server */
+    uint32_t save_bytes;   /**< log bytes saved into file */
+    uint32_t memory_size;  /**< memory malloc by log upload */
+} LogUploadStats;
+
+/**
+ * @brief Init log upload, an upload thread is created with MULTITHREAD_ENABLED, otherwise IOT_Log_Upload should be
+ * called periodically. Logs saved in file last time are uploaded first.
+ *
+ * @param[in] params @see LogUploadInitParams
+ * @return @see IotReturnCode
+ */
+int IOT_Log_Upload_Init(const LogUploadInitParams *params);
+
+/**
+ * @brief Log handler to be set as LogHandleFunc.log_handle, copy log into memory ring and never blocks. Logs are
+ * dropped when ring is full.
+ *
+ * @param[in] message log to upload
+ */
+void IOT_Log_Upload_Handle(const char *message);
+
+/**
+ * @brief Upload logs in file and memory ring if interval passed or ring is half full, logs are saved into file if
+ * upload fails.
+ *
+ * @param[in] force_upload upload at once
+ * @return @see IotReturnCode
+ */
+int IOT_Log_Upload(int force_upload);
+
+/**
+ * @brief Get statistics of log upload.
+ *
+ * @param[out] stats @see LogUploadStats
+ */
+void IOT_Log_Upload_GetStats(LogUploadStats *stats);
+
+/**
+ * @brief Stop upload thread, upload logs left or save them into file, then deinit log upload.
+ *
+ */
+void IOT_Log_Upload_Deinit(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // IOT_HUB_DEVICE_C_SDK_INCLUDE_SERVICES_COMMON_QCLOUD_IOT_LOG_UPLOAD_H_
@@ -113,7 +113,17 @@ typedef struct {
     uint8_t     auto_connect_enable;    /**< flag of auto reconnection, 1 is enable and recommended */
     uint8_t     connect_when_construct; /**< 1 is enable when no using pre-process before connect */
     uint8_t default_subscribe; /**< 1 is enable when clean session is 0, no subscribe packet send, only add subhandle */
-    MQTTEventHandler event_handle; /**< event callback */
+    MQTTEventHandler event_handle;    /**< event callback */
+    uint16_t         pub_window_size; /**< max qos1 publish in flight, 0 for default */
+    uint8_t *        write_buf;       /**< write buffer provided by user, NULL to be allocated by sdk */
+    uint8_t *        read_buf;        /**< read buffer provided by user, NULL to be allocated by sdk */
+    uint32_t         write_buf_size;  /**< size of write buffer, 0 for QCLOUD_IOT_MQTT_TX_BUF_LEN */
+    uint32_t         read_buf_size;   /**< size of read buffer, 0 for QCLOUD_IOT_MQTT_RX_BUF_LEN */
+    uint32_t         max_buf_size;    /**< ceiling of buffer allocated by sdk to grow on demand, 0 for no growing */
+    uint32_t pub_batch_buf_size; /**< size of buffer to coalesce publish packets into one write, 0 for no batching */
+    uint32_t pub_batch_flush_ms; /**< deadline to flush batched publish packets, 0 for MQTT_PUB_BATCH_FLUSH_MS */
+    uint8_t  io_thread_enable;   /**< 1 to read/keep alive/publish in background thread, only with MULTITHREAD_ENABLED */
+    uint8_t  standby_connect_enable; /**< 1 to keep a standby tcp connection to server for instant reconnect */
 } MQTTInitParams;
 
 /**
@@ -153,27 +163,46 @@ typedef struct {
     int payload_len;  // MQTT length of msg payload
 } MQTTMessage;
 
+/**
+ * @brief Define callback to release payload of qos1 publish, which is referenced until puback or timeout.
+ *
+ * @param[in] payload payload of PublishParams
+ * @param[in] usr_data user data of PublishParams, @see PublishParams
+ */
+typedef void (*OnPayloadReleaseHandler)(void *payload, void *usr_data);
+
 /**
  * @brief Params needed to publish expcept topic name(as a paramter of function).
  *
  */
 typedef struct {
-    QoS     qos;          // MQTT QoS level
-    uint8_t retain;       // RETAIN flag
-    uint8_t dup;          // DUP flag
-    void *  payload;      // MQTT msg payload
-    int     payload_len;  // MQTT length of msg payload
+    QoS                     qos;               // MQTT QoS level
+    uint8_t                 retain;            // RETAIN flag
+    uint8_t                 dup;               // DUP flag
+    void *                  payload;           // MQTT msg payload
+    int                     payload_len;       // MQTT length of msg payload
+    OnPayloadReleaseHandler payload_release;   // keep qos1 payload by reference until called, NULL to copy payload
+    void *                  release_usr_data;  // user data of payload_release
 } PublishParams;
 
 /**
  * @brief Default MQTT publish params
  *
  */
-#define DEFAULT_PUB_PARAMS  \
-    {                       \
-        QOS0, 0, 0, NULL, 0 \
+#define DEFAULT_PUB_PARAMS              \
+    {                                   \
+        QOS0, 0, 0, NULL, 0, NULL, NULL \
     }
 
+/**
+ * @brief Define callback when publish submitted by IOT_MQTT_PublishAsync is sent or fails.
+ *
+ * @param[in,out] client pointer to mqtt client
+ * @param[in] result packet id (>=0) when sent, or err code (<0) @see IotReturnCode
+ * @param[in] usr_data user data of IOT_MQTT_PublishAsync
+ */
+typedef void (*OnPublishCompleteHandler)(void *client, int result, void *usr_data);
+
 /**
  * @brief Define MQTT SUBSCRIBE callback when message arrived
  *
@@ -183,6 +212,18 @@ typedef struct {
  */
 typedef void (*OnMessageHandler)(void *client, const MQTTMessage *message, void *usr_data);
 
+/**
+ * @brief Define MQTT SUBSCRIBE callback when payload slice of message larger than read buffer arrived
+ *
+ * @param[in,out] client pointer to mqtt client
+ * @param[in] message publish message from server, payload and payload_len is the current slice
+ * @param[in] offset offset of the slice in the whole payload
+ * @param[in] total_len length of the whole payload
+ * @param[in] usr_data user data of SubscribeParams, @see SubscribeParams
+ */
+typedef void (*OnMessageChunkHandler)(void *client, const MQTTMessage *message, uint32_t offset, uint32_t total_len,
+                                      void *usr_data);
+
 /**
  * @brief Define MQTT SUBSCRIBE callback when event happened
  *
@@ -199,22 +240,51 @@ typedef void (*OnSubEventHandler)(void *client, MQTTEventType event_type, void *
  *
  */
 typedef struct {
-    QoS               qos;                  /**< MQTT QoS level */
-    OnMessageHandler  on_message_handler;   /**< callback when message arrived */
-    OnSubEventHandler on_sub_event_handler; /**< callback when event happened */
-    void *            user_data;            /**< user context for callback */
-    void (*user_data_free)(void *);         /**< user data free when sub handle remove */
+    QoS                   qos;                  /**< MQTT QoS level */
+    OnMessageHandler      on_message_handler;   /**< callback when message arrived */
+    OnSubEventHandler     on_sub_event_handler; /**< callback when event happened */
+    void *                user_data;            /**< user context for callback */
+    void (*user_data_free)(void *);             /**< user data free when sub handle remove */
+    OnMessageChunkHandler on_message_chunk;     /**< callback for message larger than read buffer, NULL to discard */
 } SubscribeParams;
 
 /**
  * Default MQTT subscribe parameters
  *
  */
-#define DEFAULT_SUB_PARAMS           \
-    {                                \
-        QOS0, NULL, NULL, NULL, NULL \
+#define DEFAULT_SUB_PARAMS                 \
+    {                                      \
+        QOS0, NULL, NULL, NULL, NULL, NULL \
     }
 
+/**
+ * @brief Statistics of QoS1 publish.
+ *
+ */
+typedef struct {
+    uint32_t retry_count;         /**< total count of publish retransmission */
+    uint32_t timeout_count;       /**< count of publish dropped after all retries */
+    uint32_t acked_count;         /**< count of publish acked by server */
+    uint32_t inflight_count;      /**< count of publish waiting for puback */
+    uint32_t last_ack_latency_ms; /**< latency from first sent to puback of the last acked publish */
+    uint32_t avg_ack_latency_ms;  /**< average latency from first sent to puback */
+} MQTTPubStatistics;
+
+/**
+ * @brief Statistics of keep alive.
+ *
+ */
+typedef struct {
+    uint32_t ping_sent_count;       /**< count of ping request sent */
+    uint32_t ping_suppressed_count; /**< count of ping request skipped for traffic within ping interval */
+    uint32_t ping_timeout_count;    /**< count of ping request without response in command timeout */
+    uint32_t ping_resp_count;       /**< count of ping response */
+    uint32_t last_rtt_ms;           /**< round trip time of the last ping */
+    uint32_t avg_rtt_ms;            /**< average round trip time of ping */
+    uint32_t ping_interval_ms;      /**< idle time before ping, shorter than keep alive if nat drops idle connection */
+    uint32_t nat_idle_timeout_ms;   /**< idle time after which connection was found broken, 0 for not found */
+} MQTTKeepAliveStatistics;
+
 /**
  * @brief Create MQTT client and connect to MQTT server.
  *
@@ -246,6 +316,8 @@ int IOT_MQTT_Destroy(void **client);
  * @param[in] timeout_ms timeout value (unit: ms) for this operation
  * @return QCLOUD_RET_SUCCESS when success, QCLOUD_ERR_MQTT_ATTEMPTING_RECONNECT when try reconnecting, others @see
  * IotReturnCode
+ * @note With io_thread_enable, packets are handled in io thread and yield only waits for timeout_ms or until packets
+ * are handled, so loops waiting for results still work. Callbacks run in io thread and should not wait in yield.
  */
 int IOT_MQTT_Yield(void *client, uint32_t timeout_ms);
 
@@ -256,9 +328,28 @@ int IOT_MQTT_Yield(void *client, uint32_t timeout_ms);
  * @param[in] topic_name topic to publish
  * @param[in] params @see PublishParams
  * @return packet id (>=0) when success, or err code (<0) @see IotReturnCode
+ * @note payload is sent without copying unless batched. If payload_release is set and qos1 publish succeeds, payload
+ * is kept by reference for republish and released on puback, timeout or client destroy, maybe in yield thread.
  */
 int IOT_MQTT_Publish(void *client, const char *topic_name, const PublishParams *params);
 
+#ifdef MULTITHREAD_ENABLED
+/**
+ * @brief Submit MQTT message to be published by io thread, without waiting for network or write buffer lock.
+ *
+ * @param[in,out] client pointer to mqtt client, constructed with io_thread_enable
+ * @param[in] topic_name topic to publish
+ * @param[in] params @see PublishParams
+ * @param[in] on_complete callback when sent or failed, called in io thread, NULL for none
+ * @param[in] usr_data user data of on_complete
+ * @return @see IotReturnCode
+ * @note topic and payload are copied unless payload_release is set, then payload is kept by reference until released
+ * or on_complete is called with error. Puback of qos1 is notified by MQTT_EVENT_PUBLISH_SUCCESS as publish.
+ */
+int IOT_MQTT_PublishAsync(void *client, const char *topic_name, const PublishParams *params,
+                          OnPublishCompleteHandler on_complete, void *usr_data);
+#endif
+
 /**
  * @brief Subscribe MQTT topic.
  *
@@ -316,6 +407,32 @@ int IOT_MQTT_SubscribeSync(void *client, const char *topic_filter, const Subscri
  */
 bool IOT_MQTT_IsConnected(void *client);
 
+/**
+ * @brief Get statistics of QoS1 publish.
+ *
+ * @param[in,out] client pointer to mqtt client
+ * @param[out] stats @see MQTTPubStatistics
+ * @return @see IotReturnCode
+ */
+int IOT_MQTT_GetPubStatistics(void *client, MQTTPubStatistics *stats);
+
+/**
+ * @brief Get statistics of keep alive.
+ *
+ * @param[in,out] client pointer to mqtt client
+ * @param[out] stats @see MQTTKeepAliveStatistics
+ * @return @see IotReturnCode
+ */
+int IOT_MQTT_GetKeepAliveStatistics(void *client, MQTTKeepAliveStatistics *stats);
+
+/**
+ * @brief Write publish packets pending in batch buffer to network immediately.
+ *
+ * @param[in,out] client pointer to mqtt client
+ * @return @see IotReturnCode
+ */
+int IOT_MQTT_Flush(void *client);
+
 /**
  * @brief Get device info using to connect mqtt server.
  *
@@ -324,6 +441,53 @@ bool IOT_MQTT_IsConnected(void *client);
  */
 DeviceInfo *IOT_MQTT_GetDeviceInfo(void *client);
 
+/**
+ * @brief Create event loop to drive many mqtt clients in one thread, instead of IOT_MQTT_Yield for each client.
+ *
+ * @return pointer to event loop, NULL for fail
+ *
+ * @note Sockets are waited by HAL_Poller(epoll in linux), so there is no limit of FD_SETSIZE. Event loop is not thread
+ * safe, clients should be added/removed in the thread running it. Use one event loop for each thread to use more cores.
+ * If MULTITHREAD_ENABLED, reconnect(tcp connect, tls handshake and connack) runs in a reconnect thread of event loop,
+ * so event handler of client may be called in it for reconnect events. Otherwise reconnect blocks the event loop.
+ */
+void *IOT_MQTT_LoopCreate(void);
+
+/**
+ * @brief Add client to event loop, client should not be yield by others after added.
+ *
+ * @param[in,out] loop pointer to event loop
+ * @param[in,out] client pointer to mqtt client
+ * @return @see IotReturnCode
+ */
+int IOT_MQTT_LoopAdd(void *loop, void *client);
+
+/**
+ * @brief Remove client from event loop, client is not destroyed.
+ *
+ * @param[in,out] loop pointer to event loop
+ * @param[in,out] client pointer to mqtt client
+ * @return @see IotReturnCode
+ */
+int IOT_MQTT_LoopRemove(void *loop, void *client);
+
+/**
+ * @brief Run event loop for timeout_ms, read/handle packets of readable clients and check ack timeout, keep alive and
+ * reconnect of all clients periodically.
+ *
+ * @param[in,out] loop pointer to event loop
+ * @param[in] timeout_ms timeout value (unit: ms) for this operation
+ * @return @see IotReturnCode
+ */
+int IOT_MQTT_LoopRun(void *loop, uint32_t timeout_ms);
+
+/**
+ * @brief Destroy event loop, clients are not destroyed.
+ *
+ * @param[in,out] loop pointer to event loop pointer
+ */
+void IOT_MQTT_LoopDestroy(void **loop);
+
 #ifdef __cplusplus
 }
 #endif
@@ -114,6 +114,15 @@ typedef struct {
     const char *   response; /**< property json defined in data template */
 } IotDataTemplateActionReply;
 
+/**
+ * @brief Write params of property report into publish buffer, such as properties need report.
+ *
+ * @param[in,out] writer json writer on publish buffer, @see UtilsJsonWriter
+ * @param[in,out] usr_data user data
+ * @return 0 for success
+ */
+typedef int (*PropertyParamsWrite)(UtilsJsonWriter *writer, void *usr_data);
+
 /**
  * @brief Check and subscribe data template topic.
  *
@@ -142,6 +151,19 @@ void IOT_DataTemplate_Deinit(void *client);
  */
 int IOT_DataTemplate_PropertyReport(void *client, char *buf, int buf_len, const char *params);
 
+/**
+ * @brief Report property, params are written into buffer directly without constructing json string first.
+ *
+ * @param[in,out] client pointer to mqtt client
+ * @param[in] buf buffer for message
+ * @param[in] buf_len buffer length
+ * @param[in] params_write write params, @see PropertyParamsWrite
+ * @param[in,out] usr_data user data of params_write
+ * @return packet id (>=0) when success, or err code (<0) @see IotReturnCode
+ */
+int IOT_DataTemplate_PropertyReportWrite(void *client, char *buf, int buf_len, PropertyParamsWrite params_write,
+                                         void *usr_data);
+
 /**
  * @brief Get control message offline.
  *
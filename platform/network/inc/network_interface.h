@@ -63,7 +63,10 @@ typedef struct IotNetwork IotNetwork;
 /**
  * @brief Define structure for network stack.
  *
- * @note init/connect/read/write/disconnect/state
+ * @note init/connect/read/recv/write/writev/disconnect/state/fd, read waits for the whole length while recv returns
+ * once any data is read. If read_ahead_size is set before init, read is served from read ahead buffer which is
+ * filled by one recv as large as possible. Data buffered by read ahead or tls is not reported by socket readable
+ * event, get_bytes_avail should be checked before waiting for socket.
  *
  */
 struct IotNetwork {
@@ -73,12 +76,22 @@ struct IotNetwork {
 
     int (*read)(IotNetwork *, unsigned char *, size_t, uint32_t, size_t *);
 
+    int (*recv)(IotNetwork *, unsigned char *, size_t, uint32_t, size_t *);
+
     int (*write)(IotNetwork *, unsigned char *, size_t, uint32_t, size_t *);
 
+    int (*writev)(IotNetwork *, const IotIoVec *, int, uint32_t, size_t *);
+
     void (*disconnect)(IotNetwork *);
 
     int (*is_connected)(IotNetwork *);
 
+    int (*get_fd)(IotNetwork *);
+
+    size_t (*get_bytes_avail)(IotNetwork *);
+
+    int (*prewarm)(IotNetwork *, int);
+
     union {
         int       fd;
         uintptr_t handle;
@@ -88,13 +101,18 @@ struct IotNetwork {
     SSLConnectParams ssl_connect_params;
 #endif
 
+    uint8_t *read_ahead_buf;  /**< read ahead buffer, allocated when connected */
+    size_t   read_ahead_size; /**< size of read ahead buffer, set before init, 0 for no read ahead */
+    size_t   read_ahead_pos;  /**< offset of data not read in read ahead buffer */
+    size_t   read_ahead_len;  /**< length of data not read in read ahead buffer */
+
     const char *   host; /**< server address */
     const char *   port; /**< server port */
     IotNetworkType type;
 };
 
 /**
- * @brief Init network, support tcp, tls(if AUTH_WITH_NO_TLS defined).
+ * @brief Init network, support tcp, tls(if AUTH_WITH_NO_TLS defined), read ahead if read_ahead_size set.
  *
  * @param[in,out] network pointer to network
  * @return @see IotReturnCode
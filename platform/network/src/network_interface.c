@@ -33,6 +33,103 @@ extern "C" {
 
 #include "network_interface.h"
 
+/**
+ * @brief Read from read ahead buffer, refill it by one recv as large as possible when empty. Read larger than the
+ * buffer goes to user buffer directly.
+ *
+ * @param[in,out] network pointer to network handle
+ * @param[out] data data buffer to be read in
+ * @param[in] datalen data buffer len
+ * @param[in] timeout_ms read timeout
+ * @param[out] read_len read data len
+ * @return @see IotReturnCode
+ */
+static int _network_read_ahead(IotNetwork *network, unsigned char *data, size_t datalen, uint32_t timeout_ms,
+                               size_t *read_len)
+{
+    POINTER_SANITY_CHECK(network, QCLOUD_ERR_INVAL);
+
+    int    rc = QCLOUD_RET_SUCCESS;
+    size_t len, recv_len;
+    Timer  timer;
+
+    if (!network->read_ahead_buf) {
+        network->read_ahead_buf = HAL_Malloc(network->read_ahead_size);
+        if (!network->read_ahead_buf) {
+            return QCLOUD_ERR_MALLOC;
+        }
+        network->read_ahead_pos = network->read_ahead_len = 0;
+    }
+
+    *read_len = 0;
+    HAL_Timer_CountdownMs(&timer, timeout_ms);
+
+    while (*read_len < datalen) {
+        // 1. copy buffered data
+        if (network->read_ahead_len) {
+            len = datalen - *read_len;
+            len = len < network->read_ahead_len ? len : network->read_ahead_len;
+            memcpy(data + *read_len, network->read_ahead_buf + network->read_ahead_pos, len);
+            network->read_ahead_pos += len;
+            network->read_ahead_len -= len;
+            *read_len += len;
+            continue;
+        }
+
+        if (*read_len && HAL_Timer_Expired(&timer)) {
+            break;
+        }
+
+        // 2. large read goes to user buffer directly, otherwise refill read ahead buffer
+        len = datalen - *read_len;
+        if (len >= network->read_ahead_size) {
+            rc = network->recv(network, data + *read_len, len, HAL_Timer_Remain(&timer), &recv_len);
+            *read_len += recv_len;
+        } else {
+            rc = network->recv(network, network->read_ahead_buf, network->read_ahead_size, HAL_Timer_Remain(&timer),
+                               &recv_len);
+            network->read_ahead_pos = 0;
+            network->read_ahead_len = recv_len;
+        }
+
+        if (rc) {
+            break;
+        }
+    }
+    return *read_len ? QCLOUD_RET_SUCCESS : rc;
+}
+
+/**
+ * @brief Free read ahead buffer and drop data buffered.
+ *
+ * @param[in,out] network pointer to network handle
+ */
+static void _network_read_ahead_deinit(IotNetwork *network)
+{
+    HAL_Free(network->read_ahead_buf);
+    network->read_ahead_buf = NULL;
+    network->read_ahead_pos = network->read_ahead_len = 0;
+}
+
+/**
+ * @brief Keep a standby tcp connection to server for fast reconnect, or close it. Both tcp and tls connect take the
+ * standby connection by HAL_TCP_Connect, tls handshake is done on it.
+ *
+ * @param[in,out] network pointer to network handle
+ * @param[in] enable 1 to start standby connection if there is none usable, 0 to close it
+ * @return @see IotReturnCode
+ */
+static int _network_prewarm(IotNetwork *network, int enable)
+{
+    POINTER_SANITY_CHECK(network, QCLOUD_ERR_INVAL);
+
+    if (!enable) {
+        HAL_TCP_PrewarmCancel(network->host, network->port);
+        return QCLOUD_RET_SUCCESS;
+    }
+    return HAL_TCP_Prewarm(network->host, network->port);
+}
+
 /**
  * @brief TCP init, do nothing.
  *
@@ -90,6 +187,24 @@ static int _network_tcp_read(IotNetwork *network, unsigned char *data, size_t da
     return HAL_TCP_Read(network->fd, data, (uint32_t)datalen, timeout_ms, read_len);
 }
 
+/**
+ * @brief TCP receive, return once any data is read.
+ *
+ * @param[in,out] network pointer to network handle
+ * @param[out] data data buffer to be read in
+ * @param[in] datalen data buffer len
+ * @param[in] timeout_ms read timeout
+ * @param[out] read_len read data len
+ * @return @see IotReturnCode
+ */
+static int _network_tcp_recv(IotNetwork *network, unsigned char *data, size_t datalen, uint32_t timeout_ms,
+                             size_t *read_len)
+{
+    POINTER_SANITY_CHECK(network, QCLOUD_ERR_INVAL);
+
+    return HAL_TCP_Recv(network->fd, data, (uint32_t)datalen, timeout_ms, read_len);
+}
+
 /**
  * @brief TCP write.
  *
@@ -108,6 +223,24 @@ static int _network_tcp_write(IotNetwork *network, unsigned char *data, size_t d
     return HAL_TCP_Write(network->fd, data, datalen, timeout_ms, written_len);
 }
 
+/**
+ * @brief TCP vectored write.
+ *
+ * @param[in,out] network pointer to network handle
+ * @param[in] iov data segments to write
+ * @param[in] iovcnt count of data segments
+ * @param[in] timeout_ms write timeout
+ * @param[out] written_len len of written data
+ * @return @see IotReturnCode
+ */
+static int _network_tcp_writev(IotNetwork *network, const IotIoVec *iov, int iovcnt, uint32_t timeout_ms,
+                               size_t *written_len)
+{
+    POINTER_SANITY_CHECK(network, QCLOUD_ERR_INVAL);
+
+    return HAL_TCP_Writev(network->fd, iov, iovcnt, timeout_ms, written_len);
+}
+
 /**
  * @brief TCP disconnect
  *
@@ -117,6 +250,8 @@ static void _network_tcp_disconnect(IotNetwork *network)
 {
     POINTER_SANITY_CHECK_RTN(network);
 
+    _network_read_ahead_deinit(network);
+
     if (network->fd < 0) {
         return;
     }
@@ -137,6 +272,28 @@ static int _is_network_tcp_connected(IotNetwork *network)
     return network->fd > 0;
 }
 
+/**
+ * @brief Return socket fd.
+ *
+ * @param[in] network pointer to network
+ * @return socket fd, -1 for not connected
+ */
+static int _network_tcp_get_fd(IotNetwork *network)
+{
+    return network->fd;
+}
+
+/**
+ * @brief Return length of data buffered by read ahead.
+ *
+ * @param[in] network pointer to network
+ * @return length of data received but not read
+ */
+static size_t _network_tcp_get_bytes_avail(IotNetwork *network)
+{
+    return network->read_ahead_len;
+}
+
 #ifndef AUTH_WITH_NO_TLS
 
 /**
@@ -180,6 +337,23 @@ static int _network_tls_read(IotNetwork *network, unsigned char *data, size_t da
     return qcloud_iot_tls_client_read(network->handle, data, datalen, timeout_ms, read_len);
 }
 
+/**
+ * @brief TLS receive, return once any data is read.
+ *
+ * @param[in,out] network pointer to network handle
+ * @param[out] data data buffer to be read in
+ * @param[in] datalen data buffer len
+ * @param[in] timeout_ms read timeout
+ * @param[out] read_len read data len
+ * @return @see IotReturnCode
+ */
+static int _network_tls_recv(IotNetwork *network, unsigned char *data, size_t datalen, uint32_t timeout_ms,
+                             size_t *read_len)
+{
+    POINTER_SANITY_CHECK(network, QCLOUD_ERR_INVAL);
+    return qcloud_iot_tls_client_recv(network->handle, data, datalen, timeout_ms, read_len);
+}
+
 /**
  * @brief TLS write.
  *
@@ -197,6 +371,23 @@ static int _network_tls_write(IotNetwork *network, unsigned char *data, size_t d
     return qcloud_iot_tls_client_write(network->handle, data, datalen, timeout_ms, written_len);
 }
 
+/**
+ * @brief TLS vectored write.
+ *
+ * @param[in,out] network pointer to network handle
+ * @param[in] iov data segments to write
+ * @param[in] iovcnt count of data segments
+ * @param[in] timeout_ms write timeout
+ * @param[out] written_len len of written data
+ * @return @see IotReturnCode
+ */
+static int _network_tls_writev(IotNetwork *network, const IotIoVec *iov, int iovcnt, uint32_t timeout_ms,
+                               size_t *written_len)
+{
+    POINTER_SANITY_CHECK(network, QCLOUD_ERR_INVAL);
+    return qcloud_iot_tls_client_writev(network->handle, iov, iovcnt, timeout_ms, written_len);
+}
+
 /**
  * @brief TLS disconnect
  *
@@ -206,6 +397,8 @@ static void _network_tls_disconnect(IotNetwork *network)
 {
     POINTER_SANITY_CHECK_RTN(network);
 
+    _network_read_ahead_deinit(network);
+
     qcloud_iot_tls_client_disconnect(network->handle);
     network->handle = 0;
 }
@@ -221,10 +414,32 @@ static int _is_network_tls_connected(IotNetwork *network)
     return network->handle;
 }
 
+/**
+ * @brief Return socket fd of tls connection.
+ *
+ * @param[in] network pointer to network
+ * @return socket fd, -1 for not connected
+ */
+static int _network_tls_get_fd(IotNetwork *network)
+{
+    return qcloud_iot_tls_client_get_fd(network->handle);
+}
+
+/**
+ * @brief Return length of data buffered by read ahead and tls.
+ *
+ * @param[in] network pointer to network
+ * @return length of data received but not read
+ */
+static size_t _network_tls_get_bytes_avail(IotNetwork *network)
+{
+    return network->read_ahead_len + qcloud_iot_tls_client_get_bytes_avail(network->handle);
+}
+
 #endif
 
 /**
- * @brief Init network, support tcp, tls(if AUTH_WITH_NO_TLS defined).
+ * @brief Init network, support tcp, tls(if AUTH_WITH_NO_TLS defined), read ahead if read_ahead_size set.
  *
  * @param[in,out] network pointer to network
  * @return @see IotReturnCode
@@ -235,24 +450,32 @@ int qcloud_iot_network_init(IotNetwork *network)
 
     switch (network->type) {
         case IOT_NETWORK_TYPE_TCP:
-            network->init         = _network_tcp_init;
-            network->connect      = _network_tcp_connect;
-            network->read         = _network_tcp_read;
-            network->write        = _network_tcp_write;
-            network->disconnect   = _network_tcp_disconnect;
-            network->is_connected = _is_network_tcp_connected;
-            network->fd           = -1;
+            network->init            = _network_tcp_init;
+            network->connect         = _network_tcp_connect;
+            network->read            = _network_tcp_read;
+            network->recv            = _network_tcp_recv;
+            network->write           = _network_tcp_write;
+            network->writev          = _network_tcp_writev;
+            network->disconnect      = _network_tcp_disconnect;
+            network->is_connected    = _is_network_tcp_connected;
+            network->get_fd          = _network_tcp_get_fd;
+            network->get_bytes_avail = _network_tcp_get_bytes_avail;
+            network->fd              = -1;
             break;
 
 #ifndef AUTH_WITH_NO_TLS
         case IOT_NETWORK_TYPE_TLS:
-            network->init         = _network_tls_init;
-            network->connect      = _network_tls_connect;
-            network->read         = _network_tls_read;
-            network->write        = _network_tls_write;
-            network->disconnect   = _network_tls_disconnect;
-            network->is_connected = _is_network_tls_connected;
-            network->handle       = 0;
+            network->init            = _network_tls_init;
+            network->connect         = _network_tls_connect;
+            network->read            = _network_tls_read;
+            network->recv            = _network_tls_recv;
+            network->write           = _network_tls_write;
+            network->writev          = _network_tls_writev;
+            network->disconnect      = _network_tls_disconnect;
+            network->is_connected    = _is_network_tls_connected;
+            network->get_fd          = _network_tls_get_fd;
+            network->get_bytes_avail = _network_tls_get_bytes_avail;
+            network->handle          = 0;
             break;
 #endif
 
@@ -260,6 +483,11 @@ int qcloud_iot_network_init(IotNetwork *network)
             Log_e("unknown network type: %d", network->type);
             return QCLOUD_ERR_INVAL;
     }
+
+    if (network->read_ahead_size) {
+        network->read = _network_read_ahead;
+    }
+    network->prewarm = _network_prewarm;
     return network->init(network);
 }
 
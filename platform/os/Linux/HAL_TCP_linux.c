@@ -33,32 +33,192 @@
 #include <netdb.h>
 #include <netinet/in.h>
 #include <netinet/tcp.h>
+#include <poll.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <sys/socket.h>
 #include <sys/time.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <unistd.h>
 #include <signal.h>
 
 #include "qcloud_iot_platform.h"
 
 /**
- * @brief TCP connect in linux
+ * @brief Max data segments of one vectored write.
  *
- * @param[in] host host to connect
- * @param[out] port port to connect
- * @return socket fd
  */
-int HAL_TCP_Connect(const char *host, const char *port)
+#define MAX_TCP_WRITEV_IOV_NUM 16
+
+/**
+ * @brief Max events reported by one poller wait.
+ *
+ */
+#define MAX_POLLER_EVENT_NUM 64
+
+/**
+ * @brief Max hosts cached.
+ *
+ */
+#define TCP_DNS_CACHE_HOST_NUM 4
+
+/**
+ * @brief Max length of host cached, longer host is resolved every time.
+ *
+ */
+#define TCP_DNS_CACHE_HOST_LEN 64
+
+/**
+ * @brief Max addresses cached for one host.
+ *
+ */
+#define TCP_DNS_CACHE_ADDR_NUM 8
+
+/**
+ * @brief Time to live of addresses cached, getaddrinfo does not report ttl of dns record (unit: ms)
+ *
+ */
+#define TCP_DNS_CACHE_TTL_MS (5 * 60 * 1000)
+
+/**
+ * @brief Delay before connecting next address while previous attempts are in progress, RFC 8305 (unit: ms)
+ *
+ */
+#define TCP_CONNECT_ATTEMPT_DELAY_MS (250)
+
+/**
+ * @brief Max age of standby connection, which may be dropped silently by nat or server (unit: ms)
+ *
+ */
+#define TCP_STANDBY_MAX_AGE_MS (60 * 1000)
+
+/**
+ * @brief Wait for socket event, poll is used instead of select for fd may be larger than FD_SETSIZE.
+ *
+ * @param[in] fd socket fd
+ * @param[in] events POLLIN or POLLOUT
+ * @param[in] timeout_ms timeout
+ * @return > 0 for ready, 0 for timeout, < 0 for error with errno set
+ */
+static int _tcp_poll(int fd, short events, uint32_t timeout_ms)
 {
-    // to avoid process crash when writing to a broken socket
-    signal(SIGPIPE, SIG_IGN);
+    struct pollfd pfd;
 
-    int rc;
-    int fd = 0;
+    pfd.fd      = fd;
+    pfd.events  = events;
+    pfd.revents = 0;
+    return poll(&pfd, 1, (int)timeout_ms);
+}
+
+/**
+ * @brief Addresses resolved for one host, ordered by preference.
+ *
+ */
+typedef struct {
+    struct sockaddr_storage addr[TCP_DNS_CACHE_ADDR_NUM];
+    socklen_t               addr_len[TCP_DNS_CACHE_ADDR_NUM];
+    int                     num;
+} TcpAddrList;
+
+/**
+ * @brief Cache of one host, with standby connection to it.
+ *
+ */
+typedef struct {
+    char                    host[TCP_DNS_CACHE_HOST_LEN];
+    char                    port[8];
+    TcpAddrList             list;
+    uint64_t                expire_ms;     // 0 for unused entry
+    int                     standby_fd;    // -1 for no standby connection
+    struct sockaddr_storage standby_addr;  // address standby connection is connecting to
+    uint64_t                standby_ms;    // time standby connection starts
+} TcpHostCache;
+
+static TcpHostCache    sg_tcp_host_cache[TCP_DNS_CACHE_HOST_NUM];
+static pthread_mutex_t sg_tcp_host_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * @brief Find cache of host. Should be called with sg_tcp_host_cache_lock locked.
+ *
+ * @param[in] host host to find
+ * @param[in] port port to find
+ * @return pointer to cache, NULL for not found
+ */
+static TcpHostCache *_tcp_host_cache_find(const char *host, const char *port)
+{
+    int i;
+
+    for (i = 0; i < TCP_DNS_CACHE_HOST_NUM; i++) {
+        if (sg_tcp_host_cache[i].expire_ms && !strcmp(sg_tcp_host_cache[i].host, host) &&
+            !strcmp(sg_tcp_host_cache[i].port, port)) {
+            return &sg_tcp_host_cache[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Close standby connection of host cache. Should be called with sg_tcp_host_cache_lock locked.
+ *
+ * @param[in,out] cache pointer to host cache
+ */
+static void _tcp_standby_close(TcpHostCache *cache)
+{
+    if (cache->standby_fd >= 0) {
+        close(cache->standby_fd);
+        cache->standby_fd = -1;
+    }
+}
+
+/**
+ * @brief Check if standby connection is usable, which is not closed by peer, failed or too old to be trusted.
+ *
+ * @param[in] cache pointer to host cache
+ * @return true for usable
+ */
+static bool _tcp_standby_usable(const TcpHostCache *cache)
+{
+    if (cache->standby_fd < 0 || HAL_Timer_CurrentMs() - cache->standby_ms > TCP_STANDBY_MAX_AGE_MS) {
+        return false;
+    }
+    // nothing is sent on standby connection, so readable means closed by peer, and error means connect failed
+    return !_tcp_poll(cache->standby_fd, POLLIN, 0);
+}
+
+/**
+ * @brief Append address to list, ignored if list is full.
+ *
+ * @param[in,out] list address list
+ * @param[in] ai address to append
+ */
+static void _tcp_addr_list_add(TcpAddrList *list, const struct addrinfo *ai)
+{
+    if (list->num >= TCP_DNS_CACHE_ADDR_NUM || ai->ai_addrlen > sizeof(struct sockaddr_storage)) {
+        return;
+    }
+    memcpy(&list->addr[list->num], ai->ai_addr, ai->ai_addrlen);
+    list->addr_len[list->num++] = ai->ai_addrlen;
+}
+
+/**
+ * @brief Resolve host, addresses of different family are interleaved starting with the family of the first address
+ * returned by getaddrinfo (RFC 8305), so a dead address family costs one attempt delay instead of a timeout.
+ *
+ * @param[in] host host to resolve
+ * @param[in] port port to connect
+ * @param[out] list addresses resolved
+ * @return @see IotReturnCode
+ */
+static int _tcp_resolve(const char *host, const char *port, TcpAddrList *list)
+{
+    int              rc, i, pref_num = 0, other_num = 0;
+    struct addrinfo  hints, *addr_list, *cur;
+    struct addrinfo *pref[TCP_DNS_CACHE_ADDR_NUM], *other[TCP_DNS_CACHE_ADDR_NUM];
 
-    struct addrinfo hints, *addr_list, *cur;
     memset(&hints, 0, sizeof(hints));
     hints.ai_family   = AF_UNSPEC;
     hints.ai_socktype = SOCK_STREAM;
@@ -72,54 +232,368 @@ int HAL_TCP_Connect(const char *host, const char *port)
     }
 
     for (cur = addr_list; cur; cur = cur->ai_next) {
-        fd = (int)socket(cur->ai_family, cur->ai_socktype, cur->ai_protocol);
-        if (fd < 0) {
-            rc = QCLOUD_ERR_TCP_SOCKET_FAILED;
-            continue;
+        if (cur->ai_family == addr_list->ai_family) {
+            if (pref_num < TCP_DNS_CACHE_ADDR_NUM) {
+                pref[pref_num++] = cur;
+            }
+        } else if (other_num < TCP_DNS_CACHE_ADDR_NUM) {
+            other[other_num++] = cur;
         }
+    }
+
+    list->num = 0;
+    for (i = 0; i < pref_num || i < other_num; i++) {
+        if (i < pref_num) {
+            _tcp_addr_list_add(list, pref[i]);
+        }
+        if (i < other_num) {
+            _tcp_addr_list_add(list, other[i]);
+        }
+    }
 
-        rc = fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
-        if (rc) {
-            Log_e("set socket non block faliled %d", rc);
-            close(fd);
-            rc = QCLOUD_ERR_TCP_SOCKET_FAILED;
+    freeaddrinfo(addr_list);
+    return list->num ? QCLOUD_RET_SUCCESS : QCLOUD_ERR_TCP_UNKNOWN_HOST;
+}
+
+/**
+ * @brief Get addresses of host from cache, resolve and cache them if not cached or expired.
+ *
+ * @param[in] host host to connect
+ * @param[in] port port to connect
+ * @param[out] list addresses of host
+ * @return @see IotReturnCode
+ */
+static int _tcp_addr_lookup(const char *host, const char *port, TcpAddrList *list)
+{
+    int           rc, i;
+    TcpHostCache *cache;
+
+    if (strlen(host) >= TCP_DNS_CACHE_HOST_LEN || strlen(port) >= sizeof(cache->port)) {
+        return _tcp_resolve(host, port, list);
+    }
+
+    pthread_mutex_lock(&sg_tcp_host_cache_lock);
+    cache = _tcp_host_cache_find(host, port);
+    if (cache && cache->expire_ms > HAL_Timer_CurrentMs()) {
+        *list = cache->list;
+        pthread_mutex_unlock(&sg_tcp_host_cache_lock);
+        return QCLOUD_RET_SUCCESS;
+    }
+    pthread_mutex_unlock(&sg_tcp_host_cache_lock);
+
+    // resolve without lock, for getaddrinfo may block for seconds
+    rc = _tcp_resolve(host, port, list);
+    if (rc) {
+        return rc;
+    }
+
+    pthread_mutex_lock(&sg_tcp_host_cache_lock);
+    cache = _tcp_host_cache_find(host, port);
+    if (!cache) {
+        // replace the entry which expires first, unused entry has expire_ms 0
+        cache = &sg_tcp_host_cache[0];
+        for (i = 1; i < TCP_DNS_CACHE_HOST_NUM; i++) {
+            cache = sg_tcp_host_cache[i].expire_ms < cache->expire_ms ? &sg_tcp_host_cache[i] : cache;
+        }
+        if (cache->expire_ms) {
+            _tcp_standby_close(cache);
+        }
+        strcpy(cache->host, host);
+        strcpy(cache->port, port);
+        cache->standby_fd = -1;
+    }
+    cache->list      = *list;
+    cache->expire_ms = HAL_Timer_CurrentMs() + TCP_DNS_CACHE_TTL_MS;
+    pthread_mutex_unlock(&sg_tcp_host_cache_lock);
+    return QCLOUD_RET_SUCCESS;
+}
+
+/**
+ * @brief Update cache after connect, address connected is moved to the front to be tried first next time, and cache
+ * is expired if all addresses fail.
+ *
+ * @param[in] host host connected
+ * @param[in] port port connected
+ * @param[in] addr address connected, NULL for fail
+ */
+static void _tcp_addr_update(const char *host, const char *port, const struct sockaddr_storage *addr)
+{
+    int                     i;
+    TcpHostCache           *cache;
+    struct sockaddr_storage tmp_addr;
+    socklen_t               tmp_len;
+
+    pthread_mutex_lock(&sg_tcp_host_cache_lock);
+    cache = _tcp_host_cache_find(host, port);
+    if (!cache) {
+        pthread_mutex_unlock(&sg_tcp_host_cache_lock);
+        return;
+    }
+
+    if (!addr) {
+        cache->expire_ms = 1;  // resolve again next time, but keep standby
+        pthread_mutex_unlock(&sg_tcp_host_cache_lock);
+        return;
+    }
+
+    for (i = 0; i < cache->list.num; i++) {
+        if (!memcmp(&cache->list.addr[i], addr, cache->list.addr_len[i])) {
+            break;
+        }
+    }
+
+    if (i > 0 && i < cache->list.num) {
+        tmp_addr = cache->list.addr[i];
+        tmp_len  = cache->list.addr_len[i];
+        memmove(&cache->list.addr[1], &cache->list.addr[0], i * sizeof(cache->list.addr[0]));
+        memmove(&cache->list.addr_len[1], &cache->list.addr_len[0], i * sizeof(cache->list.addr_len[0]));
+        cache->list.addr[0]     = tmp_addr;
+        cache->list.addr_len[0] = tmp_len;
+    }
+    pthread_mutex_unlock(&sg_tcp_host_cache_lock);
+}
+
+/**
+ * @brief Take standby connection of host if it is usable.
+ *
+ * @param[in] host host to connect
+ * @param[in] port port to connect
+ * @param[out] addr address standby connection is connecting to
+ * @return socket fd connected or connecting, -1 for no standby
+ */
+static int _tcp_standby_take(const char *host, const char *port, struct sockaddr_storage *addr)
+{
+    int           fd = -1;
+    TcpHostCache *cache;
+
+    pthread_mutex_lock(&sg_tcp_host_cache_lock);
+    cache = _tcp_host_cache_find(host, port);
+    if (cache && _tcp_standby_usable(cache)) {
+        fd                = cache->standby_fd;
+        *addr             = cache->standby_addr;
+        cache->standby_fd = -1;
+    } else if (cache) {
+        _tcp_standby_close(cache);
+    }
+    pthread_mutex_unlock(&sg_tcp_host_cache_lock);
+    return fd;
+}
+
+/**
+ * @brief Create non-blocking socket and start connect.
+ *
+ * @param[in] addr address to connect
+ * @param[in] addr_len length of address
+ * @return socket fd connected or connecting, others @see IotReturnCode
+ */
+static int _tcp_connect_start(const struct sockaddr_storage *addr, socklen_t addr_len)
+{
+    int fd = socket(addr->ss_family, SOCK_STREAM, IPPROTO_TCP);
+    if (fd < 0) {
+        return QCLOUD_ERR_TCP_SOCKET_FAILED;
+    }
+
+    if (fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK)) {
+        Log_e("set socket non block faliled: %s", strerror(errno));
+        close(fd);
+        return QCLOUD_ERR_TCP_SOCKET_FAILED;
+    }
+
+    if (connect(fd, (const struct sockaddr *)addr, addr_len) && EINPROGRESS != errno) {
+        close(fd);
+        return QCLOUD_ERR_TCP_CONNECT;
+    }
+    return fd;
+}
+
+/**
+ * @brief Connect addresses in parallel with staggered starts (happy eyeballs, RFC 8305), the first connected wins and
+ * the others are closed. Next attempt starts when TCP_CONNECT_ATTEMPT_DELAY_MS passes or all attempts fail.
+ *
+ * @param[in] list addresses to connect, ordered by preference
+ * @param[in] standby_fd standby connection joining the race as the first attempt, -1 for none
+ * @param[in] standby_addr address of standby connection, not connected again
+ * @param[in] timeout_ms timeout of the whole connect
+ * @param[out] winner index of address connected, -1 for standby connection not in list
+ * @return socket fd, others @see IotReturnCode
+ */
+static int _tcp_connect_race(const TcpAddrList *list, int standby_fd, const struct sockaddr_storage *standby_addr,
+                             uint32_t timeout_ms, int *winner)
+{
+    int           i, rc, so_error, next = 0, nfds = 0, standby_index = -1, fd = QCLOUD_ERR_TCP_CONNECT;
+    int           index[TCP_DNS_CACHE_ADDR_NUM + 1];
+    struct pollfd pfd[TCP_DNS_CACHE_ADDR_NUM + 1];
+    socklen_t     len;
+    uint32_t      wait_ms;
+    Timer         timer, attempt_timer;
+
+    HAL_Timer_CountdownMs(&timer, timeout_ms);
+    HAL_Timer_CountdownMs(&attempt_timer, 0);
+
+    if (standby_fd >= 0) {
+        for (i = 0; i < list->num && standby_index < 0; i++) {
+            standby_index = !memcmp(&list->addr[i], standby_addr, list->addr_len[i]) ? i : -1;
+        }
+        index[nfds]       = standby_index;
+        pfd[nfds].fd      = standby_fd;
+        pfd[nfds].events  = POLLOUT;
+        pfd[nfds].revents = 0;
+        nfds++;
+        HAL_Timer_CountdownMs(&attempt_timer, TCP_CONNECT_ATTEMPT_DELAY_MS);
+    }
+
+    while (!HAL_Timer_Expired(&timer)) {
+        // 1. start next attempt when nothing is in progress or attempt delay passes
+        if (next < list->num && (!nfds || HAL_Timer_Expired(&attempt_timer))) {
+            if (next == standby_index) {
+                next++;  // standby connection is connecting to it
+                continue;
+            }
+            rc = _tcp_connect_start(&list->addr[next], list->addr_len[next]);
+            if (rc >= 0) {
+                index[nfds]       = next;
+                pfd[nfds].fd      = rc;
+                pfd[nfds].events  = POLLOUT;
+                pfd[nfds].revents = 0;
+                nfds++;
+                HAL_Timer_CountdownMs(&attempt_timer, TCP_CONNECT_ATTEMPT_DELAY_MS);
+            }
+            fd = rc < 0 ? rc : fd;
+            next++;
             continue;
         }
 
-        rc = connect(fd, cur->ai_addr, cur->ai_addrlen);
-        if (!rc) {
-            rc = fd;
+        if (!nfds) {
+            break;  // all addresses fail
+        }
+
+        // 2. wait for any attempt to finish or attempt delay to pass
+        wait_ms = HAL_Timer_Remain(&timer);
+        if (next < list->num && HAL_Timer_Remain(&attempt_timer) < wait_ms) {
+            wait_ms = HAL_Timer_Remain(&attempt_timer);
+        }
+
+        rc = poll(pfd, nfds, (int)wait_ms);
+        if (rc < 0 && EINTR != errno) {
+            Log_e("poll-connect fail: %s", strerror(errno));
             break;
         }
 
-        if (errno == EINPROGRESS) {
-            // IO select to wait for connect result
-            struct timeval timeout;
-            timeout.tv_sec  = QCLOUD_IOT_MQTT_COMMAND_TIMEOUT / 1000;
-            timeout.tv_usec = 0;
-
-            fd_set sets;
-            FD_ZERO(&sets);
-            FD_SET(fd, &sets);
-
-            rc = select(fd + 1, NULL, &sets, NULL, &timeout);
-            if (rc > 0) {
-                int       so_error;
-                socklen_t len = sizeof(so_error);
-                getsockopt(fd, SOL_SOCKET, SO_ERROR, &so_error, &len);
-                if (FD_ISSET(fd, &sets) && so_error == 0) {
-                    rc = fd;
-                    break;
-                }
+        // 3. check attempts finished, the first connected wins
+        for (i = 0; rc > 0 && i < nfds;) {
+            if (!pfd[i].revents) {
+                i++;
+                continue;
+            }
+
+            so_error = 0;
+            len      = sizeof(so_error);
+            getsockopt(pfd[i].fd, SOL_SOCKET, SO_ERROR, &so_error, &len);
+            if (!so_error) {
+                fd      = pfd[i].fd;
+                *winner = index[i];
+                pfd[i]  = pfd[--nfds];
+                goto exit;
             }
+
+            // failed attempt, start next one at once
+            close(pfd[i].fd);
+            pfd[i]   = pfd[--nfds];
+            index[i] = index[nfds];
+            fd       = QCLOUD_ERR_TCP_CONNECT;
+            HAL_Timer_CountdownMs(&attempt_timer, 0);
         }
+    }
 
-        close(fd);
-        rc = QCLOUD_ERR_TCP_CONNECT;
+exit:
+    for (i = 0; i < nfds; i++) {
+        close(pfd[i].fd);
     }
+    return fd;
+}
 
-    freeaddrinfo(addr_list);
-    return rc;
+/**
+ * @brief TCP connect in linux. Addresses are cached for TCP_DNS_CACHE_TTL_MS, and connected in parallel with
+ * staggered starts, standby connection started by HAL_TCP_Prewarm is used first.
+ *
+ * @param[in] host host to connect
+ * @param[out] port port to connect
+ * @return socket fd
+ */
+int HAL_TCP_Connect(const char *host, const char *port)
+{
+    // to avoid process crash when writing to a broken socket
+    signal(SIGPIPE, SIG_IGN);
+
+    int                     rc, fd, winner = -1;
+    TcpAddrList             list;
+    struct sockaddr_storage standby_addr;
+
+    rc = _tcp_addr_lookup(host, port, &list);
+    if (rc) {
+        return rc;
+    }
+
+    fd = _tcp_standby_take(host, port, &standby_addr);
+    fd = _tcp_connect_race(&list, fd, &standby_addr, QCLOUD_IOT_MQTT_COMMAND_TIMEOUT, &winner);
+    _tcp_addr_update(host, port, fd < 0 ? NULL : winner < 0 ? &standby_addr : &list.addr[winner]);
+    return fd;
+}
+
+/**
+ * @brief Resolve host into cache and start a standby connection in background, which is taken by the next
+ * HAL_TCP_Connect to the same host. Standby connection closed by peer or older than TCP_STANDBY_MAX_AGE_MS is replaced.
+ *
+ * @param[in] host host to connect
+ * @param[in] port port to connect
+ * @return @see IotReturnCode
+ */
+int HAL_TCP_Prewarm(const char *host, const char *port)
+{
+    int           rc;
+    TcpAddrList   list;
+    TcpHostCache *cache;
+
+    rc = _tcp_addr_lookup(host, port, &list);
+    if (rc) {
+        return rc;
+    }
+
+    pthread_mutex_lock(&sg_tcp_host_cache_lock);
+    cache = _tcp_host_cache_find(host, port);
+    if (!cache || _tcp_standby_usable(cache)) {
+        pthread_mutex_unlock(&sg_tcp_host_cache_lock);
+        return cache ? QCLOUD_RET_SUCCESS : QCLOUD_ERR_FAILURE;
+    }
+
+    // connect the preferred address, which is the last connected one
+    _tcp_standby_close(cache);
+    rc = _tcp_connect_start(&cache->list.addr[0], cache->list.addr_len[0]);
+    if (rc >= 0) {
+        cache->standby_fd   = rc;
+        cache->standby_addr = cache->list.addr[0];
+        cache->standby_ms   = HAL_Timer_CurrentMs();
+    }
+    pthread_mutex_unlock(&sg_tcp_host_cache_lock);
+    return rc < 0 ? rc : QCLOUD_RET_SUCCESS;
+}
+
+/**
+ * @brief Close standby connection to host started by HAL_TCP_Prewarm.
+ *
+ * @param[in] host host to connect
+ * @param[in] port port to connect
+ */
+void HAL_TCP_PrewarmCancel(const char *host, const char *port)
+{
+    TcpHostCache *cache;
+
+    pthread_mutex_lock(&sg_tcp_host_cache_lock);
+    cache = _tcp_host_cache_find(host, port);
+    if (cache) {
+        _tcp_standby_close(cache);
+    }
+    pthread_mutex_unlock(&sg_tcp_host_cache_lock);
 }
 
 /**
@@ -160,34 +634,26 @@ int HAL_TCP_Disconnect(int fd)
  */
 int HAL_TCP_Write(int fd, const uint8_t *buf, uint32_t len, uint32_t timeout_ms, size_t *written_len)
 {
-    int            rc = 0;
-    uint32_t       len_sent;
-    Timer          timer_send;
-    fd_set         sets;
-    struct timeval timeout;
+    int      rc = 0;
+    uint32_t len_sent;
+    Timer    timer_send;
 
     HAL_Timer_CountdownMs(&timer_send, timeout_ms);
     len_sent = 0;
 
     /* send one time if timeout_ms is value 0 */
     while ((len_sent < len) && !HAL_Timer_Expired(&timer_send)) {
-        timeout.tv_sec  = HAL_Timer_Remain(&timer_send) / 1000;
-        timeout.tv_usec = HAL_Timer_Remain(&timer_send) % 1000 * 1000;
-
-        FD_ZERO(&sets);
-        FD_SET(fd, &sets);
-
-        rc = select(fd + 1, NULL, &sets, NULL, &timeout);
+        rc = _tcp_poll(fd, POLLOUT, HAL_Timer_Remain(&timer_send));
         if (!rc) {
             rc = QCLOUD_ERR_TCP_WRITE_TIMEOUT;
-            Log_e("select-write timeout %d", (int)fd);
+            Log_e("poll-write timeout %d", (int)fd);
             break;
         }
 
         if (rc < 0) {
             if (EINTR != errno) {
                 rc = QCLOUD_ERR_TCP_WRITE_FAIL;
-                Log_e("select-write fail: %s", strerror(errno));
+                Log_e("poll-write fail: %s", strerror(errno));
                 break;
             }
             Log_e("EINTR be caught");
@@ -213,6 +679,87 @@ int HAL_TCP_Write(int fd, const uint8_t *buf, uint32_t len, uint32_t timeout_ms,
     return len_sent == len ? QCLOUD_RET_SUCCESS : rc;
 }
 
+/**
+ * @brief TCP vectored write, segments are sent in order without being copied together.
+ *
+ * @param[in] fd socket fd
+ * @param[in] iov data segments to write
+ * @param[in] iovcnt count of data segments, no more than MAX_TCP_WRITEV_IOV_NUM
+ * @param[in] timeout_ms timeout
+ * @param[out] written_len data written length
+ * @return @see IotReturnCode
+ */
+int HAL_TCP_Writev(int fd, const IotIoVec *iov, int iovcnt, uint32_t timeout_ms, size_t *written_len)
+{
+    int           rc = 0, i, vec_cnt;
+    size_t        len = 0, len_sent = 0, skip;
+    Timer         timer_send;
+    struct iovec  vec[MAX_TCP_WRITEV_IOV_NUM];
+    struct msghdr msg;
+
+    *written_len = 0;
+    if (iovcnt > MAX_TCP_WRITEV_IOV_NUM) {
+        return QCLOUD_ERR_INVAL;
+    }
+
+    for (i = 0; i < iovcnt; i++) {
+        len += iov[i].len;
+    }
+
+    HAL_Timer_CountdownMs(&timer_send, timeout_ms);
+
+    while ((len_sent < len) && !HAL_Timer_Expired(&timer_send)) {
+        rc = _tcp_poll(fd, POLLOUT, HAL_Timer_Remain(&timer_send));
+        if (!rc) {
+            rc = QCLOUD_ERR_TCP_WRITE_TIMEOUT;
+            Log_e("poll-write timeout %d", (int)fd);
+            break;
+        }
+
+        if (rc < 0) {
+            if (EINTR != errno) {
+                rc = QCLOUD_ERR_TCP_WRITE_FAIL;
+                Log_e("poll-write fail: %s", strerror(errno));
+                break;
+            }
+            Log_e("EINTR be caught");
+            continue;
+        }
+
+        // skip data already sent
+        for (i = 0, vec_cnt = 0, skip = len_sent; i < iovcnt; i++) {
+            if (skip >= iov[i].len) {
+                skip -= iov[i].len;
+                continue;
+            }
+            vec[vec_cnt].iov_base = (uint8_t *)iov[i].base + skip;
+            vec[vec_cnt].iov_len  = iov[i].len - skip;
+            vec_cnt++;
+            skip = 0;
+        }
+
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov    = vec;
+        msg.msg_iovlen = vec_cnt;
+
+        rc = sendmsg(fd, &msg, 0);
+        if (rc < 0) {
+            if (EINTR == errno) {
+                Log_e("EINTR be caught");
+                continue;
+            }
+            rc = (EPIPE == errno || ECONNRESET == errno) ? QCLOUD_ERR_TCP_PEER_SHUTDOWN : QCLOUD_ERR_TCP_WRITE_FAIL;
+            Log_e("sendmsg fail: %s", strerror(errno));
+            break;
+        }
+
+        len_sent += rc;
+    }
+
+    *written_len = len_sent;
+    return len_sent == len ? QCLOUD_RET_SUCCESS : rc;
+}
+
 /**
  * @brief TCP read.
  *
@@ -225,23 +772,15 @@ int HAL_TCP_Write(int fd, const uint8_t *buf, uint32_t len, uint32_t timeout_ms,
  */
 int HAL_TCP_Read(int fd, uint8_t *buf, uint32_t len, uint32_t timeout_ms, size_t *read_len)
 {
-    int            rc;
-    uint32_t       len_recv;
-    Timer          timer_recv;
-    fd_set         sets;
-    struct timeval timeout;
+    int      rc;
+    uint32_t len_recv;
+    Timer    timer_recv;
 
     HAL_Timer_CountdownMs(&timer_recv, timeout_ms);
     len_recv = 0;
 
     do {
-        FD_ZERO(&sets);
-        FD_SET(fd, &sets);
-
-        timeout.tv_sec  = HAL_Timer_Remain(&timer_recv) / 1000;
-        timeout.tv_usec = HAL_Timer_Remain(&timer_recv) % 1000 * 1000;
-
-        rc = select(fd + 1, &sets, NULL, NULL, &timeout);
+        rc = _tcp_poll(fd, POLLIN, HAL_Timer_Remain(&timer_recv));
         if (!rc) {
             rc = QCLOUD_ERR_TCP_READ_TIMEOUT;
             break;
@@ -250,7 +789,7 @@ int HAL_TCP_Read(int fd, uint8_t *buf, uint32_t len, uint32_t timeout_ms, size_t
         if (rc < 0) {
             if (EINTR != errno) {
                 rc = QCLOUD_ERR_TCP_READ_FAIL;
-                Log_e("select-recv fail: %s", strerror(errno));
+                Log_e("poll-recv fail: %s", strerror(errno));
                 break;
             }
             Log_e("EINTR be caught");
@@ -284,3 +823,206 @@ int HAL_TCP_Read(int fd, uint8_t *buf, uint32_t len, uint32_t timeout_ms, size_t
     // We always don't know hom much should read.
     return (len_recv > 0) ? QCLOUD_RET_SUCCESS : rc;
 }
+
+/**
+ * @brief TCP receive, return as soon as any data is read instead of waiting for len bytes.
+ *
+ * @param[in] fd socket fd
+ * @param[out] buf buffer to save read data
+ * @param[in] len buffer len
+ * @param[in] timeout_ms timeout
+ * @param[out] read_len length of data read
+ * @return @see IotReturnCode
+ */
+int HAL_TCP_Recv(int fd, uint8_t *buf, uint32_t len, uint32_t timeout_ms, size_t *read_len)
+{
+    int   rc;
+    Timer timer_recv;
+
+    *read_len = 0;
+    HAL_Timer_CountdownMs(&timer_recv, timeout_ms);
+
+    do {
+        rc = _tcp_poll(fd, POLLIN, HAL_Timer_Remain(&timer_recv));
+        if (!rc) {
+            return QCLOUD_ERR_TCP_NOTHING_TO_READ;
+        }
+
+        if (rc < 0) {
+            if (EINTR != errno) {
+                Log_e("poll-recv fail: %s", strerror(errno));
+                return QCLOUD_ERR_TCP_READ_FAIL;
+            }
+            Log_e("EINTR be caught");
+            continue;
+        }
+
+        rc = recv(fd, buf, len, 0);
+        if (rc > 0) {
+            *read_len = (size_t)rc;
+            return QCLOUD_RET_SUCCESS;
+        }
+
+        if (!rc) {
+            Log_e("connection is closed by server");
+            return QCLOUD_ERR_TCP_PEER_SHUTDOWN;
+        }
+
+        if (EINTR == errno) {
+            Log_e("EINTR be caught");
+            continue;
+        }
+        Log_e("recv error: %s", strerror(errno));
+        return (EPIPE == errno || ECONNRESET == errno) ? QCLOUD_ERR_TCP_PEER_SHUTDOWN : QCLOUD_ERR_TCP_READ_FAIL;
+    } while (!HAL_Timer_Expired(&timer_recv));
+
+    return QCLOUD_ERR_TCP_NOTHING_TO_READ;
+}
+
+/**
+ * @brief Poller to wait for readable event of many sockets.
+ *
+ */
+typedef struct {
+    int epoll_fd;
+    int wake_fd;  // eventfd to wake up wait, not reported as readable
+} EpollPoller;
+
+/**
+ * @brief Create poller to wait for readable event of many sockets, epoll in linux.
+ *
+ * @return pointer to poller, NULL for fail
+ */
+void *HAL_Poller_Create(void)
+{
+    EpollPoller *poller = HAL_Malloc(sizeof(EpollPoller));
+    if (!poller) {
+        return NULL;
+    }
+
+    poller->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (poller->epoll_fd < 0) {
+        Log_e("epoll create fail: %s", strerror(errno));
+        HAL_Free(poller);
+        return NULL;
+    }
+
+    poller->wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (poller->wake_fd < 0 || HAL_Poller_Add(poller, poller->wake_fd, &poller->wake_fd)) {
+        Log_e("eventfd create fail: %s", strerror(errno));
+        HAL_Poller_Destroy(poller);
+        return NULL;
+    }
+    return poller;
+}
+
+/**
+ * @brief Destroy poller, sockets added are not closed.
+ *
+ * @param[in,out] poller pointer to poller
+ */
+void HAL_Poller_Destroy(void *poller)
+{
+    EpollPoller *epoll_poller = (EpollPoller *)poller;
+    if (!epoll_poller) {
+        return;
+    }
+
+    if (epoll_poller->wake_fd >= 0) {
+        close(epoll_poller->wake_fd);
+    }
+    close(epoll_poller->epoll_fd);
+    HAL_Free(epoll_poller);
+}
+
+/**
+ * @brief Add socket to poller, level triggered readable event is reported with usr_data.
+ *
+ * @param[in,out] poller pointer to poller
+ * @param[in] fd socket fd
+ * @param[in] usr_data user data reported when socket is readable
+ * @return @see IotReturnCode
+ */
+int HAL_Poller_Add(void *poller, int fd, void *usr_data)
+{
+    EpollPoller *      epoll_poller = (EpollPoller *)poller;
+    struct epoll_event event;
+
+    event.events   = EPOLLIN;
+    event.data.ptr = usr_data;
+    if (epoll_ctl(epoll_poller->epoll_fd, EPOLL_CTL_ADD, fd, &event)) {
+        Log_e("epoll add fd %d fail: %s", fd, strerror(errno));
+        return QCLOUD_ERR_FAILURE;
+    }
+    return QCLOUD_RET_SUCCESS;
+}
+
+/**
+ * @brief Remove socket from poller, socket closed is removed automatically.
+ *
+ * @param[in,out] poller pointer to poller
+ * @param[in] fd socket fd
+ * @return @see IotReturnCode
+ */
+int HAL_Poller_Del(void *poller, int fd)
+{
+    EpollPoller *      epoll_poller = (EpollPoller *)poller;
+    struct epoll_event event;  // for kernel before 2.6.9
+
+    return epoll_ctl(epoll_poller->epoll_fd, EPOLL_CTL_DEL, fd, &event) ? QCLOUD_ERR_FAILURE : QCLOUD_RET_SUCCESS;
+}
+
+/**
+ * @brief Wait for sockets readable.
+ *
+ * @param[in,out] poller pointer to poller
+ * @param[out] ready user data of readable sockets
+ * @param[in] max_ready max count of ready, no more than MAX_POLLER_EVENT_NUM is reported once
+ * @param[in] timeout_ms timeout
+ * @return count of readable sockets, 0 for timeout, others @see IotReturnCode
+ */
+int HAL_Poller_Wait(void *poller, void **ready, int max_ready, uint32_t timeout_ms)
+{
+    int                i, rc, count = 0;
+    uint64_t           wake_count;
+    EpollPoller *      epoll_poller = (EpollPoller *)poller;
+    struct epoll_event events[MAX_POLLER_EVENT_NUM];
+
+    max_ready = max_ready < MAX_POLLER_EVENT_NUM ? max_ready : MAX_POLLER_EVENT_NUM;
+
+    rc = epoll_wait(epoll_poller->epoll_fd, events, max_ready, (int)timeout_ms);
+    if (rc < 0) {
+        if (EINTR == errno) {
+            return 0;
+        }
+        Log_e("epoll wait fail: %s", strerror(errno));
+        return QCLOUD_ERR_FAILURE;
+    }
+
+    for (i = 0; i < rc; i++) {
+        if (events[i].data.ptr == &epoll_poller->wake_fd) {
+            // reset eventfd, wakeups before this wait are merged
+            if (read(epoll_poller->wake_fd, &wake_count, sizeof(wake_count)) < 0 && EAGAIN != errno) {
+                Log_e("eventfd read fail: %s", strerror(errno));
+            }
+            continue;
+        }
+        ready[count++] = events[i].data.ptr;
+    }
+    return count;
+}
+
+/**
+ * @brief Wake up poller waiting in other thread, wait returns with no socket readable.
+ *
+ * @param[in,out] poller pointer to poller
+ */
+void HAL_Poller_Wakeup(void *poller)
+{
+    EpollPoller *epoll_poller = (EpollPoller *)poller;
+    uint64_t     wake_count   = 1;
+
+    if (write(epoll_poller->wake_fd, &wake_count, sizeof(wake_count)) < 0 && EAGAIN != errno) {
+        Log_e("eventfd write fail: %s", strerror(errno));
+    }
+}
@@ -123,7 +123,8 @@ static int _http_client_send(IotHTTPClient *client, char *buf, uint32_t len)
 }
 
 /**
- * @brief Recv data from http server.
+ * @brief Recv data from http server, return as soon as any data is read, so response on connection kept alive is not
+ * delayed by waiting for buffer full.
  *
  * @param[in,out] client pointer to http client. @see IotHTTPClient
  * @param[out] buf
@@ -135,7 +136,7 @@ static int _http_client_recv(IotHTTPClient *client, uint8_t *buf, uint32_t len,
 {
     size_t read_len;
 
-    int rc = client->network.read(&client->network, buf, len, timeout_ms, &read_len);
+    int rc = client->network.recv(&client->network, buf, len, timeout_ms, &read_len);
     switch (rc) {
         case QCLOUD_ERR_TCP_NOTHING_TO_READ:
             return QCLOUD_RET_SUCCESS;
@@ -181,16 +182,16 @@ static int _http_client_parse_url(const char *url, HTTPData *host, HTTPData *pat
 }
 
 /**
- * @brief Send http request line.
+ * @brief Format request line, header and content header of http request.
  *
- * @param[in,out] client pointer to http client. @see IotHTTPClient
  * @param[in] params params needed to send request to http server, @see IotHTTPRequestParams
- * @return int
+ * @param[out] head request head malloc, should be freed by caller
+ * @return >0 for length of request head, others @see IotReturnCode
  */
-static int _http_client_send_request_line(IotHTTPClient *client, const IotHTTPRequestParams *params)
+static int _http_client_format_request_head(const IotHTTPRequestParams *params, char **head)
 {
     int      len, rc, buf_len;
-    char *   buf;
+    char    *buf;
     HTTPData host, path;
 
     /**
@@ -206,67 +207,34 @@ static int _http_client_send_request_line(IotHTTPClient *client, const IotHTTPRe
     }
 
     buf_len = path.data_len + host.data_len + 128;
-    buf     = HAL_Malloc(buf_len);
+    buf_len += params->header ? strlen(params->header) : 0;
+    buf_len += params->content_type ? strlen(params->content_type) : 0;
+    buf = HAL_Malloc(buf_len);
     if (!buf) {
-        Log_e("http malloc request line failed %d", rc);
+        Log_e("http malloc request head failed");
         return QCLOUD_ERR_MALLOC;
     }
 
-    len = HAL_Snprintf(buf, buf_len, "%s %.*s HTTP/1.1\r\nHost:%.*s\r\n", method_str[params->method], path.data_len,
-                       path.data, host.data_len, host.data);
-    rc  = _http_client_send(client, buf, len);
-    HAL_Free(buf);
-    return rc;
-}
+    // 1. request line and header
+    len = HAL_Snprintf(buf, buf_len, "%s %.*s HTTP/1.1\r\nHost:%.*s\r\n%s", method_str[params->method], path.data_len,
+                       path.data, host.data_len, host.data, params->header ? params->header : "");
 
-/**
- * @brief Send http request content(optional).
- *
- * @param[in,out] client pointer to http client. @see IotHTTPClient
- * @param[in] params params needed to send request to http server, @see IotHTTPRequestParams
- * @return int
- */
-static int _http_client_send_request_content(IotHTTPClient *client, const IotHTTPRequestParams *params)
-{
-    int   rc = 0, len, buf_len;
-    char *buf;
-
-    buf_len = params->content_type ? 32 + strlen(params->content_type) : 32;
-    buf     = HAL_Malloc(buf_len);
-    if (!buf) {
-        Log_e("http malloc request line failed %d", rc);
-        return QCLOUD_ERR_MALLOC;
-    }
-
-    len = HAL_Snprintf(buf, buf_len, "Content-Length:%d\r\n", params->content_length);
-    rc  = _http_client_send(client, buf, len);
-    if (rc) {
-        goto exit;
-    }
-
-    if (params->content_type) {
-        len = HAL_Snprintf(buf, buf_len, "Content-Type:%s\r\n", params->content_type);
-        rc  = _http_client_send(client, buf, len);
-        if (rc) {
-            goto exit;
+    // 2. content header(optional)
+    if (params->content && params->content_length) {
+        len += HAL_Snprintf(buf + len, buf_len - len, "Content-Length:%d\r\n", params->content_length);
+        if (params->content_type) {
+            len += HAL_Snprintf(buf + len, buf_len - len, "Content-Type:%s\r\n", params->content_type);
         }
     }
 
-    rc = _http_client_send(client, "\r\n", 2);
-    if (rc) {
-        goto exit;
-    }
-
-    HAL_Free(buf);
-    return _http_client_send(client, (char *)params->content, params->content_length);
-exit:
-    HAL_Free(buf);
-    Log_e("send request content failed %d", rc);
-    return rc;
+    len += HAL_Snprintf(buf + len, buf_len - len, "\r\n");
+    *head = buf;
+    return len;
 }
 
 /**
- * @brief Send http request to http server.
+ * @brief Send http request to http server, request head and content are sent in one vectored write, so small
+ * segments are not delayed by nagle algorithm waiting for ack.
  *
  * @param[in,out] client pointer to http client. @see IotHTTPClient
  * @param[in] params @see IotHTTPRequestParams
@@ -274,29 +242,27 @@ exit:
  */
 static int _http_client_send_request(IotHTTPClient *client, const IotHTTPRequestParams *params)
 {
-    int rc;
+    int    rc, len;
+    char  *head;
+    size_t written_len;
 
-    // 1. send request line
-    rc = _http_client_send_request_line(client, params);
-    if (rc) {
-        Log_e("http send request line failed, rc=%d", rc);
-        return rc;
+    len = _http_client_format_request_head(params, &head);
+    if (len < 0) {
+        Log_e("http format request head failed, rc=%d", len);
+        return len;
     }
 
-    // 2. send request header
-    if (params->header) {
-        rc = _http_client_send(client, (char *)params->header, strlen(params->header));
-        if (rc) {
-            Log_e("write failed %d", rc);
-            return rc;
-        }
-    }
-    if (!params->content || !params->content_length) {  // no payload body
-        return _http_client_send(client, "\r\n", 2);
-    }
+    IotIoVec iov[2] = {
+        {head, len},
+        {params->content, params->content ? params->content_length : 0},
+    };
 
-    // 3. send payload body
-    return _http_client_send_request_content(client, params);
+    rc = client->network.writev(&client->network, iov, 2, HTTP_WRITE_TIMEOUT_MS, &written_len);
+    HAL_Free(head);
+    if (rc) {
+        Log_e("http send request failed, rc=%d", rc);
+    }
+    return rc;
 }
 
 /**************************************************************************************
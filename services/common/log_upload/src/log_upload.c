@@ -0,0 +1,936 @@
+/**
+ * @copyright
+ *
+ * Tencent is pleased to support the open source community by making IoT Hub available.
+ * Copyright(C) 2018 - 2021 THL A29 Limited, a Tencent company.All rights reserved.
+ *
+ * Licensed under the MIT License(the "License"); you may not use this file except in
+ * compliance with the License. You may obtain a copy of the License at
+ * http://opensource.org/licenses/MIT
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed under the License is
+ * distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @file log_upload.c
+ * @brief upload log to cloud by http
+ * @author fancyxu (fancyxu@tencent.com)
+ * @version 1.0
+ * @date 2026-10-16
+ *
+ * @par Change Log:
+ * <table>
+ * <tr><th>Date       <th>Version <th>Author    <th>Description
+ * <tr><td>2026-10-16 <td>1.0     <td>fancyxu   <td>first commit
+ * </table>
+ */
+
+#include "qcloud_iot_log_upload.h"
+
+#include "utils_hmac.h"
+
+/**
+ * @brief Post body is header followed by logs, header is signature + ctrl bytes + product id + device name + timestamp,
+ * padded with '#'. Signature is hmac-sha1 of body after signature.
+ *
+ */
+#define LOG_UPLOAD_SIGNATURE_SIZE    40
+#define LOG_UPLOAD_CTRL_BYTES_SIZE   4
+#define LOG_UPLOAD_TIMESTAMP_SIZE    10
+#define LOG_UPLOAD_PRODUCT_ID_POS    (LOG_UPLOAD_SIGNATURE_SIZE + LOG_UPLOAD_CTRL_BYTES_SIZE)
+#define LOG_UPLOAD_DEVICE_NAME_POS   (LOG_UPLOAD_PRODUCT_ID_POS + MAX_SIZE_OF_PRODUCT_ID)
+#define LOG_UPLOAD_TIMESTAMP_POS     (LOG_UPLOAD_DEVICE_NAME_POS + MAX_SIZE_OF_DEVICE_NAME)
+#define LOG_UPLOAD_HEADER_SIZE       (LOG_UPLOAD_TIMESTAMP_POS + LOG_UPLOAD_TIMESTAMP_SIZE)
+#define LOG_UPLOAD_BATCH_SIZE        (MAX_HTTP_LOG_POST_SIZE)
+#define LOG_UPLOAD_RECV_BUF_LEN      512
+#define LOG_UPLOAD_RECV_TIMEOUT_MS   5000
+#define LOG_UPLOAD_THREAD_STACK_SIZE 8192
+
+/**
+ * @brief Record in memory ring is 4 bytes header followed by log, aligned to 4 bytes. Header is 0 until committed, pad
+ * record fills the end of ring when record can not fit in.
+ *
+ */
+#define LOG_UPLOAD_RECORD_READY      0x80000000
+#define LOG_UPLOAD_RECORD_PAD        0x40000000
+#define LOG_UPLOAD_RECORD_LEN_MASK   0x3fffffff
+#define LOG_UPLOAD_RECORD_ALIGN(len) (((len) + 3) & ~3)
+
+/**
+ * @brief Deflate with fixed huffman codes and greedy LZ77 matching, in zlib format (RFC1950/RFC1951).
+ *
+ */
+#define LOG_DEFLATE_HASH_BITS   11
+#define LOG_DEFLATE_WINDOW_SIZE 32768
+#define LOG_DEFLATE_MIN_MATCH   3
+#define LOG_DEFLATE_MAX_MATCH   258
+#define LOG_DEFLATE_BOUND(len)  (2 + ((len)*9 + 7 + 10) / 8 + 4)
+
+/**
+ * @brief Memory ring written by many threads without lock, read by upload.
+ *
+ */
+typedef struct {
+    char    *buf;
+    uint32_t size;     /**< power of 2 */
+    uint32_t head;     /**< records before head are read */
+    uint32_t tail;     /**< space before tail is claimed by writers, records may be not committed yet */
+    uint32_t drop_num; /**< logs dropped for ring full */
+} LogUploadRing;
+
+/**
+ * @brief Bit stream of deflate.
+ *
+ */
+typedef struct {
+    uint8_t *out;
+    uint32_t out_len;
+    uint32_t bit_buf;
+    int      bit_num;
+} LogDeflateStream;
+
+/**
+ * @brief Log uploader.
+ *
+ */
+typedef struct {
+    LogUploadInitParams params;
+    LogUploadRing       ring;
+    char               *body;         /**< post header + logs */
+    uint32_t            batch_len;    /**< length of logs in body, kept for retry if no file to save */
+    uint8_t            *deflate_buf;  /**< compressed body */
+    uint16_t           *deflate_hash; /**< position + 1 of last string with the same hash */
+    void               *http_client;
+    int                 connected;
+    int                 request_num; /**< requests on this connection */
+    int                 online;      /**< last upload succeeded */
+    size_t              file_offset; /**< file before offset is uploaded */
+    Timer               upload_timer;
+    void               *lock;
+    LogUploadStats      stats;
+    uint8_t             recv_buf[LOG_UPLOAD_RECV_BUF_LEN];
+    int                 wake_pending; /**< upload thread is woken up and not uploaded yet */
+#ifdef MULTITHREAD_ENABLED
+    ThreadParams        thread_params;
+    void               *wake_sem;
+    void               *exit_sem;
+    int                 running;
+#endif
+} LogUploader;
+
+static LogUploader *sg_log_uploader;
+static int          sg_log_upload_writer_num;
+
+static const uint16_t sg_deflate_len_base[]   = {3,  4,  5,  6,  7,  8,  9,  10, 11,  13,  15,  17,  19,  23, 27,
+                                                 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+static const uint8_t  sg_deflate_len_extra[]  = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2,
+                                                 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+static const uint16_t sg_deflate_dist_base[]  = {1,    2,    3,    4,    5,    7,    9,    13,    17,    25,
+                                                 33,   49,   65,   97,   129,  193,  257,  385,   513,   769,
+                                                 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+static const uint8_t  sg_deflate_dist_extra[] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6,
+                                                 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+/**************************************************************************************
+ * memory ring
+ **************************************************************************************/
+
+/**
+ * @brief Copy log into ring, never blocks.
+ *
+ * @param[in,out] ring pointer to memory ring
+ * @param[in] data log to copy
+ * @param[in] len log length
+ * @return bytes used in ring after copy, QCLOUD_ERR_BUF_TOO_SHORT for ring full
+ */
+static int _log_upload_ring_push(LogUploadRing *ring, const char *data, uint32_t len)
+{
+    uint32_t tail, head, offset, pad, need;
+
+    need = LOG_UPLOAD_RECORD_ALIGN(sizeof(uint32_t) + len);
+    tail = __atomic_load_n(&ring->tail, __ATOMIC_RELAXED);
+    do {
+        head   = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+        offset = tail & (ring->size - 1);
+        pad    = offset + need > ring->size ? ring->size - offset : 0;
+        if (tail + pad + need - head > ring->size) {
+            __atomic_add_fetch(&ring->drop_num, 1, __ATOMIC_RELAXED);
+            return QCLOUD_ERR_BUF_TOO_SHORT;
+        }
+    } while (!__atomic_compare_exchange_n(&ring->tail, &tail, tail + pad + need, 1, __ATOMIC_ACQ_REL,
+                                          __ATOMIC_RELAXED));
+
+    if (pad) {
+        __atomic_store_n((uint32_t *)(ring->buf + offset), LOG_UPLOAD_RECORD_READY | LOG_UPLOAD_RECORD_PAD | pad,
+                         __ATOMIC_RELEASE);
+        offset = 0;
+    }
+
+    memcpy(ring->buf + offset + sizeof(uint32_t), data, len);
+    __atomic_store_n((uint32_t *)(ring->buf + offset), LOG_UPLOAD_RECORD_READY | len, __ATOMIC_RELEASE);
+    return tail + pad + need - head;
+}
+
+/**
+ * @brief Move committed logs into buffer in order, stop at the first record not committed. Space read is zeroed for
+ * record header written later.
+ *
+ * @param[in,out] ring pointer to memory ring
+ * @param[out] buf buffer to save logs
+ * @param[in] buf_len buffer length
+ * @return length of logs moved
+ */
+static uint32_t _log_upload_ring_pop(LogUploadRing *ring, char *buf, uint32_t buf_len)
+{
+    uint32_t head, tail, offset, header, len, record_len, total = 0;
+
+    head = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+    tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+    while (head != tail) {
+        offset = head & (ring->size - 1);
+        header = __atomic_load_n((uint32_t *)(ring->buf + offset), __ATOMIC_ACQUIRE);
+        if (!(header & LOG_UPLOAD_RECORD_READY)) {
+            break;
+        }
+
+        len        = header & LOG_UPLOAD_RECORD_LEN_MASK;
+        record_len = len;
+        if (!(header & LOG_UPLOAD_RECORD_PAD)) {
+            if (total + len > buf_len) {
+                break;
+            }
+            memcpy(buf + total, ring->buf + offset + sizeof(uint32_t), len);
+            total += len;
+            record_len = LOG_UPLOAD_RECORD_ALIGN(sizeof(uint32_t) + len);
+        }
+
+        memset(ring->buf + offset, 0, record_len);
+        head += record_len;
+        __atomic_store_n(&ring->head, head, __ATOMIC_RELEASE);
+    }
+    return total;
+}
+
+/**
+ * @brief Bytes used in ring.
+ *
+ * @param[in] ring pointer to memory ring
+ * @return bytes used
+ */
+static uint32_t _log_upload_ring_used(LogUploadRing *ring)
+{
+    return __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) - __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+}
+
+/**************************************************************************************
+ * deflate
+ **************************************************************************************/
+
+/**
+ * @brief Put bits into stream, lsb first.
+ *
+ * @param[in,out] s pointer to stream
+ * @param[in] bits bits to put
+ * @param[in] num number of bits
+ */
+static void _deflate_put_bits(LogDeflateStream *s, uint32_t bits, int num)
+{
+    s->bit_buf |= bits << s->bit_num;
+    s->bit_num += num;
+    while (s->bit_num >= 8) {
+        s->out[s->out_len++] = s->bit_buf & 0xff;
+        s->bit_buf >>= 8;
+        s->bit_num -= 8;
+    }
+}
+
+/**
+ * @brief Put huffman code into stream, msb first.
+ *
+ * @param[in,out] s pointer to stream
+ * @param[in] code huffman code
+ * @param[in] len code length
+ */
+static void _deflate_put_code(LogDeflateStream *s, uint32_t code, int len)
+{
+    uint32_t reverse = 0;
+    int      i;
+
+    for (i = 0; i < len; i++) {
+        reverse = (reverse << 1) | ((code >> i) & 1);
+    }
+    _deflate_put_bits(s, reverse, len);
+}
+
+/**
+ * @brief Put literal/length symbol with fixed huffman code.
+ *
+ * @param[in,out] s pointer to stream
+ * @param[in] symbol 0~255 for literal, 256 for end of block, 257~285 for length
+ */
+static void _deflate_put_symbol(LogDeflateStream *s, int symbol)
+{
+    if (symbol < 144) {
+        _deflate_put_code(s, 0x30 + symbol, 8);
+    } else if (symbol < 256) {
+        _deflate_put_code(s, 0x190 + symbol - 144, 9);
+    } else if (symbol < 280) {
+        _deflate_put_code(s, symbol - 256, 7);
+    } else {
+        _deflate_put_code(s, 0xc0 + symbol - 280, 8);
+    }
+}
+
+/**
+ * @brief Put length/distance pair.
+ *
+ * @param[in,out] s pointer to stream
+ * @param[in] len match length, 3~258
+ * @param[in] dist match distance, 1~32768
+ */
+static void _deflate_put_match(LogDeflateStream *s, uint32_t len, uint32_t dist)
+{
+    int i;
+
+    for (i = 28; sg_deflate_len_base[i] > len; i--) {
+    }
+    _deflate_put_symbol(s, 257 + i);
+    _deflate_put_bits(s, len - sg_deflate_len_base[i], sg_deflate_len_extra[i]);
+
+    for (i = 29; sg_deflate_dist_base[i] > dist; i--) {
+    }
+    _deflate_put_code(s, i, 5);
+    _deflate_put_bits(s, dist - sg_deflate_dist_base[i], sg_deflate_dist_extra[i]);
+}
+
+/**
+ * @brief Hash of 3 bytes.
+ *
+ * @param[in] data data to hash
+ * @return hash value
+ */
+static uint32_t _deflate_hash(const uint8_t *data)
+{
+    return (((uint32_t)data[0] << 16 | (uint32_t)data[1] << 8 | data[2]) * 2654435761u) >> (32 - LOG_DEFLATE_HASH_BITS);
+}
+
+/**
+ * @brief Compress data in zlib format, one block with fixed huffman codes, input should be less than 65535.
+ *
+ * @param[in,out] hash_table hash table of (1 << LOG_DEFLATE_HASH_BITS) entries
+ * @param[in] in data to compress
+ * @param[in] in_len data length
+ * @param[out] out buffer of LOG_DEFLATE_BOUND(in_len)
+ * @return length of compressed data
+ */
+static uint32_t _log_deflate(uint16_t *hash_table, const uint8_t *in, uint32_t in_len, uint8_t *out)
+{
+    LogDeflateStream s = {out, 0, 0, 0};
+    uint32_t         i = 0, j, h, match_len, match_pos, a = 1, b = 0;
+
+    memset(hash_table, 0, sizeof(uint16_t) << LOG_DEFLATE_HASH_BITS);
+
+    // zlib header: deflate with 32K window, no dictionary, fastest level
+    s.out[s.out_len++] = 0x78;
+    s.out[s.out_len++] = 0x01;
+
+    // final block, fixed huffman codes
+    _deflate_put_bits(&s, 1, 1);
+    _deflate_put_bits(&s, 1, 2);
+
+    while (i < in_len) {
+        match_len = 0;
+        match_pos = 0;
+        if (i + LOG_DEFLATE_MIN_MATCH <= in_len) {
+            h             = _deflate_hash(in + i);
+            match_pos     = hash_table[h];
+            hash_table[h] = i + 1;
+            if (match_pos && i + 1 - match_pos <= LOG_DEFLATE_WINDOW_SIZE) {
+                match_pos--;
+                while (match_len < LOG_DEFLATE_MAX_MATCH && i + match_len < in_len &&
+                       in[match_pos + match_len] == in[i + match_len]) {
+                    match_len++;
+                }
+            }
+        }
+
+        if (match_len < LOG_DEFLATE_MIN_MATCH) {
+            _deflate_put_symbol(&s, in[i++]);
+            continue;
+        }
+
+        _deflate_put_match(&s, match_len, i - match_pos);
+        for (j = i + 1; j < i + match_len && j + LOG_DEFLATE_MIN_MATCH <= in_len; j++) {
+            hash_table[_deflate_hash(in + j)] = j + 1;
+        }
+        i += match_len;
+    }
+
+    // end of block, pad to byte
+    _deflate_put_symbol(&s, 256);
+    _deflate_put_bits(&s, 0, (8 - s.bit_num) & 7);
+
+    // adler32 checksum
+    for (i = 0; i < in_len; i++) {
+        a = (a + in[i]) % 65521;
+        b = (b + a) % 65521;
+    }
+    s.out[s.out_len++] = b >> 8;
+    s.out[s.out_len++] = b;
+    s.out[s.out_len++] = a >> 8;
+    s.out[s.out_len++] = a;
+    return s.out_len;
+}
+
+/**************************************************************************************
+ * http
+ **************************************************************************************/
+
+/**
+ * @brief Connect log server if not connected.
+ *
+ * @param[in,out] uploader pointer to log uploader
+ * @return @see IotReturnCode
+ */
+static int _log_upload_connect(LogUploader *uploader)
+{
+    int rc;
+
+    IotHTTPConnectParams connect_params = {
+        .url    = uploader->params.url,
+        .port   = uploader->params.port,
+        .ca_crt = NULL,
+    };
+
+    if (uploader->connected) {
+        return QCLOUD_RET_SUCCESS;
+    }
+
+    rc = IOT_HTTP_Connect(uploader->http_client, &connect_params);
+    if (rc) {
+        UPLOAD_ERR("connect log server failed: %d", rc);
+        return rc;
+    }
+
+    uploader->connected   = 1;
+    uploader->request_num = 0;
+    uploader->stats.connect_num++;
+    return QCLOUD_RET_SUCCESS;
+}
+
+/**
+ * @brief Disconnect log server.
+ *
+ * @param[in,out] uploader pointer to log uploader
+ */
+static void _log_upload_disconnect(LogUploader *uploader)
+{
+    if (uploader->connected) {
+        IOT_HTTP_Disconnect(uploader->http_client);
+        uploader->connected = 0;
+    }
+}
+
+/**
+ * @brief Post body and read the whole response, so connection can be kept alive for next post.
+ *
+ * @param[in,out] uploader pointer to log uploader
+ * @param[in] content body to post
+ * @param[in] content_len body length
+ * @return @see IotReturnCode
+ */
+static int _log_upload_request(LogUploader *uploader, char *content, int content_len)
+{
+    int   rc;
+    Timer timer;
+
+    IotHTTPRequestParams request = {
+        .url            = uploader->params.url,
+        .method         = IOT_HTTP_METHOD_POST,
+        .header         = uploader->params.compress_enable
+                              ? "Accept:*/*\r\nConnection:keep-alive\r\nContent-Encoding:deflate\r\n"
+                              : "Accept:*/*\r\nConnection:keep-alive\r\n",
+        .content_length = content_len,
+        .content_type   = "text/plain;charset=utf-8",
+        .content        = content,
+    };
+
+    rc = IOT_HTTP_Request(uploader->http_client, &request);
+    if (rc) {
+        return rc;
+    }
+    uploader->request_num++;
+
+    HAL_Timer_CountdownMs(&timer, LOG_UPLOAD_RECV_TIMEOUT_MS);
+    do {
+        rc = IOT_HTTP_Recv(uploader->http_client, uploader->recv_buf, LOG_UPLOAD_RECV_BUF_LEN,
+                           HAL_Timer_Remain(&timer));
+        if (rc < 0) {
+            return rc;
+        }
+        if (IOT_HTTP_IsRecvFinished(uploader->http_client)) {
+            return QCLOUD_RET_SUCCESS;
+        }
+    } while (!HAL_Timer_Expired(&timer));
+    return QCLOUD_ERR_HTTP_TIMEOUT;
+}
+
+/**
+ * @brief Sign and post logs in body, logs rejected by server are dropped.
+ *
+ * @param[in,out] uploader pointer to log uploader
+ * @param[in] len length of logs in body
+ * @return QCLOUD_RET_SUCCESS for logs uploaded or dropped, others for network error
+ */
+static int _log_upload_post(LogUploader *uploader, uint32_t len)
+{
+    int   rc, content_len = LOG_UPLOAD_HEADER_SIZE + len;
+    char *content = uploader->body;
+    char  timestamp[LOG_UPLOAD_TIMESTAMP_SIZE + 1];
+
+    HAL_Snprintf(timestamp, sizeof(timestamp), "%u", HAL_Timer_CurrentSec());
+    memcpy(uploader->body + LOG_UPLOAD_TIMESTAMP_POS, timestamp, strlen(timestamp));
+
+    if (uploader->params.sign_key) {
+        utils_hmac_sha1(uploader->body + LOG_UPLOAD_SIGNATURE_SIZE, content_len - LOG_UPLOAD_SIGNATURE_SIZE,
+                        (const uint8_t *)uploader->params.sign_key, strlen(uploader->params.sign_key),
+                        uploader->body);
+    }
+
+    if (uploader->params.compress_enable) {
+        content_len = _log_deflate(uploader->deflate_hash, (uint8_t *)uploader->body, content_len,
+                                   uploader->deflate_buf);
+        content     = (char *)uploader->deflate_buf;
+    }
+
+    rc = _log_upload_request(uploader, content, content_len);
+    // server may close connection kept alive, retry once with new connection
+    if (rc && rc != QCLOUD_ERR_HTTP && rc != QCLOUD_ERR_HTTP_AUTH && rc != QCLOUD_ERR_HTTP_NOT_FOUND &&
+        uploader->request_num > 1) {
+        _log_upload_disconnect(uploader);
+        rc = _log_upload_connect(uploader);
+        rc = rc ? rc : _log_upload_request(uploader, content, content_len);
+    }
+
+    uploader->stats.post_num++;
+    uploader->stats.post_bytes += content_len;
+
+    switch (rc) {
+        case QCLOUD_RET_SUCCESS:
+            uploader->stats.upload_bytes += len;
+            return QCLOUD_RET_SUCCESS;
+        case QCLOUD_ERR_HTTP:
+        case QCLOUD_ERR_HTTP_AUTH:
+        case QCLOUD_ERR_HTTP_NOT_FOUND:
+            // response body is not read, connection can not be reused
+            UPLOAD_ERR("logs rejected by server: %d", rc);
+            _log_upload_disconnect(uploader);
+            uploader->stats.drop_bytes += len;
+            return QCLOUD_RET_SUCCESS;
+        default:
+            UPLOAD_ERR("post logs failed: %d", rc);
+            return rc;
+    }
+}
+
+/**************************************************************************************
+ * upload
+ **************************************************************************************/
+
+/**
+ * @brief Save logs in body into file, dropped if file is full.
+ *
+ * @param[in,out] uploader pointer to log uploader
+ * @param[in] len length of logs in body
+ */
+static void _log_upload_file_save(LogUploader *uploader, uint32_t len)
+{
+    LogUploadFileFunc *func = &uploader->params.file_func;
+
+    size_t saved = 0;
+
+    if (func->log_file_get_size() + len <= MAX_LOG_SAVE_SIZE) {
+        saved = func->log_file_save(uploader->body + LOG_UPLOAD_HEADER_SIZE, len);
+    }
+
+    uploader->stats.save_bytes += saved;
+    uploader->stats.drop_bytes += len - saved;
+}
+
+/**
+ * @brief Upload logs saved in file, file is deleted after all uploaded. Logs are read in lines if possible.
+ *
+ * @param[in,out] uploader pointer to log uploader
+ * @return @see IotReturnCode
+ */
+static int _log_upload_file(LogUploader *uploader)
+{
+    LogUploadFileFunc *func = &uploader->params.file_func;
+
+    char  *logs = uploader->body + LOG_UPLOAD_HEADER_SIZE;
+    size_t size, len, line_len;
+    int    rc;
+
+    size = func->log_file_get_size();
+    while (uploader->file_offset < size) {
+        len = size - uploader->file_offset;
+        len = func->log_file_read(logs, len > LOG_UPLOAD_BATCH_SIZE ? LOG_UPLOAD_BATCH_SIZE : len,
+                                  uploader->file_offset);
+        if (!len) {
+            UPLOAD_ERR("read log file failed, offset %u", (unsigned int)uploader->file_offset);
+            break;
+        }
+
+        // cut at the last line end if file is not read to the end
+        line_len = len;
+        while (uploader->file_offset + len < size && line_len && logs[line_len - 1] != '\n') {
+            line_len--;
+        }
+        len = line_len ? line_len : len;
+
+        rc = _log_upload_post(uploader, len);
+        if (rc) {
+            return rc;
+        }
+        uploader->file_offset += len;
+    }
+
+    if (size) {
+        func->log_file_del();
+    }
+    uploader->file_offset = 0;
+    return QCLOUD_RET_SUCCESS;
+}
+
+/**
+ * @brief Save logs in body and ring into file when upload fails, logs are kept in memory if no file.
+ *
+ * @param[in,out] uploader pointer to log uploader
+ */
+static void _log_upload_save(LogUploader *uploader)
+{
+    if (!uploader->params.file_func.log_file_save) {
+        return;
+    }
+
+    do {
+        if (uploader->batch_len) {
+            _log_upload_file_save(uploader, uploader->batch_len);
+        }
+        uploader->batch_len =
+            _log_upload_ring_pop(&uploader->ring, uploader->body + LOG_UPLOAD_HEADER_SIZE, LOG_UPLOAD_BATCH_SIZE);
+    } while (uploader->batch_len);
+}
+
+/**
+ * @brief Upload logs in file first, then logs in body and ring, save them into file if fails.
+ *
+ * @param[in,out] uploader pointer to log uploader
+ * @return @see IotReturnCode
+ */
+static int _log_upload_run(LogUploader *uploader)
+{
+    int rc;
+
+    __atomic_store_n(&uploader->wake_pending, 0, __ATOMIC_RELEASE);
+    HAL_Timer_CountdownMs(&uploader->upload_timer, uploader->params.interval_ms);
+
+    rc = _log_upload_connect(uploader);
+    if (rc) {
+        goto offline;
+    }
+
+    if (uploader->params.file_func.log_file_get_size) {
+        rc = _log_upload_file(uploader);
+        if (rc) {
+            goto offline;
+        }
+    }
+
+    do {
+        if (!uploader->batch_len) {
+            uploader->batch_len =
+                _log_upload_ring_pop(&uploader->ring, uploader->body + LOG_UPLOAD_HEADER_SIZE, LOG_UPLOAD_BATCH_SIZE);
+        }
+        if (!uploader->batch_len) {
+            break;
+        }
+
+        rc = _log_upload_post(uploader, uploader->batch_len);
+        if (rc) {
+            goto offline;
+        }
+        uploader->batch_len = 0;
+    } while (1);
+
+    uploader->online = 1;
+    return QCLOUD_RET_SUCCESS;
+offline:
+    _log_upload_disconnect(uploader);
+    _log_upload_save(uploader);
+    uploader->online = 0;
+    return rc;
+}
+
+/**
+ * @brief Init post header, signature and timestamp are updated when posting.
+ *
+ * @param[in,out] uploader pointer to log uploader
+ */
+static void _log_upload_header_init(LogUploader *uploader)
+{
+    char *header = uploader->body;
+
+    memset(header, '#', LOG_UPLOAD_HEADER_SIZE);
+    header[LOG_UPLOAD_SIGNATURE_SIZE] = 'P';
+    memcpy(header + LOG_UPLOAD_PRODUCT_ID_POS, uploader->params.product_id,
+           strnlen(uploader->params.product_id, MAX_SIZE_OF_PRODUCT_ID));
+    memcpy(header + LOG_UPLOAD_DEVICE_NAME_POS, uploader->params.device_name,
+           strnlen(uploader->params.device_name, MAX_SIZE_OF_DEVICE_NAME));
+}
+
+/**
+ * @brief Free log uploader.
+ *
+ * @param[in,out] uploader pointer to log uploader
+ */
+static void _log_upload_free(LogUploader *uploader)
+{
+#ifdef MULTITHREAD_ENABLED
+    if (uploader->wake_sem) {
+        HAL_SemaphoreDestroy(uploader->wake_sem);
+    }
+    if (uploader->exit_sem) {
+        HAL_SemaphoreDestroy(uploader->exit_sem);
+    }
+#endif
+    if (uploader->lock) {
+        HAL_MutexDestroy(uploader->lock);
+    }
+    IOT_HTTP_Deinit(uploader->http_client);
+    HAL_Free(uploader->ring.buf);
+    HAL_Free(uploader->body);
+    HAL_Free(uploader->deflate_buf);
+    HAL_Free(uploader->deflate_hash);
+    HAL_Free(uploader);
+}
+
+#ifdef MULTITHREAD_ENABLED
+/**
+ * @brief Upload thread, woken up every interval or when ring is half full.
+ *
+ * @param[in,out] arg pointer to log uploader
+ */
+static void _log_upload_thread_run(void *arg)
+{
+    LogUploader *uploader = (LogUploader *)arg;
+
+    while (__atomic_load_n(&uploader->running, __ATOMIC_ACQUIRE)) {
+        HAL_SemaphoreWait(uploader->wake_sem, uploader->params.interval_ms);
+        IOT_Log_Upload(0);
+    }
+    HAL_SemaphorePost(uploader->exit_sem);
+}
+#endif
+
+/**************************************************************************************
+ * API
+ **************************************************************************************/
+
+/**
+ * @brief Init log upload, an upload thread is created with MULTITHREAD_ENABLED, otherwise IOT_Log_Upload should be
+ * called periodically. Logs saved in file last time are uploaded first.
+ *
+ * @param[in] params @see LogUploadInitParams
+ * @return @see IotReturnCode
+ */
+int IOT_Log_Upload_Init(const LogUploadInitParams *params)
+{
+    POINTER_SANITY_CHECK(params, QCLOUD_ERR_INVAL);
+    POINTER_SANITY_CHECK(params->url, QCLOUD_ERR_INVAL);
+    POINTER_SANITY_CHECK(params->product_id, QCLOUD_ERR_INVAL);
+    POINTER_SANITY_CHECK(params->device_name, QCLOUD_ERR_INVAL);
+
+    LogUploader *uploader;
+    uint32_t     size = 1;
+
+    if (sg_log_uploader) {
+        return QCLOUD_ERR_FAILURE;
+    }
+
+    // file functions should be all set or all NULL
+    if (!params->file_func.log_file_save != !params->file_func.log_file_read ||
+        !params->file_func.log_file_save != !params->file_func.log_file_del ||
+        !params->file_func.log_file_save != !params->file_func.log_file_get_size) {
+        return QCLOUD_ERR_INVAL;
+    }
+
+    uploader = HAL_Malloc(sizeof(LogUploader));
+    if (!uploader) {
+        return QCLOUD_ERR_MALLOC;
+    }
+    memset(uploader, 0, sizeof(LogUploader));
+    uploader->params = *params;
+
+    // ring should hold at least a batch
+    while (size < params->buffer_size || size < LOG_UPLOAD_BATCH_SIZE) {
+        size <<= 1;
+    }
+
+    uploader->ring.size   = size;
+    uploader->ring.buf    = HAL_Malloc(size);
+    uploader->body        = HAL_Malloc(LOG_UPLOAD_HEADER_SIZE + LOG_UPLOAD_BATCH_SIZE);
+    uploader->http_client = IOT_HTTP_Init();
+    uploader->lock        = HAL_MutexCreate();
+    if (!uploader->ring.buf || !uploader->body || !uploader->http_client || !uploader->lock) {
+        goto error;
+    }
+    memset(uploader->ring.buf, 0, size);
+    uploader->stats.memory_size = sizeof(LogUploader) + size + LOG_UPLOAD_HEADER_SIZE + LOG_UPLOAD_BATCH_SIZE;
+
+    if (params->compress_enable) {
+        uploader->deflate_buf  = HAL_Malloc(LOG_DEFLATE_BOUND(LOG_UPLOAD_HEADER_SIZE + LOG_UPLOAD_BATCH_SIZE));
+        uploader->deflate_hash = HAL_Malloc(sizeof(uint16_t) << LOG_DEFLATE_HASH_BITS);
+        if (!uploader->deflate_buf || !uploader->deflate_hash) {
+            goto error;
+        }
+        uploader->stats.memory_size += LOG_DEFLATE_BOUND(LOG_UPLOAD_HEADER_SIZE + LOG_UPLOAD_BATCH_SIZE) +
+                                       (sizeof(uint16_t) << LOG_DEFLATE_HASH_BITS);
+    }
+
+    _log_upload_header_init(uploader);
+    HAL_Timer_CountdownMs(&uploader->upload_timer, params->interval_ms);
+
+#ifdef MULTITHREAD_ENABLED
+    uploader->wake_sem = HAL_SemaphoreCreate();
+    uploader->exit_sem = HAL_SemaphoreCreate();
+    if (!uploader->wake_sem || !uploader->exit_sem) {
+        goto error;
+    }
+
+    uploader->running                   = 1;
+    uploader->thread_params.thread_name = "log_upload";
+    uploader->thread_params.thread_func = _log_upload_thread_run;
+    uploader->thread_params.user_arg    = uploader;
+    uploader->thread_params.stack_size  = LOG_UPLOAD_THREAD_STACK_SIZE;
+    if (HAL_ThreadCreate(&uploader->thread_params)) {
+        UPLOAD_ERR("create log upload thread failed");
+        goto error;
+    }
+#endif
+
+    __atomic_store_n(&sg_log_uploader, uploader, __ATOMIC_SEQ_CST);
+    return QCLOUD_RET_SUCCESS;
+error:
+    _log_upload_free(uploader);
+    return QCLOUD_ERR_FAILURE;
+}
+
+/**
+ * @brief Log handler to be set as LogHandleFunc.log_handle, copy log into memory ring and never blocks. Logs are
+ * dropped when ring is full.
+ *
+ * @param[in] message log to upload
+ */
+void IOT_Log_Upload_Handle(const char *message)
+{
+    LogUploader *uploader;
+    int          used;
+
+    // deinit waits for writers, so uploader is not freed while copying
+    __atomic_add_fetch(&sg_log_upload_writer_num, 1, __ATOMIC_SEQ_CST);
+    uploader = __atomic_load_n(&sg_log_uploader, __ATOMIC_SEQ_CST);
+    if (uploader && message) {
+        used = _log_upload_ring_push(&uploader->ring, message, strnlen(message, MAX_LOG_MSG_LEN));
+        if (used > (int)(uploader->ring.size / 2) &&
+            !__atomic_exchange_n(&uploader->wake_pending, 1, __ATOMIC_ACQ_REL)) {
+#ifdef MULTITHREAD_ENABLED
+            HAL_SemaphorePost(uploader->wake_sem);
+#endif
+        }
+    }
+    __atomic_sub_fetch(&sg_log_upload_writer_num, 1, __ATOMIC_SEQ_CST);
+}
+
+/**
+ * @brief Upload logs in file and memory ring if interval passed or ring is half full, logs are saved into file if
+ * upload fails.
+ *
+ * @param[in] force_upload upload at once
+ * @return @see IotReturnCode
+ */
+int IOT_Log_Upload(int force_upload)
+{
+    LogUploader *uploader = __atomic_load_n(&sg_log_uploader, __ATOMIC_ACQUIRE);
+    int          rc       = QCLOUD_RET_SUCCESS;
+
+    if (!uploader) {
+        return QCLOUD_ERR_FAILURE;
+    }
+
+    HAL_MutexLock(uploader->lock);
+    // retry after interval if offline, even if ring is half full
+    if (force_upload || HAL_Timer_Expired(&uploader->upload_timer) ||
+        (uploader->online && __atomic_load_n(&uploader->wake_pending, __ATOMIC_ACQUIRE))) {
+        rc = _log_upload_run(uploader);
+    }
+    HAL_MutexUnlock(uploader->lock);
+    return rc;
+}
+
+/**
+ * @brief Get statistics of log upload.
+ *
+ * @param[out] stats @see LogUploadStats
+ */
+void IOT_Log_Upload_GetStats(LogUploadStats *stats)
+{
+    POINTER_SANITY_CHECK_RTN(stats);
+
+    LogUploader *uploader = __atomic_load_n(&sg_log_uploader, __ATOMIC_ACQUIRE);
+
+    memset(stats, 0, sizeof(LogUploadStats));
+    if (!uploader) {
+        return;
+    }
+
+    HAL_MutexLock(uploader->lock);
+    *stats          = uploader->stats;
+    stats->drop_num = __atomic_load_n(&uploader->ring.drop_num, __ATOMIC_RELAXED);
+    HAL_MutexUnlock(uploader->lock);
+}
+
+/**
+ * @brief Stop upload thread, upload logs left or save them into file, then deinit log upload.
+ *
+ */
+void IOT_Log_Upload_Deinit(void)
+{
+    LogUploader *uploader = __atomic_load_n(&sg_log_uploader, __ATOMIC_ACQUIRE);
+
+    if (!uploader) {
+        return;
+    }
+
+#ifdef MULTITHREAD_ENABLED
+    __atomic_store_n(&uploader->running, 0, __ATOMIC_RELEASE);
+    HAL_SemaphorePost(uploader->wake_sem);
+    // upload thread may be posting, wait until it really exits
+    while (HAL_SemaphoreWait(uploader->exit_sem, uploader->params.interval_ms)) {
+        HAL_SemaphorePost(uploader->wake_sem);
+    }
+#endif
+
+    // no more logs after writers copying finish
+    __atomic_store_n(&sg_log_uploader, NULL, __ATOMIC_SEQ_CST);
+    while (__atomic_load_n(&sg_log_upload_writer_num, __ATOMIC_SEQ_CST)) {
+        HAL_SleepMs(1);
+    }
+
+    if (_log_upload_ring_used(&uploader->ring) || uploader->batch_len) {
+        _log_upload_run(uploader);
+    }
+    _log_upload_disconnect(uploader);
+    _log_upload_free(uploader);
+}
@@ -0,0 +1,553 @@
+/**
+ * @copyright
+ *
+ * Tencent is pleased to support the open source community by making IoT Hub available.
+ * Copyright(C) 2018 - 2021 THL A29 Limited, a Tencent company.All rights reserved.
+ *
+ * Licensed under the MIT License(the "License"); you may not use this file except in
+ * compliance with the License. You may obtain a copy of the License at
+ * http://opensource.org/licenses/MIT
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed under the License is
+ * distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @file test_log_upload.cc
+ * @brief unittest for log upload
+ * @author fancyxu (fancyxu@tencent.com)
+ * @version 1.0
+ * @date 2026-10-16
+ *
+ * @par Change Log:
+ * <table>
+ * <tr><th>Date       <th>Version <th>Author    <th>Description
+ * <tr><td>2026-10-16 <td>1.0     <td>fancyxu   <td>first commit
+ * </table>
+ */
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "qcloud_iot_common.h"
+#include "utils_hmac.h"
+#include "utils_log.h"
+
+namespace log_upload_unittest {
+
+static const char *kProductId  = "ABCDEFGHIJ";
+static const char *kDeviceName = "log_upload_test";
+static const char *kSignKey    = "log_upload_sign_key";
+
+/**
+ * @brief signature + ctrl bytes + product id + device name + timestamp
+ *
+ */
+static const size_t kHeaderSize = 40 + 4 + MAX_SIZE_OF_PRODUCT_ID + MAX_SIZE_OF_DEVICE_NAME + 10;
+
+/**
+ * @brief Inflate zlib data of one block with fixed huffman codes, which is what log upload posts.
+ *
+ * @param[in] in compressed data
+ * @param[out] out inflated data
+ * @return true for success
+ */
+static bool Inflate(const std::string &in, std::string *out) {
+  static const int kLenBase[] = {3,  4,  5,  6,  7,  8,  9,  10, 11,  13,  15,  17,  19,  23, 27,
+                                 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+  static const int kLenExtra[] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2,
+                                  2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+  static const int kDistBase[] = {1,    2,    3,    4,    5,    7,    9,    13,    17,    25,
+                                  33,   49,   65,   97,   129,  193,  257,  385,   513,   769,
+                                  1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+  static const int kDistExtra[] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6,
+                                   6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+  size_t pos = 2 * 8;  // zlib header
+  auto bit = [&]() -> uint32_t {
+    uint32_t b = pos / 8 < in.size() ? (static_cast<uint8_t>(in[pos / 8]) >> (pos % 8)) & 1 : 0;
+    pos++;
+    return b;
+  };
+  auto bits = [&](int num) {  // lsb first
+    uint32_t value = 0;
+    for (int i = 0; i < num; i++) value |= bit() << i;
+    return value;
+  };
+  auto code = [&](int num) {  // huffman code, msb first
+    uint32_t value = 0;
+    for (int i = 0; i < num; i++) value = (value << 1) | bit();
+    return value;
+  };
+
+  if (in.size() < 6 || static_cast<uint8_t>(in[0]) != 0x78 || bits(1) != 1 || bits(2) != 1) {
+    return false;
+  }
+
+  out->clear();
+  while (pos / 8 < in.size()) {
+    uint32_t symbol = code(7);
+    if (symbol > 0x17) {
+      symbol = (symbol << 1) | bit();
+      if (symbol >= 0x30 && symbol <= 0xbf) {
+        symbol -= 0x30;
+      } else if (symbol >= 0xc0 && symbol <= 0xc7) {
+        symbol = symbol - 0xc0 + 280;
+      } else {
+        symbol = ((symbol << 1) | bit()) - 0x190 + 144;
+      }
+    } else {
+      symbol += 256;
+    }
+
+    if (symbol < 256) {
+      out->push_back(static_cast<char>(symbol));
+      continue;
+    }
+    if (symbol == 256) {
+      break;
+    }
+
+    int len = kLenBase[symbol - 257] + bits(kLenExtra[symbol - 257]);
+    int dist_code = code(5);
+    size_t dist = kDistBase[dist_code] + bits(kDistExtra[dist_code]);
+    if (dist > out->size()) {
+      return false;
+    }
+    for (int i = 0; i < len; i++) out->push_back((*out)[out->size() - dist]);
+  }
+
+  // adler32
+  uint32_t a = 1, b = 0;
+  for (unsigned char c : *out) {
+    a = (a + c) % 65521;
+    b = (b + a) % 65521;
+  }
+  const uint8_t *adler = reinterpret_cast<const uint8_t *>(in.data() + in.size() - 4);
+  return ((b << 16) | a) == (static_cast<uint32_t>(adler[0]) << 24 | adler[1] << 16 | adler[2] << 8 | adler[3]);
+}
+
+/**
+ * @brief Local http server standing in for log server.
+ *
+ */
+class LogServer {
+ public:
+  enum Mode {
+    kNormal,  // reply 200
+    kClose,   // close connection without reply
+    kSlow,    // reply 200 after delay
+  };
+
+  bool Start() {
+    sockaddr_in addr;
+    socklen_t addr_len = sizeof(addr);
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    listen_fd_ = socket(AF_INET, SOCK_STREAM, 0);
+    if (listen_fd_ < 0 || bind(listen_fd_, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) ||
+        listen(listen_fd_, 8) || getsockname(listen_fd_, reinterpret_cast<sockaddr *>(&addr), &addr_len)) {
+      return false;
+    }
+    port_ = ntohs(addr.sin_port);
+    running_ = true;
+    thread_ = std::thread(&LogServer::Run, this);
+    return true;
+  }
+
+  void Stop() {
+    running_ = false;
+    thread_.join();
+    for (auto &conn : conns_) close(conn.fd);
+    close(listen_fd_);
+  }
+
+  int port() const { return port_; }
+  void set_mode(Mode mode) { mode_ = mode; }
+  int conn_num() const { return conn_num_; }
+  int post_num() const { return post_num_; }
+  int bad_num() const { return bad_num_; }
+
+  std::string logs() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return logs_;
+  }
+
+ private:
+  struct Conn {
+    int fd;
+    std::string buf;
+  };
+
+  void Run() {
+    while (running_) {
+      std::vector<pollfd> fds = {{listen_fd_, POLLIN, 0}};
+      for (auto &conn : conns_) fds.push_back({conn.fd, POLLIN, 0});
+      if (poll(fds.data(), fds.size(), 50) <= 0) continue;
+
+      for (size_t i = fds.size() - 1; i > 0; i--) {
+        if (fds[i].revents && !Read(&conns_[i - 1])) {
+          close(conns_[i - 1].fd);
+          conns_.erase(conns_.begin() + i - 1);
+        }
+      }
+
+      if (fds[0].revents & POLLIN) {
+        int fd = accept(listen_fd_, nullptr, nullptr);
+        if (fd >= 0) {
+          conns_.push_back({fd, ""});
+          conn_num_++;
+        }
+      }
+    }
+  }
+
+  // read and handle requests, false to close connection
+  bool Read(Conn *conn) {
+    char buf[4096];
+    ssize_t len = recv(conn->fd, buf, sizeof(buf), 0);
+    if (len <= 0) return false;
+    conn->buf.append(buf, len);
+
+    while (true) {
+      size_t header_end = conn->buf.find("\r\n\r\n");
+      if (header_end == std::string::npos) return true;
+      std::string header = conn->buf.substr(0, header_end);
+      size_t length_pos = header.find("Content-Length:");
+      size_t content_length = 0;
+      if (length_pos != std::string::npos) {
+        content_length = strtoul(header.c_str() + length_pos + strlen("Content-Length:"), nullptr, 10);
+      }
+      if (conn->buf.size() < header_end + 4 + content_length) return true;
+
+      std::string body = conn->buf.substr(header_end + 4, content_length);
+      conn->buf.erase(0, header_end + 4 + content_length);
+      if (mode_ == kClose) return false;
+
+      Handle(header, body);
+      if (mode_ == kSlow) std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+      const char *reply = "HTTP/1.1 200 OK\r\nContent-Length: 0\r\n\r\n";
+      if (send(conn->fd, reply, strlen(reply), MSG_NOSIGNAL) < 0) return false;
+    }
+  }
+
+  void Handle(const std::string &header, const std::string &content) {
+    std::string body = content;
+    char digest[41] = {0};
+
+    post_num_++;
+    if (header.find("Content-Encoding:deflate") != std::string::npos && !Inflate(content, &body)) {
+      bad_num_++;
+      return;
+    }
+
+    // check header and signature
+    if (body.size() < kHeaderSize || body.compare(44, strlen(kProductId), kProductId) ||
+        utils_hmac_sha1(body.data() + 40, body.size() - 40, reinterpret_cast<const uint8_t *>(kSignKey),
+                        strlen(kSignKey), digest) ||
+        body.compare(0, 40, digest)) {
+      bad_num_++;
+      return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    logs_ += body.substr(kHeaderSize);
+  }
+
+  int listen_fd_ = -1;
+  int port_ = 0;
+  std::atomic<bool> running_{false};
+  std::atomic<Mode> mode_{kNormal};
+  std::atomic<int> conn_num_{0};
+  std::atomic<int> post_num_{0};
+  std::atomic<int> bad_num_{0};
+  std::vector<Conn> conns_;
+  std::thread thread_;
+  std::mutex mutex_;
+  std::string logs_;
+};
+
+/**
+ * @brief Log file in memory.
+ *
+ */
+static std::string sg_log_file;
+
+static size_t LogFileSave(const char *data, size_t len) {
+  sg_log_file.append(data, len);
+  return len;
+}
+
+static size_t LogFileRead(char *buf, size_t len, size_t offset) {
+  if (offset >= sg_log_file.size()) return 0;
+  len = std::min(len, sg_log_file.size() - offset);
+  memcpy(buf, sg_log_file.data() + offset, len);
+  return len;
+}
+
+static int LogFileDel(void) {
+  sg_log_file.clear();
+  return 0;
+}
+
+static size_t LogFileGetSize(void) { return sg_log_file.size(); }
+
+/**
+ * @brief Check logs are "log <seq>\r\n" with increasing seq.
+ *
+ * @param[in] logs logs received
+ * @return number of logs, -1 for out of order
+ */
+static int CheckLogs(const std::string &logs) {
+  const char *prefix = "INF|log upload test ";
+  int num = 0, last = -1, seq;
+  size_t pos = 0, end;
+  while ((end = logs.find("\r\n", pos)) != std::string::npos) {
+    if (logs.compare(pos, strlen(prefix), prefix)) return -1;
+    seq = strtol(logs.c_str() + pos + strlen(prefix), nullptr, 10);
+    if (seq <= last) return -1;
+    last = seq;
+    num++;
+    pos = end + 2;
+  }
+  return pos == logs.size() ? num : -1;
+}
+
+/**
+ * @brief Init params with local server.
+ *
+ */
+static LogUploadInitParams TestInitParams(LogServer *server, uint8_t compress_enable) {
+  static const char *url = "http://127.0.0.1/cgi-bin/report-log";
+  LogUploadInitParams params = DEFAULT_LOG_UPLOAD_INIT_PARAMS;
+  params.url = url;
+  params.port = server->port();
+  params.product_id = kProductId;
+  params.device_name = kDeviceName;
+  params.sign_key = kSignKey;
+  params.compress_enable = compress_enable;
+  params.interval_ms = 100;
+  return params;
+}
+
+/**
+ * @brief Test log upload by log handle of utils log.
+ *
+ */
+TEST(LogUploadTest, log_handle) {
+  LogServer server;
+  ASSERT_TRUE(server.Start());
+
+  LogUploadInitParams params = TestInitParams(&server, 0);
+  ASSERT_EQ(IOT_Log_Upload_Init(&params), 0);
+
+  LogHandleFunc func = {0};
+  func.log_malloc = HAL_Malloc;
+  func.log_free = HAL_Free;
+  func.log_handle = IOT_Log_Upload_Handle;
+  func.log_printf = HAL_Printf;
+  func.log_get_current_time_str = HAL_Timer_Current;
+  ASSERT_EQ(utils_log_init(func, LOG_LEVEL_DEBUG, 2048), 0);
+
+  Log_i("log upload by log handle");
+  ASSERT_EQ(IOT_Log_Upload(1), 0);
+  utils_log_deinit();
+  IOT_Log_Upload_Deinit();
+  server.Stop();
+
+  ASSERT_NE(server.logs().find("log upload by log handle"), std::string::npos);
+  ASSERT_EQ(server.bad_num(), 0);
+}
+
+/**
+ * @brief Test logs are saved into file when offline, and uploaded first when online.
+ *
+ */
+TEST(LogUploadTest, save_when_offline) {
+  char log[64];
+  std::string offline_logs;
+  LogServer server;
+  ASSERT_TRUE(server.Start());
+
+  LogUploadInitParams params = TestInitParams(&server, 1);
+  params.interval_ms = 60 * 1000;
+  params.file_func.log_file_save = LogFileSave;
+  params.file_func.log_file_read = LogFileRead;
+  params.file_func.log_file_del = LogFileDel;
+  params.file_func.log_file_get_size = LogFileGetSize;
+  sg_log_file.clear();
+  ASSERT_EQ(IOT_Log_Upload_Init(&params), 0);
+
+  // 1. server closes connection without reply, logs are saved
+  server.set_mode(LogServer::kClose);
+  for (int i = 0; i < 50; i++) {
+    HAL_Snprintf(log, sizeof(log), "INF|log upload test %d\r\n", i);
+    IOT_Log_Upload_Handle(log);
+    offline_logs += log;
+  }
+  ASSERT_NE(IOT_Log_Upload(1), 0);
+  ASSERT_EQ(sg_log_file, offline_logs);
+
+  // 2. logs in file are uploaded before logs in memory, then file is deleted
+  server.set_mode(LogServer::kNormal);
+  for (int i = 50; i < 100; i++) {
+    HAL_Snprintf(log, sizeof(log), "INF|log upload test %d\r\n", i);
+    IOT_Log_Upload_Handle(log);
+  }
+  ASSERT_EQ(IOT_Log_Upload(1), 0);
+
+  LogUploadStats stats;
+  IOT_Log_Upload_GetStats(&stats);
+  IOT_Log_Upload_Deinit();
+  server.Stop();
+
+  ASSERT_EQ(CheckLogs(server.logs()), 100);
+  ASSERT_TRUE(sg_log_file.empty());
+  ASSERT_EQ(stats.save_bytes, offline_logs.size());
+  ASSERT_EQ(server.bad_num(), 0);
+}
+
+/**
+ * @brief Test compressed upload of logs fitting in the ring, all logs are uploaded by one connection in bounded memory.
+ *
+ */
+TEST(LogUploadTest, upload_compress) {
+  const int log_num = 80;
+  char log[128];
+  LogServer server;
+  ASSERT_TRUE(server.Start());
+
+  LogUploadInitParams params = TestInitParams(&server, 1);
+  ASSERT_EQ(IOT_Log_Upload_Init(&params), 0);
+
+  for (int i = 0; i < log_num; i++) {
+    HAL_Snprintf(log, sizeof(log), "INF|log upload test %d|test_log_upload.cc|upload_compress(%d): upload\r\n", i,
+                 __LINE__);
+    IOT_Log_Upload_Handle(log);
+  }
+  ASSERT_EQ(IOT_Log_Upload(1), 0);
+
+  LogUploadStats stats;
+  IOT_Log_Upload_GetStats(&stats);
+  IOT_Log_Upload_Deinit();
+  server.Stop();
+
+  ASSERT_EQ(CheckLogs(server.logs()), log_num);
+  ASSERT_EQ(stats.drop_num, 0u);
+  ASSERT_EQ(stats.upload_bytes, server.logs().size());
+  ASSERT_LT(stats.post_bytes, stats.upload_bytes);
+  ASSERT_EQ(stats.connect_num, 1u);
+  ASSERT_EQ(server.conn_num(), 1);
+  ASSERT_EQ(server.bad_num(), 0);
+  ASSERT_LE(stats.memory_size, 32 * 1024u);
+}
+
+/**
+ * @brief Upload throughput and memory ceiling, logs are written as fast as possible for 1 second.
+ *
+ */
+TEST(LogUploadTest, DISABLED_upload_benchmark) {
+  char log[128];
+  int log_num = 0;
+  LogServer server;
+  ASSERT_TRUE(server.Start());
+
+  LogUploadInitParams params = TestInitParams(&server, 1);
+  ASSERT_EQ(IOT_Log_Upload_Init(&params), 0);
+
+  auto start = std::chrono::steady_clock::now();
+  while (std::chrono::steady_clock::now() - start < std::chrono::seconds(1)) {
+    HAL_Snprintf(log, sizeof(log), "INF|log upload test %d|test_log_upload.cc|upload_benchmark(%d): upload\r\n",
+                 log_num, __LINE__);
+    IOT_Log_Upload_Handle(log);
+    log_num++;
+#ifndef MULTITHREAD_ENABLED
+    IOT_Log_Upload(0);
+#endif
+  }
+  ASSERT_EQ(IOT_Log_Upload(1), 0);
+  double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  LogUploadStats stats;
+  IOT_Log_Upload_GetStats(&stats);
+  IOT_Log_Upload_Deinit();
+  server.Stop();
+
+  std::cout << "logs: " << log_num << ", uploaded: " << CheckLogs(server.logs()) << ", dropped: " << stats.drop_num
+            << std::endl;
+  std::cout << "upload: " << stats.upload_bytes / elapsed / 1024 << " KB/s, posts: " << stats.post_num
+            << ", compress ratio: " << static_cast<double>(stats.post_bytes) / stats.upload_bytes
+            << ", memory: " << stats.memory_size << " bytes" << std::endl;
+
+  ASSERT_EQ(CheckLogs(server.logs()) + stats.drop_num, static_cast<uint32_t>(log_num));
+  ASSERT_EQ(stats.upload_bytes, server.logs().size());
+  ASSERT_LT(stats.post_bytes, stats.upload_bytes);
+  ASSERT_EQ(stats.connect_num, 1u);
+  ASSERT_EQ(server.conn_num(), 1);
+  ASSERT_EQ(server.bad_num(), 0);
+  // memory is bounded by ring and post buffers, no matter how many logs are written
+  ASSERT_LE(stats.memory_size, 32 * 1024u);
+}
+
+#ifdef MULTITHREAD_ENABLED
+/**
+ * @brief Log handle never blocks even if server is slow.
+ *
+ */
+TEST(LogUploadTest, slow_server) {
+  LogServer server;
+  ASSERT_TRUE(server.Start());
+  server.set_mode(LogServer::kSlow);
+
+  LogUploadInitParams params = TestInitParams(&server, 1);
+  ASSERT_EQ(IOT_Log_Upload_Init(&params), 0);
+
+  std::atomic<int64_t> max_ns{0};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; t++) {
+    threads.emplace_back([&max_ns, t]() {
+      char log[64];
+      for (int i = 0; i < 20000; i++) {
+        HAL_Snprintf(log, sizeof(log), "INF|log upload test %d\r\n", t * 20000 + i);
+        auto start = std::chrono::steady_clock::now();
+        IOT_Log_Upload_Handle(log);
+        int64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start)
+                         .count();
+        int64_t cur = max_ns.load();
+        while (ns > cur && !max_ns.compare_exchange_weak(cur, ns)) {
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) thread.join();
+
+  LogUploadStats stats;
+  IOT_Log_Upload_GetStats(&stats);
+  IOT_Log_Upload_Deinit();
+  server.Stop();
+
+  std::cout << "max log handle latency: " << max_ns.load() / 1000 << " us, dropped: " << stats.drop_num << std::endl;
+  // server replies after 200ms, log handle should not wait for it
+  ASSERT_LT(max_ns.load(), 100 * 1000 * 1000);
+  ASSERT_GT(stats.drop_num, 0u);
+}
+#endif
+
+}  // namespace log_upload_unittest
@@ -57,17 +57,83 @@ extern "C" {
 #define MAX_CONN_ID_LEN (6)
 
 /**
- * @brief Max number of topic subscribed
+ * @brief Max number of subscribe/unsubscribe waiting for ack
  *
  */
 #define MAX_MESSAGE_HANDLERS (10)
 
 /**
- * @brief Max number in repub list
+ * @brief Initial bucket number of exact topic filter hash, should be power of 2
+ *
+ */
+#define SUB_INDEX_MIN_BUCKET_NUM (16)
+
+/**
+ * @brief Default max number of publish in flight
  *
  */
 #define MAX_REPUB_NUM (20)
 
+/**
+ * @brief Upper limit of publish window size set by user
+ *
+ */
+#define MAX_PUB_WINDOW_SIZE (4096)
+
+/**
+ * @brief Slot number of puback timeout wheel, should be power of 2
+ *
+ */
+#define PUB_WAIT_WHEEL_SLOT_NUM (64)
+
+/**
+ * @brief Tick of puback timeout wheel (unit: ms)
+ *
+ */
+#define PUB_WAIT_WHEEL_TICK_MS (100)
+
+/**
+ * @brief Max retry times of one publish before timeout, wait interval doubles each time
+ *
+ */
+#define MAX_REPUB_RETRY_TIMES (3)
+
+/**
+ * @brief Minimal size of MQTT read/write buffer
+ *
+ */
+#define MIN_MQTT_BUF_LEN (128)
+
+/**
+ * @brief Idle time before buffer grown on demand shrinks back to initial size (unit: ms)
+ *
+ */
+#define MQTT_BUF_SHRINK_IDLE_MS (30 * 1000)
+
+/**
+ * @brief Size of socket read ahead buffer, small packets buffered are parsed without reading socket again
+ *
+ */
+#define MQTT_READ_AHEAD_LEN (1024)
+
+/**
+ * @brief Max packets handled for one client each time socket is readable in event loop
+ *
+ */
+#define MQTT_YIELD_READY_MAX_PACKETS (32)
+
+/**
+ * @brief Default deadline to flush batched publish packets (unit: ms)
+ *
+ */
+#define MQTT_PUB_BATCH_FLUSH_MS (5)
+
+/**
+ * @brief Interval to check standby connection and start a new one if it is used or broken (unit: ms)
+ *
+ */
+#define MQTT_STANDBY_CHECK_INTERVAL_MS (1000)
+
 /**
  * @brief Minimal wait interval when reconnect
  *
@@ -125,6 +191,81 @@ typedef struct {
     SubscribeParams params;       /**< params needed to subscribe */
 } SubTopicHandle;
 
+struct QcloudIotTopicNode;
+
+/**
+ * @brief subscription entry, stored in exact filter hash or topic trie node
+ *
+ */
+typedef struct QcloudIotSubEntry {
+    SubTopicHandle             handle;    /**< sub handle */
+    uint32_t                   hash;      /**< hash of topic filter, only for exact filter */
+    struct QcloudIotSubEntry  *hash_next; /**< next entry in the same hash bucket */
+    struct QcloudIotTopicNode *node;      /**< trie node of wildcard filter, NULL for exact filter */
+    struct QcloudIotSubEntry  *prev;      /**< prev entry in subscription list */
+    struct QcloudIotSubEntry  *next;      /**< next entry in subscription list */
+} QcloudIotSubEntry;
+
+/**
+ * @brief topic trie node, one node for one topic level of wildcard filter
+ *
+ */
+typedef struct QcloudIotTopicNode {
+    char                      *level;     /**< topic level, "+" or "#" for wildcard */
+    uint16_t                   level_len; /**< length of topic level */
+    struct QcloudIotTopicNode *parent;    /**< parent node, NULL for root */
+    struct QcloudIotTopicNode *child;     /**< first child node */
+    struct QcloudIotTopicNode *sibling;   /**< next sibling node */
+    QcloudIotSubEntry         *entry;     /**< subscription whose filter ends at this level */
+} QcloudIotTopicNode;
+
+/**
+ * @brief subscription index, exact filter is matched by hash and wildcard filter by topic trie.
+ *
+ */
+typedef struct {
+    QcloudIotSubEntry  *head;        /**< list of all subscriptions, for resubscribe and clear */
+    QcloudIotSubEntry **buckets;     /**< buckets of exact filter hash */
+    uint32_t            bucket_num;  /**< bucket number, power of 2 */
+    uint32_t            exact_count; /**< number of exact filter */
+    QcloudIotTopicNode  root;        /**< root of wildcard filter trie */
+} QcloudIotSubIndex;
+
+/**
+ * @brief topic publish info
+ *
+ */
+typedef struct QcloudIotPubInfo {
+    uint8_t                 *buf;              /**< msg buffer, header only if payload is referenced */
+    uint32_t                 len;              /**< msg length */
+    const uint8_t           *payload;          /**< payload referenced, NULL if copied in buf */
+    uint32_t                 payload_len;      /**< length of payload referenced */
+    OnPayloadReleaseHandler  payload_release;  /**< callback to release payload referenced */
+    void                    *release_usr_data; /**< user data of payload_release */
+    uint16_t                 packet_id;        /**< packet id */
+    uint8_t                  retry_cnt;        /**< retry times of republish */
+    uint8_t                  resending;        /**< off the wheel and being resent without lock of table */
+    uint8_t                  removed;          /**< removed from table while resending, freed by the resender */
+    uint64_t                 pub_time_ms;      /**< timestamp of first sent, for ack latency */
+    uint64_t                 expire_ms;        /**< timestamp of puback waiting timeout */
+    struct QcloudIotPubInfo *prev;             /**< prev info in the same timeout wheel slot */
+    struct QcloudIotPubInfo *next;             /**< next info in the same timeout wheel slot, or resend list */
+} QcloudIotPubInfo;
+
+/**
+ * @brief puback waiting table, indexed by packet id with open addressing, and timeout is checked by wheel.
+ *
+ */
+typedef struct {
+    QcloudIotPubInfo **slots;                          /**< slots indexed by packet id */
+    uint32_t           capacity;                       /**< slot count, power of 2 and at least 2 * window_size */
+    uint32_t           window_size;                    /**< max publish in flight */
+    uint32_t           count;                          /**< publish in flight */
+    QcloudIotPubInfo  *wheel[PUB_WAIT_WHEEL_SLOT_NUM]; /**< timeout wheel */
+    uint64_t           wheel_tick;                     /**< tick of wheel not fully checked */
+    void              *lock;                           /**< mutex/lock for table */
+} QcloudIotPubWaitTable;
+
 /**
  * @brief MQTT QCloud IoT Client structure
  *
@@ -135,19 +276,33 @@ typedef struct {
     uint16_t next_packet_id;     /**< MQTT random packet id */
     uint32_t command_timeout_ms; /**< MQTT command timeout, unit:ms */
 
-    uint8_t write_buf[QCLOUD_IOT_MQTT_TX_BUF_LEN]; /**< MQTT write buffer */
-    uint8_t read_buf[QCLOUD_IOT_MQTT_RX_BUF_LEN];  /**< MQTT read buffer */
-    size_t  write_buf_size;                        /**< size of MQTT write buffer */
-    size_t  read_buf_size;                         /**< size of MQTT read buffer */
-
-    MQTTEventHandler event_handle;        /**< callback for MQTT event */
-    uint8_t          auto_connect_enable; /**< enable auto connection or not */
-    uint8_t          default_subscribe;   /**< no subscribe packet send, only add subhandle */
-
-    void *lock_generic;      /**< mutex/lock for this client struture */
-    void *lock_write_buf;    /**< mutex/lock for write buffer */
-    void *list_pub_wait_ack; /**< puback waiting list */
-    void *list_sub_wait_ack; /**< suback waiting list */
+    uint8_t *write_buf;             /**< MQTT write buffer */
+    uint8_t *read_buf;              /**< MQTT read buffer */
+    size_t   write_buf_size;        /**< size of MQTT write buffer */
+    size_t   read_buf_size;         /**< size of MQTT read buffer */
+    size_t   write_buf_init_size;   /**< initial size of write buffer, shrink back to it when idle */
+    size_t   read_buf_init_size;    /**< initial size of read buffer, shrink back to it when idle */
+    size_t   buf_max_size;          /**< ceiling of buffer growing on demand, 0 for no growing */
+    uint8_t  is_write_buf_external; /**< write buffer is provided by user, no realloc or free */
+    uint8_t  is_read_buf_external;  /**< read buffer is provided by user, no realloc or free */
+    uint64_t buf_busy_time_ms;      /**< last time buffer larger than initial size is needed */
+
+    uint8_t *pub_batch_buf;      /**< buffer to coalesce publish packets, NULL for no batching */
+    size_t   pub_batch_buf_size; /**< size of publish batch buffer */
+    size_t   pub_batch_len;      /**< length of publish packets pending in batch buffer */
+    uint32_t pub_batch_flush_ms; /**< deadline to flush publish batch after first packet pending */
+    Timer    pub_batch_timer;    /**< flush timer of publish batch */
+
+    MQTTEventHandler event_handle;           /**< callback for MQTT event */
+    uint8_t          auto_connect_enable;    /**< enable auto connection or not */
+    uint8_t          default_subscribe;      /**< no subscribe packet send, only add subhandle */
+    uint8_t          standby_connect_enable; /**< keep a standby tcp connection for instant reconnect */
+    Timer            standby_timer;          /**< timer to check standby connection */
+
+    void                 *lock_generic;      /**< mutex/lock for this client struture */
+    void                 *lock_write_buf;    /**< mutex/lock for write buffer */
+    QcloudIotPubWaitTable pub_wait_table;    /**< puback waiting table */
+    void                 *list_sub_wait_ack; /**< suback waiting list */
 
     char       host_addr[HOST_STR_LENGTH]; /**< MQTT server host */
     IotNetwork network_stack;              /**< MQTT network stack */
@@ -155,33 +310,41 @@ typedef struct {
     MQTTPacketConnectOption options;                  /**< handle to connection parameters */
     char                    conn_id[MAX_CONN_ID_LEN]; /**< connect id */
 
-    SubTopicHandle sub_handles[MAX_MESSAGE_HANDLERS]; /**< subscription handle array */
-    Timer          ping_timer;                        /**< MQTT ping timer */
-    Timer          reconnect_delay_timer;             /**< MQTT reconnect delay timer */
-    uint8_t        was_manually_disconnected;         /**< was disconnect by server or device */
-    uint8_t        is_ping_outstanding;             /**< 1 = ping request is sent while ping response not arrived yet */
-    uint32_t       current_reconnect_wait_interval; /**< unit:ms */
+    QcloudIotSubIndex sub_index;                 /**< subscription index */
+    Timer             ping_timer;                /**< MQTT ping timer */
+    Timer             reconnect_delay_timer;     /**< MQTT reconnect delay timer */
+    uint8_t           was_manually_disconnected; /**< was disconnect by server or device */
+    uint8_t  is_ping_outstanding;             /**< 1 = ping request is sent while ping response not arrived yet */
+    uint32_t current_reconnect_wait_interval; /**< unit:ms */
+
+    uint64_t                last_send_ms;      /**< timestamp of last packet sent, which counts as keep alive */
+    uint64_t                last_recv_ms;      /**< timestamp of last packet received */
+    uint64_t                ping_send_ms;      /**< timestamp of last ping request sent, for round trip time */
+    uint32_t                ping_idle_ms;      /**< idle time of connection before ping request outstanding */
+    uint32_t                broken_idle_ms;    /**< idle time before connection broken, checked when reconnected */
+    uint32_t                ping_interval_ms;  /**< idle time before ping, adapted to nat idle timeout */
+    uint32_t                ping_probe_count;  /**< ping response at current interval, to probe a longer one */
+    MQTTKeepAliveStatistics keep_alive_stats;  /**< statistics of keep alive */
+    uint64_t                total_ping_rtt_ms; /**< sum of ping round trip time, for average */
 
     uint8_t  is_connected;                 /**< is connected or not */
+    uint8_t  session_present;              /**< session present flag of the last CONNACK */
     uint32_t counter_network_disconnected; /**< number of disconnection*/
 
+    MQTTPubStatistics pub_stats;            /**< statistics of qos1 publish */
+    uint64_t          total_ack_latency_ms; /**< sum of puback latency, for average latency */
+
 #ifdef MQTT_RMDUP_MSG_ENABLED
 #define MQTT_MAX_REPEAT_BUF_LEN 10
     uint16_t     repeat_packet_id_buf[MQTT_MAX_REPEAT_BUF_LEN]; /**< repeat packet id buffer */
     unsigned int current_packet_id_cnt;                         /**< index of packet id buffer */
 #endif
-} QcloudIotClient;
 
-/**
- * @brief topic publish info
- *
- */
-typedef struct {
-    uint8_t *buf;            /**< msg buffer */
-    uint32_t len;            /**< msg length */
-    uint16_t packet_id;      /**< packet id */
-    Timer    pub_start_time; /**< timer for puback waiting */
-} QcloudIotPubInfo;
+#ifdef MULTITHREAD_ENABLED
+    uint8_t io_thread_enable; /**< read/handle packets and keep alive in background io thread */
+    void   *io_thread;        /**< background io thread, NULL when not running */
+#endif
+} QcloudIotClient;
 
 /**
  * @brief topic subscribe/unsubscribe info
@@ -237,9 +400,80 @@ uint8_t get_client_conn_state(QcloudIotClient *client);
  * @param[in,out] client pointer to mqtt client
  * @param[in] length length of data to be sent, data is saved in client write_buf
  * @return @see IotReturnCode
+ * @note pending publish batch is written first to keep packets in order.
  */
 int send_mqtt_packet(QcloudIotClient *client, size_t length);
 
+/**
+ * @brief Send mqtt packet with payload not copied into write_buf, using vectored write, timeout = command_timeout_ms.
+ *
+ * @param[in,out] client pointer to mqtt client
+ * @param[in] length length of packet header saved in client write_buf
+ * @param[in] payload payload sent right after the header
+ * @param[in] payload_len length of payload
+ * @return @see IotReturnCode
+ * @note pending publish batch is written first to keep packets in order.
+ */
+int send_mqtt_packet_with_payload(QcloudIotClient *client, size_t length, const void *payload, size_t payload_len);
+
+/**
+ * @brief Record time of packet sent successfully, outbound traffic counts as keep alive.
+ *
+ * @param[in,out] client pointer to mqtt client
+ */
+void update_mqtt_send_time(QcloudIotClient *client);
+
+/**
+ * @brief Make write buffer larger than length, grow on demand if not provided by user. Should be called with
+ * lock_write_buf locked, and content of write buffer is not kept.
+ *
+ * @param[in,out] client pointer to mqtt client
+ * @param[in] length length of packet to be serialized
+ * @return @see IotReturnCode
+ */
+int reserve_mqtt_write_buf(QcloudIotClient *client, size_t length);
+
+/**
+ * @brief Make read buffer larger than length, grow on demand if not provided by user. Content of read buffer is kept.
+ *
+ * @param[in,out] client pointer to mqtt client
+ * @param[in] length length of packet to be read
+ * @return @see IotReturnCode
+ */
+int reserve_mqtt_read_buf(QcloudIotClient *client, size_t length);
+
+/**
+ * @brief Shrink buffers grown on demand back to initial size, if idle for MQTT_BUF_SHRINK_IDLE_MS.
+ *
+ * @param[in,out] client pointer to mqtt client
+ */
+void shrink_mqtt_buf(QcloudIotClient *client);
+
+/**
+ * @brief Write publish packets pending in batch buffer to network. Should be called with lock_write_buf locked.
+ *
+ * @param[in,out] client pointer to mqtt client
+ * @return @see IotReturnCode
+ */
+int send_mqtt_pub_batch(QcloudIotClient *client);
+
+/**
+ * @brief Lock write buffer and write pending publish packets to network.
+ *
+ * @param[in,out] client pointer to mqtt client
+ * @param[in] expired_only only flush when deadline of batch passes
+ * @return @see IotReturnCode
+ */
+int flush_mqtt_pub_batch(QcloudIotClient *client, bool expired_only);
+
+/**
+ * @brief Get time left before publish batch should be flushed.
+ *
+ * @param[in,out] client pointer to mqtt client
+ * @return time left (unit: ms), UINT32_MAX if no packet pending
+ */
+uint32_t get_mqtt_pub_batch_remain_ms(QcloudIotClient *client);
+
 /**************************************************************************************
  * connect
  **************************************************************************************/
@@ -315,6 +549,38 @@ int qcloud_iot_mqtt_handle_puback(QcloudIotClient *client);
  */
 void qcloud_iot_mqtt_check_pub_timeout(QcloudIotClient *client);
 
+/**
+ * @brief Init puback waiting table.
+ *
+ * @param[in,out] client pointer to mqtt_client
+ * @param[in] window_size max publish in flight, 0 for MAX_REPUB_NUM
+ * @return @see IotReturnCode
+ */
+int qcloud_iot_mqtt_pub_wait_table_init(QcloudIotClient *client, uint32_t window_size);
+
+/**
+ * @brief Deinit puback waiting table and free publish info in flight.
+ *
+ * @param[in,out] client pointer to mqtt_client
+ */
+void qcloud_iot_mqtt_pub_wait_table_deinit(QcloudIotClient *client);
+
+/**
+ * @brief Resend publish packets in puback wait list with DUP flag when reconnect.
+ *
+ * @param[in,out] client pointer to mqtt_client
+ * @return @see IotReturnCode
+ */
+int qcloud_iot_mqtt_republish(QcloudIotClient *client);
+
+/**
+ * @brief Get statistics of qos1 publish.
+ *
+ * @param[in,out] client pointer to mqtt_client
+ * @param[out] stats @see MQTTPubStatistics
+ */
+void qcloud_iot_mqtt_get_pub_statistics(QcloudIotClient *client, MQTTPubStatistics *stats);
+
 /**************************************************************************************
  * subscribe
  **************************************************************************************/
@@ -389,11 +655,24 @@ bool qcloud_iot_mqtt_is_sub_ready(QcloudIotClient *client, const char *topic_fil
 void *qcloud_iot_mqtt_get_subscribe_usr_data(QcloudIotClient *client, const char *topic_filter);
 
 /**
- * @brief Clear sub handle array.
+ * @brief Get params of sub handle matched with topic name, exact filter takes precedence over wildcard filter.
+ *
+ * @param[in,out] client pointer to mqtt client
+ * @param[in] topic_name topic name, no wildcard
+ * @param[in] topic_len length of topic name
+ * @param[out] params params of matched sub handle
+ * @return true for matched
+ * @return false for no matched
+ */
+bool qcloud_iot_mqtt_match_sub_params(QcloudIotClient *client, const char *topic_name, uint16_t topic_len,
+                                      SubscribeParams *params);
+
+/**
+ * @brief Clear sub handle index.
  *
  * @param[in,out] client pointer to mqtt client
  */
-void qcloud_iot_mqtt_sub_handle_array_clear(QcloudIotClient *client);
+void qcloud_iot_mqtt_sub_handle_clear(QcloudIotClient *client);
 
 /**
  * @brief Clear suback wait list and clear sub handle.
@@ -417,6 +696,25 @@ void qcloud_iot_mqtt_suback_wait_list_clear(QcloudIotClient *client);
  */
 int qcloud_iot_mqtt_yield(QcloudIotClient *client, uint32_t timeout_ms);
 
+/**
+ * @brief Read/handle MQTT message already received and check keep alive state without waiting, for event loop.
+ *
+ * @param[in,out] client pointer to mqtt client
+ * @param[in] readable if socket is readable, otherwise only data buffered by network is read
+ * @return QCLOUD_RET_SUCCESS when success, QCLOUD_ERR_MQTT_ATTEMPTING_RECONNECT when try reconnecting, others @see
+ * IotReturnCode
+ */
+int qcloud_iot_mqtt_yield_ready(QcloudIotClient *client, bool readable);
+
+/**
+ * @brief Check if reconnect is due, so that event loop can leave the blocking reconnect in yield ready to another
+ * thread.
+ *
+ * @param[in,out] client pointer to mqtt client
+ * @return true if disconnected and reconnect delay expires
+ */
+bool qcloud_iot_mqtt_is_reconnect_due(QcloudIotClient *client);
+
 /**
  * @brief Wait read specific mqtt packet, such as connack.
  *
@@ -426,6 +724,58 @@ int qcloud_iot_mqtt_yield(QcloudIotClient *client, uint32_t timeout_ms);
  */
 int qcloud_iot_mqtt_wait_for_read(QcloudIotClient *client, uint8_t packet_type);
 
+/**
+ * @brief Get statistics of keep alive.
+ *
+ * @param[in,out] client pointer to mqtt client
+ * @param[out] stats @see MQTTKeepAliveStatistics
+ */
+void qcloud_iot_mqtt_get_keep_alive_statistics(QcloudIotClient *client, MQTTKeepAliveStatistics *stats);
+
+#ifdef MULTITHREAD_ENABLED
+/**************************************************************************************
+ * io thread
+ **************************************************************************************/
+
+/**
+ * @brief Start io thread if io_thread_enable, which owns socket reads, keep alive, ack timeout and reconnect.
+ *
+ * @param[in,out] client pointer to mqtt client
+ * @return @see IotReturnCode
+ */
+int qcloud_iot_mqtt_io_thread_start(QcloudIotClient *client);
+
+/**
+ * @brief Stop io thread and wait for it to exit, publish not handled is completed with QCLOUD_ERR_MQTT_NO_CONN.
+ *
+ * @param[in,out] client pointer to mqtt client
+ */
+void qcloud_iot_mqtt_io_thread_stop(QcloudIotClient *client);
+
+/**
+ * @brief Wait for packets handled by io thread, instead of reading socket in yield.
+ *
+ * @param[in,out] client pointer to mqtt client
+ * @param[in] timeout_ms timeout value (unit: ms) for this operation
+ * @return QCLOUD_RET_SUCCESS when connected, QCLOUD_ERR_MQTT_ATTEMPTING_RECONNECT when try reconnecting, others @see
+ * IotReturnCode
+ */
+int qcloud_iot_mqtt_io_thread_wait(QcloudIotClient *client, uint32_t timeout_ms);
+
+/**
+ * @brief Submit publish to io thread, io thread is woken up only if it is not handling submitted publish.
+ *
+ * @param[in,out] client pointer to mqtt client
+ * @param[in] topic_name topic to publish
+ * @param[in] params publish params
+ * @param[in] on_complete callback when sent or failed, NULL for none
+ * @param[in] usr_data user data of on_complete
+ * @return @see IotReturnCode
+ */
+int qcloud_iot_mqtt_publish_async(QcloudIotClient *client, const char *topic_name, const PublishParams *params,
+                                  OnPublishCompleteHandler on_complete, void *usr_data);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
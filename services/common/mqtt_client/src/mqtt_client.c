@@ -51,12 +51,13 @@ static uint16_t _get_random_start_packet_id(void)
 }
 
 /**
- * @brief Init list_pub_wait_ack and list_sub_wait_ack
+ * @brief Init pub_wait_table and list_sub_wait_ack
  *
  * @param[in,out] client pointer to mqtt client
+ * @param[in] params mqtt init params, @see MQTTInitParams
  * @return @see IotReturnCode
  */
-static int _mqtt_client_list_init(QcloudIotClient *client)
+static int _mqtt_client_list_init(QcloudIotClient *client, const MQTTInitParams *params)
 {
     IOT_FUNC_ENTRY;
 
@@ -69,9 +70,8 @@ static int _mqtt_client_list_init(QcloudIotClient *client)
         .list_unlock      = HAL_MutexUnlock,
     };
 
-    client->list_pub_wait_ack = utils_list_create(func, MAX_REPUB_NUM);
-    if (!client->list_pub_wait_ack) {
-        Log_e("create pub wait list failed.");
+    if (qcloud_iot_mqtt_pub_wait_table_init(client, params->pub_window_size)) {
+        Log_e("create pub wait table failed.");
         goto error;
     }
 
@@ -82,13 +82,88 @@ static int _mqtt_client_list_init(QcloudIotClient *client)
     }
     IOT_FUNC_EXIT_RC(QCLOUD_RET_SUCCESS);
 error:
-    utils_list_destroy(client->list_pub_wait_ack);
-    client->list_pub_wait_ack = NULL;
+    qcloud_iot_mqtt_pub_wait_table_deinit(client);
     utils_list_destroy(client->list_sub_wait_ack);
     client->list_sub_wait_ack = NULL;
     IOT_FUNC_EXIT_RC(QCLOUD_ERR_FAILURE);
 }
 
+/**
+ * @brief Init read/write buffer provided by user or allocated by sdk, and publish batch buffer if enabled.
+ *
+ * @param[in,out] client pointer to mqtt client
+ * @param[in] params mqtt init params, @see MQTTInitParams
+ * @return @see IotReturnCode
+ */
+static int _mqtt_client_buf_init(QcloudIotClient *client, const MQTTInitParams *params)
+{
+    IOT_FUNC_ENTRY;
+
+    if ((params->write_buf && !params->write_buf_size) || (params->read_buf && !params->read_buf_size)) {
+        Log_e("size of buffer provided by user should not be 0!");
+        IOT_FUNC_EXIT_RC(QCLOUD_ERR_INVAL);
+    }
+
+    client->write_buf_size = params->write_buf_size ? params->write_buf_size : QCLOUD_IOT_MQTT_TX_BUF_LEN;
+    client->read_buf_size  = params->read_buf_size ? params->read_buf_size : QCLOUD_IOT_MQTT_RX_BUF_LEN;
+    if (client->write_buf_size < MIN_MQTT_BUF_LEN || client->read_buf_size < MIN_MQTT_BUF_LEN) {
+        Log_e("size of buffer should not be less than %d!", MIN_MQTT_BUF_LEN);
+        IOT_FUNC_EXIT_RC(QCLOUD_ERR_INVAL);
+    }
+
+    client->write_buf_init_size = client->write_buf_size;
+    client->read_buf_init_size  = client->read_buf_size;
+    client->buf_max_size        = params->max_buf_size;
+
+    client->is_write_buf_external = params->write_buf != NULL;
+    client->is_read_buf_external  = params->read_buf != NULL;
+    client->write_buf             = params->write_buf ? params->write_buf : HAL_Malloc(client->write_buf_size);
+    client->read_buf              = params->read_buf ? params->read_buf : HAL_Malloc(client->read_buf_size);
+    if (!client->write_buf || !client->read_buf) {
+        Log_e("malloc buffer failed!");
+        IOT_FUNC_EXIT_RC(QCLOUD_ERR_MALLOC);
+    }
+
+    // publish batching
+    if (!params->pub_batch_buf_size) {
+        IOT_FUNC_EXIT_RC(QCLOUD_RET_SUCCESS);
+    }
+    if (params->pub_batch_buf_size < MIN_MQTT_BUF_LEN) {
+        Log_e("size of publish batch buffer should not be less than %d!", MIN_MQTT_BUF_LEN);
+        IOT_FUNC_EXIT_RC(QCLOUD_ERR_INVAL);
+    }
+    client->pub_batch_buf_size = params->pub_batch_buf_size;
+    client->pub_batch_flush_ms = params->pub_batch_flush_ms ? params->pub_batch_flush_ms : MQTT_PUB_BATCH_FLUSH_MS;
+    client->pub_batch_len      = 0;
+    client->pub_batch_buf      = HAL_Malloc(client->pub_batch_buf_size);
+    if (!client->pub_batch_buf) {
+        Log_e("malloc publish batch buffer failed!");
+        IOT_FUNC_EXIT_RC(QCLOUD_ERR_MALLOC);
+    }
+    IOT_FUNC_EXIT_RC(QCLOUD_RET_SUCCESS);
+}
+
+/**
+ * @brief Deinit read/write buffer and publish batch buffer, only free buffer allocated by sdk.
+ *
+ * @param[in,out] client pointer to mqtt client
+ */
+static void _mqtt_client_buf_deinit(QcloudIotClient *client)
+{
+    if (!client->is_write_buf_external) {
+        HAL_Free(client->write_buf);
+    }
+    client->write_buf = NULL;
+
+    if (!client->is_read_buf_external) {
+        HAL_Free(client->read_buf);
+    }
+    client->read_buf = NULL;
+
+    HAL_Free(client->pub_batch_buf);
+    client->pub_batch_buf = NULL;
+}
+
 /**
  * @brief Init network, tcp(with AUTH_WITH_NO_TLS) or tls.
  *
@@ -122,11 +197,15 @@ static void _mqtt_client_network_init(QcloudIotClient *client, const MQTTInitPar
                                                               ? client->command_timeout_ms
                                                               : QCLOUD_IOT_TLS_HANDSHAKE_TIMEOUT;
     client->network_stack.type                          = IOT_NETWORK_TYPE_TLS;
+
+    // abbreviated handshake when reconnect
+    client->network_stack.ssl_connect_params.session_resume_enable = 1;
 #else
     client->network_stack.host = client->host_addr;
     client->network_stack.port = MQTT_SERVER_PORT_NO_TLS;
     client->network_stack.type = IOT_NETWORK_TYPE_TCP;
 #endif
+    client->network_stack.read_ahead_size = MQTT_READ_AHEAD_LEN;
     qcloud_iot_network_init(&(client->network_stack));
 }
 
@@ -149,6 +228,7 @@ static int _mqtt_client_connect_option_init(QcloudIotClient *client, const MQTTI
     client->options.client_id = client->device_info->client_id;
     client->options.keep_alive_interval =
         params->keep_alive_interval_ms / 1000 > 690 ? 690 : params->keep_alive_interval_ms / 1000;
+    client->ping_interval_ms = client->options.keep_alive_interval * 1000;
     client->options.clean_session = params->clean_session;
 
     // calculate user name & password
@@ -196,9 +276,10 @@ error:
  * @note
  * 1. init device info.
  * 2. init mutex and var
- * 3. init list @see _mqtt_client_list_init
- * 4. init connect option @see _mqtt_client_connect_option_init
- * 5. init network @see _mqtt_client_network_init
+ * 3. init buffer @see _mqtt_client_buf_init
+ * 4. init list @see _mqtt_client_list_init
+ * 5. init connect option @see _mqtt_client_connect_option_init
+ * 6. init network @see _mqtt_client_network_init
  */
 static int _qcloud_iot_mqtt_client_init(QcloudIotClient *client, const MQTTInitParams *params)
 {
@@ -225,12 +306,14 @@ static int _qcloud_iot_mqtt_client_init(QcloudIotClient *client, const MQTTInitP
             : (params->command_timeout > MAX_COMMAND_TIMEOUT ? MAX_COMMAND_TIMEOUT : params->command_timeout);
 
     // packet id, random from [1 - 65536]
-    client->next_packet_id      = _get_random_start_packet_id();
-    client->write_buf_size      = QCLOUD_IOT_MQTT_TX_BUF_LEN;
-    client->read_buf_size       = QCLOUD_IOT_MQTT_RX_BUF_LEN;
-    client->event_handle        = params->event_handle;
-    client->auto_connect_enable = params->auto_connect_enable;
-    client->default_subscribe   = params->default_subscribe;
+    client->next_packet_id         = _get_random_start_packet_id();
+    client->event_handle           = params->event_handle;
+    client->auto_connect_enable    = params->auto_connect_enable;
+    client->default_subscribe      = params->default_subscribe;
+    client->standby_connect_enable = params->standby_connect_enable;
+#ifdef MULTITHREAD_ENABLED
+    client->io_thread_enable = params->io_thread_enable;
+#endif
 
     client->lock_generic = HAL_MutexCreate();
     if (!client->lock_generic) {
@@ -242,7 +325,12 @@ static int _qcloud_iot_mqtt_client_init(QcloudIotClient *client, const MQTTInitP
         goto error;
     }
 
-    rc = _mqtt_client_list_init(client);
+    rc = _mqtt_client_buf_init(client, params);
+    if (rc) {
+        goto error;
+    }
+
+    rc = _mqtt_client_list_init(client, params);
     if (rc) {
         goto error;
     }
@@ -260,6 +348,7 @@ error:
     client->lock_generic = NULL;
     HAL_MutexDestroy(client->lock_write_buf);
     client->lock_write_buf = NULL;
+    _mqtt_client_buf_deinit(client);
     IOT_FUNC_EXIT_RC(QCLOUD_ERR_FAILURE);
 }
 
@@ -274,10 +363,14 @@ static void _qcloud_iot_mqtt_client_deinit(QcloudIotClient *client)
     HAL_Free(client->options.password);
     HAL_MutexDestroy(client->lock_generic);
     HAL_MutexDestroy(client->lock_write_buf);
-    qcloud_iot_mqtt_sub_handle_array_clear(client);
+    qcloud_iot_mqtt_sub_handle_clear(client);
     qcloud_iot_mqtt_suback_wait_list_clear(client);
-    utils_list_destroy(client->list_pub_wait_ack);
+    qcloud_iot_mqtt_pub_wait_table_deinit(client);
     utils_list_destroy(client->list_sub_wait_ack);
+    _mqtt_client_buf_deinit(client);
+#ifndef AUTH_WITH_NO_TLS
+    qcloud_iot_tls_client_session_free(&client->network_stack.ssl_connect_params);
+#endif
     Log_i("release mqtt client resources");
 }
 
@@ -332,6 +425,15 @@ void *IOT_MQTT_Construct(const MQTTInitParams *params)
     }
 
     Log_i("mqtt connect with id: %s success", client->conn_id);
+
+#ifdef MULTITHREAD_ENABLED
+    rc = qcloud_iot_mqtt_io_thread_start(client);
+    if (rc) {
+        Log_e("mqtt io thread start failed: %d", rc);
+        qcloud_iot_mqtt_disconnect(client);
+        goto exit;
+    }
+#endif
     return client;
 exit:
     _qcloud_iot_mqtt_client_deinit(client);
@@ -348,10 +450,26 @@ exit:
 int IOT_MQTT_Connect(void *client)
 {
     POINTER_SANITY_CHECK(client, QCLOUD_ERR_INVAL);
+
+    int rc = QCLOUD_RET_SUCCESS;
+#ifdef MULTITHREAD_ENABLED
+    QcloudIotClient *mqtt_client = (QcloudIotClient *)client;
+    // io thread owns the connection once started, and reconnects by itself
+    if (mqtt_client->io_thread) {
+        IOT_FUNC_EXIT_RC(get_client_conn_state(client) ? QCLOUD_RET_SUCCESS : QCLOUD_ERR_MQTT_ATTEMPTING_RECONNECT);
+    }
+#endif
+
     if (!get_client_conn_state(client)) {
-        IOT_FUNC_EXIT_RC(qcloud_iot_mqtt_connect(client));
+        rc = qcloud_iot_mqtt_connect(client);
     }
-    IOT_FUNC_EXIT_RC(QCLOUD_RET_SUCCESS);
+
+#ifdef MULTITHREAD_ENABLED
+    if (!rc) {
+        rc = qcloud_iot_mqtt_io_thread_start(mqtt_client);
+    }
+#endif
+    IOT_FUNC_EXIT_RC(rc);
 }
 
 /**
@@ -366,6 +484,10 @@ int IOT_MQTT_Destroy(void **client)
 
     QcloudIotClient *mqtt_client = (QcloudIotClient *)(*client);
 
+#ifdef MULTITHREAD_ENABLED
+    qcloud_iot_mqtt_io_thread_stop(mqtt_client);
+#endif
+
     int rc = qcloud_iot_mqtt_disconnect(mqtt_client);
     if (rc) {
         // disconnect network stack by force
@@ -373,6 +495,10 @@ int IOT_MQTT_Destroy(void **client)
         set_client_conn_state(mqtt_client, NOTCONNECTED);
     }
 
+    if (mqtt_client->standby_connect_enable) {
+        mqtt_client->network_stack.prewarm(&(mqtt_client->network_stack), 0);
+    }
+
     _qcloud_iot_mqtt_client_deinit(mqtt_client);
 
     HAL_Free(*client);
@@ -393,9 +519,27 @@ int IOT_MQTT_Yield(void *client, uint32_t timeout_ms)
 {
     POINTER_SANITY_CHECK(client, QCLOUD_ERR_INVAL);
     QcloudIotClient *mqtt_client = (QcloudIotClient *)client;
+#ifdef MULTITHREAD_ENABLED
+    if (mqtt_client->io_thread) {
+        return qcloud_iot_mqtt_io_thread_wait(mqtt_client, timeout_ms);
+    }
+#endif
     return qcloud_iot_mqtt_yield(mqtt_client, timeout_ms);
 }
 
+/**
+ * @brief Write publish packets pending in batch buffer to network immediately.
+ *
+ * @param[in,out] client pointer to mqtt client
+ * @return @see IotReturnCode
+ */
+int IOT_MQTT_Flush(void *client)
+{
+    POINTER_SANITY_CHECK(client, QCLOUD_ERR_INVAL);
+    QcloudIotClient *mqtt_client = (QcloudIotClient *)client;
+    return flush_mqtt_pub_batch(mqtt_client, false);
+}
+
 /**
  * @brief Publish MQTT message.
  *
@@ -428,6 +572,39 @@ int IOT_MQTT_Publish(void *client, const char *topic_name, const PublishParams *
     return qcloud_iot_mqtt_publish(mqtt_client, topic_name, params);
 }
 
+#ifdef MULTITHREAD_ENABLED
+/**
+ * @brief Submit MQTT message to io thread and return without waiting for network.
+ *
+ * @param[in,out] client pointer to mqtt client
+ * @param[in] topic_name topic to publish
+ * @param[in] params @see PublishParams
+ * @param[in] on_complete callback in io thread when sent or failed, NULL for none
+ * @param[in] usr_data user data of on_complete
+ * @return @see IotReturnCode
+ */
+int IOT_MQTT_PublishAsync(void *client, const char *topic_name, const PublishParams *params,
+                          OnPublishCompleteHandler on_complete, void *usr_data)
+{
+    POINTER_SANITY_CHECK(client, QCLOUD_ERR_INVAL);
+    POINTER_SANITY_CHECK(params, QCLOUD_ERR_INVAL);
+    STRING_PTR_SANITY_CHECK(topic_name, QCLOUD_ERR_INVAL);
+
+    QcloudIotClient *mqtt_client = (QcloudIotClient *)client;
+
+    if (strlen(topic_name) > MAX_SIZE_OF_CLOUD_TOPIC) {
+        IOT_FUNC_EXIT_RC(QCLOUD_ERR_MAX_TOPIC_LENGTH);
+    }
+
+    if (QOS2 == params->qos) {
+        Log_e("QoS2 is not supported currently");
+        IOT_FUNC_EXIT_RC(QCLOUD_ERR_MQTT_QOS_NOT_SUPPORT);
+    }
+
+    return qcloud_iot_mqtt_publish_async(mqtt_client, topic_name, params, on_complete, usr_data);
+}
+#endif
+
 /**
  * @brief Subscribe MQTT topic.
  *
@@ -532,12 +709,11 @@ int IOT_MQTT_SubscribeSync(void *client, const char *topic_filter, const Subscri
     POINTER_SANITY_CHECK(params, QCLOUD_ERR_INVAL);
     STRING_PTR_SANITY_CHECK(topic_filter, QCLOUD_ERR_INVAL);
 
-    int rc;
+    int   rc;
+    Timer timer;
 
     QcloudIotClient *mqtt_client = (QcloudIotClient *)client;
 
-    int cnt_sub = mqtt_client->command_timeout_ms / QCLOUD_IOT_MQTT_YIELD_TIMEOUT;
-
     if (IOT_MQTT_IsSubReady(client, topic_filter)) {
         // if already sub, free the user data
         if (params->user_data_free) {
@@ -548,11 +724,13 @@ int IOT_MQTT_SubscribeSync(void *client, const char *topic_filter, const Subscri
 
     rc = IOT_MQTT_Subscribe(client, topic_filter, params);
     if (rc < 0) {
-        Log_e("topic subscribe failed: %d, cnt: %d", rc, cnt_sub);
+        Log_e("topic subscribe failed: %d", rc);
         return rc;
     }
 
-    while (cnt_sub-- >= 0 && rc >= 0 && !IOT_MQTT_IsSubReady(client, topic_filter)) {
+    // yield returns as soon as packets handled in io thread mode, so wait by timer instead of yield count
+    HAL_Timer_CountdownMs(&timer, mqtt_client->command_timeout_ms + QCLOUD_IOT_MQTT_YIELD_TIMEOUT);
+    while (!HAL_Timer_Expired(&timer) && rc >= 0 && !IOT_MQTT_IsSubReady(client, topic_filter)) {
         /**
          * @brief wait for subscription result
          *
@@ -576,6 +754,38 @@ bool IOT_MQTT_IsConnected(void *client)
     return get_client_conn_state(mqtt_client);
 }
 
+/**
+ * @brief Get statistics of QoS1 publish.
+ *
+ * @param[in,out] client pointer to mqtt client
+ * @param[out] stats @see MQTTPubStatistics
+ * @return @see IotReturnCode
+ */
+int IOT_MQTT_GetPubStatistics(void *client, MQTTPubStatistics *stats)
+{
+    POINTER_SANITY_CHECK(client, QCLOUD_ERR_INVAL);
+    POINTER_SANITY_CHECK(stats, QCLOUD_ERR_INVAL);
+    QcloudIotClient *mqtt_client = (QcloudIotClient *)client;
+    qcloud_iot_mqtt_get_pub_statistics(mqtt_client, stats);
+    return QCLOUD_RET_SUCCESS;
+}
+
+/**
+ * @brief Get statistics of keep alive.
+ *
+ * @param[in,out] client pointer to mqtt client
+ * @param[out] stats @see MQTTKeepAliveStatistics
+ * @return @see IotReturnCode
+ */
+int IOT_MQTT_GetKeepAliveStatistics(void *client, MQTTKeepAliveStatistics *stats)
+{
+    POINTER_SANITY_CHECK(client, QCLOUD_ERR_INVAL);
+    POINTER_SANITY_CHECK(stats, QCLOUD_ERR_INVAL);
+    QcloudIotClient *mqtt_client = (QcloudIotClient *)client;
+    qcloud_iot_mqtt_get_keep_alive_statistics(mqtt_client, stats);
+    return QCLOUD_RET_SUCCESS;
+}
+
 /**
  * @brief Get device info using to connect mqtt server.
  *
@@ -0,0 +1,414 @@
+/**
+ * @copyright
+ *
+ * Tencent is pleased to support the open source community by making IoT Hub available.
+ * Copyright(C) 2018 - 2021 THL A29 Limited, a Tencent company.All rights reserved.
+ *
+ * Licensed under the MIT License(the "License"); you may not use this file except in
+ * compliance with the License. You may obtain a copy of the License at
+ * http://opensource.org/licenses/MIT
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed under the License is
+ * distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @file mqtt_client_async.c
+ * @brief background io thread of mqtt client and publish submitted by other threads
+ * @author fancyxu (fancyxu@tencent.com)
+ * @version 1.0
+ * @date 2026-10-16
+ *
+ * @par Change Log:
+ * <table>
+ * <tr><th>Date       <th>Version <th>Author    <th>Description
+ * <tr><td>2026-10-16 <td>1.0     <td>fancyxu   <td>first commit
+ * </table>
+ */
+
+#include "mqtt_client.h"
+
+#ifdef MULTITHREAD_ENABLED
+
+/**
+ * @brief Interval to check ack timeout, keep alive and reconnect in io thread (unit: ms)
+ *
+ */
+#define MQTT_IO_THREAD_TICK_MS (100)
+
+/**
+ * @brief Stack size of io thread
+ *
+ */
+#define MQTT_IO_THREAD_STACK_SIZE (8192)
+
+/**
+ * @brief Publish submitted to io thread, topic and payload copied are saved right after it.
+ *
+ */
+typedef struct MQTTAsyncRequest {
+    struct MQTTAsyncRequest *next;
+    char                    *topic_name;
+    PublishParams            params;
+    OnPublishCompleteHandler on_complete;
+    void                    *usr_data;
+} MQTTAsyncRequest;
+
+/**
+ * @brief Io thread, publish is submitted by many threads and consumed by io thread through intrusive mpsc queue, in
+ * which producer only exchanges tail and links the old one, so no lock is needed.
+ *
+ */
+typedef struct {
+    QcloudIotClient  *client;
+    ThreadParams      thread_params;
+    void             *poller;
+    int               fd;           /**< socket fd added to poller, -1 for none */
+    int               running;      /**< cleared to stop io thread */
+    int               wake_pending; /**< io thread is woken up and not handled submit queue yet */
+    int               waiter_num;   /**< number of threads waiting in yield */
+    void             *wait_sem;     /**< posted for threads waiting in yield when packets are handled */
+    void             *exit_sem;     /**< posted when io thread exits */
+    MQTTAsyncRequest *head;         /**< consumed by io thread */
+    MQTTAsyncRequest *tail;         /**< exchanged by producers */
+    MQTTAsyncRequest  stub;         /**< node to keep queue never empty */
+} MQTTIoThread;
+
+/**
+ * @brief Push request to submit queue, called by any thread.
+ *
+ * @param[in,out] io pointer to io thread
+ * @param[in,out] request request to push
+ */
+static void _submit_queue_push(MQTTIoThread *io, MQTTAsyncRequest *request)
+{
+    MQTTAsyncRequest *prev;
+
+    request->next = NULL;
+    prev          = __atomic_exchange_n(&io->tail, request, __ATOMIC_ACQ_REL);
+    // consumer can not see request until linked, and stops at prev until then
+    __atomic_store_n(&prev->next, request, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Pop request from submit queue, only called by io thread.
+ *
+ * @param[in,out] io pointer to io thread
+ * @return request, NULL if queue is empty or request pushed is not linked yet
+ */
+static MQTTAsyncRequest *_submit_queue_pop(MQTTIoThread *io)
+{
+    MQTTAsyncRequest *head = io->head;
+    MQTTAsyncRequest *next = __atomic_load_n(&head->next, __ATOMIC_ACQUIRE);
+
+    if (head == &io->stub) {
+        if (!next) {
+            return NULL;
+        }
+        io->head = next;
+        head     = next;
+        next     = __atomic_load_n(&head->next, __ATOMIC_ACQUIRE);
+    }
+
+    if (next) {
+        io->head = next;
+        return head;
+    }
+
+    // head is the last one, push stub back to take it out
+    if (head != __atomic_load_n(&io->tail, __ATOMIC_ACQUIRE)) {
+        return NULL;
+    }
+
+    _submit_queue_push(io, &io->stub);
+    next = __atomic_load_n(&head->next, __ATOMIC_ACQUIRE);
+    if (next) {
+        io->head = next;
+        return head;
+    }
+    return NULL;
+}
+
+/**
+ * @brief Notify result of request and free it.
+ *
+ * @param[in,out] client pointer to mqtt client
+ * @param[in,out] request request handled
+ * @param[in] result packet id (>=0) when sent, or err code (<0) @see IotReturnCode
+ */
+static void _io_thread_complete(QcloudIotClient *client, MQTTAsyncRequest *request, int result)
+{
+    // payload referenced is released by puback for qos1, or when sent for qos0
+    if (result >= 0 && request->params.qos == QOS0 && request->params.payload_release) {
+        request->params.payload_release(request->params.payload, request->params.release_usr_data);
+    }
+
+    if (request->on_complete) {
+        request->on_complete(client, result, request->usr_data);
+    }
+    HAL_Free(request);
+}
+
+/**
+ * @brief Publish requests submitted, write buffer is only contended by threads publishing synchronously.
+ *
+ * @param[in,out] io pointer to io thread
+ */
+static void _io_thread_publish(MQTTIoThread *io)
+{
+    int               rc;
+    MQTTAsyncRequest *request;
+
+    // cleared before consuming, so request pushed later wakes up io thread again
+    __atomic_store_n(&io->wake_pending, 0, __ATOMIC_SEQ_CST);
+
+    while ((request = _submit_queue_pop(io))) {
+        rc = get_client_conn_state(io->client) ? qcloud_iot_mqtt_publish(io->client, request->topic_name, &request->params)
+                                               : QCLOUD_ERR_MQTT_NO_CONN;
+        _io_thread_complete(io->client, request, rc);
+    }
+}
+
+/**
+ * @brief Sync socket in poller with connection of client, which is closed by disconnect or changed by reconnect.
+ *
+ * @param[in,out] io pointer to io thread
+ */
+static void _io_thread_update_fd(MQTTIoThread *io)
+{
+    IotNetwork *network = &io->client->network_stack;
+
+    int fd = get_client_conn_state(io->client) ? network->get_fd(network) : -1;
+    if (fd == io->fd) {
+        return;
+    }
+
+    // socket closed is removed from poller already
+    if (io->fd >= 0) {
+        HAL_Poller_Del(io->poller, io->fd);
+    }
+    io->fd = fd >= 0 && !HAL_Poller_Add(io->poller, fd, io) ? fd : -1;
+}
+
+/**
+ * @brief Io thread entry, read/handle packets as soon as socket readable, publish requests as soon as submitted, and
+ * check ack timeout, keep alive and reconnect every MQTT_IO_THREAD_TICK_MS.
+ *
+ * @param[in,out] arg pointer to io thread
+ */
+static void _io_thread_run(void *arg)
+{
+    MQTTIoThread    *io     = (MQTTIoThread *)arg;
+    QcloudIotClient *client = io->client;
+    IotNetwork      *network;
+    void            *ready[1];
+    int              rc, waiter_num;
+    uint32_t         wait_ms, batch_remain_ms;
+    Timer            tick_timer;
+
+    network = &client->network_stack;
+    while (__atomic_load_n(&io->running, __ATOMIC_ACQUIRE)) {
+        _io_thread_update_fd(io);
+
+        // 1. wait for readable socket, submitted publish, tick or deadline of publish batch
+        HAL_Timer_CountdownMs(&tick_timer, MQTT_IO_THREAD_TICK_MS);
+        batch_remain_ms = get_mqtt_pub_batch_remain_ms(client);
+        wait_ms         = batch_remain_ms < MQTT_IO_THREAD_TICK_MS ? batch_remain_ms : MQTT_IO_THREAD_TICK_MS;
+        wait_ms         = io->fd >= 0 && network->get_bytes_avail(network) ? 0 : wait_ms;
+
+        rc = HAL_Poller_Wait(io->poller, ready, 1, wait_ms);
+
+        // 2. publish before read, so puback is read in the same round if it arrives in time
+        _io_thread_publish(io);
+
+        // 3. read/handle packets, then check ack timeout, keep alive and reconnect
+        qcloud_iot_mqtt_yield_ready(client, rc > 0);
+
+        // 4. wake up threads waiting in yield for results of packets handled
+        if (rc > 0) {
+            waiter_num = __atomic_load_n(&io->waiter_num, __ATOMIC_ACQUIRE);
+            while (waiter_num-- > 0) {
+                HAL_SemaphorePost(io->wait_sem);
+            }
+        }
+    }
+
+    HAL_SemaphorePost(io->exit_sem);
+}
+
+/**
+ * @brief Free io thread.
+ *
+ * @param[in,out] io pointer to io thread
+ */
+static void _io_thread_free(MQTTIoThread *io)
+{
+    if (io->poller) {
+        HAL_Poller_Destroy(io->poller);
+    }
+    if (io->wait_sem) {
+        HAL_SemaphoreDestroy(io->wait_sem);
+    }
+    if (io->exit_sem) {
+        HAL_SemaphoreDestroy(io->exit_sem);
+    }
+    HAL_Free(io);
+}
+
+/**
+ * @brief Start io thread if io_thread_enable, which owns socket reads, keep alive, ack timeout and reconnect.
+ *
+ * @param[in,out] client pointer to mqtt client
+ * @return @see IotReturnCode
+ */
+int qcloud_iot_mqtt_io_thread_start(QcloudIotClient *client)
+{
+    int rc;
+
+    if (!client->io_thread_enable || client->io_thread) {
+        return QCLOUD_RET_SUCCESS;
+    }
+
+    MQTTIoThread *io = HAL_Malloc(sizeof(MQTTIoThread));
+    if (!io) {
+        return QCLOUD_ERR_MALLOC;
+    }
+    memset(io, 0, sizeof(MQTTIoThread));
+
+    io->client  = client;
+    io->fd      = -1;
+    io->running = 1;
+    io->head    = &io->stub;
+    io->tail    = &io->stub;
+
+    io->poller   = HAL_Poller_Create();
+    io->wait_sem = HAL_SemaphoreCreate();
+    io->exit_sem = HAL_SemaphoreCreate();
+    if (!io->poller || !io->wait_sem || !io->exit_sem) {
+        _io_thread_free(io);
+        return QCLOUD_ERR_FAILURE;
+    }
+
+    io->thread_params.thread_name = "mqtt_io";
+    io->thread_params.thread_func = _io_thread_run;
+    io->thread_params.user_arg    = io;
+    io->thread_params.stack_size  = MQTT_IO_THREAD_STACK_SIZE;
+
+    // set before thread runs, for api called in callbacks of io thread
+    client->io_thread = io;
+
+    rc = HAL_ThreadCreate(&io->thread_params);
+    if (rc) {
+        Log_e("create mqtt io thread failed: %d", rc);
+        client->io_thread = NULL;
+        _io_thread_free(io);
+        return rc;
+    }
+    return QCLOUD_RET_SUCCESS;
+}
+
+/**
+ * @brief Stop io thread and wait for it to exit, publish not handled is completed with QCLOUD_ERR_MQTT_NO_CONN.
+ *
+ * @param[in,out] client pointer to mqtt client
+ */
+void qcloud_iot_mqtt_io_thread_stop(QcloudIotClient *client)
+{
+    MQTTIoThread     *io = (MQTTIoThread *)client->io_thread;
+    MQTTAsyncRequest *request;
+
+    if (!io) {
+        return;
+    }
+
+    __atomic_store_n(&io->running, 0, __ATOMIC_RELEASE);
+    HAL_Poller_Wakeup(io->poller);
+    // io thread may be connecting, wait until it really exits
+    while (HAL_SemaphoreWait(io->exit_sem, MQTT_IO_THREAD_TICK_MS)) {
+        HAL_Poller_Wakeup(io->poller);
+    }
+
+    while ((request = _submit_queue_pop(io))) {
+        _io_thread_complete(client, request, QCLOUD_ERR_MQTT_NO_CONN);
+    }
+
+    if (io->fd >= 0) {
+        HAL_Poller_Del(io->poller, io->fd);
+    }
+    client->io_thread = NULL;
+    _io_thread_free(io);
+}
+
+/**
+ * @brief Wait for packets handled by io thread, instead of reading socket in yield.
+ *
+ * @param[in,out] client pointer to mqtt client
+ * @param[in] timeout_ms timeout value (unit: ms) for this operation
+ * @return QCLOUD_RET_SUCCESS when connected, QCLOUD_ERR_MQTT_ATTEMPTING_RECONNECT when try reconnecting, others @see
+ * IotReturnCode
+ */
+int qcloud_iot_mqtt_io_thread_wait(QcloudIotClient *client, uint32_t timeout_ms)
+{
+    MQTTIoThread *io = (MQTTIoThread *)client->io_thread;
+
+    __atomic_add_fetch(&io->waiter_num, 1, __ATOMIC_ACQ_REL);
+    HAL_SemaphoreWait(io->wait_sem, timeout_ms);
+    __atomic_sub_fetch(&io->waiter_num, 1, __ATOMIC_ACQ_REL);
+
+    if (get_client_conn_state(client)) {
+        return QCLOUD_RET_SUCCESS;
+    }
+
+    if (client->was_manually_disconnected) {
+        return QCLOUD_RET_MQTT_MANUALLY_DISCONNECTED;
+    }
+    return client->auto_connect_enable ? QCLOUD_ERR_MQTT_ATTEMPTING_RECONNECT : QCLOUD_ERR_MQTT_NO_CONN;
+}
+
+/**
+ * @brief Submit publish to io thread, io thread is woken up only if it is not handling submitted publish.
+ *
+ * @param[in,out] client pointer to mqtt client
+ * @param[in] topic_name topic to publish
+ * @param[in] params publish params
+ * @param[in] on_complete callback when sent or failed, NULL for none
+ * @param[in] usr_data user data of on_complete
+ * @return @see IotReturnCode
+ */
+int qcloud_iot_mqtt_publish_async(QcloudIotClient *client, const char *topic_name, const PublishParams *params,
+                                  OnPublishCompleteHandler on_complete, void *usr_data)
+{
+    MQTTIoThread     *io = (MQTTIoThread *)client->io_thread;
+    MQTTAsyncRequest *request;
+    size_t            topic_len, payload_len;
+
+    if (!io) {
+        return QCLOUD_ERR_MQTT_NO_CONN;
+    }
+
+    topic_len   = strlen(topic_name) + 1;
+    payload_len = params->payload_release ? 0 : params->payload_len;
+
+    request = HAL_Malloc(sizeof(MQTTAsyncRequest) + topic_len + payload_len);
+    if (!request) {
+        return QCLOUD_ERR_MALLOC;
+    }
+
+    request->topic_name  = (char *)(request + 1);
+    request->params      = *params;
+    request->on_complete = on_complete;
+    request->usr_data    = usr_data;
+    memcpy(request->topic_name, topic_name, topic_len);
+    if (!params->payload_release) {
+        request->params.payload = request->topic_name + topic_len;
+        memcpy(request->params.payload, params->payload, payload_len);
+    }
+
+    _submit_queue_push(io, request);
+    if (!__atomic_exchange_n(&io->wake_pending, 1, __ATOMIC_SEQ_CST)) {
+        HAL_Poller_Wakeup(io->poller);
+    }
+    return QCLOUD_RET_SUCCESS;
+}
+
+#endif
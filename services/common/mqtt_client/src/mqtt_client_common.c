@@ -113,18 +113,242 @@ uint8_t get_client_conn_state(QcloudIotClient *client)
  */
 int send_mqtt_packet(QcloudIotClient *client, size_t length)
 {
-    IOT_FUNC_ENTRY;
+    return send_mqtt_packet_with_payload(client, length, NULL, 0);
+}
 
-    int rc = QCLOUD_RET_SUCCESS;
+/**
+ * @brief Send mqtt packet with payload not copied into write_buf, using vectored write, timeout = command_timeout_ms.
+ *
+ * @param[in,out] client pointer to mqtt client
+ * @param[in] length length of packet header saved in client write_buf
+ * @param[in] payload payload sent right after the header
+ * @param[in] payload_len length of payload
+ * @return @see IotReturnCode
+ * @note pending publish batch is written first to keep packets in order.
+ */
+int send_mqtt_packet_with_payload(QcloudIotClient *client, size_t length, const void *payload, size_t payload_len)
+{
+    IOT_FUNC_ENTRY;
 
-    size_t sent_len = 0;
+    int      rc       = QCLOUD_RET_SUCCESS;
+    size_t   sent_len = 0;
+    IotIoVec iov[2]   = {{client->write_buf, length}, {payload, payload_len}};
 
     if (length >= client->write_buf_size) {
         IOT_FUNC_EXIT_RC(QCLOUD_ERR_BUF_TOO_SHORT);
     }
 
-    rc = client->network_stack.write(&(client->network_stack), client->write_buf, length, client->command_timeout_ms,
-                                     &sent_len);
+    rc = send_mqtt_pub_batch(client);
+    if (rc) {
+        IOT_FUNC_EXIT_RC(rc);
+    }
+
+    rc = payload_len ? client->network_stack.writev(&(client->network_stack), iov, 2, client->command_timeout_ms,
+                                                    &sent_len)
+                     : client->network_stack.write(&(client->network_stack), client->write_buf, length,
+                                                   client->command_timeout_ms, &sent_len);
+    if (!rc) {
+        update_mqtt_send_time(client);
+    }
     rc = QCLOUD_ERR_TCP_WRITE_TIMEOUT == rc ? QCLOUD_ERR_MQTT_REQUEST_TIMEOUT : rc;
     IOT_FUNC_EXIT_RC(rc);
 }
+
+/**
+ * @brief Record time of packet sent successfully, outbound traffic counts as keep alive.
+ *
+ * @param[in,out] client pointer to mqtt client
+ */
+void update_mqtt_send_time(QcloudIotClient *client)
+{
+    // written by threads sending packets, read by keep alive without lock
+    __atomic_store_n(&client->last_send_ms, HAL_Timer_CurrentMs(), __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Resize buffer allocated by sdk.
+ *
+ * @param[in,out] buf pointer to buffer
+ * @param[in,out] size pointer to buffer size
+ * @param[in] new_size new size of buffer
+ * @param[in] keep_content copy the content to new buffer or not
+ * @return @see IotReturnCode
+ */
+static int _resize_mqtt_buf(uint8_t **buf, size_t *size, size_t new_size, bool keep_content)
+{
+    uint8_t *new_buf = HAL_Malloc(new_size);
+    if (!new_buf) {
+        return QCLOUD_ERR_MALLOC;
+    }
+
+    if (keep_content) {
+        memcpy(new_buf, *buf, *size < new_size ? *size : new_size);
+    }
+    HAL_Free(*buf);
+    *buf  = new_buf;
+    *size = new_size;
+    return QCLOUD_RET_SUCCESS;
+}
+
+/**
+ * @brief Grow buffer to be larger than length, size doubles until reaching buf_max_size.
+ *
+ * @param[in,out] client pointer to mqtt client
+ * @param[in,out] buf pointer to buffer
+ * @param[in,out] size pointer to buffer size
+ * @param[in] init_size initial size of buffer
+ * @param[in] is_external buffer is provided by user or not
+ * @param[in] length length to reserve
+ * @param[in] keep_content copy the content to new buffer or not
+ * @return @see IotReturnCode
+ */
+static int _reserve_mqtt_buf(QcloudIotClient *client, uint8_t **buf, size_t *size, size_t init_size,
+                             uint8_t is_external, size_t length, bool keep_content)
+{
+    size_t new_size = *size;
+
+    if (length >= init_size) {
+        client->buf_busy_time_ms = HAL_Timer_CurrentMs();
+    }
+
+    if (length < *size) {
+        return QCLOUD_RET_SUCCESS;
+    }
+
+    if (is_external || length >= client->buf_max_size) {
+        return QCLOUD_ERR_BUF_TOO_SHORT;
+    }
+
+    while (new_size <= length) {
+        new_size <<= 1;
+    }
+    new_size = new_size > client->buf_max_size ? client->buf_max_size : new_size;
+    return _resize_mqtt_buf(buf, size, new_size, keep_content);
+}
+
+/**
+ * @brief Make write buffer larger than length, grow on demand if not provided by user. Should be called with
+ * lock_write_buf locked, and content of write buffer is not kept.
+ *
+ * @param[in,out] client pointer to mqtt client
+ * @param[in] length length of packet to be serialized
+ * @return @see IotReturnCode
+ */
+int reserve_mqtt_write_buf(QcloudIotClient *client, size_t length)
+{
+    return _reserve_mqtt_buf(client, &client->write_buf, &client->write_buf_size, client->write_buf_init_size,
+                             client->is_write_buf_external, length, false);
+}
+
+/**
+ * @brief Make read buffer larger than length, grow on demand if not provided by user. Content of read buffer is kept.
+ *
+ * @param[in,out] client pointer to mqtt client
+ * @param[in] length length of packet to be read
+ * @return @see IotReturnCode
+ */
+int reserve_mqtt_read_buf(QcloudIotClient *client, size_t length)
+{
+    return _reserve_mqtt_buf(client, &client->read_buf, &client->read_buf_size, client->read_buf_init_size,
+                             client->is_read_buf_external, length, true);
+}
+
+/**
+ * @brief Shrink buffers grown on demand back to initial size, if idle for MQTT_BUF_SHRINK_IDLE_MS.
+ *
+ * @param[in,out] client pointer to mqtt client
+ */
+void shrink_mqtt_buf(QcloudIotClient *client)
+{
+    if (client->write_buf_size == client->write_buf_init_size && client->read_buf_size == client->read_buf_init_size) {
+        return;
+    }
+
+    if (HAL_Timer_CurrentMs() - client->buf_busy_time_ms < MQTT_BUF_SHRINK_IDLE_MS) {
+        return;
+    }
+
+    // read buffer is only used in yield, so only write buffer needs lock
+    if (client->read_buf_size > client->read_buf_init_size) {
+        _resize_mqtt_buf(&client->read_buf, &client->read_buf_size, client->read_buf_init_size, false);
+    }
+
+    HAL_MutexLock(client->lock_write_buf);
+    if (client->write_buf_size > client->write_buf_init_size) {
+        _resize_mqtt_buf(&client->write_buf, &client->write_buf_size, client->write_buf_init_size, false);
+    }
+    HAL_MutexUnlock(client->lock_write_buf);
+}
+
+/**
+ * @brief Write publish packets pending in batch buffer to network. Should be called with lock_write_buf locked.
+ *
+ * @param[in,out] client pointer to mqtt client
+ * @return @see IotReturnCode
+ */
+int send_mqtt_pub_batch(QcloudIotClient *client)
+{
+    IOT_FUNC_ENTRY;
+
+    int    rc       = QCLOUD_RET_SUCCESS;
+    size_t sent_len = 0;
+
+    if (!client->pub_batch_len) {
+        IOT_FUNC_EXIT_RC(QCLOUD_RET_SUCCESS);
+    }
+
+    rc = client->network_stack.write(&(client->network_stack), client->pub_batch_buf, client->pub_batch_len,
+                                     client->command_timeout_ms, &sent_len);
+    if (!rc) {
+        update_mqtt_send_time(client);
+    }
+    // batch is dropped even if write failed, qos1 publish is republished from pub wait table
+    client->pub_batch_len = 0;
+    rc                    = QCLOUD_ERR_TCP_WRITE_TIMEOUT == rc ? QCLOUD_ERR_MQTT_REQUEST_TIMEOUT : rc;
+    IOT_FUNC_EXIT_RC(rc);
+}
+
+/**
+ * @brief Lock write buffer and write pending publish packets to network.
+ *
+ * @param[in,out] client pointer to mqtt client
+ * @param[in] expired_only only flush when deadline of batch passes
+ * @return @see IotReturnCode
+ */
+int flush_mqtt_pub_batch(QcloudIotClient *client, bool expired_only)
+{
+    int rc = QCLOUD_RET_SUCCESS;
+
+    if (!client->pub_batch_buf) {
+        return QCLOUD_RET_SUCCESS;
+    }
+
+    HAL_MutexLock(client->lock_write_buf);
+    if (!expired_only || HAL_Timer_Expired(&client->pub_batch_timer)) {
+        rc = send_mqtt_pub_batch(client);
+    }
+    HAL_MutexUnlock(client->lock_write_buf);
+    return rc;
+}
+
+/**
+ * @brief Get time left before publish batch should be flushed.
+ *
+ * @param[in,out] client pointer to mqtt client
+ * @return time left (unit: ms), UINT32_MAX if no packet pending
+ */
+uint32_t get_mqtt_pub_batch_remain_ms(QcloudIotClient *client)
+{
+    uint32_t remain_ms = UINT32_MAX;
+
+    if (!client->pub_batch_buf) {
+        return UINT32_MAX;
+    }
+
+    HAL_MutexLock(client->lock_write_buf);
+    if (client->pub_batch_len) {
+        remain_ms = HAL_Timer_Remain(&client->pub_batch_timer);
+    }
+    HAL_MutexUnlock(client->lock_write_buf);
+    return remain_ms;
+}
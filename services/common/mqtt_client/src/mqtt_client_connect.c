@@ -49,6 +49,16 @@ static int _mqtt_connect(QcloudIotClient *client)
 
     // send MQTT CONNECT packet
     HAL_MutexLock(client->lock_write_buf);
+    // drop publish batch of last connection, qos1 publish is republished from pub wait table
+    client->pub_batch_len = 0;
+    // fixed header, variable header and client id, username, password with 2 bytes length
+    rc = reserve_mqtt_write_buf(client, MAX_MQTT_FIXED_HEADER_LEN + 10 + 2 + strlen(client->options.client_id) + 2 +
+                                            strlen(client->options.username) + 2 +
+                                            (client->options.password ? strlen(client->options.password) : 0));
+    if (rc) {
+        HAL_MutexUnlock(client->lock_write_buf);
+        IOT_FUNC_EXIT_RC(rc);
+    }
     packet_len = mqtt_connect_packet_serialize(client->write_buf, client->write_buf_size, &client->options);
     if (packet_len > 0) {
         rc = send_mqtt_packet(client, packet_len);
@@ -79,8 +89,10 @@ static int _mqtt_connect(QcloudIotClient *client)
     set_client_conn_state(client, CONNECTED);
 
     HAL_MutexLock(client->lock_generic);
+    client->session_present           = session_present;
     client->was_manually_disconnected = client->is_ping_outstanding = 0;
-    HAL_Timer_Countdown(&client->ping_timer, client->options.keep_alive_interval);
+    client->last_recv_ms              = HAL_Timer_CurrentMs();
+    HAL_Timer_CountdownMs(&client->ping_timer, client->ping_interval_ms);
     HAL_MutexUnlock(client->lock_generic);
     IOT_FUNC_EXIT_RC(rc);
 }
@@ -132,13 +144,18 @@ int qcloud_iot_mqtt_attempt_reconnect(QcloudIotClient *client)
         IOT_FUNC_EXIT_RC(rc);
     }
 
-#if 0  // clean session is 0, user don't need resubscribe only if mqtt server error.
-    if (!client->options.clean_session) {
-        IOT_FUNC_EXIT_RC(QCLOUD_RET_MQTT_RECONNECTED);
+    Log_i("reconnect success, session present: %d", client->session_present);
+
+    // clean session is 0 and session is kept by server, no need to resubscribe.
+    if (client->options.clean_session || !client->session_present) {
+        rc = qcloud_iot_mqtt_resubscribe(client);
+        if (rc) {
+            IOT_FUNC_EXIT_RC(rc);
+        }
     }
-#endif
 
-    rc = qcloud_iot_mqtt_resubscribe(client);
+    // resend the publish packets in flight, server will dedup by packet id when session resumed.
+    rc = qcloud_iot_mqtt_republish(client);
     if (rc) {
         IOT_FUNC_EXIT_RC(rc);
     }
@@ -0,0 +1,543 @@
+/**
+ * @copyright
+ *
+ * Tencent is pleased to support the open source community by making IoT Hub available.
+ * Copyright(C) 2018 - 2021 THL A29 Limited, a Tencent company.All rights reserved.
+ *
+ * Licensed under the MIT License(the "License"); you may not use this file except in
+ * compliance with the License. You may obtain a copy of the License at
+ * http://opensource.org/licenses/MIT
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed under the License is
+ * distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @file mqtt_client_loop.c
+ * @brief event loop driving many mqtt clients in one thread
+ * @author fancyxu (fancyxu@tencent.com)
+ * @version 1.0
+ * @date 2026-10-16
+ *
+ * @par Change Log:
+ * <table>
+ * <tr><th>Date       <th>Version <th>Author    <th>Description
+ * <tr><td>2026-10-16 <td>1.0     <td>fancyxu   <td>first commit
+ * </table>
+ */
+
+#include "mqtt_client.h"
+
+/**
+ * @brief Interval to check ack timeout, keep alive and reconnect of all clients in loop (unit: ms)
+ *
+ */
+#define MQTT_LOOP_TICK_MS (100)
+
+/**
+ * @brief Max readable sockets handled for one poller wait
+ *
+ */
+#define MQTT_LOOP_MAX_READY_NUM (64)
+
+#ifdef MULTITHREAD_ENABLED
+/**
+ * @brief Stack size of reconnect thread, which runs tls handshake
+ *
+ */
+#define MQTT_LOOP_RECONNECT_STACK_SIZE (8192)
+#endif
+
+/**
+ * @brief Client in event loop.
+ *
+ */
+typedef struct MQTTLoopEntry {
+    QcloudIotClient      *client;
+    int                   fd;             /**< socket fd added to poller, -1 for none */
+    int                   index;          /**< index in client array of loop */
+    int                   pending_index;  /**< index in pending array of loop, -1 for none */
+    int                   reconnecting;   /**< 1 queued, 2 reconnecting by reconnect thread, client not touched */
+    struct MQTTLoopEntry *reconnect_next; /**< next in reconnect queue */
+} MQTTLoopEntry;
+
+/**
+ * @brief Event loop, clients with data buffered by network are kept in pending array for poller can not see it.
+ * Reconnect blocks for tcp connect, tls handshake and connack, so it runs in reconnect thread if multithread enabled.
+ *
+ */
+typedef struct {
+    void *          poller;
+    MQTTLoopEntry **entries;
+    MQTTLoopEntry **pending;
+    int             entry_num;
+    int             entry_size;
+    int             pending_num;
+    Timer           tick_timer;
+#ifdef MULTITHREAD_ENABLED
+    ThreadParams    reconnect_thread;
+    void *          reconnect_lock; /**< lock of reconnect queue */
+    void *          reconnect_sem;  /**< posted when client queued or loop destroyed */
+    void *          exit_sem;       /**< posted when reconnect thread exits */
+    MQTTLoopEntry * reconnect_head; /**< reconnect queue */
+    MQTTLoopEntry * reconnect_tail; /**< reconnect queue */
+    int             running;        /**< cleared to stop reconnect thread */
+    int             reconnect_done; /**< clients reconnected, sockets should be added to poller */
+#endif
+} MQTTEventLoop;
+
+/**
+ * @brief Add client to or remove client from pending array.
+ *
+ * @param[in,out] loop pointer to event loop
+ * @param[in,out] entry client entry
+ * @param[in] pending if client has data buffered
+ */
+static void _loop_set_pending(MQTTEventLoop *loop, MQTTLoopEntry *entry, bool pending)
+{
+    if (pending && entry->pending_index < 0) {
+        entry->pending_index               = loop->pending_num;
+        loop->pending[loop->pending_num++] = entry;
+    }
+
+    if (!pending && entry->pending_index >= 0) {
+        loop->pending[entry->pending_index]                = loop->pending[--loop->pending_num];
+        loop->pending[entry->pending_index]->pending_index = entry->pending_index;
+        entry->pending_index                               = -1;
+    }
+}
+
+/**
+ * @brief Remove socket of entry from poller, unless the fd closed is reused and added by another client.
+ *
+ * @param[in,out] loop pointer to event loop
+ * @param[in,out] entry client entry
+ */
+static void _loop_del_fd(MQTTEventLoop *loop, MQTTLoopEntry *entry)
+{
+    int i;
+
+    for (i = 0; i < loop->entry_num; i++) {
+        if (loop->entries[i] != entry && loop->entries[i]->fd == entry->fd) {
+            // socket closed is removed from poller already, the one registered now belongs to another client
+            entry->fd = -1;
+            return;
+        }
+    }
+    HAL_Poller_Del(loop->poller, entry->fd);
+    entry->fd = -1;
+}
+
+/**
+ * @brief Sync socket in poller with connection of client, which is closed by disconnect or changed by reconnect.
+ *
+ * @param[in,out] loop pointer to event loop
+ * @param[in,out] entry client entry
+ */
+static void _loop_update_entry(MQTTEventLoop *loop, MQTTLoopEntry *entry)
+{
+    IotNetwork *network = &entry->client->network_stack;
+
+    int fd = get_client_conn_state(entry->client) ? network->get_fd(network) : -1;
+    if (fd != entry->fd) {
+        if (entry->fd >= 0) {
+            _loop_del_fd(loop, entry);
+        }
+
+        if (fd >= 0 && !HAL_Poller_Add(loop->poller, fd, entry)) {
+            entry->fd = fd;
+        }
+    }
+
+    _loop_set_pending(loop, entry, entry->fd >= 0 && network->get_bytes_avail(network));
+}
+
+#ifdef MULTITHREAD_ENABLED
+/**
+ * @brief Pop client from reconnect queue and mark it reconnecting.
+ *
+ * @param[in,out] loop pointer to event loop
+ * @return client entry, NULL for empty
+ */
+static MQTTLoopEntry *_loop_reconnect_pop(MQTTEventLoop *loop)
+{
+    MQTTLoopEntry *entry;
+
+    HAL_MutexLock(loop->reconnect_lock);
+    entry = loop->reconnect_head;
+    if (entry) {
+        loop->reconnect_head  = entry->reconnect_next;
+        loop->reconnect_tail  = loop->reconnect_head ? loop->reconnect_tail : NULL;
+        entry->reconnect_next = NULL;
+        __atomic_store_n(&entry->reconnecting, 2, __ATOMIC_RELEASE);
+    }
+    HAL_MutexUnlock(loop->reconnect_lock);
+    return entry;
+}
+
+/**
+ * @brief Queue client to reconnect thread, client is not touched by event loop until reconnect returns.
+ *
+ * @param[in,out] loop pointer to event loop
+ * @param[in,out] entry client entry
+ */
+static void _loop_reconnect_push(MQTTEventLoop *loop, MQTTLoopEntry *entry)
+{
+    HAL_MutexLock(loop->reconnect_lock);
+    __atomic_store_n(&entry->reconnecting, 1, __ATOMIC_RELEASE);
+    if (loop->reconnect_tail) {
+        loop->reconnect_tail->reconnect_next = entry;
+    } else {
+        loop->reconnect_head = entry;
+    }
+    loop->reconnect_tail = entry;
+    HAL_MutexUnlock(loop->reconnect_lock);
+    HAL_SemaphorePost(loop->reconnect_sem);
+}
+
+/**
+ * @brief Remove client from reconnect queue, or wait for reconnect running.
+ *
+ * @param[in,out] loop pointer to event loop
+ * @param[in,out] entry client entry
+ */
+static void _loop_reconnect_cancel(MQTTEventLoop *loop, MQTTLoopEntry *entry)
+{
+    MQTTLoopEntry **pprev, *prev = NULL;
+
+    HAL_MutexLock(loop->reconnect_lock);
+    if (__atomic_load_n(&entry->reconnecting, __ATOMIC_ACQUIRE) == 1) {
+        for (pprev = &loop->reconnect_head; *pprev != entry; pprev = &(*pprev)->reconnect_next) {
+            prev = *pprev;
+        }
+        *pprev               = entry->reconnect_next;
+        loop->reconnect_tail = loop->reconnect_tail == entry ? prev : loop->reconnect_tail;
+        entry->reconnecting  = 0;
+    }
+    HAL_MutexUnlock(loop->reconnect_lock);
+
+    while (__atomic_load_n(&entry->reconnecting, __ATOMIC_ACQUIRE)) {
+        HAL_SleepMs(1);
+    }
+}
+
+/**
+ * @brief Reconnect thread entry, reconnect clients queued one by one, so blocking reconnect of one client does not
+ * stall others in event loop.
+ *
+ * @param[in,out] arg pointer to event loop
+ */
+static void _loop_reconnect_run(void *arg)
+{
+    MQTTEventLoop *loop = (MQTTEventLoop *)arg;
+    MQTTLoopEntry *entry;
+
+    while (__atomic_load_n(&loop->running, __ATOMIC_ACQUIRE)) {
+        HAL_SemaphoreWait(loop->reconnect_sem, MQTT_LOOP_TICK_MS);
+        while (__atomic_load_n(&loop->running, __ATOMIC_ACQUIRE) && (entry = _loop_reconnect_pop(loop))) {
+            qcloud_iot_mqtt_yield_ready(entry->client, false);
+            __atomic_store_n(&entry->reconnecting, 0, __ATOMIC_RELEASE);
+            __atomic_store_n(&loop->reconnect_done, 1, __ATOMIC_RELEASE);
+            HAL_Poller_Wakeup(loop->poller);
+        }
+    }
+    HAL_SemaphorePost(loop->exit_sem);
+}
+
+/**
+ * @brief Start reconnect thread of event loop.
+ *
+ * @param[in,out] loop pointer to event loop
+ * @return @see IotReturnCode
+ */
+static int _loop_reconnect_start(MQTTEventLoop *loop)
+{
+    loop->reconnect_lock = HAL_MutexCreate();
+    loop->reconnect_sem  = HAL_SemaphoreCreate();
+    loop->exit_sem       = HAL_SemaphoreCreate();
+    if (!loop->reconnect_lock || !loop->reconnect_sem || !loop->exit_sem) {
+        return QCLOUD_ERR_FAILURE;
+    }
+
+    loop->running                      = 1;
+    loop->reconnect_thread.thread_name = "mqtt_reconnect";
+    loop->reconnect_thread.thread_func = _loop_reconnect_run;
+    loop->reconnect_thread.user_arg    = loop;
+    loop->reconnect_thread.stack_size  = MQTT_LOOP_RECONNECT_STACK_SIZE;
+    if (HAL_ThreadCreate(&loop->reconnect_thread)) {
+        loop->running = 0;
+        return QCLOUD_ERR_FAILURE;
+    }
+    return QCLOUD_RET_SUCCESS;
+}
+
+/**
+ * @brief Stop reconnect thread and wait for reconnect running, then free resources of it.
+ *
+ * @param[in,out] loop pointer to event loop
+ */
+static void _loop_reconnect_stop(MQTTEventLoop *loop)
+{
+    if (__atomic_exchange_n(&loop->running, 0, __ATOMIC_ACQ_REL)) {
+        HAL_SemaphorePost(loop->reconnect_sem);
+        HAL_SemaphoreWait(loop->exit_sem, UINT32_MAX);
+    }
+
+    if (loop->reconnect_lock) {
+        HAL_MutexDestroy(loop->reconnect_lock);
+    }
+    if (loop->reconnect_sem) {
+        HAL_SemaphoreDestroy(loop->reconnect_sem);
+    }
+    if (loop->exit_sem) {
+        HAL_SemaphoreDestroy(loop->exit_sem);
+    }
+}
+#endif
+
+/**
+ * @brief Handle one client, errors are notified by event handler of client.
+ *
+ * @param[in,out] loop pointer to event loop
+ * @param[in,out] entry client entry
+ * @param[in] readable if socket is readable
+ */
+static void _loop_dispatch(MQTTEventLoop *loop, MQTTLoopEntry *entry, bool readable)
+{
+#ifdef MULTITHREAD_ENABLED
+    // client is owned by reconnect thread now
+    if (__atomic_load_n(&entry->reconnecting, __ATOMIC_ACQUIRE)) {
+        return;
+    }
+
+    if (qcloud_iot_mqtt_is_reconnect_due(entry->client)) {
+        _loop_update_entry(loop, entry);
+        _loop_reconnect_push(loop, entry);
+        return;
+    }
+#endif
+    qcloud_iot_mqtt_yield_ready(entry->client, readable);
+    _loop_update_entry(loop, entry);
+}
+
+/**
+ * @brief Create event loop to drive many mqtt clients in one thread, instead of IOT_MQTT_Yield for each client.
+ *
+ * @return pointer to event loop, NULL for fail
+ */
+void *IOT_MQTT_LoopCreate(void)
+{
+    MQTTEventLoop *loop = HAL_Malloc(sizeof(MQTTEventLoop));
+    if (!loop) {
+        return NULL;
+    }
+    memset(loop, 0, sizeof(MQTTEventLoop));
+
+    loop->poller = HAL_Poller_Create();
+    if (!loop->poller) {
+        HAL_Free(loop);
+        return NULL;
+    }
+
+#ifdef MULTITHREAD_ENABLED
+    if (_loop_reconnect_start(loop)) {
+        _loop_reconnect_stop(loop);
+        HAL_Poller_Destroy(loop->poller);
+        HAL_Free(loop);
+        return NULL;
+    }
+#endif
+
+    HAL_Timer_CountdownMs(&loop->tick_timer, MQTT_LOOP_TICK_MS);
+    return loop;
+}
+
+/**
+ * @brief Add client to event loop, client should not be yield by others after added.
+ *
+ * @param[in,out] loop pointer to event loop
+ * @param[in,out] client pointer to mqtt client
+ * @return @see IotReturnCode
+ */
+int IOT_MQTT_LoopAdd(void *loop, void *client)
+{
+    POINTER_SANITY_CHECK(loop, QCLOUD_ERR_INVAL);
+    POINTER_SANITY_CHECK(client, QCLOUD_ERR_INVAL);
+
+    MQTTEventLoop *event_loop = (MQTTEventLoop *)loop;
+    MQTTLoopEntry *entry, **entries, **pending;
+    int            size;
+
+    // grow client array and pending array together, so pending array never overflows
+    if (event_loop->entry_num == event_loop->entry_size) {
+        size    = event_loop->entry_size ? event_loop->entry_size * 2 : 16;
+        entries = HAL_Malloc(size * sizeof(MQTTLoopEntry *));
+        pending = HAL_Malloc(size * sizeof(MQTTLoopEntry *));
+        if (!entries || !pending) {
+            HAL_Free(entries);
+            HAL_Free(pending);
+            return QCLOUD_ERR_MALLOC;
+        }
+
+        if (event_loop->entry_num) {
+            memcpy(entries, event_loop->entries, event_loop->entry_num * sizeof(MQTTLoopEntry *));
+        }
+        if (event_loop->pending_num) {
+            memcpy(pending, event_loop->pending, event_loop->pending_num * sizeof(MQTTLoopEntry *));
+        }
+
+        HAL_Free(event_loop->entries);
+        HAL_Free(event_loop->pending);
+        event_loop->entries    = entries;
+        event_loop->pending    = pending;
+        event_loop->entry_size = size;
+    }
+
+    entry = HAL_Malloc(sizeof(MQTTLoopEntry));
+    if (!entry) {
+        return QCLOUD_ERR_MALLOC;
+    }
+
+    entry->client                                = (QcloudIotClient *)client;
+    entry->fd                                    = -1;
+    entry->index                                 = event_loop->entry_num;
+    entry->pending_index                         = -1;
+    entry->reconnecting                          = 0;
+    entry->reconnect_next                        = NULL;
+    event_loop->entries[event_loop->entry_num++] = entry;
+
+    _loop_update_entry(event_loop, entry);
+    return QCLOUD_RET_SUCCESS;
+}
+
+/**
+ * @brief Remove client from event loop, client is not destroyed.
+ *
+ * @param[in,out] loop pointer to event loop
+ * @param[in,out] client pointer to mqtt client
+ * @return @see IotReturnCode
+ */
+int IOT_MQTT_LoopRemove(void *loop, void *client)
+{
+    POINTER_SANITY_CHECK(loop, QCLOUD_ERR_INVAL);
+    POINTER_SANITY_CHECK(client, QCLOUD_ERR_INVAL);
+
+    MQTTEventLoop *event_loop = (MQTTEventLoop *)loop;
+    MQTTLoopEntry *entry      = NULL;
+    int            i;
+
+    for (i = 0; i < event_loop->entry_num; i++) {
+        if (event_loop->entries[i]->client == client) {
+            entry = event_loop->entries[i];
+            break;
+        }
+    }
+
+    if (!entry) {
+        return QCLOUD_ERR_FAILURE;
+    }
+
+#ifdef MULTITHREAD_ENABLED
+    _loop_reconnect_cancel(event_loop, entry);
+#endif
+    if (entry->fd >= 0) {
+        _loop_del_fd(event_loop, entry);
+    }
+    _loop_set_pending(event_loop, entry, false);
+
+    event_loop->entries[entry->index]        = event_loop->entries[--event_loop->entry_num];
+    event_loop->entries[entry->index]->index = entry->index;
+    HAL_Free(entry);
+    return QCLOUD_RET_SUCCESS;
+}
+
+/**
+ * @brief Run event loop for timeout_ms, read/handle packets of readable clients and check ack timeout, keep alive and
+ * reconnect of all clients every MQTT_LOOP_TICK_MS.
+ *
+ * @param[in,out] loop pointer to event loop
+ * @param[in] timeout_ms timeout value (unit: ms) for this operation
+ * @return @see IotReturnCode
+ */
+int IOT_MQTT_LoopRun(void *loop, uint32_t timeout_ms)
+{
+    POINTER_SANITY_CHECK(loop, QCLOUD_ERR_INVAL);
+
+    MQTTEventLoop *event_loop = (MQTTEventLoop *)loop;
+    void *         ready[MQTT_LOOP_MAX_READY_NUM];
+    int            i, rc;
+    uint32_t       wait_ms;
+    Timer          timer;
+
+    HAL_Timer_CountdownMs(&timer, timeout_ms);
+
+    do {
+        // 1. wait for readable sockets, no waiting if any client has data buffered
+        wait_ms = HAL_Timer_Remain(&event_loop->tick_timer);
+        wait_ms = HAL_Timer_Remain(&timer) < wait_ms ? HAL_Timer_Remain(&timer) : wait_ms;
+        wait_ms = event_loop->pending_num ? 0 : wait_ms;
+
+        rc = HAL_Poller_Wait(event_loop->poller, ready, MQTT_LOOP_MAX_READY_NUM, wait_ms);
+        if (rc < 0) {
+            return rc;
+        }
+
+        for (i = 0; i < rc; i++) {
+            _loop_dispatch(event_loop, (MQTTLoopEntry *)ready[i], true);
+        }
+
+#ifdef MULTITHREAD_ENABLED
+        // add sockets of clients reconnected by reconnect thread
+        if (__atomic_exchange_n(&event_loop->reconnect_done, 0, __ATOMIC_ACQ_REL)) {
+            for (i = 0; i < event_loop->entry_num; i++) {
+                if (!__atomic_load_n(&event_loop->entries[i]->reconnecting, __ATOMIC_ACQUIRE)) {
+                    _loop_update_entry(event_loop, event_loop->entries[i]);
+                }
+            }
+        }
+#endif
+
+        // 2. handle data buffered, backward for dispatched entry may be removed from pending array
+        for (i = event_loop->pending_num - 1; i >= 0; i--) {
+            _loop_dispatch(event_loop, event_loop->pending[i], false);
+        }
+
+        // 3. check ack timeout, keep alive and reconnect
+        if (HAL_Timer_Expired(&event_loop->tick_timer)) {
+            HAL_Timer_CountdownMs(&event_loop->tick_timer, MQTT_LOOP_TICK_MS);
+            for (i = 0; i < event_loop->entry_num; i++) {
+                _loop_dispatch(event_loop, event_loop->entries[i], false);
+            }
+        }
+    } while (!HAL_Timer_Expired(&timer));
+
+    return QCLOUD_RET_SUCCESS;
+}
+
+/**
+ * @brief Destroy event loop, clients are not destroyed.
+ *
+ * @param[in,out] loop pointer to event loop pointer
+ */
+void IOT_MQTT_LoopDestroy(void **loop)
+{
+    POINTER_SANITY_CHECK_RTN(loop);
+    POINTER_SANITY_CHECK_RTN(*loop);
+
+    MQTTEventLoop *event_loop = (MQTTEventLoop *)*loop;
+    int            i;
+
+#ifdef MULTITHREAD_ENABLED
+    // reconnect running is waited, clients queued are left disconnected
+    _loop_reconnect_stop(event_loop);
+#endif
+    for (i = 0; i < event_loop->entry_num; i++) {
+        HAL_Free(event_loop->entries[i]);
+    }
+
+    HAL_Poller_Destroy(event_loop->poller);
+    HAL_Free(event_loop->entries);
+    HAL_Free(event_loop->pending);
+    HAL_Free(event_loop);
+    *loop = NULL;
+}
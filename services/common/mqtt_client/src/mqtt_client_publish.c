@@ -29,143 +29,399 @@
 
 #include "mqtt_client.h"
 
+/**************************************************************************************
+ * puback waiting table
+ **************************************************************************************/
+
+/**
+ * @brief Get slot index of packet id.
+ *
+ * @param[in] table @see QcloudIotPubWaitTable
+ * @param[in] packet_id packet id
+ * @return slot index
+ */
+static inline uint32_t _pub_wait_table_hash(QcloudIotPubWaitTable *table, uint16_t packet_id)
+{
+    return packet_id & (table->capacity - 1);
+}
+
+/**
+ * @brief Get wheel slot index of timestamp.
+ *
+ * @param[in] timestamp_ms timestamp
+ * @return wheel slot index
+ */
+static inline uint32_t _pub_wait_wheel_slot(uint64_t timestamp_ms)
+{
+    return (timestamp_ms / PUB_WAIT_WHEEL_TICK_MS) & (PUB_WAIT_WHEEL_SLOT_NUM - 1);
+}
+
+/**
+ * @brief Add pub info to timeout wheel according to expire_ms.
+ *
+ * @param[in,out] table @see QcloudIotPubWaitTable
+ * @param[in,out] repub_info @see QcloudIotPubInfo
+ */
+static void _pub_wait_wheel_add(QcloudIotPubWaitTable *table, QcloudIotPubInfo *repub_info)
+{
+    uint32_t slot = _pub_wait_wheel_slot(repub_info->expire_ms);
+
+    repub_info->prev = NULL;
+    repub_info->next = table->wheel[slot];
+    if (repub_info->next) {
+        repub_info->next->prev = repub_info;
+    }
+    table->wheel[slot] = repub_info;
+}
+
+/**
+ * @brief Delete pub info from timeout wheel, should be called before expire_ms changed.
+ *
+ * @param[in,out] table @see QcloudIotPubWaitTable
+ * @param[in,out] repub_info @see QcloudIotPubInfo
+ */
+static void _pub_wait_wheel_del(QcloudIotPubWaitTable *table, QcloudIotPubInfo *repub_info)
+{
+    if (repub_info->prev) {
+        repub_info->prev->next = repub_info->next;
+    } else {
+        table->wheel[_pub_wait_wheel_slot(repub_info->expire_ms)] = repub_info->next;
+    }
+
+    if (repub_info->next) {
+        repub_info->next->prev = repub_info->prev;
+    }
+    repub_info->prev = repub_info->next = NULL;
+}
+
 /**
- * @brief Push pub info to list for republish.
+ * @brief Remove pub info from slots, using backward shift deletion to keep probe sequence.
+ *
+ * @param[in,out] table @see QcloudIotPubWaitTable
+ * @param[in] packet_id packet id
+ * @return pointer to pub info removed, NULL for not found
+ */
+static QcloudIotPubInfo *_pub_wait_table_slot_remove(QcloudIotPubWaitTable *table, uint16_t packet_id)
+{
+    QcloudIotPubInfo *repub_info = NULL;
+
+    uint32_t mask = table->capacity - 1;
+    uint32_t i    = _pub_wait_table_hash(table, packet_id);
+    uint32_t j, k;
+
+    while (table->slots[i] && table->slots[i]->packet_id != packet_id) {
+        i = (i + 1) & mask;
+    }
+
+    repub_info = table->slots[i];
+    if (!repub_info) {
+        return NULL;
+    }
+
+    table->slots[i] = NULL;
+    table->count--;
+
+    // move the following entries back if their home slot is not between the hole and themselves
+    for (j = (i + 1) & mask; table->slots[j]; j = (j + 1) & mask) {
+        k = _pub_wait_table_hash(table, table->slots[j]->packet_id);
+        if (((j - k) & mask) >= ((j - i) & mask)) {
+            table->slots[i] = table->slots[j];
+            table->slots[j] = NULL;
+            i               = j;
+        }
+    }
+    return repub_info;
+}
+
+/**
+ * @brief Insert pub info to table and timeout wheel.
+ *
+ * @param[in,out] table @see QcloudIotPubWaitTable
+ * @param[in] repub_info @see QcloudIotPubInfo
+ * @return @see IotReturnCode
+ */
+static int _pub_wait_table_insert(QcloudIotPubWaitTable *table, QcloudIotPubInfo *repub_info)
+{
+    uint32_t i;
+
+    HAL_MutexLock(table->lock);
+    if (table->count >= table->window_size) {
+        HAL_MutexUnlock(table->lock);
+        return QCLOUD_ERR_MQTT_PUSH_TO_LIST_FAILED;
+    }
+
+    i = _pub_wait_table_hash(table, repub_info->packet_id);
+    while (table->slots[i]) {
+        i = (i + 1) & (table->capacity - 1);
+    }
+    table->slots[i] = repub_info;
+    table->count++;
+    _pub_wait_wheel_add(table, repub_info);
+    HAL_MutexUnlock(table->lock);
+    return QCLOUD_RET_SUCCESS;
+}
+
+/**
+ * @brief Release payload referenced and free pub info.
+ *
+ * @param[in,out] repub_info @see QcloudIotPubInfo
+ */
+static void _free_pub_info(QcloudIotPubInfo *repub_info)
+{
+    if (repub_info && repub_info->payload_release) {
+        repub_info->payload_release((void *)repub_info->payload, repub_info->release_usr_data);
+    }
+    HAL_Free(repub_info);
+}
+
+/**
+ * @brief Remove pub info of publish failed to send, payload is still owned by caller so never released. Should be
+ * called with lock_write_buf locked, so pub info being resent is not written after.
+ *
+ * @param[in,out] table @see QcloudIotPubWaitTable
+ * @param[in] packet_id packet id
+ */
+static void _pub_wait_table_cancel(QcloudIotPubWaitTable *table, uint16_t packet_id)
+{
+    QcloudIotPubInfo *repub_info;
+
+    HAL_MutexLock(table->lock);
+    repub_info = _pub_wait_table_slot_remove(table, packet_id);
+    if (repub_info && repub_info->resending) {
+        // freed by the thread resending it
+        repub_info->removed         = 1;
+        repub_info->payload_release = NULL;
+        repub_info                  = NULL;
+    } else if (repub_info) {
+        _pub_wait_wheel_del(table, repub_info);
+    }
+    HAL_MutexUnlock(table->lock);
+    HAL_Free(repub_info);
+}
+
+/**
+ * @brief Push pub info to table for republish. Payload is referenced if payload_release is set, otherwise copied.
  *
  * @param[in,out] client pointer to mqtt_client
- * @param[in] packet_len packet len of publish packet
+ * @param[in] header serialized header of publish packet
+ * @param[in] header_len length of header
+ * @param[in] params publish params
  * @param[in] packet_id packet id
- * @param[out] node list node
  * @return @see IotReturnCode
  */
-static int _push_pub_info_to_list(QcloudIotClient *client, int packet_len, uint16_t packet_id, void **node)
+static int _push_pub_info_to_table(QcloudIotClient *client, const uint8_t *header, int header_len,
+                                   const PublishParams *params, uint16_t packet_id)
 {
     IOT_FUNC_ENTRY;
-    void *            list       = client->list_pub_wait_ack;
+    int               rc;
+    int               copy_len   = header_len + (params->payload_release ? 0 : params->payload_len);
     QcloudIotPubInfo *repub_info = NULL;
 
     // construct republish info
-    repub_info = (QcloudIotPubInfo *)HAL_Malloc(sizeof(QcloudIotPubInfo) + packet_len);
+    repub_info = (QcloudIotPubInfo *)HAL_Malloc(sizeof(QcloudIotPubInfo) + copy_len);
     if (!repub_info) {
         Log_e("memory malloc failed!");
         IOT_FUNC_EXIT_RC(QCLOUD_ERR_FAILURE);
     }
+    memset(repub_info, 0, sizeof(QcloudIotPubInfo));
+
+    repub_info->buf         = (uint8_t *)repub_info + sizeof(QcloudIotPubInfo);
+    repub_info->len         = copy_len;
+    repub_info->packet_id   = packet_id;
+    repub_info->retry_cnt   = 0;
+    repub_info->pub_time_ms = HAL_Timer_CurrentMs();
+    repub_info->expire_ms   = repub_info->pub_time_ms + client->command_timeout_ms;
+    memcpy(repub_info->buf, header, header_len);
+    if (params->payload_release) {
+        repub_info->payload          = params->payload;
+        repub_info->payload_len      = params->payload_len;
+        repub_info->payload_release  = params->payload_release;
+        repub_info->release_usr_data = params->release_usr_data;
+    } else {
+        memcpy(repub_info->buf + header_len, params->payload, params->payload_len);  // save the whole packet
+    }
 
-    repub_info->buf       = (uint8_t *)repub_info + sizeof(QcloudIotPubInfo);
-    repub_info->len       = packet_len;
-    repub_info->packet_id = packet_id;
-    memcpy(repub_info->buf, client->write_buf, packet_len);  // save the whole packet
-    HAL_Timer_CountdownMs(&repub_info->pub_start_time, client->command_timeout_ms);
-
-    // push republish info to list
-    *node = utils_list_push(list, repub_info);
-    if (!*node) {
+    // push republish info to table
+    rc = _pub_wait_table_insert(&client->pub_wait_table, repub_info);
+    if (rc) {
         HAL_Free(repub_info);
-        Log_e("list push failed! Check the list len!");
-        IOT_FUNC_EXIT_RC(QCLOUD_ERR_FAILURE);
+        Log_e("table insert failed! Check the publish window size!");
+        IOT_FUNC_EXIT_RC(rc);
     }
     IOT_FUNC_EXIT_RC(QCLOUD_RET_SUCCESS);
 }
 
 /**
- * @brief Check pub wait list timeout.
+ * @brief Resend the saved publish packet with DUP flag. Should be called with lock_write_buf locked and pub info
+ * marked resending, so that it is not freed by puback meanwhile.
  *
- * @param[in,out] list pointer to pub wait ack list.
- * @param[in] node pointer to list node
- * @param[in] val pointer to value, @see QcloudIotPubInfo
- * @param[in] usr_data @see QcloudIotClient
- * @return @see UtilsListResult
+ * @param[in,out] client pointer to mqtt_client
+ * @param[in,out] repub_info @see QcloudIotPubInfo
+ * @return @see IotReturnCode
+ * @note pending publish batch is written first to keep packets in order.
  */
-static UtilsListResult _pub_wait_list_process_check_timeout(void *list, void *node, void *val, void *usr_data)
+static int _resend_pub_info(QcloudIotClient *client, QcloudIotPubInfo *repub_info)
 {
-    IOT_FUNC_ENTRY;
+    int        rc;
+    size_t     written_len = 0;
+    MQTTHeader header      = {0};
+
+    IotIoVec   iov[2]      = {{repub_info->buf, repub_info->len}, {repub_info->payload, repub_info->payload_len}};
 
-    MQTTEventMsg      msg;
-    QcloudIotPubInfo *repub_info = (QcloudIotPubInfo *)val;
-    QcloudIotClient * client     = (QcloudIotClient *)usr_data;
+    // set DUP flag in fixed header, header is always saved when publish
+    header.byte        = repub_info->buf[0];
+    header.bits.dup    = 1;
+    repub_info->buf[0] = header.byte;
 
-    // check the request if timeout or not
-    if (HAL_Timer_Remain(&repub_info->pub_start_time) > 0) {
-        IOT_FUNC_EXIT_RC(LIST_TRAVERSE_CONTINUE);
+    rc = send_mqtt_pub_batch(client);
+    if (rc) {
+        return rc;
     }
 
-    // notify timeout event
-    if (client->event_handle.h_fp) {
-        msg.event_type = MQTT_EVENT_PUBLISH_TIMEOUT;
-        msg.msg        = (void *)(uintptr_t)repub_info->packet_id;
-        client->event_handle.h_fp(client, client->event_handle.context, &msg);
+    rc = client->network_stack.writev(&(client->network_stack), iov, 2, client->command_timeout_ms, &written_len);
+    if (rc) {
+        return QCLOUD_ERR_TCP_WRITE_TIMEOUT == rc ? QCLOUD_ERR_MQTT_REQUEST_TIMEOUT : rc;
     }
-    utils_list_remove(list, node);
-    IOT_FUNC_EXIT_RC(LIST_TRAVERSE_CONTINUE);
+    update_mqtt_send_time(client);
+
+    Log_d("republish packet_id=%d|retry_cnt=%d", repub_info->packet_id, repub_info->retry_cnt);
+    return QCLOUD_RET_SUCCESS;
 }
 
 /**
- * @brief Remove info from pub wait list.
+ * @brief Resend pub info taken off the wheel, then put them back to wait with exponential interval, or free the ones
+ * removed meanwhile. Should be called with lock_write_buf locked and without lock of pub wait table.
  *
- * @param[in,out] list pointer to pub wait ack list.
- * @param[in] node pointer to list node
- * @param[in] val pointer to value, @see QcloudIotPubInfo
- * @param[in] usr_data pointer to packet id
- * @return @see UtilsListResult
+ * @param[in,out] client pointer to mqtt_client
+ * @param[in,out] list pub info linked by next and marked resending
+ * @return @see IotReturnCode of the first failed resend, the rest are not written and wait for next retry
  */
-static UtilsListResult _pub_wait_list_process_remove_info(void *list, void *node, void *val, void *usr_data)
+static int _resend_pub_list(QcloudIotClient *client, QcloudIotPubInfo *list)
 {
-    IOT_FUNC_ENTRY;
+    int                    rc    = QCLOUD_RET_SUCCESS;
+    int                    removed;
+    QcloudIotPubWaitTable *table = &client->pub_wait_table;
+    QcloudIotPubInfo      *repub_info, *next;
+
+    for (repub_info = list; repub_info; repub_info = next) {
+        next             = repub_info->next;
+        repub_info->next = NULL;
+
+        // acked or canceled before lock_write_buf got, no need to write
+        HAL_MutexLock(table->lock);
+        removed = repub_info->removed;
+        HAL_MutexUnlock(table->lock);
+        if (!rc && !removed) {
+            rc = _resend_pub_info(client, repub_info);
+            if (rc) {
+                Log_w("republish packet_id=%d failed, wait for next retry", repub_info->packet_id);
+            }
+        }
 
-    QcloudIotPubInfo *repub_info = (QcloudIotPubInfo *)val;
-    if (repub_info->packet_id == *((uint16_t *)usr_data)) {
-        utils_list_remove(list, node);
-        IOT_FUNC_EXIT_RC(LIST_TRAVERSE_BREAK);
+        HAL_MutexLock(table->lock);
+        repub_info->resending = 0;
+        if (!repub_info->removed) {
+            repub_info->expire_ms = HAL_Timer_CurrentMs() + (client->command_timeout_ms << repub_info->retry_cnt);
+            _pub_wait_wheel_add(table, repub_info);
+            repub_info = NULL;
+        }
+        HAL_MutexUnlock(table->lock);
+        _free_pub_info(repub_info);
     }
-    IOT_FUNC_EXIT_RC(LIST_TRAVERSE_CONTINUE);
+    return rc;
 }
 
 /**
- * @brief Remove node signed with packet id from publish ACK wait list.
+ * @brief Handle publish which puback waiting is timeout, mark it resending until retry times run out. Should be called
+ * with lock of pub wait table locked and pub info taken off the wheel.
  *
  * @param[in,out] client pointer to mqtt_client
- * @param[in] packet_id packet id
+ * @param[in,out] repub_info @see QcloudIotPubInfo
+ * @return 0 if it should be resent without lock, 1 if retry times run out and removed from table, then timeout event
+ * should be notified without lock
  */
-static void _remove_pub_info_from_list(QcloudIotClient *client, uint16_t packet_id)
+static int _handle_pub_info_timeout(QcloudIotClient *client, QcloudIotPubInfo *repub_info)
 {
-    utils_list_process(client->list_pub_wait_ack, LIST_HEAD, _pub_wait_list_process_remove_info, &packet_id);
+    QcloudIotPubWaitTable *table = &client->pub_wait_table;
+
+    // retry with exponential wait interval
+    if (repub_info->retry_cnt < MAX_REPUB_RETRY_TIMES) {
+        repub_info->retry_cnt++;
+        repub_info->resending = 1;
+
+        HAL_MutexLock(client->lock_generic);
+        client->pub_stats.retry_count++;
+        HAL_MutexUnlock(client->lock_generic);
+        return 0;
+    }
+
+    _pub_wait_table_slot_remove(table, repub_info->packet_id);
+
+    HAL_MutexLock(client->lock_generic);
+    client->pub_stats.timeout_count++;
+    HAL_MutexUnlock(client->lock_generic);
+    return 1;
 }
 
 /**
- * @brief Check if topic match
+ * @brief Notify timeout event of publish and free it, called without lock for user handler may take long or publish.
  *
- * @param[in] topic_filter topic name filter, wildcard is supported
- * @param[in] topic_name topic name, no wildcard
- * @param[in] topic_name_len length of topic name
- * @return 1 for matched, 0 for no matched
+ * @param[in,out] client pointer to mqtt_client
+ * @param[in,out] repub_info @see QcloudIotPubInfo, removed from table
+ */
+static void _notify_pub_info_timeout(QcloudIotClient *client, QcloudIotPubInfo *repub_info)
+{
+    MQTTEventMsg msg;
+
+    if (client->event_handle.h_fp) {
+        msg.event_type = MQTT_EVENT_PUBLISH_TIMEOUT;
+        msg.msg        = (void *)(uintptr_t)repub_info->packet_id;
+        client->event_handle.h_fp(client, client->event_handle.context, &msg);
+    }
+    _free_pub_info(repub_info);
+}
+
+/**
+ * @brief Remove node signed with packet id from publish ACK wait table, and update ack latency.
  *
- * @note  assume topic filter and name is in correct format;
- * # can only be at end;
- * + and # can only be next to separator.
+ * @param[in,out] client pointer to mqtt_client
+ * @param[in] packet_id packet id
  */
-static uint8_t _is_topic_matched(char *topic_filter, const char *topic_name, uint16_t topic_name_len)
+static void _remove_pub_info_from_table(QcloudIotClient *client, uint16_t packet_id)
 {
-    char *curf     = topic_filter;
-    char *curn     = (char *)topic_name;
-    char *curn_end = curn + topic_name_len;
-
-    while (*curf && curn < curn_end) {
-        if (*curn == '/' && *curf != '/')
-            break;
-        if (*curf != '+' && *curf != '#' && *curf != *curn)
-            break;
-        if (*curf == '+') {  // skip until we meet the next separator, or end of string
-            char *nextpos = curn + 1;
-            while (nextpos < curn_end && *nextpos != '/') nextpos = ++curn + 1;
-        } else if (*curf == '#')
-            curn = curn_end - 1;  // skip until end of string
-        curf++;
-        curn++;
-    };
-
-    return (curn == curn_end) && (*curf == '\0');
+    QcloudIotPubWaitTable *table = &client->pub_wait_table;
+    QcloudIotPubInfo      *repub_info;
+    uint64_t               pub_time_ms;
+
+    HAL_MutexLock(table->lock);
+    repub_info = _pub_wait_table_slot_remove(table, packet_id);
+    if (!repub_info) {
+        HAL_MutexUnlock(table->lock);
+        return;
+    }
+
+    pub_time_ms = repub_info->pub_time_ms;
+    if (repub_info->resending) {
+        // not in wheel, freed by the thread resending it
+        repub_info->removed = 1;
+        repub_info          = NULL;
+    } else {
+        _pub_wait_wheel_del(table, repub_info);
+    }
+    HAL_MutexUnlock(table->lock);
+
+    HAL_MutexLock(client->lock_generic);
+    client->pub_stats.acked_count++;
+    client->pub_stats.last_ack_latency_ms = HAL_Timer_CurrentMs() - pub_time_ms;
+    client->total_ack_latency_ms += client->pub_stats.last_ack_latency_ms;
+    HAL_MutexUnlock(client->lock_generic);
+    _free_pub_info(repub_info);
 }
 
+/**************************************************************************************
+ * publish
+ **************************************************************************************/
+
 /**
  * @brief deliver the message to user callback
  *
@@ -174,24 +430,15 @@ static uint8_t _is_topic_matched(char *topic_filter, const char *topic_name, uin
  */
 static void _deliver_message(QcloudIotClient *client, MQTTMessage *message)
 {
-    int i;
-
-    MQTTEventMsg msg;
+    MQTTEventMsg    msg;
+    SubscribeParams params;
 
-    HAL_MutexLock(client->lock_generic);
-    for (i = 0; i < MAX_MESSAGE_HANDLERS; ++i) {
-        if (client->sub_handles[i].topic_filter &&
-            _is_topic_matched((char *)client->sub_handles[i].topic_filter, message->topic_name, message->topic_len)) {
-            if (client->sub_handles[i].params.on_message_handler) {
-                HAL_MutexUnlock(client->lock_generic);
-                // if found, then handle it, then return
-                client->sub_handles[i].params.on_message_handler(client, message,
-                                                                 client->sub_handles[i].params.user_data);
-                return;
-            }
-        }
+    if (qcloud_iot_mqtt_match_sub_params(client, message->topic_name, message->topic_len, &params) &&
+        params.on_message_handler) {
+        // if found, then handle it, then return
+        params.on_message_handler(client, message, params.user_data);
+        return;
     }
-    HAL_MutexUnlock(client->lock_generic);
 
     /* Message handler not found for topic */
     /* May be we do not care  change FAILURE  use SUCCESS*/
@@ -242,7 +489,49 @@ static void _add_packet_id_to_repeat_buf(QcloudIotClient *client, uint16_t packe
 #endif
 
 /**
- * @brief Serialize and send publish packet.
+ * @brief Serialize publish packet into batch buffer, flush the batch first if no space left. Should be called with
+ * lock_write_buf locked.
+ *
+ * @param[in,out] client pointer to mqtt_client
+ * @param[in] flags flags of publish packet
+ * @param[in] packet_id packet id
+ * @param[in] topic_name topic to publish
+ * @param[in] params publish params
+ * @param[out] packet packet serialized in batch buffer, NULL if larger than batch buffer
+ * @param[out] packet_len length of packet
+ * @return @see IotReturnCode
+ */
+static int _batch_publish_packet(QcloudIotClient *client, MQTTPublishFlags *flags, uint16_t packet_id,
+                                 const char *topic_name, const PublishParams *params, uint8_t **packet,
+                                 int *packet_len)
+{
+    int rc;
+
+    *packet     = NULL;
+    *packet_len = mqtt_publish_packet_serialize(client->pub_batch_buf + client->pub_batch_len,
+                                                client->pub_batch_buf_size - client->pub_batch_len, flags, packet_id,
+                                                topic_name, params->payload, params->payload_len);
+    if (*packet_len == MQTT_ERR_SHORT_BUFFER && client->pub_batch_len) {
+        // batch full
+        rc = send_mqtt_pub_batch(client);
+        if (rc) {
+            return rc;
+        }
+        *packet_len = mqtt_publish_packet_serialize(client->pub_batch_buf, client->pub_batch_buf_size, flags,
+                                                    packet_id, topic_name, params->payload, params->payload_len);
+    }
+
+    if (*packet_len > 0) {
+        *packet = client->pub_batch_buf + client->pub_batch_len;
+        return QCLOUD_RET_SUCCESS;
+    }
+    return *packet_len == MQTT_ERR_SHORT_BUFFER ? QCLOUD_RET_SUCCESS : QCLOUD_ERR_FAILURE;
+}
+
+/**
+ * @brief Serialize and send publish packet. If batching is enabled, packet is appended to batch buffer and sent when
+ * batch is full, flush deadline passes or IOT_MQTT_Flush is called. Packet larger than batch buffer is sent directly,
+ * with header serialized in write buffer and payload sent by vectored write without copying.
  *
  * @param[in,out] client pointer to mqtt_client
  * @param[in] topic_name topic to publish
@@ -252,10 +541,10 @@ static void _add_packet_id_to_repeat_buf(QcloudIotClient *client, uint16_t packe
 int qcloud_iot_mqtt_publish(QcloudIotClient *client, const char *topic_name, const PublishParams *params)
 {
     IOT_FUNC_ENTRY;
-    int              rc, packet_len;
+    int              rc, packet_len, header_len;
     MQTTPublishFlags flags;
-    void *           node      = NULL;
     uint16_t         packet_id = 0;
+    uint8_t         *packet    = NULL;
 
     if (params->qos > QOS0) {
         packet_id = get_next_packet_id(client);
@@ -268,18 +557,37 @@ int qcloud_iot_mqtt_publish(QcloudIotClient *client, const char *topic_name, con
     flags.qos    = params->qos;
     flags.retain = params->retain;
 
-    // serialize packet
     HAL_MutexLock(client->lock_write_buf);
-    packet_len = mqtt_publish_packet_serialize(client->write_buf, client->write_buf_size, &flags, packet_id, topic_name,
-                                               params->payload, params->payload_len);
-    if (packet_len < 0) {
-        HAL_MutexUnlock(client->lock_write_buf);
-        rc = packet_len == MQTT_ERR_SHORT_BUFFER ? QCLOUD_ERR_BUF_TOO_SHORT : QCLOUD_ERR_FAILURE;
-        IOT_FUNC_EXIT_RC(rc);
+
+    // append to batch buffer
+    if (client->pub_batch_buf) {
+        rc = _batch_publish_packet(client, &flags, packet_id, topic_name, params, &packet, &packet_len);
+        if (rc) {
+            HAL_MutexUnlock(client->lock_write_buf);
+            IOT_FUNC_EXIT_RC(rc);
+        }
+    }
+
+    // serialize header into write buffer if no batching or too large for batch buffer, payload is not copied
+    if (!packet) {
+        rc = reserve_mqtt_write_buf(client, MAX_MQTT_FIXED_HEADER_LEN + 2 + strlen(topic_name) + 2);
+        if (rc) {
+            HAL_MutexUnlock(client->lock_write_buf);
+            IOT_FUNC_EXIT_RC(rc);
+        }
+        header_len = mqtt_publish_packet_header_serialize(client->write_buf, client->write_buf_size, &flags,
+                                                          packet_id, topic_name, params->payload_len);
+        if (header_len < 0) {
+            HAL_MutexUnlock(client->lock_write_buf);
+            rc = header_len == MQTT_ERR_SHORT_BUFFER ? QCLOUD_ERR_BUF_TOO_SHORT : QCLOUD_ERR_FAILURE;
+            IOT_FUNC_EXIT_RC(rc);
+        }
+    } else {
+        header_len = packet_len - params->payload_len;
     }
 
     if (params->qos > QOS0) {
-        rc = _push_pub_info_to_list(client, packet_len, packet_id, &node);
+        rc = _push_pub_info_to_table(client, packet ? packet : client->write_buf, header_len, params, packet_id);
         if (rc) {
             Log_e("push publish info failed!");
             HAL_MutexUnlock(client->lock_write_buf);
@@ -287,18 +595,149 @@ int qcloud_iot_mqtt_publish(QcloudIotClient *client, const char *topic_name, con
         }
     }
 
-    // send the publish packet
-    rc = send_mqtt_packet(client, packet_len);
+    // commit to batch buffer, start flush timer on first pending packet
+    if (packet) {
+        if (!client->pub_batch_len) {
+            HAL_Timer_CountdownMs(&client->pub_batch_timer, client->pub_batch_flush_ms);
+        }
+        client->pub_batch_len += packet_len;
+        rc = HAL_Timer_Expired(&client->pub_batch_timer) ? send_mqtt_pub_batch(client) : QCLOUD_RET_SUCCESS;
+    } else {
+        // send header and payload of the publish packet
+        rc = send_mqtt_packet_with_payload(client, header_len, params->payload, params->payload_len);
+    }
+    // payload is still owned by caller when publish fails, so no release
+    if (rc && params->qos > QOS0) {
+        _pub_wait_table_cancel(&client->pub_wait_table, packet_id);
+    }
     HAL_MutexUnlock(client->lock_write_buf);
     if (rc) {
-        if (params->qos > QOS0) {
-            utils_list_remove(client->list_pub_wait_ack, node);
-        }
         IOT_FUNC_EXIT_RC(rc);
     }
     IOT_FUNC_EXIT_RC(packet_id);
 }
 
+/**
+ * @brief Reply puback of qos1 publish.
+ *
+ * @param[in,out] client pointer to mqtt client
+ * @param[in] packet_id packet id of publish
+ * @return @see IotReturnCode
+ */
+static int _send_puback(QcloudIotClient *client, uint16_t packet_id)
+{
+    int rc, packet_len;
+
+    HAL_MutexLock(client->lock_write_buf);
+    packet_len = mqtt_puback_packet_serialize(client->write_buf, client->write_buf_size, packet_id);
+    if (packet_len > 0) {
+        rc = send_mqtt_packet(client, packet_len);
+    } else {
+        rc = packet_len == MQTT_ERR_SHORT_BUFFER ? QCLOUD_ERR_BUF_TOO_SHORT : QCLOUD_ERR_FAILURE;
+    }
+    HAL_MutexUnlock(client->lock_write_buf);
+    return rc;
+}
+
+/**
+ * @brief Read and drop payload of publish rejected, which is left in network.
+ *
+ * @param[in,out] client pointer to mqtt client
+ * @param[in] payload_len length of payload left
+ * @return @see IotReturnCode
+ */
+static int _drain_publish_payload(QcloudIotClient *client, uint32_t payload_len)
+{
+    int      rc;
+    size_t   read_len = 0;
+    uint32_t offset, slice_len;
+
+    for (offset = 0; offset < payload_len; offset += read_len) {
+        slice_len = payload_len - offset > client->read_buf_size ? client->read_buf_size : payload_len - offset;
+
+        rc = client->network_stack.read(&(client->network_stack), client->read_buf, slice_len,
+                                        client->command_timeout_ms, &read_len);
+        if (rc) {
+            return rc;
+        }
+
+        if (read_len != slice_len) {
+#ifdef AUTH_WITH_NO_TLS
+            return QCLOUD_ERR_TCP_READ_TIMEOUT;
+#else
+            return QCLOUD_ERR_SSL_READ_TIMEOUT;
+#endif
+        }
+    }
+    return QCLOUD_RET_SUCCESS;
+}
+
+/**
+ * @brief Read payload larger than read buffer from network in slices, and deliver to on_message_chunk callback.
+ *
+ * @param[in,out] client pointer to mqtt client
+ * @param[in,out] msg message with topic in read buffer, payload is reused as slice buffer
+ * @return @see IotReturnCode
+ */
+static int _handle_publish_stream(QcloudIotClient *client, MQTTMessage *msg)
+{
+    int             rc;
+    bool            deliver;
+    size_t          read_len  = 0;
+    uint32_t        offset    = 0;
+    uint32_t        total_len = msg->payload_len;
+    uint32_t        slice_len = client->read_buf + client->read_buf_size - msg->payload;
+    SubscribeParams params    = DEFAULT_SUB_PARAMS;
+
+    if (!qcloud_iot_mqtt_match_sub_params(client, msg->topic_name, msg->topic_len, &params) ||
+        !params.on_message_chunk) {
+        Log_e("MQTT Recv buffer not enough: %lu < %u, no chunk handler for %.*s", client->read_buf_size, total_len,
+              msg->topic_len, msg->topic_name);
+        params.on_message_chunk = NULL;
+    }
+
+    deliver = params.on_message_chunk != NULL;
+#ifdef MQTT_RMDUP_MSG_ENABLED
+    // still read the payload of repeat packet, but not deliver
+    deliver = deliver && (QOS0 == msg->qos || _get_packet_id_repeat_buf(client, msg->packet_id) < 0);
+#endif
+
+    for (offset = 0; offset < total_len; offset += read_len) {
+        msg->payload_len = total_len - offset > slice_len ? slice_len : total_len - offset;
+
+        rc = client->network_stack.read(&(client->network_stack), msg->payload, msg->payload_len,
+                                        client->command_timeout_ms, &read_len);
+        if (rc) {
+            return rc;
+        }
+
+        if (read_len != msg->payload_len) {
+#ifdef AUTH_WITH_NO_TLS
+            return QCLOUD_ERR_TCP_READ_TIMEOUT;
+#else
+            return QCLOUD_ERR_SSL_READ_TIMEOUT;
+#endif
+        }
+
+        if (deliver) {
+            params.on_message_chunk(client, msg, offset, total_len, params.user_data);
+        }
+    }
+
+    if (!params.on_message_chunk) {
+        return QCLOUD_ERR_BUF_TOO_SHORT;
+    }
+
+    if (QOS0 == msg->qos) {
+        return QCLOUD_RET_SUCCESS;
+    }
+
+#ifdef MQTT_RMDUP_MSG_ENABLED
+    _add_packet_id_to_repeat_buf(client, msg->packet_id);
+#endif
+    return _send_puback(client, msg->packet_id);
+}
+
 /**
  * @brief Deserialize publish packet and deliver_message.
  *
@@ -309,12 +748,27 @@ int qcloud_iot_mqtt_publish(QcloudIotClient *client, const char *topic_name, con
 int qcloud_iot_mqtt_handle_publish(QcloudIotClient *client)
 {
     IOT_FUNC_ENTRY;
-    int              rc, packet_len = 0;
+    int              rc;
     MQTTPublishFlags flags;
     MQTTMessage      msg;
 
     rc = mqtt_publish_packet_deserialize(client->read_buf, client->read_buf_size, &flags, &msg.packet_id,
                                          &msg.topic_name, &msg.topic_len, &msg.payload, &msg.payload_len);
+    if (MQTT_ERR_SHORT_BUFFER == rc) {
+        // only header of publish larger than read buffer is read, payload is left in network, @see _read_mqtt_packet
+        msg.payload_len = 0;
+        rc = mqtt_publish_packet_header_deserialize(client->read_buf, client->read_buf_size, &flags, &msg.packet_id,
+                                                    &msg.topic_name, &msg.topic_len, &msg.payload, &msg.payload_len);
+        if (rc) {
+            // topic not in read buffer, drop the packet and keep the stream in sync
+            Log_e("MQTT Recv buffer not enough for publish header, drop payload of %d bytes", msg.payload_len);
+            rc = _drain_publish_payload(client, msg.payload_len);
+            IOT_FUNC_EXIT_RC(rc ? rc : QCLOUD_ERR_BUF_TOO_SHORT);
+        }
+        msg.qos = flags.qos;
+        IOT_FUNC_EXIT_RC(_handle_publish_stream(client, &msg));
+    }
+
     if (rc) {
         IOT_FUNC_EXIT_RC(rc);
     }
@@ -342,14 +796,7 @@ int qcloud_iot_mqtt_handle_publish(QcloudIotClient *client)
 #endif
 
     // reply with puback
-    HAL_MutexLock(client->lock_write_buf);
-    packet_len = mqtt_puback_packet_serialize(client->write_buf, client->write_buf_size, msg.packet_id);
-    if (packet_len > 0) {
-        rc = send_mqtt_packet(client, packet_len);
-    } else {
-        rc = packet_len == MQTT_ERR_SHORT_BUFFER ? QCLOUD_ERR_BUF_TOO_SHORT : QCLOUD_ERR_FAILURE;
-    }
-    HAL_MutexUnlock(client->lock_write_buf);
+    rc = _send_puback(client, msg.packet_id);
     IOT_FUNC_EXIT_RC(rc);
 }
 
@@ -372,7 +819,7 @@ int qcloud_iot_mqtt_handle_puback(QcloudIotClient *client)
         IOT_FUNC_EXIT_RC(rc);
     }
 
-    _remove_pub_info_from_list(client, packet_id);
+    _remove_pub_info_from_table(client, packet_id);
 
     /* notify this event to user callback */
     if (client->event_handle.h_fp) {
@@ -388,10 +835,168 @@ int qcloud_iot_mqtt_handle_puback(QcloudIotClient *client)
  * @brief Process puback waiting timout.
  *
  * @param[in,out] client pointer to mqtt_client
+ *
+ * @note only the wheel slots passed since last check are traversed, and publish is resent without lock of table.
  */
 void qcloud_iot_mqtt_check_pub_timeout(QcloudIotClient *client)
 {
     IOT_FUNC_ENTRY;
-    utils_list_process(client->list_pub_wait_ack, LIST_HEAD, _pub_wait_list_process_check_timeout, client);
+    QcloudIotPubWaitTable *table = &client->pub_wait_table;
+    QcloudIotPubInfo      *repub_info, *next, *expired = NULL, **expired_tail = &expired;
+    QcloudIotPubInfo      *resend = NULL, **resend_tail = &resend;
+
+    uint64_t now_ms   = HAL_Timer_CurrentMs();
+    uint64_t now_tick = now_ms / PUB_WAIT_WHEEL_TICK_MS;
+    uint64_t tick_cnt;
+    uint32_t slot;
+
+    HAL_MutexLock(table->lock);
+
+    // the slot of current tick is checked again next time, for the publish expired later in the same tick
+    tick_cnt = table->count ? now_tick - table->wheel_tick + 1 : 0;
+    tick_cnt = tick_cnt > PUB_WAIT_WHEEL_SLOT_NUM ? PUB_WAIT_WHEEL_SLOT_NUM : tick_cnt;
+
+    while (tick_cnt--) {
+        slot               = (table->wheel_tick + tick_cnt) & (PUB_WAIT_WHEEL_SLOT_NUM - 1);
+        repub_info         = table->wheel[slot];
+        table->wheel[slot] = NULL;
+
+        for (; repub_info; repub_info = next) {
+            next             = repub_info->next;
+            repub_info->prev = repub_info->next = NULL;
+            if (repub_info->expire_ms > now_ms) {
+                _pub_wait_wheel_add(table, repub_info);
+                continue;
+            }
+            // collect and resend or notify after unlock
+            if (_handle_pub_info_timeout(client, repub_info)) {
+                *expired_tail = repub_info;
+                expired_tail  = &repub_info->next;
+            } else {
+                *resend_tail = repub_info;
+                resend_tail  = &repub_info->next;
+            }
+        }
+    }
+    table->wheel_tick = now_tick;
+    HAL_MutexUnlock(table->lock);
+
+    if (resend) {
+        HAL_MutexLock(client->lock_write_buf);
+        _resend_pub_list(client, resend);
+        HAL_MutexUnlock(client->lock_write_buf);
+    }
+
+    for (repub_info = expired; repub_info; repub_info = next) {
+        next = repub_info->next;
+        _notify_pub_info_timeout(client, repub_info);
+    }
     IOT_FUNC_EXIT;
 }
+
+/**
+ * @brief Resend publish packets in puback wait table with DUP flag when reconnect.
+ *
+ * @param[in,out] client pointer to mqtt_client
+ * @return @see IotReturnCode
+ */
+int qcloud_iot_mqtt_republish(QcloudIotClient *client)
+{
+    IOT_FUNC_ENTRY;
+    int                    rc     = QCLOUD_RET_SUCCESS;
+    uint32_t               i      = 0;
+    QcloudIotPubWaitTable *table  = &client->pub_wait_table;
+    QcloudIotPubInfo      *resend = NULL, **resend_tail = &resend;
+
+    // take all off the wheel, the ones being resent by timeout are skipped
+    HAL_MutexLock(table->lock);
+    for (i = 0; i < table->capacity; i++) {
+        if (!table->slots[i] || table->slots[i]->resending) {
+            continue;
+        }
+        _pub_wait_wheel_del(table, table->slots[i]);
+        table->slots[i]->resending = 1;
+        *resend_tail               = table->slots[i];
+        resend_tail                = &table->slots[i]->next;
+    }
+    HAL_MutexUnlock(table->lock);
+
+    HAL_MutexLock(client->lock_write_buf);
+    rc = _resend_pub_list(client, resend);
+    HAL_MutexUnlock(client->lock_write_buf);
+    IOT_FUNC_EXIT_RC(rc);
+}
+
+/**
+ * @brief Get statistics of qos1 publish.
+ *
+ * @param[in,out] client pointer to mqtt_client
+ * @param[out] stats @see MQTTPubStatistics
+ */
+void qcloud_iot_mqtt_get_pub_statistics(QcloudIotClient *client, MQTTPubStatistics *stats)
+{
+    HAL_MutexLock(client->lock_generic);
+    *stats                    = client->pub_stats;
+    stats->inflight_count     = client->pub_wait_table.count;
+    stats->avg_ack_latency_ms = stats->acked_count ? client->total_ack_latency_ms / stats->acked_count : 0;
+    HAL_MutexUnlock(client->lock_generic);
+}
+
+/**
+ * @brief Init puback waiting table.
+ *
+ * @param[in,out] client pointer to mqtt_client
+ * @param[in] window_size max publish in flight, 0 for MAX_REPUB_NUM
+ * @return @see IotReturnCode
+ */
+int qcloud_iot_mqtt_pub_wait_table_init(QcloudIotClient *client, uint32_t window_size)
+{
+    QcloudIotPubWaitTable *table = &client->pub_wait_table;
+
+    memset(table, 0, sizeof(QcloudIotPubWaitTable));
+
+    window_size        = window_size ? window_size : MAX_REPUB_NUM;
+    table->window_size = window_size > MAX_PUB_WINDOW_SIZE ? MAX_PUB_WINDOW_SIZE : window_size;
+
+    // keep load factor under 0.5 for short probe sequence
+    table->capacity = 1;
+    while (table->capacity < 2 * table->window_size) {
+        table->capacity <<= 1;
+    }
+
+    table->slots = (QcloudIotPubInfo **)HAL_Malloc(table->capacity * sizeof(QcloudIotPubInfo *));
+    if (!table->slots) {
+        return QCLOUD_ERR_MALLOC;
+    }
+    memset(table->slots, 0, table->capacity * sizeof(QcloudIotPubInfo *));
+
+    table->lock = HAL_MutexCreate();
+    if (!table->lock) {
+        HAL_Free(table->slots);
+        table->slots = NULL;
+        return QCLOUD_ERR_FAILURE;
+    }
+
+    table->wheel_tick = HAL_Timer_CurrentMs() / PUB_WAIT_WHEEL_TICK_MS;
+    return QCLOUD_RET_SUCCESS;
+}
+
+/**
+ * @brief Deinit puback waiting table and free publish info in flight.
+ *
+ * @param[in,out] client pointer to mqtt_client
+ */
+void qcloud_iot_mqtt_pub_wait_table_deinit(QcloudIotClient *client)
+{
+    uint32_t               i;
+    QcloudIotPubWaitTable *table = &client->pub_wait_table;
+
+    if (table->slots) {
+        for (i = 0; i < table->capacity; i++) {
+            _free_pub_info(table->slots[i]);
+        }
+        HAL_Free(table->slots);
+    }
+    HAL_MutexDestroy(table->lock);
+    memset(table, 0, sizeof(QcloudIotPubWaitTable));
+}
@@ -38,6 +38,376 @@ typedef struct {
     SubTopicHandle handler;
 } QcloudIotSubConext;
 
+/**************************************************************************************
+ * subscription index
+ **************************************************************************************/
+
+/**
+ * @brief Hash of topic, FNV-1a.
+ *
+ * @param[in] topic topic filter or topic name
+ * @param[in] len length of topic
+ * @return hash value
+ */
+static uint32_t _sub_index_hash(const char *topic, int len)
+{
+    uint32_t hash = 2166136261u;
+    while (len-- > 0) {
+        hash ^= (uint8_t)*topic++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/**
+ * @brief Return if topic filter has wildcard.
+ *
+ * @param[in] topic_filter topic filter
+ * @return true for wildcard filter
+ */
+static bool _is_wildcard_filter(const char *topic_filter)
+{
+    return strchr(topic_filter, '+') || strchr(topic_filter, '#');
+}
+
+/**
+ * @brief Get end of current topic level.
+ *
+ * @param[in] level start of topic level
+ * @param[in] end end of topic
+ * @return pointer to separator or end of topic
+ */
+static const char *_topic_level_end(const char *level, const char *end)
+{
+    const char *level_end = memchr(level, '/', end - level);
+    return level_end ? level_end : end;
+}
+
+/**
+ * @brief Return if trie node is the wildcard level.
+ *
+ * @param[in] node trie node
+ * @param[in] wildcard '+' or '#'
+ * @return true for wildcard level
+ */
+static bool _topic_node_is_wildcard(const QcloudIotTopicNode *node, char wildcard)
+{
+    return node->level_len == 1 && node->level[0] == wildcard;
+}
+
+/**
+ * @brief Get child node with the topic level, create one if not found and required.
+ *
+ * @param[in,out] parent parent node
+ * @param[in] level topic level
+ * @param[in] len length of topic level
+ * @param[in] create create child if not found
+ * @return NULL for not found or malloc fail
+ */
+static QcloudIotTopicNode *_topic_node_get_child(QcloudIotTopicNode *parent, const char *level, int len, bool create)
+{
+    QcloudIotTopicNode *child;
+
+    for (child = parent->child; child; child = child->sibling) {
+        if (child->level_len == len && !memcmp(child->level, level, len)) {
+            return child;
+        }
+    }
+
+    if (!create) {
+        return NULL;
+    }
+
+    child = (QcloudIotTopicNode *)HAL_Malloc(sizeof(QcloudIotTopicNode) + len + 1);
+    if (!child) {
+        return NULL;
+    }
+    memset(child, 0, sizeof(QcloudIotTopicNode));
+    child->level = (char *)child + sizeof(QcloudIotTopicNode);
+    memcpy(child->level, level, len);
+    child->level[len] = '\0';
+    child->level_len  = len;
+    child->parent     = parent;
+    child->sibling    = parent->child;
+    parent->child     = child;
+    return child;
+}
+
+/**
+ * @brief Free nodes no longer used, from leaf to root.
+ *
+ * @param[in,out] node trie node
+ */
+static void _topic_trie_prune(QcloudIotTopicNode *node)
+{
+    QcloudIotTopicNode *parent, **pp;
+
+    while (node->parent && !node->entry && !node->child) {
+        parent = node->parent;
+        for (pp = &parent->child; *pp != node; pp = &(*pp)->sibling) {
+        }
+        *pp = node->sibling;
+        HAL_Free(node);
+        node = parent;
+    }
+}
+
+/**
+ * @brief Get trie node of wildcard filter.
+ *
+ * @param[in,out] root root of topic trie
+ * @param[in] topic_filter wildcard filter
+ * @param[in] create create nodes if not found
+ * @return NULL for not found or malloc fail
+ */
+static QcloudIotTopicNode *_topic_trie_get_node(QcloudIotTopicNode *root, const char *topic_filter, bool create)
+{
+    QcloudIotTopicNode *node = root, *parent;
+    const char         *level = topic_filter;
+    const char         *end   = topic_filter + strlen(topic_filter);
+    const char         *level_end;
+
+    do {
+        parent    = node;
+        level_end = _topic_level_end(level, end);
+        node      = _topic_node_get_child(parent, level, level_end - level, create);
+        level     = level_end + 1;
+    } while (node && level_end < end);
+
+    if (!node && create) {
+        _topic_trie_prune(parent);
+    }
+    return node;
+}
+
+/**
+ * @brief Get subscription of the last topic level, "#" also matches its parent level.
+ *
+ * @param[in] node trie node of the last topic level
+ * @return NULL for no subscription
+ */
+static QcloudIotSubEntry *_topic_node_get_entry(const QcloudIotTopicNode *node)
+{
+    QcloudIotTopicNode *child;
+
+    if (node->entry) {
+        return node->entry;
+    }
+
+    for (child = node->child; child; child = child->sibling) {
+        if (_topic_node_is_wildcard(child, '#')) {
+            return child->entry;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Match topic name from the topic level, cost depends on topic depth rather than subscription count.
+ *
+ * @param[in] node trie node of the previous topic level
+ * @param[in] level start of current topic level
+ * @param[in] end end of topic name
+ * @return NULL for no matched
+ */
+static QcloudIotSubEntry *_topic_trie_match(const QcloudIotTopicNode *node, const char *level, const char *end)
+{
+    QcloudIotTopicNode *child;
+    QcloudIotSubEntry  *entry, *multi_level_entry = NULL;
+    const char         *level_end = _topic_level_end(level, end);
+    int                 len       = level_end - level;
+
+    for (child = node->child; child; child = child->sibling) {
+        if (_topic_node_is_wildcard(child, '#')) {
+            multi_level_entry = child->entry;
+            continue;
+        }
+
+        if (!_topic_node_is_wildcard(child, '+') && (child->level_len != len || memcmp(child->level, level, len))) {
+            continue;
+        }
+
+        entry = level_end == end ? _topic_node_get_entry(child) : _topic_trie_match(child, level_end + 1, end);
+        if (entry) {
+            return entry;
+        }
+    }
+    return multi_level_entry;
+}
+
+/**
+ * @brief Find exact filter in hash.
+ *
+ * @param[in] index subscription index
+ * @param[in] topic topic filter or topic name
+ * @param[in] len length of topic
+ * @param[in] hash hash of topic
+ * @return NULL for not found
+ */
+static QcloudIotSubEntry *_sub_hash_find(const QcloudIotSubIndex *index, const char *topic, int len, uint32_t hash)
+{
+    QcloudIotSubEntry *entry;
+
+    if (!index->buckets) {
+        return NULL;
+    }
+
+    for (entry = index->buckets[hash & (index->bucket_num - 1)]; entry; entry = entry->hash_next) {
+        if (entry->hash == hash && !strncmp(entry->handle.topic_filter, topic, len) &&
+            !entry->handle.topic_filter[len]) {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Insert exact filter to hash, buckets doubles when full.
+ *
+ * @param[in,out] index subscription index
+ * @param[in] entry subscription entry
+ * @return @see IotReturnCode
+ */
+static int _sub_hash_insert(QcloudIotSubIndex *index, QcloudIotSubEntry *entry)
+{
+    uint32_t            i, bucket_num;
+    QcloudIotSubEntry **buckets, *node, *next;
+
+    if (index->exact_count >= index->bucket_num) {
+        bucket_num = index->bucket_num ? index->bucket_num << 1 : SUB_INDEX_MIN_BUCKET_NUM;
+        buckets    = (QcloudIotSubEntry **)HAL_Malloc(bucket_num * sizeof(QcloudIotSubEntry *));
+        if (!buckets) {
+            return QCLOUD_ERR_MALLOC;
+        }
+        memset(buckets, 0, bucket_num * sizeof(QcloudIotSubEntry *));
+
+        for (i = 0; i < index->bucket_num; i++) {
+            for (node = index->buckets[i]; node; node = next) {
+                next                                   = node->hash_next;
+                node->hash_next                        = buckets[node->hash & (bucket_num - 1)];
+                buckets[node->hash & (bucket_num - 1)] = node;
+            }
+        }
+        HAL_Free(index->buckets);
+        index->buckets    = buckets;
+        index->bucket_num = bucket_num;
+    }
+
+    entry->hash_next                                      = index->buckets[entry->hash & (index->bucket_num - 1)];
+    index->buckets[entry->hash & (index->bucket_num - 1)] = entry;
+    index->exact_count++;
+    return QCLOUD_RET_SUCCESS;
+}
+
+/**
+ * @brief Remove exact filter from hash.
+ *
+ * @param[in,out] index subscription index
+ * @param[in] entry subscription entry
+ */
+static void _sub_hash_remove(QcloudIotSubIndex *index, QcloudIotSubEntry *entry)
+{
+    QcloudIotSubEntry **pp = &index->buckets[entry->hash & (index->bucket_num - 1)];
+
+    while (*pp != entry) {
+        pp = &(*pp)->hash_next;
+    }
+    *pp = entry->hash_next;
+    index->exact_count--;
+}
+
+/**
+ * @brief Find subscription with the same topic filter.
+ *
+ * @param[in,out] index subscription index
+ * @param[in] topic_filter topic filter
+ * @return NULL for not found
+ */
+static QcloudIotSubEntry *_sub_index_find(QcloudIotSubIndex *index, const char *topic_filter)
+{
+    QcloudIotTopicNode *node;
+    int                 len = strlen(topic_filter);
+
+    if (!_is_wildcard_filter(topic_filter)) {
+        return _sub_hash_find(index, topic_filter, len, _sub_index_hash(topic_filter, len));
+    }
+
+    node = _topic_trie_get_node(&index->root, topic_filter, false);
+    return node ? node->entry : NULL;
+}
+
+/**
+ * @brief Add subscription to index, topic filter should not exist.
+ *
+ * @param[in,out] index subscription index
+ * @param[in] sub_handle sub handle
+ * @return @see IotReturnCode
+ */
+static int _sub_index_add(QcloudIotSubIndex *index, const SubTopicHandle *sub_handle)
+{
+    QcloudIotSubEntry *entry;
+
+    entry = (QcloudIotSubEntry *)HAL_Malloc(sizeof(QcloudIotSubEntry));
+    if (!entry) {
+        return QCLOUD_ERR_MALLOC;
+    }
+    memset(entry, 0, sizeof(QcloudIotSubEntry));
+    entry->handle = *sub_handle;
+
+    if (_is_wildcard_filter(sub_handle->topic_filter)) {
+        entry->node = _topic_trie_get_node(&index->root, sub_handle->topic_filter, true);
+        if (!entry->node) {
+            goto error;
+        }
+        entry->node->entry = entry;
+    } else {
+        entry->hash = _sub_index_hash(sub_handle->topic_filter, strlen(sub_handle->topic_filter));
+        if (_sub_hash_insert(index, entry)) {
+            goto error;
+        }
+    }
+
+    entry->next = index->head;
+    if (index->head) {
+        index->head->prev = entry;
+    }
+    index->head = entry;
+    return QCLOUD_RET_SUCCESS;
+error:
+    HAL_Free(entry);
+    return QCLOUD_ERR_MALLOC;
+}
+
+/**
+ * @brief Remove subscription from index and free the entry, sub handle should be cleared by caller.
+ *
+ * @param[in,out] index subscription index
+ * @param[in] entry subscription entry
+ */
+static void _sub_index_remove(QcloudIotSubIndex *index, QcloudIotSubEntry *entry)
+{
+    if (entry->node) {
+        entry->node->entry = NULL;
+        _topic_trie_prune(entry->node);
+    } else {
+        _sub_hash_remove(index, entry);
+    }
+
+    if (entry->prev) {
+        entry->prev->next = entry->next;
+    } else {
+        index->head = entry->next;
+    }
+    if (entry->next) {
+        entry->next->prev = entry->prev;
+    }
+    HAL_Free(entry);
+}
+
+/**************************************************************************************
+ * subscribe
+ **************************************************************************************/
+
 /**
  * @brief Free topic_filter and user_data
  *
@@ -197,68 +567,56 @@ static void _pop_sub_info_from_list(QcloudIotClient *client, uint16_t packet_id,
  * @return true topic exist
  * @return false topic no exist
  */
-static bool _remove_sub_handle_from_array(QcloudIotClient *client, const char *topic_filter)
+static bool _remove_sub_handle(QcloudIotClient *client, const char *topic_filter)
 {
-    int  i;
-    bool topic_exists = false;
+    QcloudIotSubEntry *entry;
 
-    // remove from message handler array
+    // remove from subscription index
     HAL_MutexLock(client->lock_generic);
-    for (i = 0; i < MAX_MESSAGE_HANDLERS; ++i) {
-        if ((client->sub_handles[i].topic_filter && !strcmp(client->sub_handles[i].topic_filter, topic_filter)) ||
-            strstr(topic_filter, "/#") || strstr(topic_filter, "/+")) {
-            // notify this event to topic subscriber
-            if (client->sub_handles[i].params.on_sub_event_handler) {
-                client->sub_handles[i].params.on_sub_event_handler(client, MQTT_EVENT_UNSUBSCRIBE,
-                                                                   client->sub_handles[i].params.user_data);
-            }
-            _clear_sub_handle(&client->sub_handles[i]);
-            // we don't want to break here, if the same topic is registered*with 2 callbacks.Unlikely scenario
-            topic_exists = true;
-        }
+    entry = _sub_index_find(&client->sub_index, topic_filter);
+    if (!entry) {
+        HAL_MutexUnlock(client->lock_generic);
+        return false;
     }
+
+    // notify this event to topic subscriber
+    if (entry->handle.params.on_sub_event_handler) {
+        entry->handle.params.on_sub_event_handler(client, MQTT_EVENT_UNSUBSCRIBE, entry->handle.params.user_data);
+    }
+    _clear_sub_handle(&entry->handle);
+    _sub_index_remove(&client->sub_index, entry);
     HAL_MutexUnlock(client->lock_generic);
-    return topic_exists;
+    return true;
 }
 
 /**
  * @brief Add sub handle when subscribe.
  *
  * @param[in,out] client pointer to mqtt_client
- * @param[in] sub_handle sub_handle to be add to array
- * @return true topic exist
- * @return false topic no exist
+ * @param[in] sub_handle sub_handle to be add to index
+ * @return @see IotReturnCode
  */
-static int _add_sub_handle_to_array(QcloudIotClient *client, const SubTopicHandle *sub_handle)
+static int _add_sub_handle(QcloudIotClient *client, const SubTopicHandle *sub_handle)
 {
     IOT_FUNC_ENTRY;
-    int i, i_free = -1;
+    int                rc = QCLOUD_RET_SUCCESS;
+    QcloudIotSubEntry *entry;
 
     HAL_MutexLock(client->lock_generic);
-
-    for (i = 0; i < MAX_MESSAGE_HANDLERS; ++i) {
-        if (client->sub_handles[i].topic_filter) {
-            if (!strcmp(client->sub_handles[i].topic_filter, sub_handle->topic_filter)) {
-                i_free = i;
-                // free the memory before
-                _clear_sub_handle(&client->sub_handles[i]);
-                Log_w("Identical topic found: %s", sub_handle->topic_filter);
-                break;
-            }
-        } else {
-            i_free = i_free == -1 ? i : i_free;
+    entry = _sub_index_find(&client->sub_index, sub_handle->topic_filter);
+    if (entry) {
+        // free the memory before
+        _clear_sub_handle(&entry->handle);
+        Log_w("Identical topic found: %s", sub_handle->topic_filter);
+        entry->handle = *sub_handle;
+    } else {
+        rc = _sub_index_add(&client->sub_index, sub_handle);
+        if (rc) {
+            Log_e("add sub handle failed: %s", sub_handle->topic_filter);
         }
     }
-
-    if (-1 == i_free) {
-        Log_e("NO more @sub_handles space!");
-        HAL_MutexUnlock(client->lock_generic);
-        IOT_FUNC_EXIT_RC(QCLOUD_ERR_FAILURE);
-    }
-
-    client->sub_handles[i_free] = *sub_handle;
     HAL_MutexUnlock(client->lock_generic);
-    IOT_FUNC_EXIT_RC(QCLOUD_RET_SUCCESS);
+    IOT_FUNC_EXIT_RC(rc);
 }
 
 /**
@@ -268,20 +626,15 @@ static int _add_sub_handle_to_array(QcloudIotClient *client, const SubTopicHandl
  * @param[in] topic_filter topic to set status
  * @param[in] status @see SubStatus
  */
-static void _set_sub_handle_status_to_array(QcloudIotClient *client, const char *topic_filter, SubStatus status)
+static void _set_sub_handle_status(QcloudIotClient *client, const char *topic_filter, SubStatus status)
 {
     IOT_FUNC_ENTRY;
-    int i;
+    QcloudIotSubEntry *entry;
 
     HAL_MutexLock(client->lock_generic);
-
-    for (i = 0; i < MAX_MESSAGE_HANDLERS; ++i) {
-        if (client->sub_handles[i].topic_filter) {
-            if (!strcmp(client->sub_handles[i].topic_filter, topic_filter)) {
-                client->sub_handles[i].status = status;
-                break;
-            }
-        }
+    entry = _sub_index_find(&client->sub_index, topic_filter);
+    if (entry) {
+        entry->handle.status = status;
     }
     HAL_MutexUnlock(client->lock_generic);
     IOT_FUNC_EXIT;
@@ -316,9 +669,10 @@ int qcloud_iot_mqtt_subscribe(QcloudIotClient *client, const char *topic_filter,
     sub_handle.status       = client->default_subscribe ? SUB_ACK_RECEIVED : SUB_ACK_NOT_RECEIVED;
 
     // add sub handle first to process
-    rc = _add_sub_handle_to_array(client, &sub_handle);
+    rc = _add_sub_handle(client, &sub_handle);
     if (rc) {
-        goto exit;
+        HAL_Free(topic_filter_stored);
+        IOT_FUNC_EXIT_RC(rc);
     }
 
     if (client->default_subscribe) {
@@ -329,6 +683,11 @@ int qcloud_iot_mqtt_subscribe(QcloudIotClient *client, const char *topic_filter,
     Log_d("subscribe topic_name=%s|packet_id=%d", topic_filter_stored, packet_id);
     // serialize packet
     HAL_MutexLock(client->lock_write_buf);
+    rc = reserve_mqtt_write_buf(client, MAX_MQTT_FIXED_HEADER_LEN + 2 + 2 + strlen(topic_filter_stored) + 1);
+    if (rc) {
+        HAL_MutexUnlock(client->lock_write_buf);
+        goto exit;
+    }
     packet_len = mqtt_subscribe_packet_serialize(client->write_buf, client->write_buf_size, packet_id, 1,
                                                  &topic_filter_stored, &qos);
     if (packet_len < 0) {
@@ -353,7 +712,7 @@ int qcloud_iot_mqtt_subscribe(QcloudIotClient *client, const char *topic_filter,
     }
     IOT_FUNC_EXIT_RC(packet_id);
 exit:
-    _remove_sub_handle_from_array(client, topic_filter_stored);
+    _remove_sub_handle(client, topic_filter_stored);
     IOT_FUNC_EXIT_RC(rc);
 }
 
@@ -391,12 +750,12 @@ int qcloud_iot_mqtt_handle_suback(QcloudIotClient *client)
         msg.event_type = MQTT_EVENT_SUBSCRIBE_NACK;
         event_type     = MQTT_EVENT_SUBSCRIBE_NACK;
         Log_e("MQTT SUBSCRIBE failed, packet_id: %u topic: %s", packet_id, sub_handle.topic_filter);
-        _remove_sub_handle_from_array(client, sub_handle.topic_filter);
+        _remove_sub_handle(client, sub_handle.topic_filter);
         rc = QCLOUD_ERR_MQTT_SUB;
     }
 
     if (MQTT_EVENT_SUBSCRIBE_SUCCESS == msg.event_type) {
-        _set_sub_handle_status_to_array(client, sub_handle.topic_filter, SUB_ACK_RECEIVED);
+        _set_sub_handle_status(client, sub_handle.topic_filter, SUB_ACK_RECEIVED);
     }
 
     // notify this event to user callback
@@ -429,7 +788,7 @@ int qcloud_iot_mqtt_unsubscribe(QcloudIotClient *client, const char *topic_filte
     memset(&sub_handle, 0, sizeof(SubTopicHandle));
 
     // remove from sub handle
-    if (!_remove_sub_handle_from_array(client, topic_filter)) {
+    if (!_remove_sub_handle(client, topic_filter)) {
         Log_w("subscription does not exists: %s", topic_filter);
         IOT_FUNC_EXIT_RC(QCLOUD_ERR_MQTT_UNSUB_FAIL);
     }
@@ -447,6 +806,11 @@ int qcloud_iot_mqtt_unsubscribe(QcloudIotClient *client, const char *topic_filte
     Log_d("unsubscribe topic_name=%s|packet_id=%d", topic_filter_stored, packet_id);
 
     HAL_MutexLock(client->lock_write_buf);
+    rc = reserve_mqtt_write_buf(client, MAX_MQTT_FIXED_HEADER_LEN + 2 + 2 + strlen(topic_filter_stored));
+    if (rc) {
+        HAL_MutexUnlock(client->lock_write_buf);
+        goto exit;
+    }
     packet_len = mqtt_unsubscribe_packet_serialize(client->write_buf, client->write_buf_size, packet_id, 1,
                                                    &topic_filter_stored);
     if (packet_len < 0) {
@@ -521,45 +885,83 @@ void qcloud_iot_mqtt_check_sub_timeout(QcloudIotClient *client)
 }
 
 /**
- * @brief Resubscribe topic when reconnect.
+ * @brief Resubscribe topic when reconnect. Filters are copied with lock_generic, then serialized and sent with
+ * lock_write_buf only.
  *
  * @param[in,out] client pointer to mqtt client
- * @return @see IotReturnCode
+ * @return @see IotReturnCode, the first failure while the rest of filters are still resubscribed unless send failed
  */
 int qcloud_iot_mqtt_resubscribe(QcloudIotClient *client)
 {
     IOT_FUNC_ENTRY;
-    int             rc, packet_len, qos, itr = 0;
-    uint16_t        packet_id;
-    SubTopicHandle *sub_handle;
-
-    for (itr = 0; itr < MAX_MESSAGE_HANDLERS; itr++) {
-        sub_handle = &client->sub_handles[itr];
-        if (!sub_handle->topic_filter) {
-            continue;
+    int                rc = QCLOUD_RET_SUCCESS, result, packet_len, count = 0, i;
+    int               *qos_list;
+    size_t             size = 0, len;
+    uint16_t           packet_id;
+    char              *topic_filter;
+    void              *snapshot = NULL;
+    QcloudIotSubEntry *entry;
+
+    // snapshot qos and filters, the entries may be removed once unlocked
+    HAL_MutexLock(client->lock_generic);
+    for (entry = client->sub_index.head; entry; entry = entry->next) {
+        size += sizeof(int) + strlen(entry->handle.topic_filter) + 1;
+        count++;
+    }
+    snapshot = count ? HAL_Malloc(size) : NULL;
+    if (snapshot) {
+        qos_list     = (int *)snapshot;
+        topic_filter = (char *)(qos_list + count);
+        for (entry = client->sub_index.head; entry; entry = entry->next) {
+            *qos_list++ = entry->handle.params.qos;
+            len         = strlen(entry->handle.topic_filter) + 1;
+            memcpy(topic_filter, entry->handle.topic_filter, len);
+            topic_filter += len;
         }
+    }
+    HAL_MutexUnlock(client->lock_generic);
+
+    if (!count) {
+        IOT_FUNC_EXIT_RC(QCLOUD_RET_SUCCESS);
+    }
+    if (!snapshot) {
+        Log_e("malloc failed, %d topics not resubscribed", count);
+        IOT_FUNC_EXIT_RC(QCLOUD_ERR_MALLOC);
+    }
 
+    qos_list     = (int *)snapshot;
+    topic_filter = (char *)(qos_list + count);
+    HAL_MutexLock(client->lock_write_buf);
+    for (i = 0; i < count; i++, topic_filter += strlen(topic_filter) + 1) {
         packet_id = get_next_packet_id(client);
-        Log_d("subscribe topic_name=%s|packet_id=%d", sub_handle->topic_filter, packet_id);
-
-        HAL_MutexLock(client->lock_write_buf);
-        qos        = sub_handle->params.qos;
-        packet_len = mqtt_subscribe_packet_serialize(client->write_buf, client->write_buf_size, packet_id, 1,
-                                                     &sub_handle->topic_filter, &qos);
-        if (packet_len < 0) {
-            HAL_MutexUnlock(client->lock_write_buf);
+        Log_d("subscribe topic_name=%s|packet_id=%d", topic_filter, packet_id);
+
+        result = reserve_mqtt_write_buf(client, MAX_MQTT_FIXED_HEADER_LEN + 2 + 2 + strlen(topic_filter) + 1);
+        if (!result) {
+            packet_len = mqtt_subscribe_packet_serialize(client->write_buf, client->write_buf_size, packet_id, 1,
+                                                         &topic_filter, &qos_list[i]);
+            if (packet_len < 0) {
+                result = packet_len == MQTT_ERR_SHORT_BUFFER ? QCLOUD_ERR_BUF_TOO_SHORT : QCLOUD_ERR_FAILURE;
+            }
+        }
+        if (result) {
+            Log_e("resubscribe topic_name=%s serialize failed, rc=%d", topic_filter, result);
+            rc = rc ? rc : result;
             continue;
         }
 
-        // send packet
-        rc = send_mqtt_packet(client, packet_len);
-        HAL_MutexUnlock(client->lock_write_buf);
-        if (rc) {
-            IOT_FUNC_EXIT_RC(rc);
+        // network is broken, the rest are resubscribed next reconnect
+        result = send_mqtt_packet(client, packet_len);
+        if (result) {
+            Log_e("resubscribe topic_name=%s send failed, rc=%d", topic_filter, result);
+            rc = rc ? rc : result;
+            break;
         }
     }
+    HAL_MutexUnlock(client->lock_write_buf);
 
-    IOT_FUNC_EXIT_RC(QCLOUD_RET_SUCCESS);
+    HAL_Free(snapshot);
+    IOT_FUNC_EXIT_RC(rc);
 }
 
 /**
@@ -573,17 +975,16 @@ int qcloud_iot_mqtt_resubscribe(QcloudIotClient *client)
 bool qcloud_iot_mqtt_is_sub_ready(QcloudIotClient *client, const char *topic_filter)
 {
     IOT_FUNC_ENTRY;
-    int i = 0;
+    bool               is_ready = false;
+    QcloudIotSubEntry *entry;
+
     HAL_MutexLock(client->lock_generic);
-    for (i = 0; i < MAX_MESSAGE_HANDLERS; ++i) {
-        if ((client->sub_handles[i].topic_filter && !strcmp(client->sub_handles[i].topic_filter, topic_filter)) ||
-            strstr(topic_filter, "/#") || strstr(topic_filter, "/+")) {
-            HAL_MutexUnlock(client->lock_generic);
-            return client->sub_handles[i].status == SUB_ACK_RECEIVED;
-        }
+    entry = _sub_index_find(&client->sub_index, topic_filter);
+    if (entry) {
+        is_ready = entry->handle.status == SUB_ACK_RECEIVED;
     }
     HAL_MutexUnlock(client->lock_generic);
-    IOT_FUNC_EXIT_RC(false);
+    IOT_FUNC_EXIT_RC(is_ready);
 }
 
 /**
@@ -596,37 +997,67 @@ bool qcloud_iot_mqtt_is_sub_ready(QcloudIotClient *client, const char *topic_fil
 void *qcloud_iot_mqtt_get_subscribe_usr_data(QcloudIotClient *client, const char *topic_filter)
 {
     IOT_FUNC_ENTRY;
-    int i = 0;
+    void              *user_data = NULL;
+    QcloudIotSubEntry *entry;
+
     HAL_MutexLock(client->lock_generic);
-    for (i = 0; i < MAX_MESSAGE_HANDLERS; ++i) {
-        if ((client->sub_handles[i].topic_filter && !strcmp(client->sub_handles[i].topic_filter, topic_filter)) ||
-            strstr(topic_filter, "/#") || strstr(topic_filter, "/+")) {
-            HAL_MutexUnlock(client->lock_generic);
-            return client->sub_handles[i].params.user_data;
-        }
+    entry = _sub_index_find(&client->sub_index, topic_filter);
+    if (entry) {
+        user_data = entry->handle.params.user_data;
     }
     HAL_MutexUnlock(client->lock_generic);
-    IOT_FUNC_EXIT_RC(NULL);
+    IOT_FUNC_EXIT_RC(user_data);
 }
 
 /**
- * @brief Clear sub handle array.
+ * @brief Get params of sub handle matched with topic name, exact filter takes precedence over wildcard filter.
  *
  * @param[in,out] client pointer to mqtt client
+ * @param[in] topic_name topic name, no wildcard
+ * @param[in] topic_len length of topic name
+ * @param[out] params params of matched sub handle
+ * @return true for matched
+ * @return false for no matched
  */
-void qcloud_iot_mqtt_sub_handle_array_clear(QcloudIotClient *client)
+bool qcloud_iot_mqtt_match_sub_params(QcloudIotClient *client, const char *topic_name, uint16_t topic_len,
+                                      SubscribeParams *params)
+{
+    QcloudIotSubEntry *entry;
+
+    HAL_MutexLock(client->lock_generic);
+    entry = _sub_hash_find(&client->sub_index, topic_name, topic_len, _sub_index_hash(topic_name, topic_len));
+    if (!entry) {
+        entry = _topic_trie_match(&client->sub_index.root, topic_name, topic_name + topic_len);
+    }
+    if (entry) {
+        *params = entry->handle.params;
+    }
+    HAL_MutexUnlock(client->lock_generic);
+    return entry != NULL;
+}
+
+/**
+ * @brief Clear sub handle index.
+ *
+ * @param[in,out] client pointer to mqtt client
+ */
+void qcloud_iot_mqtt_sub_handle_clear(QcloudIotClient *client)
 {
     IOT_FUNC_ENTRY;
-    int i;
-    for (i = 0; i < MAX_MESSAGE_HANDLERS; ++i) {
+    QcloudIotSubEntry *entry;
+
+    while ((entry = client->sub_index.head)) {
         /* notify this event to topic subscriber */
-        if (client->sub_handles[i].topic_filter && client->sub_handles[i].params.on_sub_event_handler) {
-            client->sub_handles[i].params.on_sub_event_handler(client, MQTT_EVENT_CLIENT_DESTROY,
-                                                               client->sub_handles[i].params.user_data);
+        if (entry->handle.params.on_sub_event_handler) {
+            entry->handle.params.on_sub_event_handler(client, MQTT_EVENT_CLIENT_DESTROY,
+                                                      entry->handle.params.user_data);
         }
-        _clear_sub_handle(&client->sub_handles[i]);
+        _clear_sub_handle(&entry->handle);
+        _sub_index_remove(&client->sub_index, entry);
     }
 
+    HAL_Free(client->sub_index.buckets);
+    memset(&client->sub_index, 0, sizeof(QcloudIotSubIndex));
     IOT_FUNC_EXIT;
 }
 
@@ -35,6 +35,18 @@
  */
 #define QCLOUD_IOT_MQTT_MAX_REMAIN_WAIT_MS (100)
 
+/**
+ * @brief Lower limit of ping interval shrunk for nat idle timeout (unit: ms)
+ *
+ */
+#define MQTT_PING_MIN_INTERVAL_MS (5000)
+
+/**
+ * @brief Ping responses at current interval before probing a longer one
+ *
+ */
+#define MQTT_PING_PROBE_TIMES (3)
+
 /**
  * @brief Read one byte from network for mqtt packet header except remaining length.
  *
@@ -128,7 +140,7 @@ static void _discard_packet_for_short_buf(QcloudIotClient *client, uint32_t time
     timeout_ms = timeout_ms <= 0 ? 1 : timeout_ms;
     timeout_ms += QCLOUD_IOT_MQTT_MAX_REMAIN_WAIT_MS;
 
-    bytes_to_be_read = client->read_buf_size;
+    bytes_to_be_read = rem_len >= client->read_buf_size ? client->read_buf_size : rem_len;
     do {
         rc = client->network_stack.read(&(client->network_stack), client->read_buf, bytes_to_be_read, timeout_ms,
                                         &read_len);
@@ -175,6 +187,43 @@ static int _read_packet_payload(QcloudIotClient *client, uint32_t timeout_ms, ui
     return QCLOUD_RET_SUCCESS;
 }
 
+/**
+ * @brief Read variable header of publish packet larger than read buffer, the payload is left to be streamed.
+ *
+ * @param[in,out] client pointer to mqtt_client
+ * @param[in] timeout_ms timeout to read
+ * @param[in,out] rem_len remaining length, minus length of variable header read
+ * @param[in,out] pptr pointer to buf pointer
+ * @return @see IotReturnCode
+ */
+static int _read_publish_header(QcloudIotClient *client, uint32_t timeout_ms, uint32_t *rem_len, uint8_t **pptr)
+{
+    int      rc;
+    uint32_t header_len;
+    uint8_t *buf = *pptr;
+
+    // 1. read topic length
+    rc = _read_packet_payload(client, timeout_ms, 2, buf);
+    if (rc) {
+        return rc;
+    }
+    *rem_len -= 2;
+
+    // 2. read topic name and packet id if qos > 0
+    header_len = ((buf[0] << 8) | buf[1]) + ((client->read_buf[0] & 0x06) ? 2 : 0);
+    if (header_len > *rem_len || buf + 2 + header_len >= client->read_buf + client->read_buf_size) {
+        return QCLOUD_ERR_BUF_TOO_SHORT;
+    }
+
+    rc = _read_packet_payload(client, timeout_ms, header_len, buf + 2);
+    if (rc) {
+        return rc;
+    }
+    *rem_len -= header_len;
+    *pptr += 2 + header_len;
+    return QCLOUD_RET_SUCCESS;
+}
+
 /**
  * @brief Read MQTT packet from network stack
  *
@@ -186,17 +235,19 @@ static int _read_packet_payload(QcloudIotClient *client, uint32_t timeout_ms, ui
  * @note
  * 1. read 1st byte in fixed header and check if valid
  * 2. read the remaining length
- * 3. read payload according to remaining length
+ * 3. read payload according to remaining length, only header of publish larger than read buffer is read
  */
 static int _read_mqtt_packet(QcloudIotClient *client, Timer *timer, uint8_t *packet_type)
 {
     IOT_FUNC_ENTRY;
     int      rc      = 0;
-    uint32_t rem_len = 0, packet_len = 0;
+    uint32_t rem_len = 0, packet_len = 0, header_len = 0;
+    uint32_t wait_ms = HAL_Timer_Remain(timer), batch_remain_ms = get_mqtt_pub_batch_remain_ms(client);
     uint8_t *packet_read_buf = client->read_buf;
 
-    // 1. read 1st byte in fixed header and check if valid
-    rc = _read_packet_header(client, HAL_Timer_Remain(timer), packet_type, &packet_read_buf);
+    // 1. read 1st byte in fixed header and check if valid, wake up in time to flush publish batch
+    wait_ms = batch_remain_ms < wait_ms ? batch_remain_ms : wait_ms;
+    rc      = _read_packet_header(client, wait_ms, packet_type, &packet_read_buf);
     if (rc) {
         IOT_FUNC_EXIT_RC(rc);
     }
@@ -207,9 +258,22 @@ static int _read_mqtt_packet(QcloudIotClient *client, Timer *timer, uint8_t *pac
         IOT_FUNC_EXIT_RC(rc);
     }
 
-    // if read buffer is not enough to read the remaining length, discard the packet
+    // grow read buffer on demand, keep the header read
     packet_len = packet_read_buf - client->read_buf + rem_len;
+    header_len = packet_read_buf - client->read_buf;
+    if (!reserve_mqtt_read_buf(client, packet_len)) {
+        packet_read_buf = client->read_buf + header_len;
+    }
+
+    // if read buffer is not enough to read the remaining length, stream the publish payload or discard the packet
     if (packet_len >= client->read_buf_size) {
+        if (PUBLISH == *packet_type) {
+            rc = _read_publish_header(client, HAL_Timer_Remain(timer), &rem_len, &packet_read_buf);
+            if (QCLOUD_ERR_BUF_TOO_SHORT != rc) {
+                // payload is left in network and streamed by qcloud_iot_mqtt_handle_publish
+                IOT_FUNC_EXIT_RC(rc);
+            }
+        }
         _discard_packet_for_short_buf(client, HAL_Timer_Remain(timer), rem_len);
         Log_e("MQTT Recv buffer not enough: %lu < %d", client->read_buf_size, rem_len);
         IOT_FUNC_EXIT_RC(QCLOUD_ERR_BUF_TOO_SHORT);
@@ -223,17 +287,100 @@ static int _read_mqtt_packet(QcloudIotClient *client, Timer *timer, uint8_t *pac
 }
 
 /**
- * @brief Reset ping counter & ping timer.
+ * @brief Arm ping timer to the time ping is due. Ping is due when connection is idle in both directions for ping
+ * interval (nat), nothing is sent for keep alive interval (server), or nothing is received for keep alive interval
+ * (liveness). Should be called with lock_generic locked.
+ *
+ * @param[in,out] client pointer to mqtt_client
+ * @param[in] now current timestamp
+ * @return time left before ping is due, 0 for due now
+ */
+static uint32_t _keep_alive_schedule(QcloudIotClient *client, uint64_t now)
+{
+    uint64_t last_send     = __atomic_load_n(&client->last_send_ms, __ATOMIC_RELAXED);
+    uint64_t last_active   = last_send > client->last_recv_ms ? last_send : client->last_recv_ms;
+    uint32_t keep_alive_ms = client->options.keep_alive_interval * 1000;
+    uint64_t due           = last_active + client->ping_interval_ms;
+
+    due = last_send + keep_alive_ms < due ? last_send + keep_alive_ms : due;
+    due = client->last_recv_ms + keep_alive_ms < due ? client->last_recv_ms + keep_alive_ms : due;
+    if (due <= now) {
+        return 0;
+    }
+    HAL_Timer_CountdownMs(&client->ping_timer, due - now);
+    return due - now;
+}
+
+/**
+ * @brief Lengthen ping interval after several ping responses, bounded by keep alive interval and nat idle timeout
+ * found. Should be called with lock_generic locked.
  *
  * @param[in,out] client pointer to mqtt_client
  */
-static void _handle_pingresp_packet(QcloudIotClient *client)
+static void _keep_alive_probe_longer(QcloudIotClient *client)
+{
+    uint32_t max_ms  = client->options.keep_alive_interval * 1000;
+    uint32_t nat_ms  = client->keep_alive_stats.nat_idle_timeout_ms;
+    uint32_t next_ms = client->ping_interval_ms + client->ping_interval_ms / 4;
+
+    max_ms = nat_ms && nat_ms - nat_ms / 4 < max_ms ? nat_ms - nat_ms / 4 : max_ms;
+    if (client->ping_interval_ms >= max_ms || ++client->ping_probe_count < MQTT_PING_PROBE_TIMES) {
+        return;
+    }
+
+    client->ping_probe_count = 0;
+    client->ping_interval_ms = next_ms < max_ms ? next_ms : max_ms;
+}
+
+/**
+ * @brief Shrink ping interval if connection was broken after idle and reconnect succeeds, which means the path is fine
+ * but the idle connection is dropped, probably by nat. Should be called with lock_generic locked.
+ *
+ * @param[in,out] client pointer to mqtt_client
+ */
+static void _keep_alive_shrink(QcloudIotClient *client)
+{
+    uint32_t idle_ms = client->broken_idle_ms;
+    uint32_t min_ms  = client->options.keep_alive_interval * 1000;
+
+    client->broken_idle_ms = 0;
+    min_ms                 = min_ms < MQTT_PING_MIN_INTERVAL_MS ? min_ms : MQTT_PING_MIN_INTERVAL_MS;
+    if (idle_ms <= min_ms) {
+        return;
+    }
+
+    client->keep_alive_stats.nat_idle_timeout_ms = idle_ms;
+    client->ping_interval_ms                     = idle_ms / 2 > min_ms ? idle_ms / 2 : min_ms;
+    client->ping_probe_count                     = 0;
+    Log_w("connection broken after idle %u ms, ping interval shrinks to %u ms", idle_ms, client->ping_interval_ms);
+}
+
+/**
+ * @brief Any packet received means the connection is alive, clear ping outstanding and reschedule ping. Round trip
+ * time is measured by ping response.
+ *
+ * @param[in,out] client pointer to mqtt_client
+ * @param[in] packet_type packet type received
+ */
+static void _handle_packet_received(QcloudIotClient *client, uint8_t packet_type)
 {
     IOT_FUNC_ENTRY;
 
+    uint64_t                 now   = HAL_Timer_CurrentMs();
+    MQTTKeepAliveStatistics *stats = &client->keep_alive_stats;
+
     HAL_MutexLock(client->lock_generic);
-    client->is_ping_outstanding = 0;
-    HAL_Timer_Countdown(&client->ping_timer, client->options.keep_alive_interval);
+    client->last_recv_ms = now;
+    if (PINGRESP == packet_type) {
+        stats->ping_resp_count++;
+        stats->last_rtt_ms = now - client->ping_send_ms;
+        client->total_ping_rtt_ms += stats->last_rtt_ms;
+        _keep_alive_probe_longer(client);
+    }
+    if (client->is_ping_outstanding) {
+        client->is_ping_outstanding = 0;
+        _keep_alive_schedule(client, now);
+    }
     HAL_MutexUnlock(client->lock_generic);
 
     IOT_FUNC_EXIT;
@@ -289,22 +436,8 @@ static int _cycle_for_read(QcloudIotClient *client, Timer *timer, uint8_t *packe
             break;
     }
 
-    switch (*packet_type) {
-        // Recv below msgs are all considered as PING OK
-        case PUBACK:
-        case SUBACK:
-        case UNSUBACK:
-        case PINGRESP:
-            _handle_pingresp_packet(client);
-            break;
-
-        // Recv downlink pub means link is OK but we still need to send PING request
-        case PUBLISH:
-            HAL_MutexLock(client->lock_generic);
-            client->is_ping_outstanding = 0;
-            HAL_MutexUnlock(client->lock_generic);
-            break;
-    }
+    // any packet received is considered as PING OK
+    _handle_packet_received(client, *packet_type);
 
     IOT_FUNC_EXIT_RC(rc);
 }
@@ -321,7 +454,9 @@ static void _set_reconnect_wait_interval(QcloudIotClient *client)
         srand(HAL_Timer_CurrentSec());
         // range: 1000 - 2000 ms, in 10ms unit
         client->current_reconnect_wait_interval = (rand() % 100 + 100) * 10;
-        HAL_Timer_CountdownMs(&(client->reconnect_delay_timer), client->current_reconnect_wait_interval);
+        // reconnect at once with standby connection, the interval is kept for backoff if it fails
+        HAL_Timer_CountdownMs(&(client->reconnect_delay_timer),
+                              client->standby_connect_enable ? 0 : client->current_reconnect_wait_interval);
     }
 }
 
@@ -340,6 +475,11 @@ static void _handle_disconnect(QcloudIotClient *client)
         return;
     }
 
+    // idle time is checked when reconnected to find nat idle timeout
+    HAL_MutexLock(client->lock_generic);
+    client->broken_idle_ms = client->is_ping_outstanding ? client->ping_idle_ms : 0;
+    HAL_MutexUnlock(client->lock_generic);
+
     rc = qcloud_iot_mqtt_disconnect(client);
     // disconnect network stack by force
     if (rc) {
@@ -383,6 +523,10 @@ static int _handle_reconnect(QcloudIotClient *client)
     rc = qcloud_iot_mqtt_attempt_reconnect(client);
     if (QCLOUD_RET_MQTT_RECONNECTED == rc) {
         Log_e("attempt to reconnect success.");
+        HAL_MutexLock(client->lock_generic);
+        _keep_alive_shrink(client);
+        HAL_Timer_CountdownMs(&client->ping_timer, client->ping_interval_ms);
+        HAL_MutexUnlock(client->lock_generic);
         // notify event
         if (client->event_handle.h_fp) {
             msg.event_type = MQTT_EVENT_RECONNECT;
@@ -405,7 +549,8 @@ static int _handle_reconnect(QcloudIotClient *client)
 }
 
 /**
- * @brief Handle MQTT keep alive (hearbeat with server).
+ * @brief Handle MQTT keep alive (hearbeat with server). Any packet sent or received counts as keep alive, so ping is
+ * only sent when connection is idle, @see _keep_alive_schedule.
  *
  * @param[in,out] client pointer to mqtt client
  * @return @see IotReturnCode
@@ -416,7 +561,9 @@ static int _mqtt_keep_alive(QcloudIotClient *client)
 #define MQTT_PING_SEND_RETRY_TIMES 3
 
     IOT_FUNC_ENTRY;
-    int rc = 0;
+    int      rc = 0;
+    uint8_t  ping_outstanding;
+    uint64_t now, last_send, last_active;
 
     if (0 == client->options.keep_alive_interval) {
         IOT_FUNC_EXIT_RC(QCLOUD_RET_SUCCESS);
@@ -426,7 +573,24 @@ static int _mqtt_keep_alive(QcloudIotClient *client)
         IOT_FUNC_EXIT_RC(QCLOUD_RET_SUCCESS);
     }
 
-    if (client->is_ping_outstanding >= MQTT_PING_RETRY_TIMES) {
+    now       = HAL_Timer_CurrentMs();
+    last_send = __atomic_load_n(&client->last_send_ms, __ATOMIC_RELAXED);
+
+    // ping state is also updated by packet received and connect, which may run in other threads
+    HAL_MutexLock(client->lock_generic);
+    last_active      = last_send > client->last_recv_ms ? last_send : client->last_recv_ms;
+    ping_outstanding = client->is_ping_outstanding;
+    if (ping_outstanding) {
+        client->keep_alive_stats.ping_timeout_count++;
+    } else if (_keep_alive_schedule(client, now)) {
+        // packets sent or received after ping timer set, no need to ping
+        client->keep_alive_stats.ping_suppressed_count++;
+        HAL_MutexUnlock(client->lock_generic);
+        IOT_FUNC_EXIT_RC(QCLOUD_RET_SUCCESS);
+    }
+    HAL_MutexUnlock(client->lock_generic);
+
+    if (ping_outstanding >= MQTT_PING_RETRY_TIMES) {
         // reaching here means we haven't received any MQTT packet for a long time (keep_alive_interval)
         Log_e("Fail to recv MQTT msg. Something wrong with the connection.");
         _handle_disconnect(client);
@@ -445,14 +609,44 @@ static int _mqtt_keep_alive(QcloudIotClient *client)
 
     // start a timer to wait for PINGRESP from server
     HAL_MutexLock(client->lock_generic);
-    client->is_ping_outstanding++;
+    if (!client->is_ping_outstanding) {
+        client->ping_idle_ms = now - last_active;
+    }
+    ping_outstanding     = ++client->is_ping_outstanding;
+    client->ping_send_ms = HAL_Timer_CurrentMs();
+    client->keep_alive_stats.ping_sent_count++;
     HAL_Timer_CountdownMs(&client->ping_timer, client->command_timeout_ms);
     HAL_MutexUnlock(client->lock_generic);
-    Log_d("PING request %u has been sent...", client->is_ping_outstanding);
+    Log_d("PING request %u has been sent...", ping_outstanding);
 
     IOT_FUNC_EXIT_RC(QCLOUD_RET_SUCCESS);
 }
 
+/**
+ * @brief Handle timeout of publish batch, ACK and keep alive, which is checked after packet read.
+ *
+ * @param[in,out] client pointer to mqtt client
+ * @return @see IotReturnCode
+ */
+static int _handle_periodic(QcloudIotClient *client)
+{
+    // flush publish batch if deadline passes, write failure is found by next read or keep alive
+    flush_mqtt_pub_batch(client, true);
+    // check list of wait publish ACK to remove node that is ACKED or timeout
+    qcloud_iot_mqtt_check_pub_timeout(client);
+    // check list of wait subscribe(or unsubscribe) ACK to remove node that is ACKED or timeout
+    qcloud_iot_mqtt_check_sub_timeout(client);
+    // shrink buffer grown on demand when idle
+    shrink_mqtt_buf(client);
+    // start standby connection if it is used or broken
+    if (client->standby_connect_enable && HAL_Timer_Expired(&client->standby_timer)) {
+        client->network_stack.prewarm(&client->network_stack, 1);
+        HAL_Timer_CountdownMs(&client->standby_timer, MQTT_STANDBY_CHECK_INTERVAL_MS);
+    }
+
+    return _mqtt_keep_alive(client);
+}
+
 /**
  * @brief Check connection and keep alive state, read/handle MQTT message in synchronized way.
  *
@@ -498,12 +692,7 @@ int qcloud_iot_mqtt_yield(QcloudIotClient *client, uint32_t timeout_ms)
         rc = _cycle_for_read(client, &timer, &packet_type);
         switch (rc) {
             case QCLOUD_RET_SUCCESS:
-                // check list of wait publish ACK to remove node that is ACKED or timeout
-                qcloud_iot_mqtt_check_pub_timeout(client);
-                // check list of wait subscribe(or unsubscribe) ACK to remove node that is ACKED or timeout
-                qcloud_iot_mqtt_check_sub_timeout(client);
-
-                rc = _mqtt_keep_alive(client);
+                rc = _handle_periodic(client);
                 if (rc) {
                     IOT_FUNC_EXIT_RC(client->auto_connect_enable ? QCLOUD_ERR_MQTT_ATTEMPTING_RECONNECT : rc);
                 }
@@ -525,6 +714,92 @@ int qcloud_iot_mqtt_yield(QcloudIotClient *client, uint32_t timeout_ms)
     IOT_FUNC_EXIT_RC(rc);
 }
 
+/**
+ * @brief Read/handle MQTT message already received and check keep alive state without waiting, for event loop.
+ *
+ * @param[in,out] client pointer to mqtt client
+ * @param[in] readable if socket is readable, otherwise only data buffered by network is read
+ * @return QCLOUD_RET_SUCCESS when success, QCLOUD_ERR_MQTT_ATTEMPTING_RECONNECT when try reconnecting, others @see
+ * IotReturnCode
+ *
+ * @note At most MQTT_YIELD_READY_MAX_PACKETS packets are handled for fairness among clients, check
+ * network_stack.get_bytes_avail for packets left. Packet partially received is waited for at most
+ * QCLOUD_IOT_MQTT_MAX_REMAIN_WAIT_MS.
+ */
+int qcloud_iot_mqtt_yield_ready(QcloudIotClient *client, bool readable)
+{
+    IOT_FUNC_ENTRY;
+
+    int     rc    = QCLOUD_RET_SUCCESS;
+    int     count = 0;
+    uint8_t packet_type;
+    Timer   timer;
+
+    // 1. check connection state, reconnect is tried when reconnect delay expires
+    if (!get_client_conn_state(client)) {
+        if (client->was_manually_disconnected == 1) {
+            IOT_FUNC_EXIT_RC(QCLOUD_RET_MQTT_MANUALLY_DISCONNECTED);
+        }
+
+        if (client->auto_connect_enable == 0) {
+            IOT_FUNC_EXIT_RC(QCLOUD_ERR_MQTT_NO_CONN);
+        }
+
+        if (client->current_reconnect_wait_interval > MAX_RECONNECT_WAIT_INTERVAL) {
+            IOT_FUNC_EXIT_RC(QCLOUD_ERR_MQTT_RECONNECT_TIMEOUT);
+        }
+        IOT_FUNC_EXIT_RC(_handle_reconnect(client));
+    }
+
+    // 2. read and handle packets received, no waiting for header
+    HAL_Timer_CountdownMs(&timer, 0);
+    while ((readable || client->network_stack.get_bytes_avail(&client->network_stack)) &&
+           count++ < MQTT_YIELD_READY_MAX_PACKETS) {
+        readable = false;
+        rc       = _cycle_for_read(client, &timer, &packet_type);
+        if (rc) {
+            break;
+        }
+    }
+
+    switch (rc) {
+        case QCLOUD_RET_SUCCESS:
+            break;
+        case QCLOUD_ERR_SSL_READ_TIMEOUT:
+        case QCLOUD_ERR_SSL_READ:
+        case QCLOUD_ERR_TCP_PEER_SHUTDOWN:
+        case QCLOUD_ERR_TCP_READ_TIMEOUT:
+        case QCLOUD_ERR_TCP_READ_FAIL:
+            Log_e("network read failed, rc: %d. MQTT Disconnect.", rc);
+            _handle_disconnect(client);
+            IOT_FUNC_EXIT_RC(client->auto_connect_enable ? QCLOUD_ERR_MQTT_ATTEMPTING_RECONNECT
+                                                         : QCLOUD_ERR_MQTT_NO_CONN);
+        default:  // others, just return
+            IOT_FUNC_EXIT_RC(rc);
+    }
+
+    // 3. handle timeout and keep alive
+    rc = _handle_periodic(client);
+    if (rc) {
+        IOT_FUNC_EXIT_RC(client->auto_connect_enable ? QCLOUD_ERR_MQTT_ATTEMPTING_RECONNECT : rc);
+    }
+    IOT_FUNC_EXIT_RC(rc);
+}
+
+/**
+ * @brief Check if reconnect is due, so that event loop can leave the blocking reconnect in yield ready to another
+ * thread.
+ *
+ * @param[in,out] client pointer to mqtt client
+ * @return true if disconnected and reconnect delay expires
+ */
+bool qcloud_iot_mqtt_is_reconnect_due(QcloudIotClient *client)
+{
+    return !get_client_conn_state(client) && client->was_manually_disconnected != 1 && client->auto_connect_enable &&
+           client->current_reconnect_wait_interval <= MAX_RECONNECT_WAIT_INTERVAL &&
+           HAL_Timer_Expired(&(client->reconnect_delay_timer));
+}
+
 /**
  * @brief Wait read specific mqtt packet, such as connack.
  *
@@ -551,3 +826,18 @@ int qcloud_iot_mqtt_wait_for_read(QcloudIotClient *client, uint8_t packet_type)
 
     IOT_FUNC_EXIT_RC(rc);
 }
+
+/**
+ * @brief Get statistics of keep alive.
+ *
+ * @param[in,out] client pointer to mqtt client
+ * @param[out] stats @see MQTTKeepAliveStatistics
+ */
+void qcloud_iot_mqtt_get_keep_alive_statistics(QcloudIotClient *client, MQTTKeepAliveStatistics *stats)
+{
+    HAL_MutexLock(client->lock_generic);
+    *stats                  = client->keep_alive_stats;
+    stats->ping_interval_ms = client->ping_interval_ms;
+    stats->avg_rtt_ms       = stats->ping_resp_count ? client->total_ping_rtt_ms / stats->ping_resp_count : 0;
+    HAL_MutexUnlock(client->lock_generic);
+}
@@ -29,9 +29,19 @@
  * </table>
  */
 
+#include <malloc.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <ctime>
 #include <iostream>
 #include <string>
+#include <thread>
+#include <vector>
 
+#include "mqtt_client.h"
 #include "mqtt_client_test.h"
 
 namespace mqtt_client_unittest {
@@ -114,6 +124,274 @@ TEST_F(MqttClientTest, publish) {
    */
   pub_params.qos = QOS1;
   ASSERT_GE(IOT_MQTT_Publish(client, topic_name, &pub_params), 0);
+
+  /**
+   * @brief QOS1 statistics
+   *
+   */
+  MQTTPubStatistics stats;
+  ASSERT_EQ(IOT_MQTT_GetPubStatistics(client, &stats), 0);
+  ASSERT_EQ(stats.inflight_count, 1);
+  ASSERT_EQ(IOT_MQTT_Yield(client, QCLOUD_IOT_MQTT_YIELD_TIMEOUT), 0);
+  ASSERT_EQ(IOT_MQTT_GetPubStatistics(client, &stats), 0);
+  ASSERT_EQ(stats.inflight_count, 0);
+  ASSERT_EQ(stats.acked_count, 1);
+}
+
+/**
+ * @brief Release payload referenced by qos1 publish.
+ *
+ */
+static void _on_payload_release(void *payload, void *usr_data) {
+  *reinterpret_cast<int *>(usr_data) += 1;
+  HAL_Free(payload);
+}
+
+/**
+ * @brief Test publish payload larger than write buffer without copying.
+ *
+ */
+TEST_F(MqttClientTest, publish_zero_copy) {
+  char topic_name[MAX_SIZE_OF_CLOUD_TOPIC] = {0};
+  HAL_Snprintf(topic_name, sizeof(topic_name), "%s/%s/data", device_info.product_id, device_info.device_name);
+
+  int released = 0;
+  int payload_len = 4 * QCLOUD_IOT_MQTT_TX_BUF_LEN;
+  char *payload = reinterpret_cast<char *>(HAL_Malloc(payload_len));
+  ASSERT_NE(payload, nullptr);
+  memset(payload, 'a', payload_len);
+
+  PublishParams pub_params = DEFAULT_PUB_PARAMS;
+  pub_params.qos = QOS1;
+  pub_params.payload = payload;
+  pub_params.payload_len = payload_len;
+  pub_params.payload_release = _on_payload_release;
+  pub_params.release_usr_data = &released;
+
+  ASSERT_GE(IOT_MQTT_Publish(client, topic_name, &pub_params), 0);
+  ASSERT_EQ(released, 0);
+  ASSERT_EQ(IOT_MQTT_Yield(client, QCLOUD_IOT_MQTT_YIELD_TIMEOUT), 0);
+  ASSERT_EQ(released, 1);
+}
+
+/**
+ * @brief Test publish window size.
+ *
+ */
+TEST_F(MqttClientTest, publish_window) {
+  IOT_MQTT_Destroy(&client);
+
+  HAL_SleepMs(5000);  // for iot hub can not connect twice in 5 s
+
+  char topic_name[MAX_SIZE_OF_CLOUD_TOPIC] = {0};
+  ASSERT_EQ(HAL_GetDevInfo(reinterpret_cast<void *>(&device_info)), 0);
+  HAL_Snprintf(topic_name, sizeof(topic_name), "%s/%s/data", device_info.product_id, device_info.device_name);
+
+  MQTTInitParams init_params = DEFAULT_MQTT_INIT_PARAMS;
+  init_params.device_info = &device_info;
+  init_params.pub_window_size = 1;
+
+  client = IOT_MQTT_Construct(&init_params);
+  ASSERT_NE(client, nullptr);
+
+  char topic_content[] = "{\"action\": \"publish_window_test\", \"count\": \"0\"}";
+  PublishParams pub_params = DEFAULT_PUB_PARAMS;
+  pub_params.qos = QOS1;
+  pub_params.payload = topic_content;
+  pub_params.payload_len = strlen(topic_content);
+
+  ASSERT_GE(IOT_MQTT_Publish(client, topic_name, &pub_params), 0);
+  ASSERT_EQ(IOT_MQTT_Publish(client, topic_name, &pub_params), QCLOUD_ERR_MQTT_PUSH_TO_LIST_FAILED);
+  ASSERT_EQ(IOT_MQTT_Yield(client, QCLOUD_IOT_MQTT_YIELD_TIMEOUT), 0);
+  ASSERT_GE(IOT_MQTT_Publish(client, topic_name, &pub_params), 0);
+}
+
+/**
+ * @brief Received slices of message larger than read buffer.
+ *
+ */
+typedef struct {
+  uint32_t received_len;
+  uint32_t total_len;
+  int chunk_count;
+} StreamContext;
+
+static void _on_message_chunk(void *client, const MQTTMessage *message, uint32_t offset, uint32_t total_len,
+                              void *usr_data) {
+  StreamContext *context = reinterpret_cast<StreamContext *>(usr_data);
+  if (offset == context->received_len) {
+    context->received_len += message->payload_len;
+  }
+  context->total_len = total_len;
+  context->chunk_count++;
+}
+
+/**
+ * @brief Test streaming receive of message larger than read buffer, which is published by mosquitto_pub.
+ *
+ */
+TEST_F(MqttClientTest, publish_stream) {
+  const uint32_t payload_len = 64 * QCLOUD_IOT_MQTT_RX_BUF_LEN;
+
+  char topic_name[MAX_SIZE_OF_CLOUD_TOPIC] = {0};
+  HAL_Snprintf(topic_name, sizeof(topic_name), "%s/%s/data", device_info.product_id, device_info.device_name);
+
+  StreamContext context = {0};
+  SubscribeParams sub_params = DEFAULT_SUB_PARAMS;
+  sub_params.qos = QOS1;
+  sub_params.user_data = &context;
+  sub_params.on_message_chunk = _on_message_chunk;
+  ASSERT_GE(IOT_MQTT_SubscribeSync(client, topic_name, &sub_params), 0);
+
+  char cmd[256];
+  HAL_Snprintf(cmd, sizeof(cmd), "head -c %u /dev/zero | tr '\\0' 'a' | mosquitto_pub -h %s -t %s -q 1 -s", payload_len,
+               reinterpret_cast<QcloudIotClient *>(client)->host_addr, topic_name);
+  ASSERT_EQ(system(cmd), 0);
+
+  int wait_cnt = 10;
+  while (context.received_len < payload_len && wait_cnt-- > 0) {
+    ASSERT_EQ(IOT_MQTT_Yield(client, QCLOUD_IOT_MQTT_YIELD_TIMEOUT), 0);
+  }
+  ASSERT_EQ(context.received_len, payload_len);
+  ASSERT_EQ(context.total_len, payload_len);
+  ASSERT_GT(context.chunk_count, 1);
+}
+
+/**
+ * @brief Test buffer growing on demand, with small initial buffer.
+ *
+ */
+TEST_F(MqttClientTest, buffer_grow) {
+  IOT_MQTT_Destroy(&client);
+
+  HAL_SleepMs(5000);  // for iot hub can not connect twice in 5 s
+
+  char topic_name[MAX_SIZE_OF_CLOUD_TOPIC] = {0};
+  ASSERT_EQ(HAL_GetDevInfo(reinterpret_cast<void *>(&device_info)), 0);
+  HAL_Snprintf(topic_name, sizeof(topic_name), "%s/%s/data", device_info.product_id, device_info.device_name);
+
+  MQTTInitParams init_params = DEFAULT_MQTT_INIT_PARAMS;
+  init_params.device_info = &device_info;
+  init_params.write_buf_size = 256;
+  init_params.read_buf_size = 256;
+  init_params.max_buf_size = 8192;
+
+  client = IOT_MQTT_Construct(&init_params);
+  ASSERT_NE(client, nullptr);
+
+  SubscribeParams sub_params = DEFAULT_SUB_PARAMS;
+  sub_params.qos = QOS1;
+  ASSERT_GE(IOT_MQTT_SubscribeSync(client, topic_name, &sub_params), 0);
+
+  std::string payload(4000, 'a');
+  PublishParams pub_params = DEFAULT_PUB_PARAMS;
+  pub_params.qos = QOS1;
+  pub_params.payload = &payload[0];
+  pub_params.payload_len = payload.length();
+  ASSERT_GE(IOT_MQTT_Publish(client, topic_name, &pub_params), 0);
+  ASSERT_EQ(IOT_MQTT_Yield(client, QCLOUD_IOT_MQTT_YIELD_TIMEOUT), 0);
+
+  QcloudIotClient *mqtt_client = reinterpret_cast<QcloudIotClient *>(client);
+  ASSERT_GT(mqtt_client->write_buf_size, payload.length());
+  ASSERT_GT(mqtt_client->read_buf_size, payload.length());
+
+  // publish larger than ceiling
+  payload.resize(init_params.max_buf_size);
+  pub_params.payload = &payload[0];
+  pub_params.payload_len = payload.length();
+  ASSERT_EQ(IOT_MQTT_Publish(client, topic_name, &pub_params), QCLOUD_ERR_BUF_TOO_SHORT);
+}
+
+/**
+ * @brief Test user buffer and small buffer, user buffer should be used as it is.
+ *
+ */
+TEST_F(MqttClientTest, buffer_user) {
+  static uint8_t write_buf[MIN_MQTT_BUF_LEN];
+  static uint8_t read_buf[MIN_MQTT_BUF_LEN];
+
+  MQTTInitParams init_params = DEFAULT_MQTT_INIT_PARAMS;
+  init_params.device_info = &device_info;
+  init_params.connect_when_construct = 0;
+  init_params.write_buf = write_buf;
+  init_params.read_buf = read_buf;
+  init_params.write_buf_size = sizeof(write_buf);
+  init_params.read_buf_size = sizeof(read_buf);
+
+  void *user_client = IOT_MQTT_Construct(&init_params);
+  ASSERT_NE(user_client, nullptr);
+  QcloudIotClient *mqtt_client = reinterpret_cast<QcloudIotClient *>(user_client);
+  ASSERT_EQ(mqtt_client->write_buf, write_buf);
+  ASSERT_EQ(mqtt_client->read_buf, read_buf);
+  ASSERT_EQ(mqtt_client->write_buf_size, sizeof(write_buf));
+  ASSERT_EQ(mqtt_client->read_buf_size, sizeof(read_buf));
+  ASSERT_TRUE(mqtt_client->is_write_buf_external);
+  ASSERT_TRUE(mqtt_client->is_read_buf_external);
+  IOT_MQTT_Destroy(&user_client);
+
+  init_params = DEFAULT_MQTT_INIT_PARAMS;
+  init_params.device_info = &device_info;
+  init_params.connect_when_construct = 0;
+  init_params.write_buf_size = MIN_MQTT_BUF_LEN;
+  init_params.read_buf_size = MIN_MQTT_BUF_LEN;
+  init_params.max_buf_size = QCLOUD_IOT_MQTT_RX_BUF_LEN;
+
+  void *small_client = IOT_MQTT_Construct(&init_params);
+  ASSERT_NE(small_client, nullptr);
+  mqtt_client = reinterpret_cast<QcloudIotClient *>(small_client);
+  ASSERT_EQ(mqtt_client->write_buf_size, static_cast<size_t>(MIN_MQTT_BUF_LEN));
+  ASSERT_EQ(mqtt_client->read_buf_size, static_cast<size_t>(MIN_MQTT_BUF_LEN));
+  ASSERT_FALSE(mqtt_client->is_write_buf_external);
+  IOT_MQTT_Destroy(&small_client);
+}
+
+/**
+ * @brief Benchmark of memory footprint for 1/100/1000 constructed clients, with default, small and user buffers.
+ *
+ */
+TEST_F(MqttClientTest, DISABLED_buffer_footprint_benchmark) {
+  static uint8_t shared_write_buf[MIN_MQTT_BUF_LEN];
+  static uint8_t shared_read_buf[MIN_MQTT_BUF_LEN];
+
+  MQTTInitParams default_params = DEFAULT_MQTT_INIT_PARAMS;
+  default_params.device_info = &device_info;
+  default_params.connect_when_construct = 0;
+
+  MQTTInitParams small_params = default_params;
+  small_params.write_buf_size = MIN_MQTT_BUF_LEN;
+  small_params.read_buf_size = MIN_MQTT_BUF_LEN;
+  small_params.max_buf_size = QCLOUD_IOT_MQTT_RX_BUF_LEN;
+
+  // only for footprint, user buffer should not be shared by clients in use
+  MQTTInitParams user_params = default_params;
+  user_params.write_buf = shared_write_buf;
+  user_params.read_buf = shared_read_buf;
+  user_params.write_buf_size = sizeof(shared_write_buf);
+  user_params.read_buf_size = sizeof(shared_read_buf);
+
+  const struct {
+    const char *name;
+    MQTTInitParams *params;
+  } cases[] = {{"default", &default_params}, {"small", &small_params}, {"user", &user_params}};
+
+  utils_log_set_level(LOG_LEVEL_ERROR);
+  for (auto &c : cases) {
+    for (int client_num : {1, 100, 1000}) {
+      std::vector<void *> clients;
+      size_t start = mallinfo2().uordblks;
+      for (int i = 0; i < client_num; i++) {
+        clients.push_back(IOT_MQTT_Construct(c.params));
+        ASSERT_NE(clients.back(), nullptr);
+      }
+      size_t used = mallinfo2().uordblks - start;
+      std::cout << c.name << " buffer, clients: " << client_num << ", memory: " << used
+                << " bytes, per client: " << used / client_num << " bytes" << std::endl;
+      for (auto &mqtt_client : clients) {
+        IOT_MQTT_Destroy(&mqtt_client);
+      }
+    }
+  }
+  utils_log_set_level(LOG_LEVEL_DEBUG);
 }
 
 /**
@@ -152,4 +430,1085 @@ TEST_F(MqttClientTest, clean_session) {
   ASSERT_EQ(IOT_MQTT_Connect(client), 0);
 }
 
+/**
+ * @brief Test reconnect with session resumption, using local mosquitto which could be restarted.
+ *
+ */
+TEST_F(MqttClientTest, reconnect) {
+  IOT_MQTT_Destroy(&client);
+
+  HAL_SleepMs(5000);  // for iot hub can not connect twice in 5 s
+
+  SubscribeParams sub_params = DEFAULT_SUB_PARAMS;
+  sub_params.qos = QOS1;
+
+  char topic_name[MAX_SIZE_OF_CLOUD_TOPIC] = {0};
+  ASSERT_EQ(HAL_GetDevInfo(reinterpret_cast<void *>(&device_info)), 0);
+  HAL_Snprintf(topic_name, sizeof(topic_name), "%s/%s/data", device_info.product_id, device_info.device_name);
+
+  MQTTInitParams init_params = DEFAULT_MQTT_INIT_PARAMS;
+  init_params.device_info = &device_info;
+  init_params.clean_session = 0;
+  init_params.auto_connect_enable = 1;
+
+  client = IOT_MQTT_Construct(&init_params);
+  ASSERT_NE(client, nullptr);
+  ASSERT_GE(IOT_MQTT_SubscribeSync(client, topic_name, &sub_params), 0);
+
+  char topic_content[] = "{\"action\": \"reconnect_test\", \"count\": \"0\"}";
+  PublishParams pub_params = DEFAULT_PUB_PARAMS;
+  pub_params.qos = QOS1;
+  pub_params.payload = topic_content;
+  pub_params.payload_len = strlen(topic_content);
+
+  /**
+   * @brief restart broker when publish is in flight
+   *
+   */
+  ASSERT_GE(IOT_MQTT_Publish(client, topic_name, &pub_params), 0);
+  ASSERT_EQ(system("pkill -9 mosquitto; mosquitto -d -c ./config/mosquitto/mosquitto.conf"), 0);
+
+  uint64_t start_time = HAL_Timer_CurrentMs();
+  int wait_cnt = MAX_RECONNECT_WAIT_INTERVAL / QCLOUD_IOT_MQTT_YIELD_TIMEOUT;
+  do {
+    IOT_MQTT_Yield(client, QCLOUD_IOT_MQTT_YIELD_TIMEOUT);
+  } while (!(IOT_MQTT_IsConnected(client) && IOT_MQTT_IsSubReady(client, topic_name)) && wait_cnt-- > 0);
+  ASSERT_GT(wait_cnt, 0);
+  std::cout << "time to recover: " << HAL_Timer_CurrentMs() - start_time << " ms" << std::endl;
+
+  ASSERT_GE(IOT_MQTT_Publish(client, topic_name, &pub_params), 0);
+  ASSERT_EQ(IOT_MQTT_Yield(client, QCLOUD_IOT_MQTT_YIELD_TIMEOUT), 0);
+}
+
+/**
+ * @brief Test keep alive, publish within keep alive interval suppresses ping, and ping is sent when idle.
+ *
+ */
+TEST_F(MqttClientTest, keep_alive) {
+  IOT_MQTT_Destroy(&client);
+
+  HAL_SleepMs(5000);  // for iot hub can not connect twice in 5 s
+
+  MQTTInitParams init_params = DEFAULT_MQTT_INIT_PARAMS;
+  init_params.device_info = &device_info;
+  init_params.keep_alive_interval_ms = 2000;
+  init_params.auto_connect_enable = 1;
+
+  client = IOT_MQTT_Construct(&init_params);
+  ASSERT_NE(client, nullptr);
+
+  char topic_name[MAX_SIZE_OF_CLOUD_TOPIC] = {0};
+  HAL_Snprintf(topic_name, sizeof(topic_name), "%s/%s/data", device_info.product_id, device_info.device_name);
+
+  char topic_content[] = "{\"action\": \"keep_alive_test\", \"count\": \"0\"}";
+  PublishParams pub_params = DEFAULT_PUB_PARAMS;
+  pub_params.qos = QOS1;
+  pub_params.payload = topic_content;
+  pub_params.payload_len = strlen(topic_content);
+
+  /**
+   * @brief busy: publish and puback count as keep alive
+   *
+   */
+  MQTTKeepAliveStatistics stats;
+  uint64_t start_time = HAL_Timer_CurrentMs();
+  while (HAL_Timer_CurrentMs() - start_time < 5000) {
+    ASSERT_GE(IOT_MQTT_Publish(client, topic_name, &pub_params), 0);
+    ASSERT_EQ(IOT_MQTT_Yield(client, 200), 0);
+  }
+  ASSERT_EQ(IOT_MQTT_GetKeepAliveStatistics(client, &stats), 0);
+  ASSERT_EQ(stats.ping_sent_count, 0);
+  ASSERT_GT(stats.ping_suppressed_count, 0);
+
+  /**
+   * @brief idle: ping every keep alive interval
+   *
+   */
+  start_time = HAL_Timer_CurrentMs();
+  while (HAL_Timer_CurrentMs() - start_time < 5000) {
+    ASSERT_EQ(IOT_MQTT_Yield(client, 200), 0);
+  }
+  ASSERT_EQ(IOT_MQTT_GetKeepAliveStatistics(client, &stats), 0);
+  ASSERT_EQ(stats.ping_sent_count, 2);
+  ASSERT_EQ(stats.ping_resp_count, 2);
+  ASSERT_EQ(stats.ping_timeout_count, 0);
+  ASSERT_EQ(stats.ping_interval_ms, 2000);
+  ASSERT_LT(stats.avg_rtt_ms, QCLOUD_IOT_MQTT_COMMAND_TIMEOUT);
+  std::cout << "ping sent: " << stats.ping_sent_count << ", suppressed: " << stats.ping_suppressed_count
+            << ", avg rtt: " << stats.avg_rtt_ms << " ms" << std::endl;
+}
+
+/**
+ * @brief Test reconnect with standby connection, which is taken at once instead of waiting reconnect interval, using
+ * local mosquitto for iot hub can not connect twice in 5 s.
+ *
+ */
+TEST_F(MqttClientTest, standby_connect) {
+  IOT_MQTT_Destroy(&client);
+
+  HAL_SleepMs(5000);  // for iot hub can not connect twice in 5 s
+
+  MQTTInitParams init_params = DEFAULT_MQTT_INIT_PARAMS;
+  init_params.device_info = &device_info;
+  init_params.auto_connect_enable = 1;
+  init_params.standby_connect_enable = 1;
+
+  client = IOT_MQTT_Construct(&init_params);
+  ASSERT_NE(client, nullptr);
+  ASSERT_EQ(IOT_MQTT_Yield(client, QCLOUD_IOT_MQTT_YIELD_TIMEOUT), 0);
+
+  // break the connection under mqtt client
+  IotNetwork *network = &reinterpret_cast<QcloudIotClient *>(client)->network_stack;
+  ASSERT_EQ(shutdown(network->get_fd(network), SHUT_RDWR), 0);
+
+  uint64_t start_time = HAL_Timer_CurrentMs();
+  int wait_cnt = MAX_RECONNECT_WAIT_INTERVAL / 100;
+  do {
+    IOT_MQTT_Yield(client, 100);
+  } while (!IOT_MQTT_IsConnected(client) && wait_cnt-- > 0);
+  ASSERT_TRUE(IOT_MQTT_IsConnected(client));
+  ASSERT_LT(HAL_Timer_CurrentMs() - start_time, MIN_RECONNECT_WAIT_INTERVAL);
+  std::cout << "time to recover: " << HAL_Timer_CurrentMs() - start_time << " ms" << std::endl;
+}
+
+/**
+ * @brief Topic match of sub handle array scanned linearly, as baseline of dispatch benchmark.
+ *
+ */
+static bool array_topic_matched(const char *topic_filter, const char *topic_name, uint16_t topic_name_len) {
+  const char *curf = topic_filter;
+  const char *curn = topic_name;
+  const char *curn_end = curn + topic_name_len;
+
+  while (*curf && curn < curn_end) {
+    if (*curn == '/' && *curf != '/') break;
+    if (*curf != '+' && *curf != '#' && *curf != *curn) break;
+    if (*curf == '+') {
+      const char *nextpos = curn + 1;
+      while (nextpos < curn_end && *nextpos != '/') nextpos = ++curn + 1;
+    } else if (*curf == '#') {
+      curn = curn_end - 1;
+    }
+    curf++;
+    curn++;
+  }
+  return (curn == curn_end) && (*curf == '\0');
+}
+
+/**
+ * @brief Subscribe exact, single level and multi level wildcard filters for each sub device, with index + 1 as user
+ * data. Topics matching each filter are returned.
+ *
+ */
+static void dispatch_subscribe(void *client, const DeviceInfo &device_info, int filter_num,
+                               std::vector<std::string> &filters, std::vector<std::string> &topics) {
+  char buf[MAX_SIZE_OF_CLOUD_TOPIC];
+  for (int i = 0; i < filter_num; i++) {
+    switch (i % 3) {
+      case 0:
+        HAL_Snprintf(buf, sizeof(buf), "%s/dev%d/data", device_info.product_id, i);
+        filters.push_back(buf);
+        topics.push_back(buf);
+        break;
+      case 1:
+        HAL_Snprintf(buf, sizeof(buf), "%s/dev%d/+/event", device_info.product_id, i);
+        filters.push_back(buf);
+        HAL_Snprintf(buf, sizeof(buf), "%s/dev%d/thing/event", device_info.product_id, i);
+        topics.push_back(buf);
+        break;
+      default:
+        HAL_Snprintf(buf, sizeof(buf), "%s/dev%d/ota/#", device_info.product_id, i);
+        filters.push_back(buf);
+        HAL_Snprintf(buf, sizeof(buf), "%s/dev%d/ota/report/progress", device_info.product_id, i);
+        topics.push_back(buf);
+        break;
+    }
+    SubscribeParams sub_params = DEFAULT_SUB_PARAMS;
+    sub_params.user_data = reinterpret_cast<void *>(static_cast<uintptr_t>(i + 1));
+    ASSERT_EQ(IOT_MQTT_Subscribe(client, filters[i].c_str(), &sub_params), 0);
+  }
+}
+
+/**
+ * @brief Test subscription dispatch, each topic should be dispatched to the sub handle of its filter.
+ *
+ */
+TEST_F(MqttClientTest, dispatch) {
+  const int filter_num = 30;
+
+  MQTTInitParams init_params = DEFAULT_MQTT_INIT_PARAMS;
+  init_params.device_info = &device_info;
+  init_params.connect_when_construct = 0;
+  init_params.default_subscribe = 1;
+
+  IOT_MQTT_Destroy(&client);
+  client = IOT_MQTT_Construct(&init_params);
+  ASSERT_NE(client, nullptr);
+
+  std::vector<std::string> filters;
+  std::vector<std::string> topics;
+  dispatch_subscribe(client, device_info, filter_num, filters, topics);
+  ASSERT_EQ(topics.size(), static_cast<size_t>(filter_num));
+
+  SubscribeParams params;
+  for (int i = 0; i < filter_num; i++) {
+    ASSERT_TRUE(qcloud_iot_mqtt_match_sub_params(reinterpret_cast<QcloudIotClient *>(client), topics[i].c_str(),
+                                                 topics[i].length(), &params));
+    ASSERT_EQ(params.user_data, reinterpret_cast<void *>(static_cast<uintptr_t>(i + 1)));
+  }
+
+  // topic not subscribed
+  std::string topic = std::string(device_info.product_id) + "/dev0/thing/event";
+  ASSERT_FALSE(qcloud_iot_mqtt_match_sub_params(reinterpret_cast<QcloudIotClient *>(client), topic.c_str(),
+                                                topic.length(), &params));
+
+  // sub handle of wildcard filter is found by the same filter
+  ASSERT_NE(IOT_MQTT_GetSubUsrData(client, filters[1].c_str()), nullptr);
+}
+
+/**
+ * @brief Benchmark of subscription dispatch, index vs array with 10/100/1000 filters.
+ *
+ */
+TEST_F(MqttClientTest, DISABLED_dispatch_benchmark) {
+  const int dispatch_times = 100000;
+
+  MQTTInitParams init_params = DEFAULT_MQTT_INIT_PARAMS;
+  init_params.device_info = &device_info;
+  init_params.connect_when_construct = 0;
+  init_params.default_subscribe = 1;
+
+  for (int filter_num : {10, 100, 1000}) {
+    IOT_MQTT_Destroy(&client);
+    client = IOT_MQTT_Construct(&init_params);
+    ASSERT_NE(client, nullptr);
+
+    std::vector<std::string> filters;
+    std::vector<std::string> topics;
+    dispatch_subscribe(client, device_info, filter_num, filters, topics);
+    ASSERT_EQ(topics.size(), static_cast<size_t>(filter_num));
+
+    int index_mismatch = 0, array_mismatch = 0;
+    SubscribeParams params;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int n = 0; n < dispatch_times; n++) {
+      int i = (n * 7919) % filter_num;
+      if (!qcloud_iot_mqtt_match_sub_params(reinterpret_cast<QcloudIotClient *>(client), topics[i].c_str(),
+                                            topics[i].length(), &params) ||
+          params.user_data != reinterpret_cast<void *>(static_cast<uintptr_t>(i + 1))) {
+        index_mismatch++;
+      }
+    }
+    auto index_cost = std::chrono::steady_clock::now() - start;
+
+    start = std::chrono::steady_clock::now();
+    for (int n = 0; n < dispatch_times; n++) {
+      int i = (n * 7919) % filter_num, j = 0;
+      for (j = 0; j < filter_num; j++) {
+        if (array_topic_matched(filters[j].c_str(), topics[i].c_str(), topics[i].length())) {
+          break;
+        }
+      }
+      array_mismatch += j != i;
+    }
+    auto array_cost = std::chrono::steady_clock::now() - start;
+
+    ASSERT_EQ(index_mismatch, 0);
+    ASSERT_EQ(array_mismatch, 0);
+    std::cout << "filters: " << filter_num << ", index dispatch: "
+              << std::chrono::duration_cast<std::chrono::nanoseconds>(index_cost).count() / dispatch_times
+              << " ns, array dispatch: "
+              << std::chrono::duration_cast<std::chrono::nanoseconds>(array_cost).count() / dispatch_times << " ns"
+              << std::endl;
+
+    // sub handle of wildcard filter is found by the same filter
+    ASSERT_NE(IOT_MQTT_GetSubUsrData(client, filters[1].c_str()), nullptr);
+  }
+}
+
+/**
+ * @brief Test publish batching, packets are pending in batch buffer until flush and all of them are received.
+ *
+ */
+TEST_F(MqttClientTest, publish_batch) {
+  const int publish_times = 20;
+
+  char topic_name[MAX_SIZE_OF_CLOUD_TOPIC] = {0};
+  HAL_Snprintf(topic_name, sizeof(topic_name), "%s/%s/data", device_info.product_id, device_info.device_name);
+
+  IOT_MQTT_Destroy(&client);
+  HAL_SleepMs(5000);  // for iot hub can not connect twice in 5 s
+
+  MQTTInitParams init_params = DEFAULT_MQTT_INIT_PARAMS;
+  init_params.device_info = &device_info;
+  init_params.pub_batch_buf_size = 16 * 1024;
+  client = IOT_MQTT_Construct(&init_params);
+  ASSERT_NE(client, nullptr);
+
+  int received = 0;
+  SubscribeParams sub_params = DEFAULT_SUB_PARAMS;
+  sub_params.on_message_handler = [](void *client, const MQTTMessage *message, void *usr_data) {
+    (*reinterpret_cast<int *>(usr_data))++;
+  };
+  sub_params.user_data = &received;
+  ASSERT_GE(IOT_MQTT_SubscribeSync(client, topic_name, &sub_params), 0);
+
+  std::string payload(256, 'a');
+  PublishParams pub_params = DEFAULT_PUB_PARAMS;
+  pub_params.payload = &payload[0];
+  pub_params.payload_len = payload.length();
+  for (int n = 0; n < publish_times; n++) {
+    ASSERT_GE(IOT_MQTT_Publish(client, topic_name, &pub_params), 0);
+  }
+  QcloudIotClient *mqtt_client = reinterpret_cast<QcloudIotClient *>(client);
+  ASSERT_GT(mqtt_client->pub_batch_len, 0u);
+  ASSERT_EQ(IOT_MQTT_Flush(client), 0);
+  ASSERT_EQ(mqtt_client->pub_batch_len, 0u);
+
+  for (int i = 0; i < 50 && received < publish_times; i++) {
+    ASSERT_EQ(IOT_MQTT_Yield(client, 100), 0);
+  }
+  ASSERT_EQ(received, publish_times);
+}
+
+/**
+ * @brief Benchmark of publish throughput with and without batching.
+ *
+ */
+TEST_F(MqttClientTest, DISABLED_publish_batch_benchmark) {
+  const int publish_times = 10000;
+
+  char topic_name[MAX_SIZE_OF_CLOUD_TOPIC] = {0};
+  HAL_Snprintf(topic_name, sizeof(topic_name), "%s/%s/data", device_info.product_id, device_info.device_name);
+
+  MQTTInitParams init_params = DEFAULT_MQTT_INIT_PARAMS;
+  init_params.device_info = &device_info;
+
+  for (uint32_t batch_buf_size : {0, 16 * 1024}) {
+    IOT_MQTT_Destroy(&client);
+    HAL_SleepMs(5000);  // for iot hub can not connect twice in 5 s
+
+    init_params.pub_batch_buf_size = batch_buf_size;
+    client = IOT_MQTT_Construct(&init_params);
+    ASSERT_NE(client, nullptr);
+
+    utils_log_set_level(LOG_LEVEL_ERROR);
+    for (size_t payload_len : {64, 256, 1024}) {
+      std::string payload(payload_len, 'a');
+      PublishParams pub_params = DEFAULT_PUB_PARAMS;
+      pub_params.payload = &payload[0];
+      pub_params.payload_len = payload_len;
+
+      auto start = std::chrono::steady_clock::now();
+      for (int n = 0; n < publish_times; n++) {
+        ASSERT_GE(IOT_MQTT_Publish(client, topic_name, &pub_params), 0);
+      }
+      ASSERT_EQ(IOT_MQTT_Flush(client), 0);
+      auto cost = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+
+      std::cout << (batch_buf_size ? "batch" : "no batch") << " publish, payload: " << payload_len
+                << " bytes, throughput: " << publish_times * 1000000LL / (cost.count() + 1) << " msgs/s" << std::endl;
+      ASSERT_EQ(IOT_MQTT_Yield(client, QCLOUD_IOT_MQTT_YIELD_TIMEOUT), 0);
+    }
+    utils_log_set_level(LOG_LEVEL_DEBUG);
+  }
+}
+
+/**
+ * @brief Count reads on socket.
+ *
+ */
+static int sg_socket_read_count = 0;
+static int (*sg_socket_read)(IotNetwork *, unsigned char *, size_t, uint32_t, size_t *) = nullptr;
+
+static int _counted_socket_read(IotNetwork *network, unsigned char *data, size_t datalen, uint32_t timeout_ms,
+                                size_t *read_len) {
+  sg_socket_read_count++;
+  return sg_socket_read(network, data, datalen, timeout_ms, read_len);
+}
+
+static void _on_burst_message(void *client, const MQTTMessage *message, void *usr_data) {
+  (*reinterpret_cast<int *>(usr_data))++;
+}
+
+/**
+ * @brief Test read ahead, messages arriving in burst should all be received through recv of network.
+ *
+ */
+TEST_F(MqttClientTest, read_ahead) {
+  const int message_num = 20;
+
+  char topic_name[MAX_SIZE_OF_CLOUD_TOPIC] = {0};
+  HAL_Snprintf(topic_name, sizeof(topic_name), "%s/%s/data", device_info.product_id, device_info.device_name);
+
+  IOT_MQTT_Destroy(&client);
+  HAL_SleepMs(5000);  // for iot hub can not connect twice in 5 s
+
+  MQTTInitParams init_params = DEFAULT_MQTT_INIT_PARAMS;
+  init_params.device_info = &device_info;
+  init_params.connect_when_construct = 0;
+  client = IOT_MQTT_Construct(&init_params);
+  ASSERT_NE(client, nullptr);
+
+  IotNetwork *network = &reinterpret_cast<QcloudIotClient *>(client)->network_stack;
+  network->read_ahead_size = MQTT_READ_AHEAD_LEN;
+  ASSERT_EQ(qcloud_iot_network_init(network), 0);
+  sg_socket_read = network->recv;
+  network->recv = _counted_socket_read;
+  ASSERT_EQ(IOT_MQTT_Connect(client), 0);
+
+  int received = 0;
+  SubscribeParams sub_params = DEFAULT_SUB_PARAMS;
+  sub_params.on_message_handler = _on_burst_message;
+  sub_params.user_data = &received;
+  ASSERT_GE(IOT_MQTT_SubscribeSync(client, topic_name, &sub_params), 0);
+
+  char payload[64];
+  memset(payload, 'a', sizeof(payload));
+  PublishParams pub_params = DEFAULT_PUB_PARAMS;
+  pub_params.payload = payload;
+  pub_params.payload_len = sizeof(payload);
+  for (int i = 0; i < message_num; i++) {
+    ASSERT_GE(IOT_MQTT_Publish(client, topic_name, &pub_params), 0);
+  }
+
+  sg_socket_read_count = 0;
+  for (int i = 0; i < 50 && received < message_num; i++) {
+    ASSERT_EQ(IOT_MQTT_Yield(client, 100), 0);
+  }
+  ASSERT_EQ(received, message_num);
+  ASSERT_GT(sg_socket_read_count, 0);
+}
+
+/**
+ * @brief Benchmark of socket reads per message with and without read ahead, when messages arrive in burst.
+ *
+ */
+TEST_F(MqttClientTest, DISABLED_read_ahead_benchmark) {
+  const int message_num = 1000;
+
+  char topic_name[MAX_SIZE_OF_CLOUD_TOPIC] = {0};
+  HAL_Snprintf(topic_name, sizeof(topic_name), "%s/%s/data", device_info.product_id, device_info.device_name);
+
+  char payload[64];
+  memset(payload, 'a', sizeof(payload));
+  PublishParams pub_params = DEFAULT_PUB_PARAMS;
+  pub_params.payload = payload;
+  pub_params.payload_len = sizeof(payload);
+
+  MQTTInitParams init_params = DEFAULT_MQTT_INIT_PARAMS;
+  init_params.device_info = &device_info;
+  init_params.connect_when_construct = 0;
+
+  for (size_t read_ahead_size : {0, MQTT_READ_AHEAD_LEN}) {
+    IOT_MQTT_Destroy(&client);
+    HAL_SleepMs(5000);  // for iot hub can not connect twice in 5 s
+
+    client = IOT_MQTT_Construct(&init_params);
+    ASSERT_NE(client, nullptr);
+
+    // socket is read by recv with read ahead, otherwise by read
+    IotNetwork *network = &reinterpret_cast<QcloudIotClient *>(client)->network_stack;
+    network->read_ahead_size = read_ahead_size;
+    ASSERT_EQ(qcloud_iot_network_init(network), 0);
+    auto &socket_read = read_ahead_size ? network->recv : network->read;
+    sg_socket_read = socket_read;
+    socket_read = _counted_socket_read;
+    ASSERT_EQ(IOT_MQTT_Connect(client), 0);
+
+    int received = 0;
+    SubscribeParams sub_params = DEFAULT_SUB_PARAMS;
+    sub_params.on_message_handler = _on_burst_message;
+    sub_params.user_data = &received;
+    ASSERT_GE(IOT_MQTT_SubscribeSync(client, topic_name, &sub_params), 0);
+
+    utils_log_set_level(LOG_LEVEL_ERROR);
+    for (int i = 0; i < message_num; i++) {
+      ASSERT_GE(IOT_MQTT_Publish(client, topic_name, &pub_params), 0);
+    }
+
+    sg_socket_read_count = 0;
+    for (int i = 0; i < 100 && received < message_num; i++) {
+      ASSERT_EQ(IOT_MQTT_Yield(client, 100), 0);
+    }
+    utils_log_set_level(LOG_LEVEL_DEBUG);
+
+    ASSERT_EQ(received, message_num);
+    std::cout << (read_ahead_size ? "read ahead" : "no read ahead") << ", messages: " << received
+              << ", socket reads: " << sg_socket_read_count
+              << ", per message: " << static_cast<double>(sg_socket_read_count) / received << std::endl;
+  }
+}
+
+/**
+ * @brief Test client driven by event loop instead of yield.
+ *
+ */
+TEST_F(MqttClientTest, event_loop) {
+  char topic_name[MAX_SIZE_OF_CLOUD_TOPIC] = {0};
+  HAL_Snprintf(topic_name, sizeof(topic_name), "%s/%s/data", device_info.product_id, device_info.device_name);
+
+  void *loop = IOT_MQTT_LoopCreate();
+  ASSERT_NE(loop, nullptr);
+  ASSERT_EQ(IOT_MQTT_LoopAdd(loop, client), 0);
+
+  int received = 0;
+  SubscribeParams sub_params = DEFAULT_SUB_PARAMS;
+  sub_params.on_message_handler = _on_burst_message;
+  sub_params.user_data = &received;
+  ASSERT_GE(IOT_MQTT_Subscribe(client, topic_name, &sub_params), 0);
+  for (int i = 0; i < 10 && !IOT_MQTT_IsSubReady(client, topic_name); i++) {
+    ASSERT_EQ(IOT_MQTT_LoopRun(loop, 100), 0);
+  }
+  ASSERT_TRUE(IOT_MQTT_IsSubReady(client, topic_name));
+
+  char payload[] = "{\"action\": \"event_loop\"}";
+  PublishParams pub_params = DEFAULT_PUB_PARAMS;
+  pub_params.qos = QOS1;
+  pub_params.payload = payload;
+  pub_params.payload_len = strlen(payload);
+  ASSERT_GE(IOT_MQTT_Publish(client, topic_name, &pub_params), 0);
+  for (int i = 0; i < 10 && !received; i++) {
+    ASSERT_EQ(IOT_MQTT_LoopRun(loop, 100), 0);
+  }
+  ASSERT_EQ(received, 1);
+
+  MQTTPubStatistics stats;
+  ASSERT_EQ(IOT_MQTT_GetPubStatistics(client, &stats), 0);
+  ASSERT_EQ(stats.inflight_count, 0);
+
+  ASSERT_EQ(IOT_MQTT_LoopRemove(loop, client), 0);
+  IOT_MQTT_LoopDestroy(&loop);
+  ASSERT_EQ(loop, nullptr);
+}
+
+/**
+ * @brief Benchmark of event loop driving many clients in one thread, run against local broker with sdk built with
+ * AUTH_WITH_NO_TLS, such as mosquitto -c config/mosquitto/mosquitto.conf.
+ *
+ * MQTT_LOOP_BENCH_BROKER=127.0.0.1 MQTT_LOOP_BENCH_CLIENTS=10000, host of client is product id joined with init host,
+ * so the broker address is split at the first dot.
+ */
+TEST_F(MqttClientTest, DISABLED_event_loop_benchmark) {
+  const char *broker = getenv("MQTT_LOOP_BENCH_BROKER");
+  if (!broker || !strchr(broker, '.')) {
+    GTEST_SKIP() << "MQTT_LOOP_BENCH_BROKER not set";
+  }
+  const char *clients_env = getenv("MQTT_LOOP_BENCH_CLIENTS");
+  const int client_num = clients_env ? atoi(clients_env) : 10000;
+
+  // one socket for each client
+  struct rlimit limit;
+  ASSERT_EQ(getrlimit(RLIMIT_NOFILE, &limit), 0);
+  limit.rlim_cur = limit.rlim_max;
+  ASSERT_EQ(setrlimit(RLIMIT_NOFILE, &limit), 0);
+
+  std::string product_id(broker, strchr(broker, '.') - broker);
+  std::vector<DeviceInfo> devices(client_num, device_info);
+  std::vector<void *> clients(client_num, nullptr);
+  std::vector<std::string> topics(client_num);
+
+  MQTTInitParams init_params = DEFAULT_MQTT_INIT_PARAMS;
+  init_params.host = strchr(broker, '.') + 1;
+
+  void *loop = IOT_MQTT_LoopCreate();
+  ASSERT_NE(loop, nullptr);
+
+  utils_log_set_level(LOG_LEVEL_ERROR);
+  for (int i = 0; i < client_num; i++) {
+    HAL_Snprintf(devices[i].product_id, sizeof(devices[i].product_id), "%s", product_id.c_str());
+    HAL_Snprintf(devices[i].device_name, sizeof(devices[i].device_name), "bench_%d", i);
+    topics[i] = product_id + "/bench_" + std::to_string(i) + "/data";
+
+    init_params.device_info = &devices[i];
+    clients[i] = IOT_MQTT_Construct(&init_params);
+    ASSERT_NE(clients[i], nullptr);
+    ASSERT_EQ(IOT_MQTT_LoopAdd(loop, clients[i]), 0);
+  }
+
+  // 1. subscribe
+  int received = 0;
+  SubscribeParams sub_params = DEFAULT_SUB_PARAMS;
+  sub_params.on_message_handler = _on_burst_message;
+  sub_params.user_data = &received;
+  for (int i = 0; i < client_num; i++) {
+    ASSERT_GE(IOT_MQTT_Subscribe(clients[i], topics[i].c_str(), &sub_params), 0);
+  }
+
+  auto all_sub_ready = [&]() {
+    for (int i = 0; i < client_num; i++) {
+      if (!IOT_MQTT_IsSubReady(clients[i], topics[i].c_str())) {
+        return false;
+      }
+    }
+    return true;
+  };
+  for (int n = 0; n < 100 && !all_sub_ready(); n++) {
+    ASSERT_EQ(IOT_MQTT_LoopRun(loop, 100), 0);
+  }
+  ASSERT_TRUE(all_sub_ready());
+
+  // 2. each client publishes one qos1 message to itself
+  char payload[64];
+  memset(payload, 'a', sizeof(payload));
+  PublishParams pub_params = DEFAULT_PUB_PARAMS;
+  pub_params.qos = QOS1;
+  pub_params.payload = payload;
+  pub_params.payload_len = sizeof(payload);
+
+  std::clock_t cpu_start = std::clock();
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < client_num; i++) {
+    ASSERT_GE(IOT_MQTT_Publish(clients[i], topics[i].c_str(), &pub_params), 0);
+  }
+  for (int n = 0; n < 200 && received < client_num; n++) {
+    ASSERT_EQ(IOT_MQTT_LoopRun(loop, 50), 0);
+  }
+  auto cost = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+  ASSERT_EQ(received, client_num);
+  std::cout << "clients: " << client_num << ", publish round trip: " << cost.count()
+            << " ms, cpu: " << (std::clock() - cpu_start) * 1000 / CLOCKS_PER_SEC << " ms" << std::endl;
+
+  // 3. idle, only keep alive and ack timeout checking
+  cpu_start = std::clock();
+  ASSERT_EQ(IOT_MQTT_LoopRun(loop, 5000), 0);
+  std::cout << "clients: " << client_num
+            << ", idle 5000 ms, cpu: " << (std::clock() - cpu_start) * 1000 / CLOCKS_PER_SEC << " ms" << std::endl;
+  utils_log_set_level(LOG_LEVEL_DEBUG);
+
+  for (int i = 0; i < client_num; i++) {
+    ASSERT_TRUE(IOT_MQTT_IsConnected(clients[i]));
+    IOT_MQTT_Destroy(&clients[i]);
+  }
+  IOT_MQTT_LoopDestroy(&loop);
+}
+
+#ifdef MULTITHREAD_ENABLED
+static void _on_publish_complete(void *client, int result, void *usr_data) {
+  if (result >= 0) {
+    __atomic_add_fetch(reinterpret_cast<int *>(usr_data), 1, __ATOMIC_RELAXED);
+  }
+}
+
+static void _on_async_message(void *client, const MQTTMessage *message, void *usr_data) {
+  __atomic_add_fetch(reinterpret_cast<int *>(usr_data), 1, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Test client driven by background io thread, yield only waits for packets handled.
+ *
+ */
+TEST_F(MqttClientTest, io_thread) {
+  char topic_name[MAX_SIZE_OF_CLOUD_TOPIC] = {0};
+  HAL_Snprintf(topic_name, sizeof(topic_name), "%s/%s/data", device_info.product_id, device_info.device_name);
+
+  IOT_MQTT_Destroy(&client);
+  HAL_SleepMs(5000);  // for iot hub can not connect twice in 5 s
+
+  MQTTInitParams init_params = DEFAULT_MQTT_INIT_PARAMS;
+  init_params.device_info = &device_info;
+  init_params.io_thread_enable = 1;
+  client = IOT_MQTT_Construct(&init_params);
+  ASSERT_NE(client, nullptr);
+
+  int received = 0;
+  SubscribeParams sub_params = DEFAULT_SUB_PARAMS;
+  sub_params.on_message_handler = _on_async_message;
+  sub_params.user_data = &received;
+  ASSERT_EQ(IOT_MQTT_SubscribeSync(client, topic_name, &sub_params), 0);
+
+  int completed = 0;
+  char payload[] = "{\"action\": \"io_thread\"}";
+  PublishParams pub_params = DEFAULT_PUB_PARAMS;
+  pub_params.qos = QOS1;
+  pub_params.payload = payload;
+  pub_params.payload_len = strlen(payload);
+  ASSERT_EQ(IOT_MQTT_PublishAsync(client, topic_name, &pub_params, _on_publish_complete, &completed), 0);
+  for (int i = 0; i < 10 && !__atomic_load_n(&received, __ATOMIC_RELAXED); i++) {
+    ASSERT_EQ(IOT_MQTT_Yield(client, 100), 0);
+  }
+  ASSERT_EQ(__atomic_load_n(&completed, __ATOMIC_RELAXED), 1);
+  ASSERT_EQ(__atomic_load_n(&received, __ATOMIC_RELAXED), 1);
+}
+
+/**
+ * @brief Benchmark of publish from many threads, synchronous publish contends for write buffer and socket, while
+ * asynchronous publish only links request to submit queue of io thread.
+ *
+ */
+TEST_F(MqttClientTest, DISABLED_io_thread_benchmark) {
+  const int thread_num = 4;
+  const int publish_times = 2000;
+
+  char topic_name[MAX_SIZE_OF_CLOUD_TOPIC] = {0};
+  HAL_Snprintf(topic_name, sizeof(topic_name), "%s/%s/data", device_info.product_id, device_info.device_name);
+
+  char payload[64];
+  memset(payload, 'a', sizeof(payload));
+  PublishParams pub_params = DEFAULT_PUB_PARAMS;
+  pub_params.payload = payload;
+  pub_params.payload_len = sizeof(payload);
+
+  MQTTInitParams init_params = DEFAULT_MQTT_INIT_PARAMS;
+  init_params.device_info = &device_info;
+
+  for (uint8_t io_thread_enable : {0, 1}) {
+    IOT_MQTT_Destroy(&client);
+    HAL_SleepMs(5000);  // for iot hub can not connect twice in 5 s
+
+    init_params.io_thread_enable = io_thread_enable;
+    client = IOT_MQTT_Construct(&init_params);
+    ASSERT_NE(client, nullptr);
+
+    utils_log_set_level(LOG_LEVEL_ERROR);
+    int completed = 0;
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int t = 0; t < thread_num; t++) {
+      threads.emplace_back([&] {
+        for (int n = 0; n < publish_times; n++) {
+          if (io_thread_enable) {
+            IOT_MQTT_PublishAsync(client, topic_name, &pub_params, _on_publish_complete, &completed);
+          } else if (IOT_MQTT_Publish(client, topic_name, &pub_params) >= 0) {
+            __atomic_add_fetch(&completed, 1, __ATOMIC_RELAXED);
+          }
+        }
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    auto submit_cost = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+
+    // yield returns as soon as packets handled in io thread mode, so wait by deadline
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+    while (std::chrono::steady_clock::now() < deadline &&
+           __atomic_load_n(&completed, __ATOMIC_RELAXED) < thread_num * publish_times) {
+      IOT_MQTT_Yield(client, 10);
+    }
+    auto cost = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+    utils_log_set_level(LOG_LEVEL_DEBUG);
+
+    ASSERT_EQ(__atomic_load_n(&completed, __ATOMIC_RELAXED), thread_num * publish_times);
+    std::cout << (io_thread_enable ? "async" : "sync") << " publish from " << thread_num
+              << " threads, submit: " << submit_cost.count() << " us, throughput: "
+              << thread_num * publish_times * 1000000LL / (cost.count() + 1) << " msgs/s" << std::endl;
+  }
+}
+
+/**
+ * @brief Benchmark of publish throughput with debug log on, printed by the thread publishing or by drain thread.
+ *
+ */
+TEST_F(MqttClientTest, DISABLED_log_benchmark) {
+  const int publish_times = 5000;
+
+  char topic_name[MAX_SIZE_OF_CLOUD_TOPIC] = {0};
+  HAL_Snprintf(topic_name, sizeof(topic_name), "%s/%s/data", device_info.product_id, device_info.device_name);
+
+  char payload[] = "{\"method\":\"report\",\"params\":{\"power_switch\":1}}";
+  PublishParams pub_params = DEFAULT_PUB_PARAMS;
+  pub_params.payload = payload;
+  pub_params.payload_len = strlen(payload);
+
+  LogAsyncFunc async_func = {
+      .log_sem_create = HAL_SemaphoreCreate,
+      .log_sem_destroy = HAL_SemaphoreDestroy,
+      .log_sem_post = HAL_SemaphorePost,
+      .log_sem_wait = HAL_SemaphoreWait,
+  };
+  static ThreadParams thread_params;
+
+  for (bool async : {false, true}) {
+    if (async) {
+      ASSERT_EQ(utils_log_async_init(async_func, 1024), 0);
+      thread_params.thread_name = const_cast<char *>("log_drain");
+      thread_params.thread_func = utils_log_async_run;
+      thread_params.stack_size = 4096;
+      ASSERT_EQ(HAL_ThreadCreate(&thread_params), 0);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (int n = 0; n < publish_times; n++) {
+      ASSERT_GE(IOT_MQTT_Publish(client, topic_name, &pub_params), 0);
+    }
+    auto cost = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+
+    if (async) {
+      utils_log_async_deinit();
+    }
+    std::cout << (async ? "async" : "sync") << " debug log, publish throughput: "
+              << publish_times * 1000000LL / (cost.count() + 1) << " msgs/s" << std::endl;
+  }
+}
+#endif
+
+#ifndef AUTH_WITH_NO_TLS
+/**
+ * @brief Test tls session resume, session is saved after handshake only if resume is enabled, and connect with saved
+ * session succeeds.
+ *
+ */
+TEST_F(MqttClientTest, tls_resume) {
+  IotNetwork *client_network = &reinterpret_cast<QcloudIotClient *>(client)->network_stack;
+
+  for (uint8_t resume : {0, 1}) {
+    IotNetwork network;
+    memset(&network, 0, sizeof(network));
+    network.type = IOT_NETWORK_TYPE_TLS;
+    network.host = client_network->host;
+    network.port = client_network->port;
+    network.ssl_connect_params = client_network->ssl_connect_params;
+    network.ssl_connect_params.session_resume_enable = resume;
+    network.ssl_connect_params.session = 0;
+    ASSERT_EQ(qcloud_iot_network_init(&network), 0);
+
+    ASSERT_EQ(network.connect(&network), 0);
+    network.disconnect(&network);
+    ASSERT_EQ(network.ssl_connect_params.session != 0, resume != 0);
+
+    ASSERT_EQ(network.connect(&network), 0);
+    network.disconnect(&network);
+
+    qcloud_iot_tls_client_session_free(&network.ssl_connect_params);
+    ASSERT_EQ(network.ssl_connect_params.session, 0u);
+  }
+}
+
+/**
+ * @brief Benchmark of full and resumed tls handshake. Run against mqtt server of device by default, or local mbedtls
+ * test server by TLS_BENCH_HOST and TLS_BENCH_PORT, such as ssl_server2 tickets=1 psk=<hex of device secret decoded>
+ * psk_identity=<client id>.
+ *
+ */
+TEST_F(MqttClientTest, DISABLED_tls_resume_benchmark) {
+  const int connect_times = 20;
+
+  IotNetwork *client_network = &reinterpret_cast<QcloudIotClient *>(client)->network_stack;
+  const char *host = getenv("TLS_BENCH_HOST") ? getenv("TLS_BENCH_HOST") : client_network->host;
+  const char *port = getenv("TLS_BENCH_PORT") ? getenv("TLS_BENCH_PORT") : client_network->port;
+
+  for (uint8_t resume : {0, 1}) {
+    IotNetwork network;
+    memset(&network, 0, sizeof(network));
+    network.type = IOT_NETWORK_TYPE_TLS;
+    network.host = host;
+    network.port = port;
+    network.ssl_connect_params = client_network->ssl_connect_params;
+    network.ssl_connect_params.session_resume_enable = resume;
+    network.ssl_connect_params.session = 0;
+    ASSERT_EQ(qcloud_iot_network_init(&network), 0);
+
+    // first connect is always a full handshake
+    ASSERT_EQ(network.connect(&network), 0);
+    network.disconnect(&network);
+
+    std::clock_t cpu_start = std::clock();
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < connect_times; i++) {
+      ASSERT_EQ(network.connect(&network), 0);
+      network.disconnect(&network);
+    }
+    auto cost = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+    std::cout << (resume ? "resumed" : "full") << " handshake, connect latency: " << cost.count() / connect_times
+              << " us, cpu: " << (std::clock() - cpu_start) * 1000000 / CLOCKS_PER_SEC / connect_times << " us"
+              << std::endl;
+
+    qcloud_iot_tls_client_session_free(&network.ssl_connect_params);
+  }
+}
+
+/**
+ * @brief Test connections with the same credential, which share drbg and ssl config, are open at the same time and
+ * connect again after all closed.
+ *
+ */
+TEST_F(MqttClientTest, tls_connect_shared) {
+  const int connect_num = 3;
+
+  IotNetwork *client_network = &reinterpret_cast<QcloudIotClient *>(client)->network_stack;
+  std::vector<IotNetwork> networks(connect_num);
+
+  for (IotNetwork &network : networks) {
+    memset(&network, 0, sizeof(network));
+    network.type = IOT_NETWORK_TYPE_TLS;
+    network.host = client_network->host;
+    network.port = client_network->port;
+    network.ssl_connect_params = client_network->ssl_connect_params;
+    network.ssl_connect_params.session_resume_enable = 0;
+    network.ssl_connect_params.session = 0;
+    ASSERT_EQ(qcloud_iot_network_init(&network), 0);
+    ASSERT_EQ(network.connect(&network), 0);
+  }
+
+  for (IotNetwork &network : networks) {
+    network.disconnect(&network);
+  }
+
+  ASSERT_EQ(networks[0].connect(&networks[0]), 0);
+  networks[0].disconnect(&networks[0]);
+}
+
+/**
+ * @brief Benchmark of connect rate and heap of each connection, drbg and ssl config are shared by connections with the
+ * same credential. Session resume is disabled to count full handshakes only.
+ *
+ */
+TEST_F(MqttClientTest, DISABLED_tls_connect_benchmark) {
+  const int connect_num = 10;
+
+  IotNetwork *client_network = &reinterpret_cast<QcloudIotClient *>(client)->network_stack;
+  std::vector<IotNetwork> networks(connect_num);
+
+  for (IotNetwork &network : networks) {
+    memset(&network, 0, sizeof(network));
+    network.type = IOT_NETWORK_TYPE_TLS;
+    network.host = getenv("TLS_BENCH_HOST") ? getenv("TLS_BENCH_HOST") : client_network->host;
+    network.port = getenv("TLS_BENCH_PORT") ? getenv("TLS_BENCH_PORT") : client_network->port;
+    network.ssl_connect_params = client_network->ssl_connect_params;
+    network.ssl_connect_params.session_resume_enable = 0;
+    network.ssl_connect_params.session = 0;
+    ASSERT_EQ(qcloud_iot_network_init(&network), 0);
+  }
+
+  size_t heap_start = mallinfo2().uordblks;
+  std::clock_t cpu_start = std::clock();
+  auto start = std::chrono::steady_clock::now();
+  for (IotNetwork &network : networks) {
+    ASSERT_EQ(network.connect(&network), 0);
+  }
+  auto cost = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+  size_t heap_used = mallinfo2().uordblks - heap_start;
+
+  std::cout << "connect rate: " << connect_num * 1000000LL / (cost.count() ? cost.count() : 1)
+            << " /s, cpu: " << (std::clock() - cpu_start) * 1000000 / CLOCKS_PER_SEC / connect_num
+            << " us, heap of each connection: " << heap_used / connect_num << " bytes" << std::endl;
+
+  for (IotNetwork &network : networks) {
+    network.disconnect(&network);
+  }
+}
+
+/**
+ * @brief Benchmark of bulk write throughput through tls layer, build with CONFIG_TLS_PROFILE DEFAULT and PERFORMANCE
+ * to compare. Run against local server discarding data by TLS_BENCH_HOST and TLS_BENCH_PORT, such as openssl s_server
+ * -accept <port> -nocert -tls1_2 -psk <hex of device secret decoded> -psk_identity <client id> -quiet > /dev/null.
+ *
+ */
+TEST_F(MqttClientTest, DISABLED_tls_throughput_benchmark) {
+  const size_t total_len = 64 * 1024 * 1024;
+  const size_t chunk_len = 64 * 1024;
+
+  if (!getenv("TLS_BENCH_HOST") || !getenv("TLS_BENCH_PORT")) {
+    GTEST_SKIP() << "TLS_BENCH_HOST or TLS_BENCH_PORT not set";
+  }
+
+  IotNetwork network;
+  memset(&network, 0, sizeof(network));
+  network.type = IOT_NETWORK_TYPE_TLS;
+  network.host = getenv("TLS_BENCH_HOST");
+  network.port = getenv("TLS_BENCH_PORT");
+  network.ssl_connect_params = reinterpret_cast<QcloudIotClient *>(client)->network_stack.ssl_connect_params;
+  network.ssl_connect_params.session_resume_enable = 0;
+  network.ssl_connect_params.session = 0;
+  ASSERT_EQ(qcloud_iot_network_init(&network), 0);
+  ASSERT_EQ(network.connect(&network), 0);
+
+  std::vector<unsigned char> chunk(chunk_len, 'x');
+  size_t written_len = 0;
+
+  std::clock_t cpu_start = std::clock();
+  auto start = std::chrono::steady_clock::now();
+  for (size_t sent = 0; sent < total_len; sent += written_len) {
+    ASSERT_EQ(network.write(&network, chunk.data(), chunk_len, 5000, &written_len), 0);
+  }
+  auto cost = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+
+#ifdef TLS_PROFILE_PERFORMANCE
+  const char *profile = "performance";
+#else
+  const char *profile = "default";
+#endif
+  std::cout << profile << " tls profile, write throughput: " << total_len / (cost.count() ? cost.count() : 1)
+            << " MB/s, cpu: " << (std::clock() - cpu_start) * 1000 / CLOCKS_PER_SEC << " ms for "
+            << total_len / (1024 * 1024) << " MB" << std::endl;
+
+  network.disconnect(&network);
+}
+
+static void _on_latency_message(void *client, const MQTTMessage *message, void *usr_data) {
+  *reinterpret_cast<std::chrono::steady_clock::time_point *>(usr_data) = std::chrono::steady_clock::now();
+}
+
+/**
+ * @brief Test tls read waits for the remaining time of yield, each control message is received in one yield.
+ *
+ */
+TEST_F(MqttClientTest, tls_read) {
+  const int message_num = 3;
+
+  char topic_name[MAX_SIZE_OF_CLOUD_TOPIC] = {0};
+  HAL_Snprintf(topic_name, sizeof(topic_name), "%s/%s/data", device_info.product_id, device_info.device_name);
+
+  std::chrono::steady_clock::time_point received;
+  SubscribeParams sub_params = DEFAULT_SUB_PARAMS;
+  sub_params.on_message_handler = _on_latency_message;
+  sub_params.user_data = &received;
+  ASSERT_GE(IOT_MQTT_SubscribeSync(client, topic_name, &sub_params), 0);
+
+  char payload[] = "{\"method\":\"control\"}";
+  PublishParams pub_params = DEFAULT_PUB_PARAMS;
+  pub_params.payload = payload;
+  pub_params.payload_len = strlen(payload);
+
+  for (int i = 0; i < message_num; i++) {
+    received = std::chrono::steady_clock::time_point();
+    ASSERT_GE(IOT_MQTT_Publish(client, topic_name, &pub_params), 0);
+    ASSERT_EQ(IOT_MQTT_Yield(client, 1000), 0);
+    ASSERT_NE(received, std::chrono::steady_clock::time_point());
+  }
+}
+
+/**
+ * @brief Benchmark of downstream control message latency and cpu of idle yield over tls, tls read waits on socket for
+ * the remaining time of yield instead of polling every read timeout.
+ *
+ */
+TEST_F(MqttClientTest, DISABLED_tls_read_latency_benchmark) {
+  const int message_num = 20;
+
+  char topic_name[MAX_SIZE_OF_CLOUD_TOPIC] = {0};
+  HAL_Snprintf(topic_name, sizeof(topic_name), "%s/%s/data", device_info.product_id, device_info.device_name);
+
+  std::chrono::steady_clock::time_point received;
+  SubscribeParams sub_params = DEFAULT_SUB_PARAMS;
+  sub_params.on_message_handler = _on_latency_message;
+  sub_params.user_data = &received;
+  ASSERT_GE(IOT_MQTT_SubscribeSync(client, topic_name, &sub_params), 0);
+
+  char payload[] = "{\"method\":\"control\"}";
+  PublishParams pub_params = DEFAULT_PUB_PARAMS;
+  pub_params.payload = payload;
+  pub_params.payload_len = strlen(payload);
+
+  std::chrono::microseconds total_latency(0);
+  for (int i = 0; i < message_num; i++) {
+    received = std::chrono::steady_clock::time_point();
+    auto sent = std::chrono::steady_clock::now();
+    ASSERT_GE(IOT_MQTT_Publish(client, topic_name, &pub_params), 0);
+    ASSERT_EQ(IOT_MQTT_Yield(client, 1000), 0);
+    ASSERT_NE(received, std::chrono::steady_clock::time_point());
+    total_latency += std::chrono::duration_cast<std::chrono::microseconds>(received - sent);
+  }
+
+  std::clock_t cpu_start = std::clock();
+  ASSERT_EQ(IOT_MQTT_Yield(client, 5000), 0);
+
+  std::cout << "control message latency: " << total_latency.count() / message_num
+            << " us, idle yield 5000 ms cpu: " << (std::clock() - cpu_start) * 1000000 / CLOCKS_PER_SEC << " us"
+            << std::endl;
+}
+#endif
+
 }  // namespace mqtt_client_unittest
@@ -28,6 +28,12 @@
 
 #include "qcloud_iot_ota.h"
 
+/**
+ * @brief Tokens to index members of ota message, members beyond are found by scanning.
+ *
+ */
+#define OTA_JSON_TOKEN_NUM 16
+
 /**
  * @brief Context of OTA update topic, callback and user data.
  *
@@ -50,11 +56,12 @@ typedef enum {
  * @brief Parse payload and callback.
  *
  * @param[in] type @see OTAUpdateType
- * @param[in] message message from cloud
+ * @param[in] tokens json index of message from cloud
+ * @param[in] num number of tokens
  * @param[in] callback callback for user
  * @param[in,out] usr_data user data used in callback
  */
-static void _parse_update_payload_and_callback(OTAUpdateType type, const MQTTMessage *message,
+static void _parse_update_payload_and_callback(OTAUpdateType type, const UtilsJsonToken *tokens, int num,
                                                const IotOTAUpdateCallback *callback, void *usr_data)
 {
     int            rc, result_code;
@@ -68,8 +75,7 @@ static void _parse_update_payload_and_callback(OTAUpdateType type, const MQTTMes
                 return;
             }
 
-            rc = utils_json_value_get("result_code", strlen("result_code"), message->payload_str, message->payload_len,
-                                      &value_result_code);
+            rc = utils_json_index_value_get(tokens, num, "result_code", strlen("result_code"), &value_result_code);
             if (rc) {
                 goto error;
             }
@@ -84,12 +90,10 @@ static void _parse_update_payload_and_callback(OTAUpdateType type, const MQTTMes
                 return;
             }
 
-            rc = utils_json_value_get("version", strlen("version"), message->payload_str, message->payload_len,
-                                      &version);
-            rc |= utils_json_value_get("url", strlen("url"), message->payload_str, message->payload_len, &url);
-            rc |= utils_json_value_get("md5sum", strlen("md5sum"), message->payload_str, message->payload_len, &md5sum);
-            rc |= utils_json_value_get("file_size", strlen("file_size"), message->payload_str, message->payload_len,
-                                       &value_file_size);
+            rc = utils_json_index_value_get(tokens, num, "version", strlen("version"), &version);
+            rc |= utils_json_index_value_get(tokens, num, "url", strlen("url"), &url);
+            rc |= utils_json_index_value_get(tokens, num, "md5sum", strlen("md5sum"), &md5sum);
+            rc |= utils_json_index_value_get(tokens, num, "file_size", strlen("file_size"), &value_file_size);
             rc |= utils_json_value_data_get(value_file_size, UTILS_JSON_VALUE_TYPE_UINT32, &file_size);
             if (rc) {
                 goto error;
@@ -119,14 +123,16 @@ static void _ota_mqtt_message_callback(void *client, const MQTTMessage *message,
         "update_firmware",     // OTA_UPDATE_TYPE_UPDATE_FIRMWARE
     };
 
-    int rc, i = 0;
+    int rc, num, i = 0;
 
     OTAUpdateContext *ota_update_context = (OTAUpdateContext *)usr_data;
     UtilsJsonValue    update_type;
+    UtilsJsonToken    tokens[OTA_JSON_TOKEN_NUM];
 
     Log_d("receive ota message:%.*s", message->payload_len, message->payload_str);
 
-    rc = utils_json_value_get("type", strlen("type"), message->payload_str, message->payload_len, &update_type);
+    num = utils_json_index_parse(message->payload_str, message->payload_len, 1, tokens, OTA_JSON_TOKEN_NUM);
+    rc  = utils_json_index_value_get(tokens, num, "type", strlen("type"), &update_type);
     if (rc) {
         Log_e("invalid ota message!");
         return;
@@ -135,7 +141,8 @@ static void _ota_mqtt_message_callback(void *client, const MQTTMessage *message,
     for (i = OTA_UPDATE_TYPE_REPORT_VERSION_RSP; i <= OTA_UPDATE_TYPE_UPDATE_FIRMWARE; i++) {
         if (!strncmp(update_type.value, ota_update_str[i], update_type.value_len)) {
             Log_d("callback ota message!");
-            _parse_update_payload_and_callback(i, message, &ota_update_context->callback, ota_update_context->usr_data);
+            _parse_update_payload_and_callback(i, tokens, num, &ota_update_context->callback,
+                                               ota_update_context->usr_data);
         }
     }
 }
@@ -267,28 +274,41 @@ int IOT_OTA_ReportProgress(void *client, char *buf, int buf_len, IotOTAReportTyp
     int         result_code[] = {0, 0, 0, -1, -2, -3, -4, -5};
     const char *result_msg[]  = {"", "", "", "timeout", "file not exit", "auth fail", "md5 not match", "upgrade fail"};
 
-    int len;
-    switch (report_type) {
-        case IOT_OTA_REPORT_TYPE_DOWNLOADING:
-            len = HAL_Snprintf(buf, buf_len,
-                               "{\"type\":\"report_progress\",\"report\":{\"progress\":{\"state\":\"%s\",\"percent\":"
-                               "\"%d\",\"result_code\":\"%d\",\"result_msg\":\"\"},\"version\":\"%s\"}}",
-                               ota_state[report_type], progress, result_code[report_type], version);
-            break;
-        case IOT_OTA_REPORT_TYPE_UPGRADE_BEGIN:
-        case IOT_OTA_REPORT_TYPE_UPGRADE_SUCCESS:
-        case IOT_OTA_REPORT_TYPE_DOWNLOAD_TIMEOUT:
-        case IOT_OTA_REPORT_TYPE_FILE_NOT_EXIST:
-        case IOT_OTA_REPORT_TYPE_AUTH_FAIL:
-        case IOT_OTA_REPORT_TYPE_MD5_NOT_MATCH:
-        case IOT_OTA_REPORT_TYPE_UPGRADE_FAIL:
-            len = HAL_Snprintf(buf, buf_len,
-                               "{\"type\":\"report_progress\",\"report\":{\"progress\":{\"state\":\"%s\",\"result_"
-                               "code\":\"%d\",\"result_msg\":\"%s\"},\"version\":\"%s\"}}",
-                               ota_state[report_type], result_code[report_type], result_msg[report_type], version);
-            break;
-        default:
-            return QCLOUD_ERR_INVAL;
+    int             len;
+    UtilsJsonWriter writer;
+
+    if (report_type < IOT_OTA_REPORT_TYPE_DOWNLOADING || report_type > IOT_OTA_REPORT_TYPE_UPGRADE_FAIL) {
+        return QCLOUD_ERR_INVAL;
+    }
+
+    utils_json_writer_init(&writer, buf, buf_len);
+    utils_json_writer_object_begin(&writer);
+    UTILS_JSON_WRITER_KEY(&writer, "type");
+    utils_json_writer_string(&writer, "report_progress", strlen("report_progress"));
+    UTILS_JSON_WRITER_KEY(&writer, "report");
+    utils_json_writer_object_begin(&writer);
+    UTILS_JSON_WRITER_KEY(&writer, "progress");
+    utils_json_writer_object_begin(&writer);
+    UTILS_JSON_WRITER_KEY(&writer, "state");
+    utils_json_writer_string(&writer, ota_state[report_type], strlen(ota_state[report_type]));
+    if (IOT_OTA_REPORT_TYPE_DOWNLOADING == report_type) {
+        UTILS_JSON_WRITER_KEY(&writer, "percent");
+        utils_json_writer_int_string(&writer, progress);
+    }
+    UTILS_JSON_WRITER_KEY(&writer, "result_code");
+    utils_json_writer_int_string(&writer, result_code[report_type]);
+    UTILS_JSON_WRITER_KEY(&writer, "result_msg");
+    utils_json_writer_string(&writer, result_msg[report_type], strlen(result_msg[report_type]));
+    utils_json_writer_object_end(&writer);
+    UTILS_JSON_WRITER_KEY(&writer, "version");
+    utils_json_writer_string(&writer, version, strlen(version));
+    utils_json_writer_object_end(&writer);
+    utils_json_writer_object_end(&writer);
+
+    len = utils_json_writer_finish(&writer);
+    if (len < 0) {
+        Log_e("buffer is not enough for ota report!");
+        return QCLOUD_ERR_JSON_BUFFER_TRUNCATED;
     }
     return _ota_mqtt_publish(client, QOS0, buf, len);
 }
@@ -304,7 +324,26 @@ int IOT_OTA_ReportProgress(void *client, char *buf, int buf_len, IotOTAReportTyp
  */
 int IOT_OTA_ReportVersion(void *client, char *buf, int buf_len, const char *version)
 {
-    int len = HAL_Snprintf(buf, buf_len, "{\"type\":\"report_version\",\"report\":{\"version\":\"%s\"}}",
-                           STRING_PTR_PRINT_SANITY_CHECK(version));
+    int             len;
+    UtilsJsonWriter writer;
+
+    version = STRING_PTR_PRINT_SANITY_CHECK(version);
+
+    utils_json_writer_init(&writer, buf, buf_len);
+    utils_json_writer_object_begin(&writer);
+    UTILS_JSON_WRITER_KEY(&writer, "type");
+    utils_json_writer_string(&writer, "report_version", strlen("report_version"));
+    UTILS_JSON_WRITER_KEY(&writer, "report");
+    utils_json_writer_object_begin(&writer);
+    UTILS_JSON_WRITER_KEY(&writer, "version");
+    utils_json_writer_string(&writer, version, strlen(version));
+    utils_json_writer_object_end(&writer);
+    utils_json_writer_object_end(&writer);
+
+    len = utils_json_writer_finish(&writer);
+    if (len < 0) {
+        Log_e("buffer is not enough for ota version!");
+        return QCLOUD_ERR_JSON_BUFFER_TRUNCATED;
+    }
     return _ota_mqtt_publish(client, QOS0, buf, len);
 }
@@ -40,6 +40,12 @@ extern "C" {
  * common
  **************************************************************************************/
 
+/**
+ * @brief Tokens to index members of down message, members beyond are found by scanning.
+ *
+ */
+#define DATA_TEMPLATE_JSON_TOKEN_NUM 16
+
 /**
  * @brief Type of data template(property/event/action).
  *
@@ -109,8 +115,11 @@ typedef enum {
 } PropertyUpMethodType;
 
 typedef union {
-    const char *json;
-    int         code;
+    struct {
+        PropertyParamsWrite write;
+        void               *usr_data;
+    } params;
+    int code;
     struct {
         int            code;
         UtilsJsonValue client_token;
@@ -88,8 +88,28 @@ error:
  */
 int data_template_action_reply_publish(void *client, char *buf, int buf_len, IotDataTemplateActionReply reply)
 {
-    int len =
-        HAL_Snprintf(buf, buf_len, "{\"method\":\"action_reply\",\"clientToken\":\"%.*s\",\"code\":%d,\"response\":%s}",
-                     reply.client_token.value_len, reply.client_token.value, reply.code, reply.response);
+    int             len;
+    UtilsJsonWriter writer;
+
+    POINTER_SANITY_CHECK(reply.response, QCLOUD_ERR_INVAL);
+
+    utils_json_writer_init(&writer, buf, buf_len);
+    utils_json_writer_object_begin(&writer);
+    UTILS_JSON_WRITER_KEY(&writer, "method");
+    utils_json_writer_string(&writer, "action_reply", strlen("action_reply"));
+    UTILS_JSON_WRITER_KEY(&writer, "clientToken");
+    // client token got from json is already escaped
+    utils_json_writer_string_raw(&writer, reply.client_token.value, reply.client_token.value_len);
+    UTILS_JSON_WRITER_KEY(&writer, "code");
+    utils_json_writer_int(&writer, reply.code);
+    UTILS_JSON_WRITER_KEY(&writer, "response");
+    utils_json_writer_raw(&writer, reply.response, strlen(reply.response));
+    utils_json_writer_object_end(&writer);
+
+    len = utils_json_writer_finish(&writer);
+    if (len < 0) {
+        Log_e("buffer is not enough for action reply!");
+        return QCLOUD_ERR_JSON_BUFFER_TRUNCATED;
+    }
     return data_template_publish(client, DATA_TEMPLATE_TYPE_ACTION, QOS0, buf, len);
 }
@@ -78,6 +78,19 @@ void IOT_DataTemplate_Deinit(void *client)
     data_template_topic_unsubscribe(client, DATA_TEMPLATE_TYPE_ACTION);
 }
 
+/**
+ * @brief Write params string constructed by user.
+ *
+ * @param[in,out] writer @see UtilsJsonWriter
+ * @param[in] usr_data params string
+ * @return 0 for success
+ */
+static int _property_params_string_write(UtilsJsonWriter *writer, void *usr_data)
+{
+    utils_json_writer_raw(writer, usr_data, strlen(usr_data));
+    return 0;
+}
+
 /**
  * @brief Report property.
  *
@@ -91,8 +104,30 @@ int IOT_DataTemplate_PropertyReport(void *client, char *buf, int buf_len, const
 {
     POINTER_SANITY_CHECK(client, QCLOUD_ERR_INVAL);
     POINTER_SANITY_CHECK(buf, QCLOUD_ERR_INVAL);
+    POINTER_SANITY_CHECK(params, QCLOUD_ERR_INVAL);
+
+    PropertyPublishParams publish_params = {.params = {_property_params_string_write, (void *)params}};
+    return data_template_property_publish(client, PROPERTY_UP_METHOD_TYPE_REPORT, buf, buf_len, publish_params);
+}
+
+/**
+ * @brief Report property, params are written into buffer directly without constructing json string first.
+ *
+ * @param[in,out] client pointer to mqtt client
+ * @param[in] buf buffer for message
+ * @param[in] buf_len buffer length
+ * @param[in] params_write write params, @see PropertyParamsWrite
+ * @param[in,out] usr_data user data of params_write
+ * @return packet id (>=0) when success, or err code (<0) @see IotReturnCode
+ */
+int IOT_DataTemplate_PropertyReportWrite(void *client, char *buf, int buf_len, PropertyParamsWrite params_write,
+                                         void *usr_data)
+{
+    POINTER_SANITY_CHECK(client, QCLOUD_ERR_INVAL);
+    POINTER_SANITY_CHECK(buf, QCLOUD_ERR_INVAL);
+    POINTER_SANITY_CHECK(params_write, QCLOUD_ERR_INVAL);
 
-    PropertyPublishParams publish_params = {.json = params};
+    PropertyPublishParams publish_params = {.params = {params_write, usr_data}};
     return data_template_property_publish(client, PROPERTY_UP_METHOD_TYPE_REPORT, buf, buf_len, publish_params);
 }
 
@@ -126,8 +161,9 @@ int IOT_DataTemplate_PropertyReportInfo(void *client, char *buf, int buf_len, co
 {
     POINTER_SANITY_CHECK(client, QCLOUD_ERR_INVAL);
     POINTER_SANITY_CHECK(buf, QCLOUD_ERR_INVAL);
+    POINTER_SANITY_CHECK(params, QCLOUD_ERR_INVAL);
 
-    PropertyPublishParams publish_params = {.json = params};
+    PropertyPublishParams publish_params = {.params = {_property_params_string_write, (void *)params}};
     return data_template_property_publish(client, PROPERTY_UP_METHOD_TYPE_REPORT_INFO, buf, buf_len, publish_params);
 }
 
@@ -74,6 +74,26 @@ error:
     Log_e("invalid format of payload!");
 }
 
+/**
+ * @brief Write client token of event post, which is event-{token_num}.
+ *
+ * @param[in,out] writer @see UtilsJsonWriter
+ * @return @see IotReturnCode
+ */
+static int _event_client_token_write(UtilsJsonWriter *writer)
+{
+    static uint32_t token_num = 0;
+
+    char client_token[32];
+    int  len = HAL_Snprintf(client_token, sizeof(client_token), "event-%u", (unsigned int)token_num++);
+
+    if (len < 0 || len >= (int)sizeof(client_token)) {
+        return QCLOUD_ERR_FAILURE;
+    }
+    utils_json_writer_string(writer, client_token, len);
+    return QCLOUD_RET_SUCCESS;
+}
+
 /**
  * @brief Publish message to event topic.
  *
@@ -91,11 +111,35 @@ int data_template_event_reply_publish(void *client, char *buf, int buf_len, IotD
         "fault",  // IOT_DATA_TEMPLATE_EVENT_TYPE_FAULT
     };
 
-    static uint32_t token_num = 0;
+    int             len;
+    UtilsJsonWriter writer;
+
+    POINTER_SANITY_CHECK(data.event_id, QCLOUD_ERR_INVAL);
+    POINTER_SANITY_CHECK(data.params, QCLOUD_ERR_INVAL);
+    if (data.type < IOT_DATA_TEMPLATE_EVENT_TYPE_INFO || data.type > IOT_DATA_TEMPLATE_EVENT_TYPE_FAULT) {
+        return QCLOUD_ERR_INVAL;
+    }
+
+    utils_json_writer_init(&writer, buf, buf_len);
+    utils_json_writer_object_begin(&writer);
+    UTILS_JSON_WRITER_KEY(&writer, "method");
+    utils_json_writer_string(&writer, "event_post", strlen("event_post"));
+    UTILS_JSON_WRITER_KEY(&writer, "clientToken");
+    if (_event_client_token_write(&writer)) {
+        return QCLOUD_ERR_FAILURE;
+    }
+    UTILS_JSON_WRITER_KEY(&writer, "eventId");
+    utils_json_writer_string(&writer, data.event_id, strlen(data.event_id));
+    UTILS_JSON_WRITER_KEY(&writer, "type");
+    utils_json_writer_string(&writer, event_type[data.type], strlen(event_type[data.type]));
+    UTILS_JSON_WRITER_KEY(&writer, "params");
+    utils_json_writer_raw(&writer, data.params, strlen(data.params));
+    utils_json_writer_object_end(&writer);
 
-    int len = HAL_Snprintf(
-        buf, buf_len,
-        "{\"method\":\"event_post\",\"clientToken\":\"event-%u\",\"eventId\":\"%s\",\"type\":\"%s\",\"params\":%s}",
-        token_num++, data.event_id, event_type[data.type], data.params);
+    len = utils_json_writer_finish(&writer);
+    if (len < 0) {
+        Log_e("buffer is not enough for event post!");
+        return QCLOUD_ERR_JSON_BUFFER_TRUNCATED;
+    }
     return data_template_publish(client, DATA_TEMPLATE_TYPE_EVENT, QOS0, buf, len);
 }
@@ -45,19 +45,20 @@ typedef enum {
  * @brief Parse payload and callback.
  *
  * @param[in] type @see PropertyDownMethodType
- * @param[in] message message from cloud
+ * @param[in] tokens json index of message from cloud
+ * @param[in] num number of tokens
  * @param[in] callback callback for user
  * @param[in,out] usr_data user data used in callback
  */
-static void _parse_method_payload_and_callback(PropertyDownMethodType type, const MQTTMessage *message,
+static void _parse_method_payload_and_callback(PropertyDownMethodType type, const UtilsJsonToken *tokens, int num,
                                                const PropertyMessageCallback *callback, void *usr_data)
 {
-    int            rc = 0, code;
-    UtilsJsonValue client_token, value_code, params, reported, control;
+    int            rc = 0, code, data_num;
+    UtilsJsonValue client_token, value_code, params, data, reported, control;
+    UtilsJsonToken data_tokens[DATA_TEMPLATE_JSON_TOKEN_NUM];
 
     // get client token
-    rc = utils_json_value_get("clientToken", strlen("clientToken"), message->payload_str, message->payload_len,
-                              &client_token);
+    rc = utils_json_index_value_get(tokens, num, "clientToken", strlen("clientToken"), &client_token);
     if (rc) {
         goto error;
     }
@@ -65,7 +66,7 @@ static void _parse_method_payload_and_callback(PropertyDownMethodType type, cons
     // get code
     if (PROPERTY_DOWN_METHOD_TYPE_REPORT_REPLY == type || PROPERTY_DOWN_METHOD_TYPE_GET_STATUS_REPLY == type ||
         PROPERTY_DOWN_METHOD_TYPE_REPORT_INFO_REPLY == type || PROPERTY_DOWN_METHOD_TYPE_CLEAR_CONTROL_REPLY == type) {
-        rc = utils_json_value_get("code", strlen("code"), message->payload_str, message->payload_len, &value_code);
+        rc = utils_json_index_value_get(tokens, num, "code", strlen("code"), &value_code);
         if (rc) {
             goto error;
         }
@@ -80,8 +81,7 @@ static void _parse_method_payload_and_callback(PropertyDownMethodType type, cons
     switch (type) {
         case PROPERTY_DOWN_METHOD_TYPE_CONTROL:
             if (callback->method_control_callback) {
-                rc = utils_json_value_get("params", strlen("params"), message->payload_str, message->payload_len,
-                                          &params);
+                rc = utils_json_index_value_get(tokens, num, "params", strlen("params"), &params);
                 if (rc) {
                     goto error;
                 }
@@ -99,10 +99,15 @@ static void _parse_method_payload_and_callback(PropertyDownMethodType type, cons
                 reported.value_len = 0;
                 control.value      = NULL;
                 control.value_len  = 0;
-                rc = utils_json_value_get("data.reported", strlen("data.reported"), message->payload_str,
-                                          message->payload_len, &reported);
-                rc &= utils_json_value_get("data.control", strlen("data.control"), message->payload_str,
-                                           message->payload_len, &control);
+                // index members of data once instead of scanning it for each
+                rc = utils_json_index_value_get(tokens, num, "data", strlen("data"), &data);
+                if (rc) {
+                    goto error;
+                }
+                data_num =
+                    utils_json_index_parse(data.value, data.value_len, 1, data_tokens, DATA_TEMPLATE_JSON_TOKEN_NUM);
+                rc = utils_json_index_value_get(data_tokens, data_num, "reported", strlen("reported"), &reported);
+                rc &= utils_json_index_value_get(data_tokens, data_num, "control", strlen("control"), &control);
                 if (rc) {
                     goto error;
                 }
@@ -146,26 +151,49 @@ void data_template_property_message_handler(void *client, const MQTTMessage *mes
         "clear_control_reply",  // PROPERTY_DOWN_METHOD_TYPE_CLEAR_CONTROL_REPLY
     };
 
-    int rc, i = 0;
+    int rc, num, i = 0;
 
     DataTemplateContext *data_template_context = (DataTemplateContext *)usr_data;
     UtilsJsonValue       method;
+    UtilsJsonToken       tokens[DATA_TEMPLATE_JSON_TOKEN_NUM];
 
     Log_d("receive property message:%.*s", message->payload_len, message->payload_str);
 
-    rc = utils_json_value_get("method", strlen("method"), message->payload_str, message->payload_len, &method);
+    // index members of payload once, params and data are kept as a whole
+    num = utils_json_index_parse(message->payload_str, message->payload_len, 1, tokens, DATA_TEMPLATE_JSON_TOKEN_NUM);
+    rc  = utils_json_index_value_get(tokens, num, "method", strlen("method"), &method);
     if (rc) {
         return;
     }
 
     for (i = PROPERTY_DOWN_METHOD_TYPE_CONTROL; i <= PROPERTY_DOWN_METHOD_TYPE_CLEAR_CONTROL_REPLY; i++) {
         if (!strncmp(method.value, property_down_method_str[i], method.value_len)) {
-            _parse_method_payload_and_callback(i, message, &data_template_context->property_callback,
+            _parse_method_payload_and_callback(i, tokens, num, &data_template_context->property_callback,
                                                data_template_context->usr_data);
         }
     }
 }
 
+/**
+ * @brief Write client token of up message, which is property-{token_num}.
+ *
+ * @param[in,out] writer @see UtilsJsonWriter
+ * @return @see IotReturnCode
+ */
+static int _property_client_token_write(UtilsJsonWriter *writer)
+{
+    static uint32_t token_num = 0;
+
+    char client_token[32];
+    int  len = HAL_Snprintf(client_token, sizeof(client_token), "property-%u", (unsigned int)token_num++);
+
+    if (len < 0 || len >= (int)sizeof(client_token)) {
+        return QCLOUD_ERR_FAILURE;
+    }
+    utils_json_writer_string(writer, client_token, len);
+    return QCLOUD_RET_SUCCESS;
+}
+
 /**
  * @brief Publish message to property topic.
  *
@@ -179,36 +207,51 @@ void data_template_property_message_handler(void *client, const MQTTMessage *mes
 int data_template_property_publish(void *client, PropertyUpMethodType publish_type, char *buf, int buf_len,
                                    PropertyPublishParams params)
 {
-    static uint32_t token_num = 0;
+    /**
+     * @brief order @see PropertyUpMethodType
+     *
+     */
+    const char *method_str[] = {"report", "report_info", "get_status", "clear_control", "control_reply"};
+
+    int             len;
+    UtilsJsonWriter writer;
+
+    if (publish_type < PROPERTY_UP_METHOD_TYPE_REPORT || publish_type > PROPERTY_UP_METHOD_TYPE_CONTROL_REPLY) {
+        return QCLOUD_ERR_FAILURE;
+    }
 
-    int len = 0;
+    utils_json_writer_init(&writer, buf, buf_len);
+    utils_json_writer_object_begin(&writer);
+    UTILS_JSON_WRITER_KEY(&writer, "method");
+    utils_json_writer_string(&writer, method_str[publish_type], strlen(method_str[publish_type]));
+    UTILS_JSON_WRITER_KEY(&writer, "clientToken");
 
     switch (publish_type) {
-        case PROPERTY_UP_METHOD_TYPE_REPORT:
-            len = HAL_Snprintf(buf, buf_len, "{\"method\":\"report\",\"clientToken\":\"property-%u\",\"params\":%s}",
-                               token_num++, params.json);
-            break;
-        case PROPERTY_UP_METHOD_TYPE_REPORT_INFO:
-            len =
-                HAL_Snprintf(buf, buf_len, "{\"method\":\"report_info\",\"clientToken\":\"property-%u\",\"params\":%s}",
-                             token_num++, params.json);
-            break;
-        case PROPERTY_UP_METHOD_TYPE_GET_STATUS:
-            len =
-                HAL_Snprintf(buf, buf_len, "{\"method\":\"get_status\",\"clientToken\":\"property-%u\"}", token_num++);
-            break;
-        case PROPERTY_UP_METHOD_TYPE_CLEAR_CONTROL:
-            len = HAL_Snprintf(buf, buf_len, "{\"method\":\"clear_control\",\"clientToken\":\"property-%u\"}",
-                               token_num++);
-            break;
         case PROPERTY_UP_METHOD_TYPE_CONTROL_REPLY:
-            len = HAL_Snprintf(buf, buf_len, "{\"method\":\"control_reply\",\"clientToken\":\"%.*s\",\"code\":%d}",
-                               params.control_reply.client_token.value_len, params.control_reply.client_token.value,
-                               params.control_reply.code);
+            // client token got from json is already escaped
+            utils_json_writer_string_raw(&writer, params.control_reply.client_token.value,
+                                         params.control_reply.client_token.value_len);
+            UTILS_JSON_WRITER_KEY(&writer, "code");
+            utils_json_writer_int(&writer, params.control_reply.code);
             break;
         default:
-            return QCLOUD_ERR_FAILURE;
+            if (_property_client_token_write(&writer)) {
+                return QCLOUD_ERR_FAILURE;
+            }
+            if (PROPERTY_UP_METHOD_TYPE_REPORT == publish_type || PROPERTY_UP_METHOD_TYPE_REPORT_INFO == publish_type) {
+                UTILS_JSON_WRITER_KEY(&writer, "params");
+                if (params.params.write(&writer, params.params.usr_data)) {
+                    return QCLOUD_ERR_JSON;
+                }
+            }
+            break;
     }
+    utils_json_writer_object_end(&writer);
 
+    len = utils_json_writer_finish(&writer);
+    if (len < 0) {
+        Log_e("buffer is not enough for property message!");
+        return QCLOUD_ERR_JSON_BUFFER_TRUNCATED;
+    }
     return data_template_publish(client, DATA_TEMPLATE_TYPE_PROPERTY, QOS0, buf, len);
 }
@@ -303,47 +303,66 @@ int IOT_FileManage_Report(void *client, char *buf, int buf_len, IotFileManageRep
         "post fail",
     };
 
-    int len;
+    int             len, is_post;
+    UtilsJsonWriter writer;
+
+    if (report_type < IOT_FILE_MANAGE_REPORT_TYPE_DOWNLOADING || report_type > IOT_FILE_MANAGE_REPORT_TYPE_POST_FAIL) {
+        return QCLOUD_ERR_INVAL;
+    }
+    // post result reports token of file posted, without version
+    is_post = report_type >= IOT_FILE_MANAGE_REPORT_TYPE_POST_SUCCESS;
+
+    utils_json_writer_init(&writer, buf, buf_len);
+    utils_json_writer_object_begin(&writer);
+    UTILS_JSON_WRITER_KEY(&writer, "method");
     switch (report_type) {
         case IOT_FILE_MANAGE_REPORT_TYPE_DOWNLOADING:
-            len = HAL_Snprintf(
-                buf, buf_len,
-                "{\"method\":\"report_progress\",\"report\":{\"progress\":{\"resource_name\":\"%s\",\"state\":\"%s\","
-                "\"percent\":\"%d\",\"result_code\":\"%d\",\"result_msg\":\"\"},\"version\":\"%s\"}}",
-                file_name_or_token, state_string[report_type], progress, result_code[report_type], version);
-            break;
-        case IOT_FILE_MANAGE_REPORT_TYPE_UPGRADE_BEGIN:
-        case IOT_FILE_MANAGE_REPORT_TYPE_UPGRADE_SUCCESS:
-        case IOT_FILE_MANAGE_REPORT_TYPE_DOWNLOAD_TIMEOUT:
-        case IOT_FILE_MANAGE_REPORT_TYPE_FILE_NOT_EXIST:
-        case IOT_FILE_MANAGE_REPORT_TYPE_AUTH_FAIL:
-        case IOT_FILE_MANAGE_REPORT_TYPE_MD5_NOT_MATCH:
-        case IOT_FILE_MANAGE_REPORT_TYPE_UPGRADE_FAIL:
-        case IOT_FILE_MANAGE_REPORT_TYPE_SPACE_NOT_ENOUGH:
-            len = HAL_Snprintf(buf, buf_len,
-                               "{\"method\":\"report_result\",\"report\":{\"progress\":{\"resource_name\":\"%s\","
-                               "\"state\":\"%s\",\"result_code\":\"%d\",\"result_msg\":\"%s\"},\"version\":\"%s\"}}",
-                               file_name_or_token, state_string[report_type], result_code[report_type],
-                               result_msg[report_type], version);
+            utils_json_writer_string(&writer, "report_progress", strlen("report_progress"));
             break;
         case IOT_FILE_MANAGE_REPORT_TYPE_DEL_SUCCESS:
         case IOT_FILE_MANAGE_REPORT_TYPE_DEL_FAIL:
-            len = HAL_Snprintf(buf, buf_len,
-                               "{\"method\":\"del_result\",\"report\":{\"progress\":{\"resource_name\":\"%s\","
-                               "\"state\":\"%s\",\"result_code\":\"%d\", \"result_msg\":\"%s\"}, \"version\":\"%s\"}}",
-                               file_name_or_token, state_string[report_type], result_code[report_type],
-                               result_msg[report_type], version);
+            utils_json_writer_string(&writer, "del_result", strlen("del_result"));
             break;
         case IOT_FILE_MANAGE_REPORT_TYPE_POST_SUCCESS:
         case IOT_FILE_MANAGE_REPORT_TYPE_POST_FAIL:
-            len = HAL_Snprintf(buf, buf_len,
-                               "{\"method\":\"report_post_result\",\"report\":{\"progress\":{\"resource_token\":\"%s\","
-                               "\"state\":\"%s\",\"result_code\":\"%d\", \"result_msg\":\"%s\"}}}",
-                               file_name_or_token, state_string[report_type], result_code[report_type],
-                               result_msg[report_type]);
+            utils_json_writer_string(&writer, "report_post_result", strlen("report_post_result"));
             break;
         default:
-            return QCLOUD_ERR_INVAL;
+            utils_json_writer_string(&writer, "report_result", strlen("report_result"));
+            break;
+    }
+    UTILS_JSON_WRITER_KEY(&writer, "report");
+    utils_json_writer_object_begin(&writer);
+    UTILS_JSON_WRITER_KEY(&writer, "progress");
+    utils_json_writer_object_begin(&writer);
+    if (is_post) {
+        UTILS_JSON_WRITER_KEY(&writer, "resource_token");
+    } else {
+        UTILS_JSON_WRITER_KEY(&writer, "resource_name");
+    }
+    utils_json_writer_string(&writer, file_name_or_token, strlen(file_name_or_token));
+    UTILS_JSON_WRITER_KEY(&writer, "state");
+    utils_json_writer_string(&writer, state_string[report_type], strlen(state_string[report_type]));
+    if (IOT_FILE_MANAGE_REPORT_TYPE_DOWNLOADING == report_type) {
+        UTILS_JSON_WRITER_KEY(&writer, "percent");
+        utils_json_writer_int_string(&writer, progress);
+    }
+    UTILS_JSON_WRITER_KEY(&writer, "result_code");
+    utils_json_writer_int_string(&writer, result_code[report_type]);
+    UTILS_JSON_WRITER_KEY(&writer, "result_msg");
+    utils_json_writer_string(&writer, result_msg[report_type], strlen(result_msg[report_type]));
+    utils_json_writer_object_end(&writer);
+    if (!is_post) {
+        UTILS_JSON_WRITER_KEY(&writer, "version");
+        utils_json_writer_string(&writer, version, strlen(version));
+    }
+    utils_json_writer_object_end(&writer);
+    utils_json_writer_object_end(&writer);
+
+    len = utils_json_writer_finish(&writer);
+    if (len < 0) {
+        Log_e("buffer is not enough for file manage report!");
+        return QCLOUD_ERR_JSON_BUFFER_TRUNCATED;
     }
     return service_mqtt_publish(client, QOS0, buf, len);
 }
@@ -365,23 +384,40 @@ int IOT_FileManage_ReportFileList(void *client, char *buf, int buf_len, const Io
     POINTER_SANITY_CHECK(buf, QCLOUD_ERR_INVAL);
     NUMBERIC_SANITY_CHECK(buf_len, QCLOUD_ERR_INVAL);
 
-    int len = HAL_Snprintf(buf, buf_len, "{\"method\":\"report_version\",\"report\":{\"resource_list\":[");
+    int             len;
+    UtilsJsonWriter writer;
+
+    utils_json_writer_init(&writer, buf, buf_len);
+    utils_json_writer_object_begin(&writer);
+    UTILS_JSON_WRITER_KEY(&writer, "method");
+    utils_json_writer_string(&writer, "report_version", strlen("report_version"));
+    UTILS_JSON_WRITER_KEY(&writer, "report");
+    utils_json_writer_object_begin(&writer);
+    UTILS_JSON_WRITER_KEY(&writer, "resource_list");
+    utils_json_writer_array_begin(&writer);
     for (int i = 0; i < max_num; i++) {
-        if (file_list[i].file_type == IOT_FILE_MANAGE_FILE_TYPE_UNKOWN) {
+        if (file_list[i].file_type == IOT_FILE_MANAGE_FILE_TYPE_UNKOWN || file_list[i].file_name[0] == '\0') {
             continue;
         }
-
-        if (file_list[i].file_name[0] != '\0') {
-            len += HAL_Snprintf(buf + len, buf_len - len,
-                                "{\"resource_name\":\"%s\",\"version\":\"%s\",\"resource_type\":\"%s\"},",
-                                file_list[i].file_name, file_list[i].file_version,
-                                sg_file_manage_file_type_str[file_list[i].file_type]);
-        }
+        const char *file_type = sg_file_manage_file_type_str[file_list[i].file_type];
+        utils_json_writer_object_begin(&writer);
+        UTILS_JSON_WRITER_KEY(&writer, "resource_name");
+        utils_json_writer_string(&writer, file_list[i].file_name, strlen(file_list[i].file_name));
+        UTILS_JSON_WRITER_KEY(&writer, "version");
+        utils_json_writer_string(&writer, file_list[i].file_version, strlen(file_list[i].file_version));
+        UTILS_JSON_WRITER_KEY(&writer, "resource_type");
+        utils_json_writer_string(&writer, file_type, strlen(file_type));
+        utils_json_writer_object_end(&writer);
     }
-    if (buf[len - 1] != '[') {
-        len--;  // remove the last ','
+    utils_json_writer_array_end(&writer);
+    utils_json_writer_object_end(&writer);
+    utils_json_writer_object_end(&writer);
+
+    len = utils_json_writer_finish(&writer);
+    if (len < 0) {
+        Log_e("buffer is not enough for file list!");
+        return QCLOUD_ERR_JSON_BUFFER_TRUNCATED;
     }
-    len += HAL_Snprintf(buf + len, buf_len - len, "]}}");
     return service_mqtt_publish(client, QOS0, buf, len);
 }
 
@@ -404,11 +440,32 @@ int IOT_FileManage_PostRequest(void *client, char *buf, int buf_len, const IotFi
     POINTER_SANITY_CHECK(file_info, QCLOUD_ERR_INVAL);
     NUMBERIC_SANITY_CHECK(file_info->file_type, QCLOUD_ERR_INVAL);
 
-    int len = HAL_Snprintf(buf, buf_len,
-                           "{\"method\":\"request_url\",\"request_id\":\"%d\","
-                           "\"report\":{\"resource_name\":\"%s\",\"version\":\"%s\",\"resource_type\":\"%s\"}}",
-                           request_id, file_info->file_name, file_info->file_version,
-                           sg_file_manage_file_type_str[file_info->file_type]);
+    int             len;
+    UtilsJsonWriter writer;
+    const char     *file_type = sg_file_manage_file_type_str[file_info->file_type];
+
+    utils_json_writer_init(&writer, buf, buf_len);
+    utils_json_writer_object_begin(&writer);
+    UTILS_JSON_WRITER_KEY(&writer, "method");
+    utils_json_writer_string(&writer, "request_url", strlen("request_url"));
+    UTILS_JSON_WRITER_KEY(&writer, "request_id");
+    utils_json_writer_int_string(&writer, request_id);
+    UTILS_JSON_WRITER_KEY(&writer, "report");
+    utils_json_writer_object_begin(&writer);
+    UTILS_JSON_WRITER_KEY(&writer, "resource_name");
+    utils_json_writer_string(&writer, file_info->file_name, strlen(file_info->file_name));
+    UTILS_JSON_WRITER_KEY(&writer, "version");
+    utils_json_writer_string(&writer, file_info->file_version, strlen(file_info->file_version));
+    UTILS_JSON_WRITER_KEY(&writer, "resource_type");
+    utils_json_writer_string(&writer, file_type, strlen(file_type));
+    utils_json_writer_object_end(&writer);
+    utils_json_writer_object_end(&writer);
+
+    len = utils_json_writer_finish(&writer);
+    if (len < 0) {
+        Log_e("buffer is not enough for request url!");
+        return QCLOUD_ERR_JSON_BUFFER_TRUNCATED;
+    }
     return service_mqtt_publish(client, QOS0, buf, len);
 }
 
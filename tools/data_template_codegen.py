@@ -0,0 +1,467 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+#
+# Tencent is pleased to support the open source community by making IoT Hub available.
+# Copyright(C) 2018 - 2021 THL A29 Limited, a Tencent company.All rights reserved.
+#
+# Licensed under the MIT License(the "License"); you may not use this file except in
+# compliance with the License. You may obtain a copy of the License at
+# http://opensource.org/licenses/MIT
+#
+# Unless required by applicable law or agreed to in writing, software distributed under the License is
+# distributed on an "AS IS" basis, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+# either express or implied. See the License for the specific language governing permissions and
+# limitations under the License.
+"""Generate data template tables from thing model json.
+
+Usage: data_template_codegen.py -c data_template.json -d output_dir
+
+Outputs data_template_config_gen.h and data_template_config_gen.c, which are used by
+app/data_template/data_template_config.c:
+  - index enums and counts of properties, struct members, events, actions and action inputs
+  - statically initialized tables, so nothing is initialized at runtime
+  - perfect hash of keys for each property table, so parsing matches a key in O(1)
+  - typed accessors of properties
+"""
+
+import argparse
+import json
+import os
+import sys
+
+GEN_H = "data_template_config_gen.h"
+GEN_C = "data_template_config_gen.c"
+
+# max properties of one table, limited by dirty/parse bitmap of uint32_t
+MAX_TABLE_SIZE = 32
+
+# default string buffer length when max is not defined
+DEFAULT_STRING_LEN = 64
+
+PROPERTY_TYPES = {
+    "int": ("DATA_TEMPLATE_TYPE_INT", "value_int", "int32_t", "0"),
+    "enum": ("DATA_TEMPLATE_TYPE_ENUM", "value_enum", "int32_t", "0"),
+    "stringenum": ("DATA_TEMPLATE_TYPE_STRING_ENUM", "value_string_enum", "const char*", '""'),
+    "float": ("DATA_TEMPLATE_TYPE_FLOAT", "value_float", "float", "0"),
+    "bool": ("DATA_TEMPLATE_TYPE_BOOL", "value_bool", "int32_t", "0"),
+    "string": ("DATA_TEMPLATE_TYPE_STRING", "value_string", "const char*", '""'),
+    "timestamp": ("DATA_TEMPLATE_TYPE_TIME", "value_time", "uint32_t", "0"),
+    "struct": ("DATA_TEMPLATE_TYPE_STRUCT", "value_struct", None, "{}"),
+    "array": ("DATA_TEMPLATE_TYPE_ARRAY", "value_arrary", None, "[]"),
+}
+
+EVENT_TYPES = {
+    "info": "IOT_DATA_TEMPLATE_EVENT_TYPE_INFO",
+    "alert": "IOT_DATA_TEMPLATE_EVENT_TYPE_ALERT",
+    "fault": "IOT_DATA_TEMPLATE_EVENT_TYPE_FAULT",
+}
+
+# empty slot of perfect hash index
+HASH_EMPTY = 0xFF
+MAX_HASH_SEED = 0xFFFF
+
+
+def hash_key(key, seed):
+    """Same as _hash_property_key in data_template_config.c."""
+    h = (2166136261 ^ seed) & 0xFFFFFFFF
+    for c in key.encode("utf-8"):
+        h ^= c
+        h = (h * 16777619) & 0xFFFFFFFF
+    h ^= h >> 16
+    h = (h * 0x7FEB352D) & 0xFFFFFFFF
+    h ^= h >> 15
+    return h
+
+
+def _power_of_2(n):
+    size = 1
+    while size < n:
+        size <<= 1
+    return size
+
+
+def _displace(keys, bucket_num, slot_num):
+    buckets = [[] for _ in range(bucket_num)]
+    for i, key in enumerate(keys):
+        buckets[hash_key(key, 0) & (bucket_num - 1)].append(i)
+
+    seeds = [0] * bucket_num
+    index = [HASH_EMPTY] * slot_num
+    for b in sorted(range(bucket_num), key=lambda b: -len(buckets[b])):
+        if not buckets[b]:
+            continue
+        for seed in range(1, MAX_HASH_SEED + 1):
+            slots = [hash_key(keys[i], seed) & (slot_num - 1) for i in buckets[b]]
+            if len(set(slots)) == len(slots) and all(index[s] == HASH_EMPTY for s in slots):
+                break
+        else:
+            return None
+        seeds[b] = seed
+        for i, s in zip(buckets[b], slots):
+            index[s] = i
+    return seeds, index
+
+
+def perfect_hash(keys):
+    """Hash and displace: keys are grouped into buckets by seed 0, then a seed is searched for each bucket (larger
+    first) to put all its keys into free slots. Return (seeds, index) with index[slot] = key index."""
+    bucket_num = _power_of_2(max(1, (len(keys) + 1) // 2))
+    slot_num = _power_of_2(max(1, len(keys)))
+    while True:
+        result = _displace(keys, bucket_num, slot_num)
+        if result:
+            return result
+        slot_num <<= 1
+
+
+class Property(object):
+    def __init__(self, node, table):
+        self.id = node["id"]
+        define = node.get("define") or node.get("dataType")
+        if not self.id.isidentifier():
+            raise ValueError("invalid id: %s" % self.id)
+        if define is None or define.get("type") not in PROPERTY_TYPES:
+            raise ValueError("invalid type of %s" % self.id)
+        self.type = define["type"]
+        self.type_enum, self.value_field, self.c_type, self.default = PROPERTY_TYPES[self.type]
+        self.index = "%s_%s" % (table.prefix, self.id.upper())
+
+        self.string_len = 0
+        if self.type == "string":
+            self.string_len = int(define.get("max", DEFAULT_STRING_LEN))
+        elif self.type == "stringenum":
+            self.string_len = max([len(k.encode("utf-8")) for k in define.get("mapping", {})] or [DEFAULT_STRING_LEN])
+
+        self.members = None
+        if self.type == "struct":
+            if not table.struct_enable:
+                raise ValueError("struct is not supported in %s" % table.name)
+            name = "%s_%s" % (table.name, self.id)
+            self.members = PropertyTable(define.get("specs", []), name, "%s_INDEX" % name.upper(),
+                                         "TOTAL_%s_STRUCT_%s_COUNT" % (table.name.upper(), self.id.upper()))
+
+    def default_json(self):
+        if self.members is not None:
+            return self.members.default_json()
+        return '"%s":%s' % (self.id, self.default)
+
+
+class PropertyTable(object):
+    def __init__(self, nodes, name, prefix, count, struct_enable=False):
+        """name such as usr_property_position, prefix of index enum such as USR_PROPERTY_POSITION_INDEX."""
+        self.name = name
+        self.prefix = prefix
+        self.count = count
+        self.struct_enable = struct_enable
+        self.properties = [Property(n, self) for n in nodes]
+        if len(self.properties) > MAX_TABLE_SIZE:
+            raise ValueError("%s: %d properties at most" % (name, MAX_TABLE_SIZE))
+        keys = [p.id for p in self.properties]
+        if len(set(keys)) != len(keys):
+            raise ValueError("%s: duplicated id" % name)
+        self.seeds, self.index = perfect_hash(keys)
+
+    def default_json(self):
+        return "{%s}" % ",".join(p.default_json() for p in self.properties)
+
+
+def camel(name):
+    return "".join(s[:1].upper() + s[1:] for s in name.split("_"))
+
+
+def c_string(s):
+    return '"%s"' % s.replace("\\", "\\\\").replace('"', '\\"')
+
+
+def _split(line, indent, limit):
+    lines, start = [], 0
+    while len(line) - start > limit - (indent if lines else 0):
+        cut = line.rfind(", ", start, start + limit - (indent if lines else 0))
+        if cut <= start:
+            return None
+        lines.append(line[start:cut + 1])
+        start = cut + 2
+    lines.append(line[start:])
+    return [lines[0]] + [" " * indent + l for l in lines[1:]]
+
+
+def wrap(line, limit=120):
+    """Wrap call or initializer after ', ' and align to the first '(' or '{', enough for generated code."""
+    if len(line) <= limit:
+        return [line]
+    bracket = min(i for i in (line.find("("), line.find("{")) if i >= 0) + 1
+    lines = _split(line, bracket, limit)
+    if lines:
+        return lines
+    # break after bracket if aligned lines are still too long
+    indent = len(line) - len(line.lstrip()) + 4
+    return [line[:bracket]] + (_split(" " * indent + line[bracket:], 0, limit) or [" " * indent + line[bracket:]])
+
+
+def _struct_member_table_name(table, prop):
+    return "sg_%s" % prop.members.name
+
+
+def gen_enum(out, type_name, count, prefix, names):
+    out.append("#define %s %d\n" % (count, len(names)))
+    if not names:
+        out.append("typedef int %s;\n" % type_name)
+        return
+    out.append("typedef enum {")
+    for i, name in enumerate(names):
+        out.append("    %s_%s%s," % (prefix, name.upper(), " = 0" if i == 0 else ""))
+    out.append("} %s;\n" % type_name)
+
+
+def gen_header(model):
+    props, events, actions = model
+    out = [
+        "/**",
+        " * @file %s" % GEN_H,
+        " * @brief Generated by tools/data_template_codegen.py from thing model, DO NOT EDIT.",
+        " *",
+        " */",
+        "",
+        "#ifndef IOT_HUB_DEVICE_C_SDK_APP_DATA_TEMPLATE_DATA_TEMPLATE_CONFIG_GEN_H_",
+        "#define IOT_HUB_DEVICE_C_SDK_APP_DATA_TEMPLATE_DATA_TEMPLATE_CONFIG_GEN_H_",
+        "",
+        "/**************************************************************************************",
+        " * usr data template definition",
+        " **************************************************************************************/",
+        "",
+    ]
+    gen_enum(out, "UsrPropertyIndex", props.count, props.prefix, [p.id for p in props.properties])
+    for p in props.properties:
+        if p.members is not None:
+            m = p.members
+            gen_enum(out, "UsrProperty%sIndex" % camel(p.id), m.count, m.prefix, [q.id for q in m.properties])
+    gen_enum(out, "UsrEventIndex", "TOTAL_USR_EVENT_COUNT", "USR_EVENT_INDEX", [e["id"] for e, _ in events])
+    gen_enum(out, "UsrActionIndex", "TOTAL_USR_ACTION_COUNT", "USR_ACTION_INDEX", [a["id"] for a, _ in actions])
+    for a, inputs in actions:
+        gen_enum(out, "UsrAction%sInputIndex" % camel(a["id"]), inputs.count, inputs.prefix,
+                 [q.id for q in inputs.properties])
+
+    out += [
+        "/**",
+        " * @brief Tables of user data template, used by data_template_config.c.",
+        " *",
+        " */",
+        "extern DataTemplateProperty           sg_usr_data_template_property[];",
+        "extern const DataTemplatePropertyHash sg_usr_data_template_property_hash;",
+        "extern DataTemplateEvent              sg_usr_data_template_event[];",
+        "extern DataTemplateAction             sg_usr_data_template_action[];",
+        "",
+        "/**************************************************************************************",
+        " * typed accessors of user property",
+        " **************************************************************************************/",
+        "",
+    ]
+    for p, struct in _accessor_properties(props):
+        name = p.id if struct is None else "%s_%s" % (struct.id, p.id)
+        out.append("%s usr_data_template_property_%s_get(void);" % (p.c_type, name))
+        out.append("void usr_data_template_property_%s_set(%s value);" % (name, p.c_type))
+        out.append("")
+
+    out += ["#endif  // IOT_HUB_DEVICE_C_SDK_APP_DATA_TEMPLATE_DATA_TEMPLATE_CONFIG_GEN_H_", ""]
+    return "\n".join(out)
+
+
+def _accessor_properties(props):
+    for p in props.properties:
+        if p.members is not None:
+            for q in p.members.properties:
+                if q.c_type:
+                    yield q, p
+        elif p.c_type:
+            yield p, None
+
+
+def gen_table(out, table, var, storage):
+    """Property table with string buffers, struct members and perfect hash."""
+    for p in table.properties:
+        if p.members is not None:
+            gen_table(out, p.members, _struct_member_table_name(table, p), "static ")
+    for p in table.properties:
+        if p.string_len:
+            out.append("static char sg_%s_%s[%d + 1];" % (table.name, p.id, p.string_len))
+    if any(p.string_len for p in table.properties):
+        out.append("")
+
+    out.append("%sDataTemplateProperty %s[%s] = {" % (storage, var, _array_size(table.count, table.properties)))
+    for p in table.properties:
+        init = [".type = %s" % p.type_enum, ".key = %s" % c_string(p.id)]
+        if p.string_len:
+            buf = "sg_%s_%s" % (table.name, p.id)
+            init += [".value.%s = %s" % (p.value_field, buf), ".string_size = sizeof(%s)" % buf]
+        if p.members is not None:
+            member_var = _struct_member_table_name(table, p)
+            init += [
+                ".value.value_struct.property = %s" % member_var,
+                ".value.value_struct.count = %s" % p.members.count,
+                ".value.value_struct.hash = &%s_hash" % member_var,
+            ]
+        line = "    [%s] = {%s}," % (p.index, ", ".join(init))
+        if len(line) > 120:
+            line = "    [%s] =\n        {\n            %s,\n        }," % (p.index, ",\n            ".join(init))
+        out.append(line)
+    out.append("};")
+    out.append("")
+    gen_hash(out, table, var + "_hash", "static " if storage else "")
+
+
+def gen_hash(out, table, var, storage):
+    out.append("static const uint16_t %s_seed[] = {%s};" % (var, ", ".join(str(s) for s in table.seeds)))
+    out.append("static const uint8_t  %s_index[] = {%s};" % (var, ", ".join("0x%02x" % i for i in table.index)))
+    out += wrap("%sconst DataTemplatePropertyHash %s = {%s_seed, %s_index, %d, %d};" %
+                (storage, var, var, var, len(table.seeds) - 1, len(table.index) - 1))
+    out.append("")
+
+
+def _array_size(count, items):
+    # zero length array is not allowed
+    return count if items else "1"
+
+
+def gen_source(model):
+    props, events, actions = model
+    out = [
+        "/**",
+        " * @file %s" % GEN_C,
+        " * @brief Generated by tools/data_template_codegen.py from thing model, DO NOT EDIT.",
+        " *",
+        " */",
+        "",
+        '#include "data_template_config.h"',
+        "",
+        "/**************************************************************************************",
+        " * user property",
+        " **************************************************************************************/",
+        "",
+    ]
+    gen_table(out, props, "sg_usr_data_template_property", "")
+
+    out += [
+        "/**************************************************************************************",
+        " * user event",
+        " **************************************************************************************/",
+        "",
+        "DataTemplateEvent sg_usr_data_template_event[%s] = {" % _array_size("TOTAL_USR_EVENT_COUNT", events),
+    ]
+    for e, params in events:
+        out += [
+            "    [USR_EVENT_INDEX_%s] =" % e["id"].upper(),
+            "        {",
+            "            .event_id = %s," % c_string(e["id"]),
+            "            .type     = %s," % EVENT_TYPES[e.get("type", "info")],
+            "            .params   = %s," % c_string(params.default_json()),
+            "        },",
+        ]
+    out += ["};", ""]
+
+    out += [
+        "/**************************************************************************************",
+        " * user action",
+        " **************************************************************************************/",
+        "",
+    ]
+    for a, inputs in actions:
+        gen_table(out, inputs, "sg_%s" % inputs.name, "static ")
+    out.append("DataTemplateAction sg_usr_data_template_action[%s] = {" %
+               _array_size("TOTAL_USR_ACTION_COUNT", actions))
+    for a, inputs in actions:
+        output = PropertyTable(a.get("output", []), "usr_action_%s_output" % a["id"], None, None)
+        var = "sg_%s" % inputs.name
+        out += [
+            "    [USR_ACTION_INDEX_%s] =" % a["id"].upper(),
+            "        {",
+            "            .action_id                          = %s," % c_string(a["id"]),
+            "            .input_struct.value_struct.property = %s," % var,
+            "            .input_struct.value_struct.count    = %s," % inputs.count,
+            "            .input_struct.value_struct.hash     = &%s_hash," % var,
+            "            .reply.response                     = %s," % c_string(output.default_json()),
+            "        },",
+        ]
+    out += ["};", ""]
+
+    out += [
+        "/**************************************************************************************",
+        " * typed accessors of user property",
+        " **************************************************************************************/",
+        "",
+    ]
+    for p, struct in _accessor_properties(props):
+        name = p.id if struct is None else "%s_%s" % (struct.id, p.id)
+        cast = "(char*)" if p.c_type == "const char*" else ""
+        if struct is None:
+            get = "usr_data_template_property_value_get(%s)" % p.index
+            set_ = "usr_data_template_property_value_set(%s, property_value)" % p.index
+        else:
+            get = "usr_data_template_property_struct_value_get(%s, %s)" % (struct.index, p.index)
+            set_ = "usr_data_template_property_struct_value_set(%s, %s, property_value)" % (struct.index, p.index)
+        out += ["%s usr_data_template_property_%s_get(void)" % (p.c_type, name), "{"]
+        out += wrap("    return %s.%s;" % (get, p.value_field))
+        out += [
+            "}",
+            "",
+            "void usr_data_template_property_%s_set(%s value)" % (name, p.c_type),
+            "{",
+            "    DataTemplatePropertyValue property_value;",
+            "    property_value.%s = %svalue;" % (p.value_field, cast),
+        ]
+        out += wrap("    %s;" % set_)
+        out += ["}", ""]
+    return "\n".join(out)
+
+
+def load_model(path):
+    with open(path, encoding="utf-8") as f:
+        model = json.load(f)
+
+    props = PropertyTable(model.get("properties", []), "usr_property", "USR_PROPERTY_INDEX",
+                          "TOTAL_USR_PROPERTY_COUNT", True)
+
+    events = []
+    for e in model.get("events", []):
+        if e.get("type", "info") not in EVENT_TYPES:
+            raise ValueError("invalid event type of %s" % e["id"])
+        events.append((e, PropertyTable(e.get("params", []), "usr_event_%s" % e["id"], None, None, True)))
+
+    actions = []
+    for a in model.get("actions", []):
+        name = "usr_action_%s_input" % a["id"]
+        actions.append((a, PropertyTable(a.get("input", []), name, "%s_INDEX" % name.upper(),
+                                         "TOTAL_USR_ACTION_%s_INPUT_PARAMS_COUNT" % a["id"].upper())))
+    return props, events, actions
+
+
+def _write_if_changed(path, content):
+    # keep timestamp if not changed, avoid rebuilding
+    if os.path.exists(path):
+        with open(path, encoding="utf-8") as f:
+            if f.read() == content:
+                return
+    with open(path, "w", encoding="utf-8") as f:
+        f.write(content)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Generate data template tables from thing model json.")
+    parser.add_argument("-c", "--config", required=True, help="thing model json")
+    parser.add_argument("-d", "--dest", default=".", help="output directory")
+    args = parser.parse_args()
+
+    try:
+        model = load_model(args.config)
+    except (ValueError, KeyError) as e:
+        sys.stderr.write("%s: %s\n" % (args.config, e))
+        return 1
+
+    if not os.path.isdir(args.dest):
+        os.makedirs(args.dest)
+    _write_if_changed(os.path.join(args.dest, GEN_H), gen_header(model))
+    _write_if_changed(os.path.join(args.dest, GEN_C), gen_source(model))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())